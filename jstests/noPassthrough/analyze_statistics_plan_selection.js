@@ -0,0 +1,81 @@
+/**
+ * Tests that the 'analyze' command builds field statistics and stores them in system.statistics,
+ * and that with 'internalQueryPlannerUseStatistics' set the planner uses them to discard candidate
+ * plans which would examine far more keys than the others, without trialling them.
+ */
+(function() {
+    "use strict";
+
+    load("jstests/libs/analyze_plan.js");
+
+    const conn = MongoRunner.runMongod({setParameter: {internalQueryPlannerUseStatistics: true}});
+    assert.neq(null, conn, "mongod was unable to start up");
+    const db = conn.getDB("test");
+    const coll = db.analyze_statistics_plan_selection;
+
+    let docs = [];
+    for (let i = 0; i < 1000; ++i) {
+        docs.push({a: i % 2, b: i});
+    }
+    assert.commandWorked(coll.insert(docs));
+    assert.commandWorked(coll.createIndex({a: 1}));
+    assert.commandWorked(coll.createIndex({b: 1}));
+
+    const query = {a: 0, b: 4};
+
+    // Without statistics every candidate is trialled.
+    let explain = coll.find(query).explain();
+    assert.gt(explain.queryPlanner.rejectedPlans.length, 0, tojson(explain));
+
+    // Invalid arguments are rejected.
+    assert.commandFailedWithCode(db.runCommand({analyze: "nonexistent", key: "a"}),
+                                 ErrorCodes.NamespaceNotFound);
+    assert.commandFailedWithCode(db.runCommand({analyze: coll.getName(), key: 1}),
+                                 ErrorCodes.TypeMismatch);
+    assert.commandFailedWithCode(db.runCommand({analyze: coll.getName(), key: "a", buckets: 0}),
+                                 ErrorCodes.BadValue);
+
+    // The whole of a small collection is analyzed.
+    let res = assert.commandWorked(db.runCommand({analyze: coll.getName(), key: "a"}));
+    assert.eq(1000, res.numDocuments, tojson(res));
+    assert.eq(1000, res.numSampled, tojson(res));
+    assert.eq(2, res.buckets, tojson(res));
+    assert.lt(Math.abs(res.distinctEstimate - 2), 0.1, tojson(res));
+
+    // The statistics are written like any other document, so a write concern is accepted.
+    res = assert.commandWorked(db.runCommand(
+        {analyze: coll.getName(), key: "b", buckets: 10, writeConcern: {w: 1, j: true}}));
+    assert.eq(10, res.buckets, tojson(res));
+    assert.lt(Math.abs(res.distinctEstimate - 1000), 100, tojson(res));
+
+    const stats = db.system.statistics.find().toArray();
+    assert.eq(2, stats.length, tojson(stats));
+    for (let doc of stats) {
+        assert.eq(coll.getFullName(), doc.ns, tojson(doc));
+        assert.eq(1000, doc.numDocuments, tojson(doc));
+    }
+
+    // The scan of the unselective index on 'a' is discarded before multi-planning, leaving a single
+    // plan which scans the index on 'b'.
+    const prunedBefore =
+        db.serverStatus().metrics.query.planner.solutionsPrunedByStatistics.valueOf();
+    explain = coll.find(query).explain();
+    assert.eq(0, explain.queryPlanner.rejectedPlans.length, tojson(explain));
+    const ixscan = getPlanStage(explain.queryPlanner.winningPlan, "IXSCAN");
+    assert.neq(null, ixscan, tojson(explain));
+    assert.eq("b_1", ixscan.indexName, tojson(explain));
+    assert.gt(db.serverStatus().metrics.query.planner.solutionsPrunedByStatistics.valueOf(),
+              prunedBefore);
+    assert.eq(1, coll.find(query).itcount());
+
+    // Queries with a limit are still trialled, as scans may stop early.
+    explain = coll.find(query).limit(1).explain();
+    assert.gt(explain.queryPlanner.rejectedPlans.length, 0, tojson(explain));
+
+    // Dropping the statistics makes the planner trial every candidate again.
+    assert(db.system.statistics.drop());
+    explain = coll.find(query).explain();
+    assert.gt(explain.queryPlanner.rejectedPlans.length, 0, tojson(explain));
+
+    MongoRunner.stopMongod(conn);
+}());
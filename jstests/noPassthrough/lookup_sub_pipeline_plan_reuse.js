@@ -0,0 +1,66 @@
+/**
+ * Tests that the queries issued by a $lookup sub-pipeline reuse the active cached plan for their
+ * shape rather than being replanned for every input document, and that this is reported by the
+ * 'metrics.query.subPipelinePlans' serverStatus counters.
+ */
+(function() {
+    "use strict";
+
+    const conn = MongoRunner.runMongod();
+    assert.neq(null, conn, "mongod was unable to start up");
+    const testDB = conn.getDB("test");
+
+    const local = testDB.lookup_sub_pipeline_plan_reuse_local;
+    const foreign = testDB.lookup_sub_pipeline_plan_reuse_foreign;
+
+    const numDocs = 100;
+    let localDocs = [];
+    let foreignDocs = [];
+    for (let i = 0; i < numDocs; ++i) {
+        localDocs.push({_id: i, key: i});
+        foreignDocs.push({_id: i, a: i, b: i});
+    }
+    assert.commandWorked(local.insert(localDocs));
+    assert.commandWorked(foreign.insert(foreignDocs));
+
+    // Two candidate indexes ensure that the sub-pipeline's query is multi-planned and cached.
+    assert.commandWorked(foreign.createIndex({a: 1}));
+    assert.commandWorked(foreign.createIndex({a: 1, b: 1}));
+
+    function getSubPipelinePlanMetrics() {
+        return testDB.serverStatus().metrics.query.subPipelinePlans;
+    }
+
+    const before = getSubPipelinePlanMetrics();
+
+    const results = local
+                        .aggregate([
+                            {
+                              $lookup: {
+                                  from: foreign.getName(),
+                                  let : {key: "$key"},
+                                  pipeline: [{$match: {$expr: {$eq: ["$a", "$$key"]}}}],
+                                  as: "matches"
+                              }
+                            },
+                            {$sort: {_id: 1}}
+                        ])
+                        .toArray();
+
+    assert.eq(numDocs, results.length);
+    for (let i = 0; i < numDocs; ++i) {
+        assert.eq([{_id: i, a: i, b: i}], results[i].matches, tojson(results[i]));
+    }
+
+    const after = getSubPipelinePlanMetrics();
+    const reused = after.reused - before.reused;
+    const rebuilt = after.rebuilt - before.rebuilt;
+
+    // Every input document issues one query, which is either served by the cached plan or planned.
+    assert.eq(numDocs, reused + rebuilt, tojson({before: before, after: after}));
+
+    // Only the first few queries, which create and then activate the cache entry, need planning.
+    assert.gt(reused, rebuilt, tojson({before: before, after: after}));
+
+    MongoRunner.stopMongod(conn);
+}());
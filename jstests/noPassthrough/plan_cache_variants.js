@@ -0,0 +1,63 @@
+/**
+ * Tests that with 'internalQueryCacheMaxVariantsPerShape' set, queries of the same shape are cached
+ * as separate plan variants according to the selectivity of their parameters, and that
+ * planCacheListPlans and planCacheListQueryShapes report which variant a query was assigned to.
+ */
+(function() {
+    "use strict";
+
+    const numVariants = 8;
+    const conn = MongoRunner.runMongod(
+        {setParameter: {internalQueryCacheMaxVariantsPerShape: numVariants}});
+    assert.neq(null, conn, "mongod was unable to start up");
+    const coll = conn.getDB("test").plan_cache_variants;
+
+    let docs = [];
+    for (let i = 0; i < 100; ++i) {
+        docs.push({a: i, b: i});
+    }
+    assert.commandWorked(coll.insert(docs));
+    assert.commandWorked(coll.createIndex({a: 1}));
+    assert.commandWorked(coll.createIndex({a: 1, b: 1}));
+
+    // Run each query twice so that its variant's cache entry is created and then activated.
+    // Equality predicates are equally selective whatever their value, so these share one variant.
+    for (let i = 0; i < 20; ++i) {
+        assert.eq(1, coll.find({a: i}).itcount());
+        assert.eq(1, coll.find({a: i}).itcount());
+    }
+    let shapes = coll.getPlanCache().listQueryShapes();
+    assert.eq(1, shapes.length, tojson(shapes));
+
+    // Ranges of different widths are expected to differ in selectivity, and get their own variants.
+    for (let width of [2, 90]) {
+        assert.eq(width, coll.find({a: {$gte: 0, $lt: width}}).itcount());
+        assert.eq(width, coll.find({a: {$gte: 0, $lt: width}}).itcount());
+    }
+
+    // All of the range queries share a shape, but are spread over more than one variant.
+    shapes = coll.getPlanCache().listQueryShapes().filter(
+        shape => shape.query.a.hasOwnProperty("$gte"));
+    let variantsSeen = new Set();
+    for (let shape of shapes) {
+        assert(shape.hasOwnProperty("variant"), tojson(shape));
+        assert.lt(shape.variant, numVariants, tojson(shape));
+        variantsSeen.add(shape.variant);
+    }
+    assert.eq(shapes.length, variantsSeen.size, tojson(shapes));
+    assert.eq(2, variantsSeen.size, tojson(shapes));
+
+    // planCacheListPlans reports the variant of the given query along with its cost histograms.
+    const res = assert.commandWorked(coll.runCommand("planCacheListPlans", {query: {a: 0}}));
+    assert(res.hasOwnProperty("variant"), tojson(res));
+    assert.gt(res.plans.length, 0, tojson(res));
+    assert(Array.isArray(res.worksHistogram), tojson(res));
+    assert(res.hasOwnProperty("expectedTrialWorks"), tojson(res));
+
+    // Clearing the shape removes all of its variants.
+    assert.commandWorked(coll.runCommand("planCacheClear", {query: {a: {$gte: 0, $lt: 2}}}));
+    assert.commandWorked(coll.runCommand("planCacheClear", {query: {a: 0}}));
+    assert.eq(0, coll.getPlanCache().listQueryShapes().length);
+
+    MongoRunner.stopMongod(conn);
+}());
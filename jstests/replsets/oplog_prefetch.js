@@ -0,0 +1,60 @@
+/**
+ * Checks that a secondary prefetching the documents and index entries each batch will touch, with
+ * replPrefetcherThreadCount set, ends up with the same data as its primary and reports the lookups
+ * it made.
+ */
+
+(function() {
+    "use strict";
+
+    let name = "oplog_prefetch";
+    let rst = new ReplSetTest({
+        name: name,
+        nodes: [
+            {},
+            {
+              rsConfig: {priority: 0},
+              replIndexPrefetch: "all",
+              setParameter: {replPrefetcherThreadCount: 4}
+            }
+        ]
+    });
+    rst.startSet();
+    rst.initiate();
+
+    let primary = rst.getPrimary();
+    let secondary = rst.getSecondary();
+    let coll = primary.getDB(name)["foo"];
+    assert.commandWorked(coll.createIndex({a: 1}));
+
+    // Inserts touch the index entries of the new documents, updates and deletes also look up the
+    // documents they modify.
+    let bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < 1000; i++) {
+        bulk.insert({_id: i, a: i});
+    }
+    assert.writeOK(bulk.execute());
+    bulk = coll.initializeUnorderedBulkOp();
+    for (let i = 0; i < 1000; i++) {
+        if (i % 2 === 0) {
+            bulk.find({_id: i}).updateOne({$inc: {a: 1000}});
+        } else {
+            bulk.find({_id: i}).removeOne();
+        }
+    }
+    assert.writeOK(bulk.execute());
+    rst.awaitReplication();
+
+    let secondaryColl = secondary.getDB(name)["foo"];
+    assert.eq(500, secondaryColl.find().itcount());
+    assert.eq(1000, secondaryColl.findOne({_id: 0}).a);
+
+    let serverStatus = assert.commandWorked(secondary.adminCommand({serverStatus: 1}));
+    let preload = serverStatus.metrics.repl.preload;
+    jsTestLog("Secondary preload metrics: " + tojson(preload));
+    assert.gt(preload.docs.num, 0, tojson(preload));
+    assert.gt(preload.indexes.num, 0, tojson(preload));
+
+    // stopSet() checks that the data on both nodes is the same.
+    rst.stopSet();
+})();
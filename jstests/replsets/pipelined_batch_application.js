@@ -0,0 +1,53 @@
+/**
+ * Checks that a secondary with replPipelinedBatchApplication enabled, which writes the oplog
+ * entries of the next batch while applying the current one, ends up with the same data as its
+ * primary, and that it reports the time spent in each stage of batch application.
+ */
+
+(function() {
+    "use strict";
+
+    let name = "pipelined_batch_application";
+    let rst = new ReplSetTest({
+        name: name,
+        nodes: [{}, {rsConfig: {priority: 0}, setParameter: {replPipelinedBatchApplication: true}}]
+    });
+    rst.startSet();
+    rst.initiate();
+
+    let primary = rst.getPrimary();
+    let secondary = rst.getSecondary();
+    let coll = primary.getDB(name)["foo"];
+
+    // Mix inserts of new documents with repeated updates to a single hot document, then run a
+    // command so that batches are cut in the middle of the load.
+    assert.writeOK(coll.insert({_id: "hot", count: 0}));
+    for (let round = 0; round < 10; round++) {
+        let bulk = coll.initializeOrderedBulkOp();
+        for (let i = 0; i < 1000; i++) {
+            bulk.insert({round: round, i: i});
+            bulk.find({_id: "hot"}).updateOne({$inc: {count: 1}});
+        }
+        assert.writeOK(bulk.execute());
+        if (round % 3 === 0) {
+            assert.commandWorked(coll.createIndex({["round" + round]: 1}));
+        }
+    }
+    assert.writeOK(coll.remove({round: 5}));
+    rst.awaitReplication();
+
+    let secondaryColl = secondary.getDB(name)["foo"];
+    assert.eq(10000, secondaryColl.findOne({_id: "hot"}).count);
+    assert.eq(coll.find().itcount(), secondaryColl.find().itcount());
+
+    let apply = assert.commandWorked(secondary.adminCommand({serverStatus: 1})).metrics.repl.apply;
+    jsTestLog("Secondary apply metrics: " + tojson(apply));
+    assert.gt(apply.stages.oplogWrite.num, 0, tojson(apply));
+    assert.gt(apply.stages.partition.num, 0, tojson(apply));
+    assert.gt(apply.stages.apply.num, 0, tojson(apply));
+    assert.gte(apply.pipelinedBatches, 0, tojson(apply));
+    assert.gt(apply.writers.length, 0, tojson(apply));
+
+    // stopSet() checks that the data on both nodes is the same.
+    rst.stopSet();
+})();
@@ -0,0 +1,156 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Returns a document with 'numFields' fields named f0, f1, ..., cycling through the value types
+ * most documents are made of.
+ */
+BSONObj makeDocument(int numFields) {
+    BSONObjBuilder bob;
+    for (int i = 0; i < numFields; i++) {
+        const std::string name = str::stream() << "f" << i;
+        switch (i % 4) {
+            case 0:
+                bob.append(name, i);
+                break;
+            case 1:
+                bob.append(name, "some string value");
+                break;
+            case 2:
+                bob.append(name, i * 1.5);
+                break;
+            case 3:
+                bob.append(name, BSON("x" << i << "y" << "nested"));
+                break;
+        }
+    }
+    return bob.obj();
+}
+
+void BM_BSONObjBuilderAppendInt(benchmark::State& state) {
+    for (auto keepRunning : state) {
+        BSONObjBuilder bob;
+        for (int i = 0; i < state.range(0); i++) {
+            bob.append("field", i);
+        }
+        benchmark::DoNotOptimize(bob.done());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_BSONObjBuilderAppendString(benchmark::State& state) {
+    const std::string value(state.range(1), 'x');
+    for (auto keepRunning : state) {
+        BSONObjBuilder bob;
+        for (int i = 0; i < state.range(0); i++) {
+            bob.append("field", value);
+        }
+        benchmark::DoNotOptimize(bob.done());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_BSONObjBuilderAppendSubobject(benchmark::State& state) {
+    for (auto keepRunning : state) {
+        BSONObjBuilder bob;
+        for (int i = 0; i < state.range(0); i++) {
+            BSONObjBuilder sub(bob.subobjStart("field"));
+            sub.append("a", i);
+            sub.append("b", "value");
+            sub.done();
+        }
+        benchmark::DoNotOptimize(bob.done());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Copies every element of an existing document into a new one, which is how most server code
+ * transforms documents.
+ */
+void BM_BSONObjBuilderAppendElements(benchmark::State& state) {
+    const BSONObj source = makeDocument(state.range(0));
+    for (auto keepRunning : state) {
+        BSONObjBuilder bob;
+        bob.appendElements(source);
+        benchmark::DoNotOptimize(bob.done());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * source.objsize());
+}
+
+/**
+ * Compares two equal documents, the worst case since every field must be visited.
+ */
+void BM_BSONObjWoCompareEqual(benchmark::State& state) {
+    const BSONObj lhs = makeDocument(state.range(0));
+    const BSONObj rhs = lhs.copy();
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(lhs.woCompare(rhs));
+    }
+    state.SetBytesProcessed(state.iterations() * lhs.objsize());
+}
+
+void BM_BSONObjWoCompareWithOrdering(benchmark::State& state) {
+    const BSONObj lhs = BSON("" << 1 << "" << "abc" << "" << 2.5);
+    const BSONObj rhs = BSON("" << 1 << "" << "abc" << "" << 3.5);
+    const BSONObj keyPattern = BSON("a" << 1 << "b" << -1 << "c" << 1);
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(lhs.woCompare(rhs, keyPattern, false));
+    }
+}
+
+void BM_BSONObjGetField(benchmark::State& state) {
+    const BSONObj obj = makeDocument(state.range(0));
+    const std::string lastField = str::stream() << "f" << (state.range(0) - 1);
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(obj.getField(lastField));
+    }
+}
+
+BENCHMARK(BM_BSONObjBuilderAppendInt)->Arg(10)->Arg(100);
+BENCHMARK(BM_BSONObjBuilderAppendString)->Args({10, 8})->Args({10, 256});
+BENCHMARK(BM_BSONObjBuilderAppendSubobject)->Arg(10);
+BENCHMARK(BM_BSONObjBuilderAppendElements)->Arg(10)->Arg(100);
+BENCHMARK(BM_BSONObjWoCompareEqual)->Arg(1)->Arg(10)->Arg(100);
+BENCHMARK(BM_BSONObjWoCompareWithOrdering);
+BENCHMARK(BM_BSONObjGetField)->Arg(1)->Arg(10)->Arg(100);
+
+}  // namespace
+}  // namespace mongo
@@ -237,9 +237,10 @@ public:
                                                Timestamp* timestamps,
                                                size_t nDocs) = 0;
 
-        virtual Status insertDocument(OperationContext* opCtx,
-                                      const BSONObj& doc,
-                                      const std::vector<MultiIndexBlock*>& indexBlocks) = 0;
+        virtual Status insertDocuments(OperationContext* opCtx,
+                                       std::vector<BSONObj>::const_iterator begin,
+                                       std::vector<BSONObj>::const_iterator end,
+                                       const std::vector<MultiIndexBlock*>& indexBlocks) = 0;
 
         virtual RecordId updateDocument(OperationContext* opCtx,
                                         const RecordId& oldLocation,
@@ -488,7 +489,23 @@ public:
     inline Status insertDocument(OperationContext* const opCtx,
                                  const BSONObj& doc,
                                  const std::vector<MultiIndexBlock*>& indexBlocks) {
-        return this->_impl().insertDocument(opCtx, doc, indexBlocks);
+        std::vector<BSONObj> docs{doc};
+        return this->_impl().insertDocuments(opCtx, docs.begin(), docs.end(), indexBlocks);
+    }
+
+    /**
+     * Inserts documents into the record store with a single call and adds them to the
+     * MultiIndexBlocks passed in, whose bulk builders sort the keys and build each index at
+     * once when the caller finishes. Indexes that are already built are not updated, so this is
+     * only for loading a collection whose indexes are all being built by 'indexBlocks'.
+     *
+     * NOTE: It is up to caller to commit the indexes.
+     */
+    inline Status insertDocuments(OperationContext* const opCtx,
+                                  const std::vector<BSONObj>::const_iterator begin,
+                                  const std::vector<BSONObj>::const_iterator end,
+                                  const std::vector<MultiIndexBlock*>& indexBlocks) {
+        return this->_impl().insertDocuments(opCtx, begin, end, indexBlocks);
     }
 
     /**
@@ -378,9 +378,12 @@ Status CollectionImpl::insertDocument(OperationContext* opCtx,
     return insertDocuments(opCtx, docs.begin(), docs.end(), opDebug, fromMigrate);
 }
 
-Status CollectionImpl::insertDocument(OperationContext* opCtx,
-                                      const BSONObj& doc,
-                                      const std::vector<MultiIndexBlock*>& indexBlocks) {
+Status CollectionImpl::insertDocuments(OperationContext* opCtx,
+                                       const vector<BSONObj>::const_iterator begin,
+                                       const vector<BSONObj>::const_iterator end,
+                                       const std::vector<MultiIndexBlock*>& indexBlocks) {
+    if (begin == end)
+        return Status::OK();
 
     MONGO_FAIL_POINT_BLOCK(failCollectionInserts, extraData) {
         const BSONObj& data = extraData.getData();
@@ -389,52 +392,67 @@ Status CollectionImpl::insertDocument(OperationContext* opCtx,
         if (!collElem || _ns.ns() == collElem.str()) {
             const std::string msg = str::stream()
                 << "Failpoint (failCollectionInserts) has been enabled (" << data
-                << "), so rejecting insert: " << doc;
+                << "), so rejecting insert (first doc): " << *begin;
             log() << msg;
             return {ErrorCodes::FailPointEnabled, msg};
         }
     }
 
-    {
-        auto status = checkValidation(opCtx, doc);
+    for (auto it = begin; it != end; it++) {
+        auto status = checkValidation(opCtx, *it);
         if (!status.isOK())
             return status;
     }
 
     dassert(opCtx->lockState()->isCollectionLockedForMode(ns().toString(), MODE_IX));
 
+    const size_t count = std::distance(begin, end);
+    std::vector<Record> records;
+    records.reserve(count);
+    for (auto it = begin; it != end; it++) {
+        records.push_back({RecordId(), RecordData(it->objdata(), it->objsize())});
+    }
+
     // TODO SERVER-30638: using timestamp 0 for these inserts, which are non-oplog so we don't yet
     // care about their correct timestamps.
-    StatusWith<RecordId> loc =
-        _recordStore->insertRecord(opCtx, doc.objdata(), doc.objsize(), Timestamp());
-
-    if (!loc.isOK())
-        return loc.getStatus();
-
-    for (auto&& indexBlock : indexBlocks) {
-        Status status = indexBlock->insert(doc, loc.getValue());
-        if (!status.isOK()) {
-            return status;
-        }
-    }
+    std::vector<Timestamp> timestamps(count);
+    Status status = _recordStore->insertRecords(opCtx, &records, &timestamps);
+    if (!status.isOK())
+        return status;
+    _infoCache.getColumnCache()->notifyOfInserts(opCtx, records);
 
     vector<InsertStatement> inserts;
-    OplogSlot slot;
-    // Fetch a new optime now, if necessary.
+    inserts.reserve(count);
+    std::vector<OplogSlot> slots(count);
+    // Fetch new optimes now, if necessary.
     auto replCoord = repl::ReplicationCoordinator::get(opCtx);
     if (!replCoord->isOplogDisabledFor(opCtx, _ns)) {
-        // Populate 'slot' with a new optime.
-        slot = repl::getNextOpTime(opCtx);
+        slots = repl::getNextOpTimes(opCtx, count);
+    }
+    size_t i = 0;
+    for (auto it = begin; it != end; it++, i++) {
+        inserts.emplace_back(kUninitializedStmtId, *it, slots[i]);
     }
-    inserts.emplace_back(kUninitializedStmtId, doc, slot);
 
     getGlobalServiceContext()->getOpObserver()->onInserts(
         opCtx, ns(), uuid(), inserts.begin(), inserts.end(), false);
 
+    // The bulk builders cannot take keys back if this unit of work is retried, so feed them only
+    // after every step that can throw a WriteConflictException.
+    for (auto&& indexBlock : indexBlocks) {
+        i = 0;
+        for (auto it = begin; it != end; it++, i++) {
+            status = indexBlock->insert(*it, records[i].id);
+            if (!status.isOK()) {
+                return status;
+            }
+        }
+    }
+
     opCtx->recoveryUnit()->onCommit(
         [this](boost::optional<Timestamp>) { notifyCappedWaitersIfNeeded(); });
 
-    return loc.getStatus();
+    return Status::OK();
 }
 
 Status CollectionImpl::_insertDocuments(OperationContext* opCtx,
@@ -475,6 +493,7 @@ Status CollectionImpl::_insertDocuments(OperationContext* opCtx,
     Status status = _recordStore->insertRecords(opCtx, &records, &timestamps);
     if (!status.isOK())
         return status;
+    _infoCache.getColumnCache()->notifyOfInserts(opCtx, records);
 
     std::vector<BsonRecord> bsonRecords;
     bsonRecords.reserve(count);
@@ -559,6 +578,7 @@ void CollectionImpl::deleteDocument(OperationContext* opCtx,
         opDebug->additiveMetrics.incrementKeysDeleted(keysDeleted);
     }
 
+    _infoCache.getColumnCache()->notifyOfWrite(opCtx, loc);
     _recordStore->deleteRecord(opCtx, loc);
 
     getGlobalServiceContext()->getOpObserver()->onDelete(
@@ -651,6 +671,7 @@ RecordId CollectionImpl::updateDocument(OperationContext* opCtx,
 
     args->preImageDoc = oldDoc.value().getOwned();
 
+    _infoCache.getColumnCache()->notifyOfWrite(opCtx, oldLocation);
     Status updateStatus =
         _recordStore->updateRecord(opCtx, oldLocation, newDoc.objdata(), newDoc.objsize(), this);
 
@@ -708,6 +729,7 @@ StatusWith<RecordData> CollectionImpl::updateDocumentWithDamages(
 
     // Broadcast the mutation so that query results stay correct.
     _cursorManager.invalidateDocument(opCtx, loc, INVALIDATION_MUTATION);
+    _infoCache.getColumnCache()->notifyOfWrite(opCtx, loc);
 
     auto newRecStatus =
         _recordStore->updateWithDamages(opCtx, loc, oldRec.value(), damageSource, damages);
@@ -786,6 +808,7 @@ Status CollectionImpl::truncate(OperationContext* opCtx) {
     _cursorManager.invalidateAll(opCtx, false, "collection truncated");
 
     // 3) truncate record store
+    _infoCache.getColumnCache()->notifyOfTruncate(opCtx);
     auto status = _recordStore->truncate(opCtx);
     if (!status.isOK())
         return status;
@@ -180,13 +180,14 @@ public:
                                    size_t nDocs) final;
 
     /**
-     * Inserts a document into the record store and adds it to the MultiIndexBlocks passed in.
+     * Inserts documents into the record store and adds them to the MultiIndexBlocks passed in.
      *
      * NOTE: It is up to caller to commit the indexes.
      */
-    Status insertDocument(OperationContext* opCtx,
-                          const BSONObj& doc,
-                          const std::vector<MultiIndexBlock*>& indexBlocks) final;
+    Status insertDocuments(OperationContext* opCtx,
+                           std::vector<BSONObj>::const_iterator begin,
+                           std::vector<BSONObj>::const_iterator end,
+                           const std::vector<MultiIndexBlock*>& indexBlocks) final;
 
     /**
      * Updates the document @ oldLocation with newDoc.
@@ -151,9 +151,10 @@ public:
         std::abort();
     }
 
-    Status insertDocument(OperationContext* opCtx,
-                          const BSONObj& doc,
-                          const std::vector<MultiIndexBlock*>& indexBlocks) {
+    Status insertDocuments(OperationContext* opCtx,
+                           std::vector<BSONObj>::const_iterator begin,
+                           std::vector<BSONObj>::const_iterator end,
+                           const std::vector<MultiIndexBlock*>& indexBlocks) {
         std::abort();
     }
 
@@ -459,8 +459,8 @@ Status DatabaseImpl::dropCollection(OperationContext* opCtx,
                 if (_profile != 0)
                     return Status(ErrorCodes::IllegalOperation,
                                   "turn off profiling before dropping system.profile collection");
-            } else if (!(nss.isSystemDotViews() || nss.isHealthlog() ||
-                         nss == NamespaceString::kLogicalSessionsNamespace ||
+            } else if (!(nss.isSystemDotViews() || nss.isSystemDotStatistics() ||
+                         nss.isHealthlog() || nss == NamespaceString::kLogicalSessionsNamespace ||
                          nss == NamespaceString::kSystemKeysNamespace)) {
                 return Status(ErrorCodes::IllegalOperation,
                               str::stream() << "can't drop system collection " << fullns);
@@ -32,6 +32,8 @@
 
 #include "mongo/db/catalog/index_create_impl.h"
 
+#include <algorithm>
+
 #include "mongo/base/error_codes.h"
 #include "mongo/base/init.h"
 #include "mongo/db/audit.h"
@@ -49,8 +51,10 @@
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/stdx/future.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
@@ -95,6 +99,38 @@ public:
 
 } exportedMaxIndexBuildMemoryUsageParameter;
 
+// The most threads one foreground index build uses at a time. Key generation fans out across
+// this many threads; when the keys are sorted, the indexes are sorted concurrently and each index's
+// sorter gets an equal share of the threads. Background builds always use one thread.
+AtomicInt32 maxIndexBuildThreads(1);
+
+class ExportedMaxIndexBuildThreadsParameter
+    : public ExportedServerParameter<std::int32_t, ServerParameterType::kStartupAndRuntime> {
+public:
+    ExportedMaxIndexBuildThreadsParameter()
+        : ExportedServerParameter<std::int32_t, ServerParameterType::kStartupAndRuntime>(
+              ServerParameterSet::getGlobal(), "maxIndexBuildThreads", &maxIndexBuildThreads) {}
+
+    virtual Status validate(const std::int32_t& potentialNewValue) {
+        if (potentialNewValue < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "maxIndexBuildThreads must be greater than or equal to 1");
+        }
+
+        return Status::OK();
+    }
+
+} exportedMaxIndexBuildThreadsParameter;
+
+namespace {
+
+// Limits on how many documents a foreground build buffers before generating their keys in
+// parallel.
+const size_t kMaxKeyGenerationBatchDocs = 1024;
+const size_t kMaxKeyGenerationBatchBytes = 16 * 1024 * 1024;
+
+}  // namespace
+
 
 /**
  * On rollback sets MultiIndexBlockImpl::_needToCleanup to true.
@@ -238,10 +274,13 @@ StatusWith<std::vector<BSONObj>> MultiIndexBlockImpl::init(const std::vector<BSO
     std::vector<BSONObj> indexInfoObjs;
     indexInfoObjs.reserve(indexSpecs.size());
     std::size_t eachIndexBuildMaxMemoryUsageBytes = 0;
+    std::size_t eachIndexSortThreads = 1;
+    _maxThreads = maxIndexBuildThreads.load();
     if (!indexSpecs.empty()) {
         eachIndexBuildMaxMemoryUsageBytes =
             static_cast<std::size_t>(maxIndexBuildMemoryUsageMegabytes.load()) * 1024 * 1024 /
             indexSpecs.size();
+        eachIndexSortThreads = std::max<std::size_t>(1, _maxThreads / indexSpecs.size());
     }
 
     for (size_t i = 0; i < indexSpecs.size(); i++) {
@@ -268,7 +307,8 @@ StatusWith<std::vector<BSONObj>> MultiIndexBlockImpl::init(const std::vector<BSO
         if (!_buildInBackground) {
             // Bulk build process requires foreground building as it assumes nothing is changing
             // under it.
-            index.bulk = index.real->initiateBulk(eachIndexBuildMaxMemoryUsageBytes);
+            index.bulk =
+                index.real->initiateBulk(eachIndexBuildMaxMemoryUsageBytes, eachIndexSortThreads);
         }
 
         const IndexDescriptor* descriptor = index.block->getEntry()->descriptor();
@@ -364,6 +404,16 @@ Status MultiIndexBlockImpl::insertAllDocumentsInCollection(std::set<RecordId>* d
     auto exec =
         InternalPlanner::collectionScan(_opCtx, _collection->ns().ns(), _collection, yieldPolicy);
 
+    // When every index is built in bulk, inserting a document only buffers its keys in memory.
+    // Documents can then be batched and their keys generated on several threads at once.
+    const bool insertInBatches = _maxThreads > 1 && !_indexes.empty() &&
+        std::all_of(_indexes.begin(), _indexes.end(), [](const IndexToBuild& index) {
+            return bool(index.bulk);
+        });
+    std::vector<BSONObj> batchDocs;
+    std::vector<RecordId> batchLocs;
+    size_t batchBytes = 0;
+
     Snapshotted<BSONObj> objToIndex;
     RecordId loc;
     PlanExecutor::ExecState state;
@@ -396,24 +446,39 @@ Status MultiIndexBlockImpl::insertAllDocumentsInCollection(std::set<RecordId>* d
 
             failPointHangDuringBuild(&hangBeforeIndexBuildOf, "before", objToIndex.value());
 
-            WriteUnitOfWork wunit(_opCtx);
-            Status ret = insert(objToIndex.value(), loc);
-            if (_buildInBackground)
-                exec->saveState();
-            if (ret.isOK()) {
-                wunit.commit();
-            } else if (dupsOut && ret.code() == ErrorCodes::DuplicateKey) {
-                // If dupsOut is non-null, we should only fail the specific insert that
-                // led to a DuplicateKey rather than the whole index build.
-                dupsOut->insert(loc);
+            if (insertInBatches) {
+                // Nothing is written to storage until doneInserting(), so buffering the document
+                // needs no WriteUnitOfWork and cannot write conflict.
+                batchDocs.push_back(objToIndex.value().getOwned());
+                batchLocs.push_back(loc);
+                batchBytes += batchDocs.back().objsize();
+                if (batchDocs.size() >= kMaxKeyGenerationBatchDocs ||
+                    batchBytes >= kMaxKeyGenerationBatchBytes) {
+                    _insertBatchInParallel(batchDocs, batchLocs);
+                    batchDocs.clear();
+                    batchLocs.clear();
+                    batchBytes = 0;
+                }
             } else {
-                // Fail the index build hard.
-                return ret;
-            }
-            if (_buildInBackground) {
-                auto restoreStatus = exec->restoreState();  // Handles any WCEs internally.
-                if (!restoreStatus.isOK()) {
-                    return restoreStatus;
+                WriteUnitOfWork wunit(_opCtx);
+                Status ret = insert(objToIndex.value(), loc);
+                if (_buildInBackground)
+                    exec->saveState();
+                if (ret.isOK()) {
+                    wunit.commit();
+                } else if (dupsOut && ret.code() == ErrorCodes::DuplicateKey) {
+                    // If dupsOut is non-null, we should only fail the specific insert that
+                    // led to a DuplicateKey rather than the whole index build.
+                    dupsOut->insert(loc);
+                } else {
+                    // Fail the index build hard.
+                    return ret;
+                }
+                if (_buildInBackground) {
+                    auto restoreStatus = exec->restoreState();  // Handles any WCEs internally.
+                    if (!restoreStatus.isOK()) {
+                        return restoreStatus;
+                    }
                 }
             }
 
@@ -444,6 +509,10 @@ Status MultiIndexBlockImpl::insertAllDocumentsInCollection(std::set<RecordId>* d
         return WorkingSetCommon::getMemberObjectStatus(objToIndex.value());
     }
 
+    if (!batchDocs.empty()) {
+        _insertBatchInParallel(batchDocs, batchLocs);
+    }
+
     if (MONGO_FAIL_POINT(hangAfterStartingIndexBuildUnlocked)) {
         // Unlock before hanging so replication recognizes we've completed.
         Locker::LockSnapshot lockInfo;
@@ -466,16 +535,151 @@ Status MultiIndexBlockImpl::insertAllDocumentsInCollection(std::set<RecordId>* d
     }
 
     progress->finished();
+    const long long scanMillis = t.millis();
 
     Status ret = doneInserting(dupsOut);
     if (!ret.isOK())
         return ret;
 
-    log() << "build index done.  scanned " << n << " total records. " << t.seconds() << " secs";
+    // Report how long each phase took with the operation's slow query log line and profile entry.
+    BSONObjBuilder phases;
+    phases.append("scanMillis", scanMillis);
+    if (insertInBatches) {
+        phases.append("keyGenerationMillis", _keyGenerationMicros / 1000);
+        phases.append("sorterInsertMillis", _sorterInsertMicros / 1000);
+    }
+    if (std::any_of(_indexes.begin(), _indexes.end(), [](const IndexToBuild& index) {
+            return bool(index.bulk);
+        })) {
+        phases.append("sortMillis", _sortMicros / 1000);
+        phases.append("bulkLoadMillis", _bulkLoadMicros / 1000);
+    }
+    CurOp::get(_opCtx)->debug().indexBuildPhases = phases.obj();
+
+    log() << "build index done.  scanned " << n << " total records. " << t.seconds() << " secs "
+          << CurOp::get(_opCtx)->debug().indexBuildPhases << " on up to " << _maxThreads
+          << " threads";
 
     return Status::OK();
 }
 
+void MultiIndexBlockImpl::_insertBatchInParallel(const std::vector<BSONObj>& docs,
+                                                 const std::vector<RecordId>& locs) {
+    invariant(docs.size() == locs.size());
+
+    // Split every index's share of the work into slices so that a batch keeps all threads busy
+    // even when only one index is being built.
+    const size_t numSlices =
+        std::min(docs.size(), (_maxThreads + _indexes.size() - 1) / _indexes.size());
+    const size_t sliceSize = (docs.size() + numSlices - 1) / numSlices;
+
+    struct GeneratedKeys {
+        std::vector<BSONObjSet> keys;
+        std::vector<MultikeyPaths> multikeyPaths;
+        std::vector<char> matched;
+    };
+    std::vector<GeneratedKeys> generated(_indexes.size());
+    for (auto&& index : generated) {
+        index.keys.resize(docs.size(), SimpleBSONObjComparator::kInstance.makeBSONObjSet());
+        index.multikeyPaths.resize(docs.size());
+        index.matched.resize(docs.size());
+    }
+
+    Timer keyGenerationTimer;
+    _runConcurrently(_maxThreads, _indexes.size() * numSlices, [&](size_t task) {
+        const size_t i = task / numSlices;
+        const size_t begin = (task % numSlices) * sliceSize;
+        const size_t end = std::min(docs.size(), begin + sliceSize);
+        const IndexToBuild& index = _indexes[i];
+        for (size_t doc = begin; doc < end; doc++) {
+            if (index.filterExpression && !index.filterExpression->matchesBSON(docs[doc])) {
+                continue;
+            }
+            generated[i].matched[doc] = true;
+            index.bulk->generateKeys(docs[doc],
+                                     index.options,
+                                     &generated[i].keys[doc],
+                                     &generated[i].multikeyPaths[doc]);
+        }
+    });
+    _keyGenerationMicros += keyGenerationTimer.micros();
+
+    // Each index has its own sorter, so the indexes can be fed concurrently as long as every
+    // sorter sees its keys in document order.
+    Timer sorterInsertTimer;
+    _runConcurrently(_maxThreads, _indexes.size(), [&](size_t i) {
+        for (size_t doc = 0; doc < docs.size(); doc++) {
+            if (!generated[i].matched[doc]) {
+                continue;
+            }
+            _indexes[i].bulk->addKeys(generated[i].keys[doc],
+                                      generated[i].multikeyPaths[doc],
+                                      locs[doc],
+                                      nullptr);
+        }
+    });
+    _sorterInsertMicros += sorterInsertTimer.micros();
+}
+
+void MultiIndexBlockImpl::_runConcurrently(size_t numThreads,
+                                           size_t numTasks,
+                                           const stdx::function<void(size_t)>& task) {
+    AtomicUInt64 nextTask(0);
+    AtomicWord<bool> failed(false);
+    auto worker = [&] {
+        for (size_t i = nextTask.fetchAndAdd(1); i < numTasks && !failed.load();
+             i = nextTask.fetchAndAdd(1)) {
+            try {
+                task(i);
+            } catch (...) {
+                failed.store(true);
+                throw;
+            }
+        }
+    };
+
+    const size_t numWorkers = std::min(numThreads, numTasks);
+    if (numWorkers > 1 && !_workerPool) {
+        // The calling thread takes part, so the pool needs one thread fewer. Its threads are
+        // reused by every later batch of this build and joined when the build is destroyed.
+        ThreadPool::Options options;
+        options.poolName = "IndexBuildWorkers";
+        options.threadNamePrefix = "IndexBuildWorker-";
+        options.minThreads = 0;
+        options.maxThreads = numThreads - 1;
+        _workerPool = stdx::make_unique<ThreadPool>(options);
+        _workerPool->startup();
+    }
+
+    std::vector<stdx::future<void>> helpers;
+    for (size_t i = 1; i < numWorkers; i++) {
+        auto helper = std::make_shared<stdx::packaged_task<void()>>(worker);
+        helpers.push_back(helper->get_future());
+        if (!_workerPool->schedule([helper] { (*helper)(); }).isOK()) {
+            (*helper)();
+        }
+    }
+
+    std::exception_ptr firstError;
+    try {
+        worker();
+    } catch (...) {
+        firstError = std::current_exception();
+    }
+
+    for (auto&& helper : helpers) {
+        try {
+            helper.get();
+        } catch (...) {
+            if (!firstError)
+                firstError = std::current_exception();
+        }
+    }
+
+    if (firstError)
+        std::rethrow_exception(firstError);
+}
+
 Status MultiIndexBlockImpl::insert(const BSONObj& doc, const RecordId& loc) {
     for (size_t i = 0; i < _indexes.size(); i++) {
         if (_indexes[i].filterExpression && !_indexes[i].filterExpression->matchesBSON(doc)) {
@@ -498,6 +702,40 @@ Status MultiIndexBlockImpl::insert(const BSONObj& doc, const RecordId& loc) {
 
 Status MultiIndexBlockImpl::doneInserting(std::set<RecordId>* dupsOut) {
     invariant(!_opCtx->lockState()->inAWriteUnitOfWork());
+
+    // Sorting a bulk builder's keys needs nothing but the builder itself, so the indexes can be
+    // sorted concurrently. Loading the sorted keys into each index must still happen one index at
+    // a time, since the storage engine's bulk cursors belong to this operation.
+    const auto numBulk = std::count_if(_indexes.begin(),
+                                       _indexes.end(),
+                                       [](const IndexToBuild& index) { return bool(index.bulk); });
+    if (numBulk == 0) {
+        return Status::OK();
+    }
+
+    stdx::unique_lock<Client> lk(*_opCtx->getClient());
+    ProgressMeterHolder progress(
+        CurOp::get(_opCtx)->setMessage_inlock("Index Bulk Build: (1/3) sorting keys",
+                                              "Index: (1/3) Sorting Keys Progress",
+                                              numBulk,
+                                              1));
+    lk.unlock();
+
+    Timer sortTimer;
+    _runConcurrently(_maxThreads, _indexes.size(), [&](size_t i) {
+        if (!_indexes[i].bulk)
+            return;
+        _indexes[i].bulk->doneInserting();
+
+        // Helper threads may report progress too, so it is done under the Client lock like
+        // currentOp's reads of it.
+        stdx::lock_guard<Client> lk(*_opCtx->getClient());
+        progress->hit();
+    });
+    progress->finished();
+    _sortMicros += sortTimer.micros();
+
+    Timer bulkLoadTimer;
     for (size_t i = 0; i < _indexes.size(); i++) {
         if (_indexes[i].bulk == NULL)
             continue;
@@ -512,6 +750,7 @@ Status MultiIndexBlockImpl::doneInserting(std::set<RecordId>* dupsOut) {
             return status;
         }
     }
+    _bulkLoadMicros += bulkLoadTimer.micros();
 
     return Status::OK();
 }
@@ -41,6 +41,7 @@
 #include "mongo/db/catalog/index_catalog_impl.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/record_id.h"
+#include "mongo/stdx/functional.h"
 
 namespace mongo {
 
@@ -48,6 +49,7 @@ class BackgroundOperation;
 class BSONObj;
 class Collection;
 class OperationContext;
+class ThreadPool;
 
 /**
  * Builds one or more indexes.
@@ -204,6 +206,24 @@ private:
 
     virtual bool initBackgroundIndexFromSpec(const BSONObj& spec) const = 0;
 
+    /**
+     * Bulk-inserts a batch of documents into every index. Keys are generated on up to
+     * '_maxThreads' threads, then added to each index's sorter in document order. Only valid when
+     * every index is being built with a BulkBuilder.
+     */
+    void _insertBatchInParallel(const std::vector<BSONObj>& docs,
+                                const std::vector<RecordId>& locs);
+
+    /**
+     * Runs task(0) through task(numTasks - 1) on up to 'numThreads' threads: the calling one and
+     * threads from '_workerPool', which is started on first use. Returns once every task has
+     * finished; the first exception thrown by a task is rethrown and stops the remaining tasks
+     * from starting.
+     */
+    void _runConcurrently(size_t numThreads,
+                          size_t numTasks,
+                          const stdx::function<void(size_t)>& task);
+
     std::vector<IndexToBuild> _indexes;
 
     std::unique_ptr<BackgroundOperation> _backgroundOperation;
@@ -217,6 +237,18 @@ private:
     bool _ignoreUnique;
 
     bool _needToCleanup;
+
+    // The most threads this build uses at a time, read from maxIndexBuildThreads by init().
+    size_t _maxThreads = 1;
+
+    // Time spent in each phase of a bulk build, reported in OpDebug::indexBuildPhases.
+    long long _keyGenerationMicros = 0;
+    long long _sorterInsertMicros = 0;
+    long long _sortMicros = 0;
+    long long _bulkLoadMicros = 0;
+
+    // Helper threads for _runConcurrently(), shared by all the batches of this build.
+    std::unique_ptr<ThreadPool> _workerPool;
 };
 
 }  // namespace mongo
@@ -0,0 +1,239 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kCommand
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/db/bson/dotted_path_support.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog_raii.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbhelpers.h"
+#include "mongo/db/query/collection_statistics.h"
+#include "mongo/db/query/field_statistics.h"
+#include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/repl/replication_coordinator.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+namespace {
+
+const long long kDefaultSampleSize = 10000;
+const long long kMaxSampleSize = 1000 * 1000;
+const long long kDefaultBuckets = 100;
+const long long kMaxBuckets = 1000;
+
+long long parseLimitedPositiveInt(const BSONObj& cmdObj,
+                                  StringData fieldName,
+                                  long long defaultValue,
+                                  long long maxValue) {
+    BSONElement elem = cmdObj[fieldName];
+    if (elem.eoo()) {
+        return defaultValue;
+    }
+    uassert(ErrorCodes::TypeMismatch,
+            str::stream() << "'" << fieldName << "' must be a number",
+            elem.isNumber());
+    const long long value = elem.safeNumberLong();
+    uassert(ErrorCodes::BadValue,
+            str::stream() << "'" << fieldName << "' must be between 1 and " << maxValue,
+            value >= 1 && value <= maxValue);
+    return value;
+}
+
+/**
+ * Appends the values 'doc' has for 'path' to 'values', as an index on 'path' would generate keys
+ * for them: each element of an array is a separate value, and a missing field is null.
+ */
+void appendValues(const BSONObj& doc, StringData path, BSONArrayBuilder* values) {
+    BSONElementSet elements;
+    dotted_path_support::extractAllElementsAlongPath(doc, path, elements);
+    if (elements.empty()) {
+        values->appendNull();
+        return;
+    }
+    for (auto&& elem : elements) {
+        values->append(elem);
+    }
+}
+
+/**
+ * { analyze: <collection>, key: <field path>, sampleSize: <number>, buckets: <number> }
+ *
+ * Builds a histogram and a distinct value sketch of the values of a field from a random sample
+ * of the collection's documents, and stores them in the database's 'system.statistics'
+ * collection for the query planner to use.
+ */
+class CmdAnalyze : public BasicCommand {
+public:
+    CmdAnalyze() : BasicCommand("analyze") {}
+
+    AllowedOnSecondary secondaryAllowed(ServiceContext*) const override {
+        return AllowedOnSecondary::kNever;
+    }
+
+    bool supportsWriteConcern(const BSONObj& cmd) const override {
+        return true;
+    }
+
+    std::string help() const override {
+        return "Builds statistics of the values of a field for the query planner.\n"
+               "{ analyze: <collection>, key: <field path>, sampleSize: <number of documents>, "
+               "buckets: <number of histogram buckets> }";
+    }
+
+    void addRequiredPrivileges(const std::string& dbname,
+                               const BSONObj& cmdObj,
+                               std::vector<Privilege>* out) const override {
+        ActionSet actions;
+        actions.addAction(ActionType::find);
+        actions.addAction(ActionType::planCacheWrite);
+        out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+    }
+
+    bool run(OperationContext* opCtx,
+             const std::string& dbname,
+             const BSONObj& cmdObj,
+             BSONObjBuilder& result) override {
+        const NamespaceString nss(CommandHelpers::parseNsCollectionRequired(dbname, cmdObj));
+
+        BSONElement keyElem = cmdObj["key"];
+        uassert(ErrorCodes::TypeMismatch,
+                "'key' must be the path of the field to analyze",
+                keyElem.type() == String);
+        const std::string key = keyElem.str();
+        uassert(ErrorCodes::BadValue,
+                "'key' must be a non-empty field path not starting with '$'",
+                !key.empty() && key[0] != '$');
+
+        const long long sampleSize =
+            parseLimitedPositiveInt(cmdObj, "sampleSize", kDefaultSampleSize, kMaxSampleSize);
+        const long long maxBuckets =
+            parseLimitedPositiveInt(cmdObj, "buckets", kDefaultBuckets, kMaxBuckets);
+
+        BSONArrayBuilder valuesBuilder;
+        long long numSampled = 0;
+        long long numDocuments = 0;
+        boost::optional<CollectionUUID> uuid;
+        {
+            AutoGetCollectionForReadCommand ctx(opCtx, nss);
+            Collection* collection = ctx.getCollection();
+            uassert(ErrorCodes::NamespaceNotFound, "ns not found", collection);
+            uuid = collection->uuid();
+            uassert(
+                ErrorCodes::IllegalOperation, "cannot analyze a collection without a UUID", uuid);
+
+            numDocuments = collection->numRecords(opCtx);
+            const long long maxValueBytes = internalQueryExecMaxBlockingSortBytes.load();
+            auto sample = [&](const BSONObj& doc) {
+                appendValues(doc, key, &valuesBuilder);
+                ++numSampled;
+                uassert(50904,
+                        str::stream() << "analyze sampled more than " << maxValueBytes
+                                      << " bytes of values; use a smaller sampleSize",
+                        valuesBuilder.len() <= maxValueBytes);
+            };
+
+            // Sample random documents of large collections, and all of the documents of small
+            // ones or of storage engines without random cursors.
+            std::unique_ptr<RecordCursor> randomCursor;
+            if (numDocuments > sampleSize) {
+                randomCursor = collection->getRecordStore()->getRandomCursor(opCtx);
+            }
+            if (randomCursor) {
+                while (numSampled < sampleSize) {
+                    auto record = randomCursor->next();
+                    if (!record) {
+                        break;
+                    }
+                    sample(record->data.toBson());
+                }
+            } else {
+                auto exec = InternalPlanner::collectionScan(
+                    opCtx, nss.ns(), collection, PlanExecutor::NO_YIELD);
+                BSONObj doc;
+                while (numSampled < sampleSize &&
+                       exec->getNext(&doc, nullptr) == PlanExecutor::ADVANCED) {
+                    sample(doc);
+                }
+            }
+        }
+
+        BSONObj values = valuesBuilder.arr();
+        std::vector<BSONElement> elements;
+        for (auto&& elem : values) {
+            elements.push_back(elem);
+        }
+        auto stats =
+            FieldStatistics::build(std::move(elements), numSampled, numDocuments, maxBuckets);
+
+        BSONObjBuilder statsDoc;
+        statsDoc.append("_id", CollectionStatisticsCache::makeId(*uuid, key));
+        statsDoc.append("ns", nss.ns());
+        statsDoc.appendElements(stats.toBSON());
+        const BSONObj doc = statsDoc.obj();
+
+        // Writing the statistics invalidates the statistics cache of every member of the replica
+        // set through the OpObserver.
+        const NamespaceString statsNss(nss.db(),
+                                       NamespaceString::kSystemDotStatisticsCollectionName);
+        writeConflictRetry(opCtx, "analyze", statsNss.ns(), [&] {
+            AutoGetOrCreateDb autoDb(opCtx, statsNss.db(), MODE_X);
+            uassert(ErrorCodes::NotMaster,
+                    str::stream() << "Not primary while analyzing " << nss.ns(),
+                    repl::ReplicationCoordinator::get(opCtx)->canAcceptWritesFor(opCtx, statsNss));
+
+            Helpers::upsert(opCtx, statsNss.ns(), doc);
+
+            // Plans chosen without the new statistics are replanned.
+            if (Collection* collection = autoDb.getDb()->getCollection(opCtx, nss)) {
+                collection->infoCache()->clearQueryCache();
+            }
+        });
+
+        LOG(1) << "analyzed " << key << " of " << nss << " from " << numSampled << " of "
+               << numDocuments << " documents";
+
+        result.append("numDocuments", numDocuments);
+        result.append("numSampled", numSampled);
+        result.append("buckets", static_cast<long long>(stats.getBuckets().size()));
+        result.append("distinctEstimate", stats.getDistinctEstimate());
+        return true;
+    }
+} cmdAnalyze;
+
+}  // namespace
+}  // namespace mongo
@@ -260,6 +260,9 @@ Status PlanCacheListQueryShapes::list(const PlanCache& planCache, BSONObjBuilder
         if (!entry->collation.isEmpty()) {
             shapeBuilder.append("collation", entry->collation);
         }
+        if (entry->variant) {
+            shapeBuilder.append("variant", static_cast<long long>(*entry->variant));
+        }
         shapeBuilder.doneFast();
 
         // Release resources for cached solution after extracting query shape.
@@ -445,6 +448,14 @@ Status PlanCacheListPlans::list(OperationContext* opCtx,
     bob->append("isActive", entry->isActive);
     bob->append("works", static_cast<long long>(entry->works));
 
+    // Append which of the shape's plan variants the query was assigned to, how many works that
+    // variant's cached runs needed during their trial periods, and the resulting works budget.
+    if (entry->variant) {
+        bob->append("variant", static_cast<long long>(*entry->variant));
+    }
+    bob->append("worksHistogram", entry->worksHistogram.toBSON());
+    bob->append("expectedTrialWorks", static_cast<long long>(entry->expectedTrialWorks()));
+
     return Status::OK();
 }
 
@@ -485,17 +485,23 @@ Status runAggregate(OperationContext* opCtx,
             return status;
         }
 
+        auto makeExpCtx = [&](std::unique_ptr<CollatorInterface> collator) {
+            boost::intrusive_ptr<ExpressionContext> newExpCtx(
+                new ExpressionContext(opCtx,
+                                      request,
+                                      std::move(collator),
+                                      std::make_shared<PipelineD::MongoDInterface>(opCtx),
+                                      uassertStatusOK(resolveInvolvedNamespaces(opCtx, request)),
+                                      uuid));
+            newExpCtx->tempDir = storageGlobalParams.dbpath + "/_tmp";
+            auto session = OperationContextSession::get(opCtx);
+            newExpCtx->inMultiDocumentTransaction =
+                session && session->inMultiDocumentTransaction();
+            return newExpCtx;
+        };
+
         invariant(collatorToUse);
-        expCtx.reset(
-            new ExpressionContext(opCtx,
-                                  request,
-                                  std::move(*collatorToUse),
-                                  std::make_shared<PipelineD::MongoDInterface>(opCtx),
-                                  uassertStatusOK(resolveInvolvedNamespaces(opCtx, request)),
-                                  uuid));
-        expCtx->tempDir = storageGlobalParams.dbpath + "/_tmp";
-        auto session = OperationContextSession::get(opCtx);
-        expCtx->inMultiDocumentTransaction = session && session->inMultiDocumentTransaction();
+        expCtx = makeExpCtx(std::move(*collatorToUse));
 
         auto pipeline = uassertStatusOK(Pipeline::parse(request.getPipeline(), expCtx));
 
@@ -520,33 +526,71 @@ Status runAggregate(OperationContext* opCtx,
             pipeline = reparsePipeline(pipeline.get(), request, expCtx);
         }
 
-        // Prepare a PlanExecutor to provide input into the pipeline, if needed.
-        if (liteParsedPipeline.hasChangeStream()) {
-            // If we are using a change stream, the cursor stage should have a simple collation,
-            // regardless of what the user's collation was.
-            std::unique_ptr<CollatorInterface> collatorForCursor = nullptr;
-            auto collatorStash = expCtx->temporarilyChangeCollator(std::move(collatorForCursor));
-            PipelineD::prepareCursorSource(collection, nss, &request, pipeline.get());
-        } else {
-            PipelineD::prepareCursorSource(collection, nss, &request, pipeline.get());
-        }
-        // Optimize again, since there may be additional optimizations that can be done after adding
-        // the initial cursor stage. Note this has to be done outside the above blocks to ensure
-        // this process uses the correct collation if it does any string comparisons.
-        pipeline->optimizePipeline();
-
         std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> pipelines;
 
-        pipelines.emplace_back(std::move(pipeline));
-
-        auto exchange =
-            dynamic_cast<DocumentSourceExchange*>(pipelines[0]->getSources().back().get());
-        if (exchange) {
-            for (size_t idx = 1; idx < exchange->getConsumers(); ++idx) {
-                auto sources = pipelines[0]->getSources();
-                sources.back() = new DocumentSourceExchange(expCtx, exchange->getExchange(), idx);
-                pipelines.emplace_back(
-                    uassertStatusOK(Pipeline::create(std::move(sources), expCtx)));
+        // If the consumers of a roundrobin $exchange can each scan their own range of the
+        // collection, give every consumer its own copy of the stages before the $exchange, so that
+        // the consumers run in parallel instead of waiting on one shared producer.
+        const auto splitPoints = PipelineD::getExchangeSplitPoints(collection, pipeline.get());
+        if (!splitPoints.empty()) {
+            const size_t numConsumers =
+                static_cast<DocumentSourceExchange&>(*pipeline->getSources().back())
+                    .getConsumers();
+            for (size_t idx = 0; idx < numConsumers; ++idx) {
+                std::unique_ptr<Pipeline, PipelineDeleter> consumer;
+                if (idx == 0) {
+                    consumer = std::move(pipeline);
+                } else {
+                    consumer = uassertStatusOK(Pipeline::parse(
+                        request.getPipeline(),
+                        makeExpCtx(CollatorInterface::cloneCollator(expCtx->getCollator()))));
+                    consumer->optimizePipeline();
+                }
+                consumer->popBack();
+
+                // If the collection has fewer split points than there are consumers, the consumers
+                // past the last range get an empty one.
+                const size_t numSplitPoints = splitPoints.size();
+                const RecordId minRecord =
+                    idx == 0 ? RecordId() : splitPoints[std::min(idx, numSplitPoints) - 1];
+                const RecordId maxRecord = idx < numSplitPoints
+                    ? splitPoints[idx]
+                    : (idx == numSplitPoints ? RecordId() : minRecord);
+                PipelineD::prepareRangeCursorSource(
+                    collection, minRecord, maxRecord, consumer.get());
+                consumer->optimizePipeline();
+
+                pipelines.emplace_back(std::move(consumer));
+            }
+        } else {
+            // Prepare a PlanExecutor to provide input into the pipeline, if needed.
+            if (liteParsedPipeline.hasChangeStream()) {
+                // If we are using a change stream, the cursor stage should have a simple
+                // collation, regardless of what the user's collation was.
+                std::unique_ptr<CollatorInterface> collatorForCursor = nullptr;
+                auto collatorStash =
+                    expCtx->temporarilyChangeCollator(std::move(collatorForCursor));
+                PipelineD::prepareCursorSource(collection, nss, &request, pipeline.get());
+            } else {
+                PipelineD::prepareCursorSource(collection, nss, &request, pipeline.get());
+            }
+            // Optimize again, since there may be additional optimizations that can be done after
+            // adding the initial cursor stage. Note this has to be done outside the above blocks to
+            // ensure this process uses the correct collation if it does any string comparisons.
+            pipeline->optimizePipeline();
+
+            pipelines.emplace_back(std::move(pipeline));
+
+            auto exchange =
+                dynamic_cast<DocumentSourceExchange*>(pipelines[0]->getSources().back().get());
+            if (exchange) {
+                for (size_t idx = 1; idx < exchange->getConsumers(); ++idx) {
+                    auto sources = pipelines[0]->getSources();
+                    sources.back() =
+                        new DocumentSourceExchange(expCtx, exchange->getExchange(), idx);
+                    pipelines.emplace_back(
+                        uassertStatusOK(Pipeline::create(std::move(sources), expCtx)));
+                }
             }
         }
 
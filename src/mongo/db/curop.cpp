@@ -569,6 +569,8 @@ string OpDebug::report(Client* client,
     OPDEBUG_TOSTRING_HELP_OPTIONAL("keysDeleted", additiveMetrics.keysDeleted);
     OPDEBUG_TOSTRING_HELP_OPTIONAL("prepareReadConflicts", additiveMetrics.prepareReadConflicts);
     OPDEBUG_TOSTRING_HELP_OPTIONAL("writeConflicts", additiveMetrics.writeConflicts);
+    OPDEBUG_TOSTRING_HELP_OPTIONAL("sorterBytesSpilled", additiveMetrics.sorterBytesSpilled);
+    OPDEBUG_TOSTRING_HELP_OPTIONAL("sorterBytesWritten", additiveMetrics.sorterBytesWritten);
 
     s << " numYields:" << curop.numYields();
     OPDEBUG_TOSTRING_HELP(nreturned);
@@ -592,6 +594,10 @@ string OpDebug::report(Client* client,
         s << " locks:" << locks.obj().toString();
     }
 
+    if (!indexBuildPhases.isEmpty()) {
+        s << " indexBuildPhases:" << indexBuildPhases.toString();
+    }
+
     if (iscommand) {
         s << " protocol:" << getProtoString(networkOp);
     }
@@ -650,6 +656,8 @@ void OpDebug::append(const CurOp& curop,
     OPDEBUG_APPEND_OPTIONAL("keysDeleted", additiveMetrics.keysDeleted);
     OPDEBUG_APPEND_OPTIONAL("prepareReadConflicts", additiveMetrics.prepareReadConflicts);
     OPDEBUG_APPEND_OPTIONAL("writeConflicts", additiveMetrics.writeConflicts);
+    OPDEBUG_APPEND_OPTIONAL("sorterBytesSpilled", additiveMetrics.sorterBytesSpilled);
+    OPDEBUG_APPEND_OPTIONAL("sorterBytesWritten", additiveMetrics.sorterBytesWritten);
 
     b.appendNumber("numYield", curop.numYields());
     OPDEBUG_APPEND_NUMBER(nreturned);
@@ -681,6 +689,10 @@ void OpDebug::append(const CurOp& curop,
     if (!execStats.isEmpty()) {
         b.append("execStats", execStats);
     }
+
+    if (!indexBuildPhases.isEmpty()) {
+        b.append("indexBuildPhases", indexBuildPhases);
+    }
 }
 
 void OpDebug::setPlanSummaryMetrics(const PlanSummaryStats& planSummaryStats) {
@@ -720,6 +732,8 @@ void OpDebug::AdditiveMetrics::add(const AdditiveMetrics& otherMetrics) {
     prepareReadConflicts =
         addOptionalLongs(prepareReadConflicts, otherMetrics.prepareReadConflicts);
     writeConflicts = addOptionalLongs(writeConflicts, otherMetrics.writeConflicts);
+    sorterBytesSpilled = addOptionalLongs(sorterBytesSpilled, otherMetrics.sorterBytesSpilled);
+    sorterBytesWritten = addOptionalLongs(sorterBytesWritten, otherMetrics.sorterBytesWritten);
 }
 
 bool OpDebug::AdditiveMetrics::equals(const AdditiveMetrics& otherMetrics) {
@@ -729,7 +743,9 @@ bool OpDebug::AdditiveMetrics::equals(const AdditiveMetrics& otherMetrics) {
         nmoved == otherMetrics.nmoved && keysInserted == otherMetrics.keysInserted &&
         keysDeleted == otherMetrics.keysDeleted &&
         prepareReadConflicts == otherMetrics.prepareReadConflicts &&
-        writeConflicts == otherMetrics.writeConflicts;
+        writeConflicts == otherMetrics.writeConflicts &&
+        sorterBytesSpilled == otherMetrics.sorterBytesSpilled &&
+        sorterBytesWritten == otherMetrics.sorterBytesWritten;
 }
 
 void OpDebug::AdditiveMetrics::incrementWriteConflicts(long long n) {
@@ -774,6 +790,20 @@ void OpDebug::AdditiveMetrics::incrementPrepareReadConflicts(long long n) {
     *prepareReadConflicts += n;
 }
 
+void OpDebug::AdditiveMetrics::incrementSorterBytesSpilled(long long n) {
+    if (!sorterBytesSpilled) {
+        sorterBytesSpilled = 0;
+    }
+    *sorterBytesSpilled += n;
+}
+
+void OpDebug::AdditiveMetrics::incrementSorterBytesWritten(long long n) {
+    if (!sorterBytesWritten) {
+        sorterBytesWritten = 0;
+    }
+    *sorterBytesWritten += n;
+}
+
 string OpDebug::AdditiveMetrics::report() {
     StringBuilder s;
 
@@ -788,6 +818,8 @@ string OpDebug::AdditiveMetrics::report() {
     OPDEBUG_TOSTRING_HELP_OPTIONAL("keysDeleted", keysDeleted);
     OPDEBUG_TOSTRING_HELP_OPTIONAL("prepareReadConflicts", prepareReadConflicts);
     OPDEBUG_TOSTRING_HELP_OPTIONAL("writeConflicts", writeConflicts);
+    OPDEBUG_TOSTRING_HELP_OPTIONAL("sorterBytesSpilled", sorterBytesSpilled);
+    OPDEBUG_TOSTRING_HELP_OPTIONAL("sorterBytesWritten", sorterBytesWritten);
 
     return s.str();
 }
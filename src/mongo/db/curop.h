@@ -98,6 +98,16 @@ public:
          */
         void incrementPrepareReadConflicts(long long n);
 
+        /**
+         * Increments sorterBytesSpilled by n.
+         */
+        void incrementSorterBytesSpilled(long long n);
+
+        /**
+         * Increments sorterBytesWritten by n.
+         */
+        void incrementSorterBytesWritten(long long n);
+
         /**
          * Generates a string showing all non-empty fields. For every non-empty field field1,
          * field2, ..., with corresponding values value1, value2, ..., we will output a string in
@@ -124,6 +134,10 @@ public:
         // Number of read conflicts caused by a prepared transaction.
         boost::optional<long long> prepareReadConflicts;
         boost::optional<long long> writeConflicts;
+
+        // Bytes of data spilled to disk by sorts, and the bytes written for it after compression.
+        boost::optional<long long> sorterBytesSpilled;
+        boost::optional<long long> sorterBytesWritten;
     };
 
     OpDebug() = default;
@@ -180,6 +194,9 @@ public:
 
     BSONObj execStats;  // Owned here.
 
+    // Milliseconds spent in each phase of an index build, if this operation built indexes.
+    BSONObj indexBuildPhases;  // Owned here.
+
     // Details of any error (whether from an exception or a command returning failure).
     Status errInfo = Status::OK();
 
@@ -63,6 +63,10 @@ TEST(CurOpTest, AddingAdditiveMetricsObjectsTogetherShouldAddFieldsTogether) {
     additiveMetricsToAdd.prepareReadConflicts = 5;
     currentAdditiveMetrics.writeConflicts = 7;
     additiveMetricsToAdd.writeConflicts = 0;
+    currentAdditiveMetrics.sorterBytesSpilled = 100;
+    additiveMetricsToAdd.sorterBytesSpilled = 50;
+    currentAdditiveMetrics.sorterBytesWritten = 40;
+    additiveMetricsToAdd.sorterBytesWritten = 20;
 
     // Save the current AdditiveMetrics object before adding.
     OpDebug::AdditiveMetrics additiveMetricsBeforeAdd = currentAdditiveMetrics;
@@ -92,6 +96,12 @@ TEST(CurOpTest, AddingAdditiveMetricsObjectsTogetherShouldAddFieldsTogether) {
                   *additiveMetricsToAdd.prepareReadConflicts);
     ASSERT_EQ(*currentAdditiveMetrics.writeConflicts,
               *additiveMetricsBeforeAdd.writeConflicts + *additiveMetricsToAdd.writeConflicts);
+    ASSERT_EQ(*currentAdditiveMetrics.sorterBytesSpilled,
+              *additiveMetricsBeforeAdd.sorterBytesSpilled +
+                  *additiveMetricsToAdd.sorterBytesSpilled);
+    ASSERT_EQ(*currentAdditiveMetrics.sorterBytesWritten,
+              *additiveMetricsBeforeAdd.sorterBytesWritten +
+                  *additiveMetricsToAdd.sorterBytesWritten);
 }
 
 TEST(CurOpTest, AddingUninitializedAdditiveMetricsFieldsShouldBeTreatedAsZero) {
@@ -159,6 +169,8 @@ TEST(CurOpTest, AdditiveMetricsFieldsShouldIncrementByN) {
     additiveMetrics.incrementNmoved(1);
     additiveMetrics.incrementNinserted(3);
     additiveMetrics.incrementPrepareReadConflicts(2);
+    additiveMetrics.incrementSorterBytesSpilled(64);
+    additiveMetrics.incrementSorterBytesWritten(32);
 
     ASSERT_EQ(*additiveMetrics.writeConflicts, 2);
     ASSERT_EQ(*additiveMetrics.keysInserted, 7);
@@ -166,6 +178,8 @@ TEST(CurOpTest, AdditiveMetricsFieldsShouldIncrementByN) {
     ASSERT_EQ(*additiveMetrics.nmoved, 1);
     ASSERT_EQ(*additiveMetrics.ninserted, 3);
     ASSERT_EQ(*additiveMetrics.prepareReadConflicts, 8);
+    ASSERT_EQ(*additiveMetrics.sorterBytesSpilled, 64);
+    ASSERT_EQ(*additiveMetrics.sorterBytesWritten, 32);
 }
 
 }  // namespace
@@ -68,6 +68,8 @@ CachedPlanStage::CachedPlanStage(OperationContext* opCtx,
       _plannerParams(params),
       _decisionWorks(decisionWorks) {
     invariant(_collection);
+    _specificStats.planCacheVariant =
+        _collection->infoCache()->getPlanCache()->computeVariant(*_canonicalQuery);
     _children.emplace_back(root);
 }
 
@@ -82,8 +84,11 @@ Status CachedPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     size_t maxWorksBeforeReplan =
         static_cast<size_t>(internalQueryCacheEvictionRatio * _decisionWorks);
 
-    // The trial period ends without replanning if the cached plan produces this many results.
-    size_t numResults = MultiPlanStage::getTrialPeriodNumToReturn(*_canonicalQuery);
+    // The trial period ends without replanning if the cached plan produces this many results. A
+    // short trial only waits for the first one.
+    size_t numResults = (_plannerParams.options & QueryPlannerParams::SHORT_CACHED_PLAN_TRIAL)
+        ? 1U
+        : MultiPlanStage::getTrialPeriodNumToReturn(*_canonicalQuery);
 
     for (size_t i = 0; i < maxWorksBeforeReplan; ++i) {
         // Might need to yield between calls to work due to the timer elapsing.
@@ -69,6 +69,9 @@ CollectionScan::CollectionScan(OperationContext* opCtx,
     _specificStats.direction = params.direction;
     _specificStats.maxTs = params.maxTs;
     invariant(!_params.shouldTrackLatestOplogTimestamp || _params.collection->ns().isOplog());
+    invariant((_params.minRecord.isNull() && _params.maxRecord.isNull()) ||
+              (_params.direction == CollectionScanParams::FORWARD && !_params.tailable &&
+               _params.start.isNull()));
 
     if (params.maxTs) {
         _endConditionBSON = BSON("$gte" << *(params.maxTs));
@@ -137,6 +140,9 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
                     *out = WorkingSetCommon::allocateStatusMember(_workingSet, status);
                     return PlanStage::DEAD;
                 }
+            } else if (!_params.minRecord.isNull()) {
+                // If the cursor cannot seek, read from the beginning and skip to 'minRecord'.
+                _skipToMinRecord = !_cursor->seekAtOrAfter(_params.minRecord);
             }
 
             return PlanStage::NEED_TIME;
@@ -178,7 +184,18 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
         return PlanStage::IS_EOF;
     }
 
+    if (!_params.maxRecord.isNull() && record->id >= _params.maxRecord) {
+        _commonStats.isEOF = true;
+        return PlanStage::IS_EOF;
+    }
+
     _lastSeenId = record->id;
+    if (_skipToMinRecord) {
+        if (record->id < _params.minRecord)
+            return PlanStage::NEED_TIME;
+        _skipToMinRecord = false;
+    }
+
     if (_params.shouldTrackLatestOplogTimestamp) {
         auto status = setLatestOplogEntryTimestamp(*record);
         if (!status.isOK()) {
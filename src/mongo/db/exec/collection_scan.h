@@ -111,6 +111,10 @@ private:
 
     RecordId _lastSeenId;  // Null if nothing has been returned from _cursor yet.
 
+    // Set if _params.minRecord is not null but _cursor could not seek to it, so records before it
+    // are read and dropped.
+    bool _skipToMinRecord = false;
+
     // We allocate a working set member with this id on construction of the stage. It gets used for
     // all fetch requests. This should only be used for passing up the Fetcher for a NEED_YIELD, and
     // should remain in the INVALID state.
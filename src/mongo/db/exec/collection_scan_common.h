@@ -49,6 +49,12 @@ struct CollectionScanParams {
     // not being invalidated before the first call to work(...).
     RecordId start;
 
+    // If not null, a forward scan only returns records with ids at or after 'minRecord' and
+    // before 'maxRecord'. Used to split one collection scan into ranges that can be read
+    // independently; see RecordStore::getRangeSplitPoints().
+    RecordId minRecord;
+    RecordId maxRecord;
+
     // If present, the collection scan will stop and return EOF the first time it sees a document
     // that does not pass the filter and has 'ts' greater than 'maxTs'.
     boost::optional<Timestamp> maxTs;
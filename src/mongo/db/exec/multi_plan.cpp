@@ -45,6 +45,7 @@
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/log.h"
@@ -209,6 +210,7 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
 
     size_t numWorks = getTrialPeriodWorks(getOpCtx(), _collection);
     size_t numResults = getTrialPeriodNumToReturn(*_query);
+    const double pruneRatio = internalQueryPlanEvaluationPruneRatio.load();
 
     // Work the plans, stopping when a plan hits EOF or returns some
     // fixed number of results.
@@ -217,6 +219,14 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
         if (!moreToDo) {
             break;
         }
+
+        if (pruneRatio > 0.0) {
+            pruneDominatedPlans(pruneRatio);
+        }
+    }
+
+    for (auto&& candidate : _candidates) {
+        _specificStats.trialWorks += candidate.root->getCommonStats()->works;
     }
 
     if (_failure) {
@@ -342,7 +352,7 @@ bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolic
 
     for (size_t ix = 0; ix < _candidates.size(); ++ix) {
         CandidatePlan& candidate = _candidates[ix];
-        if (candidate.failed) {
+        if (candidate.failed || candidate.pruned) {
             continue;
         }
 
@@ -410,6 +420,37 @@ bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolic
     return !doneWorking;
 }
 
+void MultiPlanStage::pruneDominatedPlans(double pruneRatio) {
+    const size_t minWorks = internalQueryPlanEvaluationPruneMinWorks.load();
+
+    // Estimate each candidate's productivity the same way the PlanRanker will score it.
+    auto productivity = [](const CandidatePlan& candidate) {
+        const CommonStats* stats = candidate.root->getCommonStats();
+        return static_cast<double>(stats->advanced) / static_cast<double>(stats->works);
+    };
+    auto isEligible = [minWorks](const CandidatePlan& candidate) {
+        return !candidate.failed && !candidate.pruned &&
+            candidate.root->getCommonStats()->works >= minWorks;
+    };
+
+    double bestProductivity = 0.0;
+    for (auto&& candidate : _candidates) {
+        if (isEligible(candidate)) {
+            bestProductivity = std::max(bestProductivity, productivity(candidate));
+        }
+    }
+
+    for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+        CandidatePlan& candidate = _candidates[ix];
+        if (isEligible(candidate) && productivity(candidate) < pruneRatio * bestProductivity) {
+            LOG(5) << "Pruning candidate plan " << ix << " with productivity "
+                   << productivity(candidate) << ", best productivity is " << bestProductivity;
+            candidate.pruned = true;
+            ++_specificStats.candidatesPruned;
+        }
+    }
+}
+
 namespace {
 
 void invalidateHelper(OperationContext* opCtx,
@@ -168,6 +168,14 @@ private:
      */
     bool workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolicy);
 
+    /**
+     * Stops working any candidate whose productivity so far is less than 'pruneRatio' times
+     * that of the most productive candidate still being worked. Only candidates which have been
+     * worked at least 'internalQueryPlanEvaluationPruneMinWorks' times are considered, as are
+     * only the leaders which have.
+     */
+    void pruneDominatedPlans(double pruneRatio);
+
     /**
      * Checks whether we need to perform either a timing-based yield or a yield for a document
      * fetch. If so, then uses 'yieldPolicy' to actually perform the yield.
@@ -190,6 +190,10 @@ struct CachedPlanStats : public SpecificStats {
     }
 
     bool replanned;
+
+    // Which of the query shape's plan variants the cached plan was taken from, if the plan cache
+    // is keeping several variants per shape.
+    boost::optional<size_t> planCacheVariant;
 };
 
 struct CollectionScanStats : public SpecificStats {
@@ -483,6 +487,13 @@ struct MultiPlanStats : public SpecificStats {
     SpecificStats* clone() const final {
         return new MultiPlanStats(*this);
     }
+
+    // The total number of works performed by all candidate plans during the trial period.
+    size_t trialWorks = 0;
+
+    // How many candidate plans were pruned during the trial period for being clearly dominated
+    // by another candidate.
+    size_t candidatesPruned = 0;
 };
 
 struct OrStats : public SpecificStats {
@@ -0,0 +1,106 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/simple_bsonobj_comparator.h"
+#include "mongo/db/index/btree_key_generator.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+namespace {
+
+std::unique_ptr<BtreeKeyGenerator> makeKeyGenerator(const BSONObj& keyPattern) {
+    std::vector<const char*> fieldNames;
+    std::vector<BSONElement> fixed;
+    for (auto&& elem : keyPattern) {
+        fieldNames.push_back(elem.fieldName());
+        fixed.push_back(BSONElement());
+    }
+    return BtreeKeyGenerator::make(IndexDescriptor::IndexVersion::kV2,
+                                   std::move(fieldNames),
+                                   std::move(fixed),
+                                   false /* isSparse */,
+                                   nullptr /* collator */);
+}
+
+void runGetKeys(benchmark::State& state, const BSONObj& keyPattern, const BSONObj& doc) {
+    const auto keyGen = makeKeyGenerator(keyPattern);
+    size_t numKeys = 0;
+    for (auto keepRunning : state) {
+        BSONObjSet keys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+        MultikeyPaths multikeyPaths;
+        keyGen->getKeys(doc, &keys, &multikeyPaths);
+        numKeys += keys.size();
+    }
+    state.SetItemsProcessed(numKeys);
+}
+
+void BM_BtreeKeyGeneratorSingleField(benchmark::State& state) {
+    runGetKeys(state, BSON("a" << 1), BSON("_id" << 1 << "a" << 5 << "b" << "x"));
+}
+
+void BM_BtreeKeyGeneratorCompound(benchmark::State& state) {
+    runGetKeys(state,
+               BSON("a" << 1 << "b.c" << 1 << "d" << -1),
+               BSON("_id" << 1 << "a" << 5 << "b" << BSON("c" << "x") << "d" << 2.5));
+}
+
+/**
+ * Generates keys for a document whose indexed field is an array with the given number of
+ * elements, producing one key per element.
+ */
+void BM_BtreeKeyGeneratorMultikey(benchmark::State& state) {
+    BSONArrayBuilder arr;
+    for (int i = 0; i < state.range(0); i++) {
+        arr.append(i);
+    }
+    runGetKeys(state, BSON("a" << 1 << "b" << 1), BSON("_id" << 1 << "a" << arr.arr() << "b" << 7));
+}
+
+/**
+ * Generates keys for an array of subdocuments indexed on a nested field, the common shape for
+ * indexes over embedded arrays such as {"items.sku": 1}.
+ */
+void BM_BtreeKeyGeneratorMultikeyNested(benchmark::State& state) {
+    BSONArrayBuilder arr;
+    for (int i = 0; i < state.range(0); i++) {
+        arr.append(BSON("sku" << i << "qty" << 1));
+    }
+    runGetKeys(state, BSON("items.sku" << 1), BSON("_id" << 1 << "items" << arr.arr()));
+}
+
+BENCHMARK(BM_BtreeKeyGeneratorSingleField);
+BENCHMARK(BM_BtreeKeyGeneratorCompound);
+BENCHMARK(BM_BtreeKeyGeneratorMultikey)->Arg(10)->Arg(1000);
+BENCHMARK(BM_BtreeKeyGeneratorMultikeyNested)->Arg(10)->Arg(1000);
+
+}  // namespace
+}  // namespace mongo
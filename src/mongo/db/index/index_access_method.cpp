@@ -408,18 +408,23 @@ Status IndexAccessMethod::compact(OperationContext* opCtx) {
 }
 
 std::unique_ptr<IndexAccessMethod::BulkBuilder> IndexAccessMethod::initiateBulk(
-    size_t maxMemoryUsageBytes) {
-    return std::unique_ptr<BulkBuilder>(new BulkBuilder(this, _descriptor, maxMemoryUsageBytes));
+    size_t maxMemoryUsageBytes, size_t numSortThreads) {
+    return std::unique_ptr<BulkBuilder>(
+        new BulkBuilder(this, _descriptor, maxMemoryUsageBytes, numSortThreads));
 }
 
 IndexAccessMethod::BulkBuilder::BulkBuilder(const IndexAccessMethod* index,
                                             const IndexDescriptor* descriptor,
-                                            size_t maxMemoryUsageBytes)
+                                            size_t maxMemoryUsageBytes,
+                                            size_t numSortThreads)
     : _sorter(Sorter::make(
           SortOptions()
               .TempDir(storageGlobalParams.dbpath + "/_tmp")
               .ExtSortAllowed()
-              .MaxMemoryUsageBytes(maxMemoryUsageBytes),
+              .MaxMemoryUsageBytes(maxMemoryUsageBytes)
+              .ParallelSortThreads(numSortThreads)
+              .SpillStats(&_spillStats)
+              .PrefixCompressKeys(),
           BtreeExternalSortComparison(descriptor->keyPattern(), descriptor->version()))),
       _real(index) {}
 
@@ -431,7 +436,24 @@ Status IndexAccessMethod::BulkBuilder::insert(OperationContext* opCtx,
     BSONObjSet keys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
     MultikeyPaths multikeyPaths;
 
-    _real->getKeys(obj, options.getKeysMode, &keys, &multikeyPaths);
+    generateKeys(obj, options, &keys, &multikeyPaths);
+    addKeys(keys, multikeyPaths, loc, numInserted);
+
+    return Status::OK();
+}
+
+void IndexAccessMethod::BulkBuilder::generateKeys(const BSONObj& obj,
+                                                  const InsertDeleteOptions& options,
+                                                  BSONObjSet* keys,
+                                                  MultikeyPaths* multikeyPaths) const {
+    _real->getKeys(obj, options.getKeysMode, keys, multikeyPaths);
+}
+
+void IndexAccessMethod::BulkBuilder::addKeys(const BSONObjSet& keys,
+                                             const MultikeyPaths& multikeyPaths,
+                                             const RecordId& loc,
+                                             int64_t* numInserted) {
+    invariant(!_sorted);
 
     _everGeneratedMultipleKeys = _everGeneratedMultipleKeys || (keys.size() > 1);
 
@@ -446,7 +468,7 @@ Status IndexAccessMethod::BulkBuilder::insert(OperationContext* opCtx,
         }
     }
 
-    for (BSONObjSet::iterator it = keys.begin(); it != keys.end(); ++it) {
+    for (BSONObjSet::const_iterator it = keys.begin(); it != keys.end(); ++it) {
         _sorter->add(*it, loc);
         _keysInserted++;
     }
@@ -454,8 +476,11 @@ Status IndexAccessMethod::BulkBuilder::insert(OperationContext* opCtx,
     if (NULL != numInserted) {
         *numInserted += keys.size();
     }
+}
 
-    return Status::OK();
+void IndexAccessMethod::BulkBuilder::doneInserting() {
+    invariant(!_sorted);
+    _sorted.reset(_sorter->done());
 }
 
 
@@ -466,7 +491,13 @@ Status IndexAccessMethod::commitBulk(OperationContext* opCtx,
                                      set<RecordId>* dupsToDrop) {
     Timer timer;
 
-    std::unique_ptr<BulkBuilder::Sorter::Iterator> it(bulk->_sorter->done());
+    std::unique_ptr<BulkBuilder::Sorter::Iterator> it(
+        bulk->_sorted ? bulk->_sorted.release() : bulk->_sorter->done());
+    if (bulk->_spillStats.bytesSpilled.load()) {
+        auto& metrics = CurOp::get(opCtx)->debug().additiveMetrics;
+        metrics.incrementSorterBytesSpilled(bulk->_spillStats.bytesSpilled.load());
+        metrics.incrementSorterBytesWritten(bulk->_spillStats.bytesWritten.load());
+    }
 
     stdx::unique_lock<Client> lk(*opCtx->getClient());
     ProgressMeterHolder pm(
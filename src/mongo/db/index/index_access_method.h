@@ -210,6 +210,31 @@ public:
                       const InsertDeleteOptions& options,
                       int64_t* numInserted);
 
+        /**
+         * Generates the keys that insert() would add for 'obj'. Does not modify the BulkBuilder,
+         * so it may be called from several threads at once.
+         */
+        void generateKeys(const BSONObj& obj,
+                          const InsertDeleteOptions& options,
+                          BSONObjSet* keys,
+                          MultikeyPaths* multikeyPaths) const;
+
+        /**
+         * Adds keys produced by generateKeys() for the document at 'loc'. Together the two calls
+         * are equivalent to insert().
+         */
+        void addKeys(const BSONObjSet& keys,
+                     const MultikeyPaths& multikeyPaths,
+                     const RecordId& loc,
+                     int64_t* numInserted);
+
+        /**
+         * Sorts the keys inserted so far, which commitBulk() would otherwise do first. Touches
+         * only this BulkBuilder, so the builders of different indexes may sort concurrently. No
+         * keys may be inserted afterwards.
+         */
+        void doneInserting();
+
         const MultikeyPaths& getMultikeyPaths() const {
             return _indexMultikeyPaths;
         }
@@ -223,9 +248,16 @@ public:
 
         BulkBuilder(const IndexAccessMethod* index,
                     const IndexDescriptor* descriptor,
-                    size_t maxMemoryUsageBytes);
+                    size_t maxMemoryUsageBytes,
+                    size_t numSortThreads);
 
+        // Must outlive '_sorter', which reports the data it spills to disk here.
+        SorterSpillStats _spillStats;
         std::unique_ptr<Sorter> _sorter;
+
+        // Set by doneInserting().
+        std::unique_ptr<Sorter::Iterator> _sorted;
+
         const IndexAccessMethod* _real;
         int64_t _keysInserted = 0;
 
@@ -247,8 +279,11 @@ public:
      *
      * maxMemoryUsageBytes: amount of memory consumed before the external sorter starts spilling to
      *                      disk
+     * numSortThreads: threads the external sorter may use to sort and spill keys. 1 keeps all
+     *                 sorting work on the calling thread.
      */
-    std::unique_ptr<BulkBuilder> initiateBulk(size_t maxMemoryUsageBytes);
+    std::unique_ptr<BulkBuilder> initiateBulk(size_t maxMemoryUsageBytes,
+                                              size_t numSortThreads = 1);
 
     /**
      * Call this when you are ready to finish your bulk work.
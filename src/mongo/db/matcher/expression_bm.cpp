@@ -0,0 +1,98 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+
+namespace mongo {
+namespace {
+
+BSONObj exampleDoc() {
+    return fromjson(
+        "{_id: 1, status: 'active', qty: 42, price: 9.99, tags: ['a', 'b', 'c', 'd'],"
+        " customer: {name: 'someone', address: {city: 'Springfield', zip: '12345'}},"
+        " items: [{sku: 1, qty: 2}, {sku: 2, qty: 4}, {sku: 3, qty: 8}]}");
+}
+
+/**
+ * Parses 'filter' and benchmarks matching it against a document shaped like a typical order.
+ */
+void runMatchesBSON(benchmark::State& state, const char* filter) {
+    const BSONObj doc = exampleDoc();
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto expr = uassertStatusOK(MatchExpressionParser::parse(fromjson(filter), expCtx));
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(expr->matchesBSON(doc));
+    }
+}
+
+void BM_MatchesBSONEquality(benchmark::State& state) {
+    runMatchesBSON(state, "{status: 'active'}");
+}
+
+void BM_MatchesBSONRangeConjunction(benchmark::State& state) {
+    runMatchesBSON(state, "{qty: {$gte: 10, $lt: 100}, price: {$lt: 20}}");
+}
+
+void BM_MatchesBSONIn(benchmark::State& state) {
+    runMatchesBSON(state, "{status: {$in: ['new', 'pending', 'active', 'closed']}}");
+}
+
+void BM_MatchesBSONNestedPath(benchmark::State& state) {
+    runMatchesBSON(state, "{'customer.address.city': 'Springfield'}");
+}
+
+void BM_MatchesBSONArrayTraversal(benchmark::State& state) {
+    runMatchesBSON(state, "{'items.qty': 8}");
+}
+
+void BM_MatchesBSONElemMatch(benchmark::State& state) {
+    runMatchesBSON(state, "{items: {$elemMatch: {sku: 3, qty: {$gt: 5}}}}");
+}
+
+void BM_MatchesBSONDisjunction(benchmark::State& state) {
+    runMatchesBSON(state, "{$or: [{status: 'closed'}, {tags: 'z'}, {qty: 42}]}");
+}
+
+BENCHMARK(BM_MatchesBSONEquality);
+BENCHMARK(BM_MatchesBSONRangeConjunction);
+BENCHMARK(BM_MatchesBSONIn);
+BENCHMARK(BM_MatchesBSONNestedPath);
+BENCHMARK(BM_MatchesBSONArrayTraversal);
+BENCHMARK(BM_MatchesBSONElemMatch);
+BENCHMARK(BM_MatchesBSONDisjunction);
+
+}  // namespace
+}  // namespace mongo
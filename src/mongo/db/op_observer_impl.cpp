@@ -44,6 +44,7 @@
 #include "mongo/db/logical_time_validator.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/query/collection_statistics.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplog_entry_gen.h"
 #include "mongo/db/repl/replication_coordinator.h"
@@ -430,6 +431,8 @@ void OpObserverImpl::onInserts(OperationContext* opCtx,
         Scope::storedFuncMod(opCtx);
     } else if (nss.coll() == DurableViewCatalog::viewsCollectionName()) {
         DurableViewCatalog::onExternalChange(opCtx, nss);
+    } else if (nss.isSystemDotStatistics()) {
+        CollectionStatisticsCache::onExternalChange(opCtx);
     } else if (nss == NamespaceString::kServerConfigurationNamespace) {
         // We must check server configuration collection writes for featureCompatibilityVersion
         // document changes.
@@ -496,6 +499,8 @@ void OpObserverImpl::onUpdate(OperationContext* opCtx, const OplogUpdateEntryArg
         Scope::storedFuncMod(opCtx);
     } else if (args.nss.coll() == DurableViewCatalog::viewsCollectionName()) {
         DurableViewCatalog::onExternalChange(opCtx, args.nss);
+    } else if (args.nss.isSystemDotStatistics()) {
+        CollectionStatisticsCache::onExternalChange(opCtx);
     } else if (args.nss == NamespaceString::kServerConfigurationNamespace) {
         // We must check server configuration collection writes for featureCompatibilityVersion
         // document changes.
@@ -554,6 +559,8 @@ void OpObserverImpl::onDelete(OperationContext* opCtx,
         Scope::storedFuncMod(opCtx);
     } else if (nss.coll() == DurableViewCatalog::viewsCollectionName()) {
         DurableViewCatalog::onExternalChange(opCtx, nss);
+    } else if (nss.isSystemDotStatistics()) {
+        CollectionStatisticsCache::onExternalChange(opCtx);
     } else if (nss.isServerConfigurationCollection()) {
         auto _id = deleteState.documentKey["_id"];
         if (_id.type() == BSONType::String &&
@@ -759,6 +766,8 @@ repl::OpTime OpObserverImpl::onDropCollection(OperationContext* opCtx,
 
     if (collectionName.coll() == DurableViewCatalog::viewsCollectionName()) {
         DurableViewCatalog::onExternalChange(opCtx, collectionName);
+    } else if (collectionName.isSystemDotStatistics()) {
+        CollectionStatisticsCache::onExternalChange(opCtx);
     } else if (collectionName == NamespaceString::kSessionTransactionsTableNamespace) {
         SessionCatalog::get(opCtx)->invalidateSessions(opCtx, boost::none);
     }
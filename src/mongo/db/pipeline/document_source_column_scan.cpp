@@ -0,0 +1,224 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source_column_scan.h"
+
+#include <algorithm>
+
+#include "mongo/db/matcher/expression_path.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/value.h"
+
+namespace mongo {
+
+using boost::intrusive_ptr;
+
+constexpr StringData DocumentSourceColumnScan::kStageName;
+
+namespace {
+
+// Number of rows filtered at a time.
+const size_t kBatchSize = 1024;
+
+}  // namespace
+
+DocumentSourceColumnScan::Rows::Rows(std::shared_ptr<const ColumnCache::ColumnSet> columnSet,
+                                     const std::set<std::string>& fieldNames)
+    : columns(std::move(columnSet)) {
+    for (auto&& fieldName : fieldNames) {
+        const ColumnCache::Column* column = columns->getColumn(fieldName);
+        invariant(column);
+        fields.push_back(column);
+    }
+}
+
+DocumentSourceColumnScan::DocumentSourceColumnScan(const intrusive_ptr<ExpressionContext>& expCtx,
+                                                   ColumnCache::View view,
+                                                   const std::set<std::string>& fields,
+                                                   std::unique_ptr<MatchExpression> filter,
+                                                   BSONObj query)
+    : DocumentSource(expCtx),
+      _cached(std::move(view.columns), fields),
+      _changed(std::move(view.changedRows), fields),
+      _changedIds(std::move(view.changedIds)),
+      _filter(std::move(filter)),
+      _query(query.getOwned()) {}
+
+intrusive_ptr<DocumentSourceColumnScan> DocumentSourceColumnScan::create(
+    const intrusive_ptr<ExpressionContext>& expCtx,
+    ColumnCache::View view,
+    const std::set<std::string>& fields,
+    std::unique_ptr<MatchExpression> filter,
+    BSONObj query) {
+    return new DocumentSourceColumnScan(
+        expCtx, std::move(view), fields, std::move(filter), std::move(query));
+}
+
+const char* DocumentSourceColumnScan::getSourceName() const {
+    return kStageName.rawData();
+}
+
+DocumentSource::GetNextResult DocumentSourceColumnScan::getNext() {
+    pExpCtx->checkForInterrupt();
+
+    while (_nextSelectedRow == _selectedRows.size()) {
+        if (_cached.exhausted() && _changed.exhausted()) {
+            return GetNextResult::makeEOF();
+        }
+        filterNextBatch();
+    }
+
+    const size_t row = _selectedRows[_nextSelectedRow++];
+    MutableDocument doc(_batchSource->fields.size());
+    for (auto&& column : _batchSource->fields) {
+        const BSONElement elem = column->at(row);
+        if (!elem.eoo()) {
+            doc.addField(elem.fieldNameStringData(), Value(elem));
+        }
+    }
+    return doc.freeze();
+}
+
+void DocumentSourceColumnScan::filterNextBatch() {
+    const std::vector<RecordId>& cachedIds = _cached.columns->recordIds;
+    const std::vector<RecordId>& changedRowIds = _changed.columns->recordIds;
+
+    // A cached row with the same id as a changed one is skipped, so the changed row may go first.
+    const bool fromChanged = !_changed.exhausted() &&
+        (_cached.exhausted() || changedRowIds[_changed.nextRow] <= cachedIds[_cached.nextRow]);
+    Rows& source = fromChanged ? _changed : _cached;
+    const Rows& other = fromChanged ? _cached : _changed;
+
+    auto begin = source.columns->recordIds.begin() + source.nextRow;
+    auto end = source.columns->recordIds.begin() +
+        std::min(source.columns->numRows, source.nextRow + kBatchSize);
+    if (!other.exhausted()) {
+        const RecordId& otherId = other.columns->recordIds[other.nextRow];
+        end = fromChanged ? std::upper_bound(begin, end, otherId)
+                          : std::lower_bound(begin, end, otherId);
+    }
+    const size_t endRow = end - source.columns->recordIds.begin();
+
+    _selectedRows.clear();
+    for (size_t row = source.nextRow; row < endRow; row++) {
+        if (!fromChanged) {
+            // Skip the cached rows of documents that changed since, which are both sorted.
+            while (_nextChangedId < _changedIds.size() &&
+                   _changedIds[_nextChangedId] < cachedIds[row]) {
+                _nextChangedId++;
+            }
+            if (_nextChangedId < _changedIds.size() &&
+                _changedIds[_nextChangedId] == cachedIds[row]) {
+                continue;
+            }
+        }
+        _selectedRows.push_back(row);
+    }
+    source.nextRow = endRow;
+    _batchSource = &source;
+    _nextSelectedRow = 0;
+
+    if (_filter) {
+        applyFilter(source, _filter.get(), &_selectedRows);
+    }
+}
+
+void DocumentSourceColumnScan::applyFilter(const Rows& source,
+                                           const MatchExpression* expr,
+                                           std::vector<size_t>* rows) const {
+    if (expr->matchType() == MatchExpression::AND) {
+        for (size_t i = 0; i < expr->numChildren() && !rows->empty(); i++) {
+            applyFilter(source, expr->getChild(i), rows);
+        }
+        return;
+    }
+
+    auto pathExpr = dynamic_cast<const PathMatchExpression*>(expr);
+    const ColumnCache::Column* column =
+        pathExpr ? source.columns->getColumn(pathExpr->path()) : nullptr;
+    if (column) {
+        // A predicate on a top-level field can be matched against that field's column alone.
+        // Scalars are matched directly; missing values and arrays go through the path
+        // traversal of a document holding just the field.
+        const bool missingMatches = expr->matchesBSON(BSONObj());
+        auto out = rows->begin();
+        for (size_t row : *rows) {
+            const BSONElement elem = column->at(row);
+            bool matches;
+            if (elem.eoo()) {
+                matches = missingMatches;
+            } else if (elem.type() == Array) {
+                matches = expr->matchesBSON(elem.wrap());
+            } else {
+                matches = expr->matchesSingleElement(elem);
+            }
+            if (matches) {
+                *out++ = row;
+            }
+        }
+        rows->erase(out, rows->end());
+        return;
+    }
+
+    rows->erase(std::remove_if(rows->begin(),
+                               rows->end(),
+                               [&](size_t row) {
+                                   return !expr->matchesBSON(rowToBson(source, row));
+                               }),
+                rows->end());
+}
+
+BSONObj DocumentSourceColumnScan::rowToBson(const Rows& source, size_t row) const {
+    BSONObjBuilder bob;
+    for (auto&& column : source.fields) {
+        const BSONElement elem = column->at(row);
+        if (!elem.eoo()) {
+            bob.append(elem);
+        }
+    }
+    return bob.obj();
+}
+
+Value DocumentSourceColumnScan::serialize(
+    boost::optional<ExplainOptions::Verbosity> explain) const {
+    // Like DocumentSourceCursor, this stage is never parsed, so it only serializes for
+    // diagnostics.
+    if (!explain)
+        return Value();
+
+    return Value(DOC(getSourceName() << DOC(
+                         "query" << _query << "numRows"
+                                 << static_cast<long long>(_cached.columns->numRows)
+                                 << "numChangedRows"
+                                 << static_cast<long long>(_changed.columns->numRows))));
+}
+
+}  // namespace mongo
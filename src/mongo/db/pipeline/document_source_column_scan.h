@@ -0,0 +1,150 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/pipeline/document_source.h"
+#include "mongo/db/query/column_cache.h"
+
+namespace mongo {
+
+/**
+ * Produces one Document per document of a collection from columns held in the collection's
+ * ColumnCache, rather than by scanning the collection. The documents hold only the cached fields a
+ * pipeline depends on, and may be filtered by an initial $match, which is evaluated a batch of rows
+ * and one predicate at a time. Rows changed since the columns were cached are replaced by their
+ * current values, so documents are returned in RecordId order, as a collection scan would.
+ *
+ * This class is not a registered stage; it only replaces the DocumentSourceCursor of pipelines that
+ * can be answered from cached columns.
+ */
+class DocumentSourceColumnScan final : public DocumentSource {
+public:
+    static constexpr StringData kStageName = "$columnScan"_sd;
+
+    /**
+     * Creates a stage returning the values of 'fields' from 'view' for every document matching
+     * 'filter', or for every document if 'filter' is null. 'fields' must be top-level fields held
+     * by the view's columns, and must include every field 'filter' depends on. 'query' is the BSON
+     * form of 'filter', reported by serialize().
+     */
+    static boost::intrusive_ptr<DocumentSourceColumnScan> create(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        ColumnCache::View view,
+        const std::set<std::string>& fields,
+        std::unique_ptr<MatchExpression> filter,
+        BSONObj query);
+
+    GetNextResult getNext() final;
+    const char* getSourceName() const final;
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        StageConstraints constraints(StreamType::kStreaming,
+                                     PositionRequirement::kFirst,
+                                     HostTypeRequirement::kAnyShard,
+                                     DiskUseRequirement::kNoDiskUse,
+                                     FacetRequirement::kNotAllowed,
+                                     TransactionRequirement::kNotAllowed);
+
+        constraints.requiresInputDocSource = false;
+        return constraints;
+    }
+
+private:
+    /**
+     * One of the column sets rows are read from.
+     */
+    struct Rows {
+        Rows(std::shared_ptr<const ColumnCache::ColumnSet> columns,
+             const std::set<std::string>& fields);
+
+        bool exhausted() const {
+            return nextRow == columns->numRows;
+        }
+
+        std::shared_ptr<const ColumnCache::ColumnSet> columns;
+
+        // The columns of the fields to return, in field name order.
+        std::vector<const ColumnCache::Column*> fields;
+
+        // The first row not yet filtered.
+        size_t nextRow = 0;
+    };
+
+    DocumentSourceColumnScan(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                             ColumnCache::View view,
+                             const std::set<std::string>& fields,
+                             std::unique_ptr<MatchExpression> filter,
+                             BSONObj query);
+
+    /**
+     * Fills '_selectedRows' with the rows of the next batch that match the filter. A batch comes
+     * from either the cached or the changed rows, whichever holds the next document in RecordId
+     * order, and stops before the next document of the other.
+     */
+    void filterNextBatch();
+
+    /**
+     * Removes the rows of 'source' that do not match 'expr' from 'rows'.
+     */
+    void applyFilter(const Rows& source,
+                     const MatchExpression* expr,
+                     std::vector<size_t>* rows) const;
+
+    /**
+     * Returns the fields of 'row' as a BSONObj, for predicates that cannot be evaluated on a
+     * single column.
+     */
+    BSONObj rowToBson(const Rows& source, size_t row) const;
+
+    // The rows as of when the columns were cached, and the current values of the documents
+    // changed since then.
+    Rows _cached;
+    Rows _changed;
+
+    // The ids of the cached rows to skip, in increasing order, and the next one to look for.
+    std::vector<RecordId> _changedIds;
+    size_t _nextChangedId = 0;
+
+    std::unique_ptr<MatchExpression> _filter;
+    BSONObj _query;
+
+    // The rows of the current batch that matched the filter, which of '_cached' and '_changed'
+    // they come from, and the next one to return.
+    std::vector<size_t> _selectedRows;
+    const Rows* _batchSource = nullptr;
+    size_t _nextSelectedRow = 0;
+};
+
+}  // namespace mongo
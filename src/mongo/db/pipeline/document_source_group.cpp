@@ -28,6 +28,9 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
+
+#include "mongo/db/curop.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/accumulator.h"
@@ -38,6 +41,7 @@
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/stdx/memory.h"
 
 namespace mongo {
@@ -70,7 +74,9 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNext() {
         accum->reset();  // Prep accumulators for a new group.
     }
 
-    if (_spilled) {
+    if (_partitioned) {
+        return getNextPartitioned();
+    } else if (_spilled) {
         return getNextSpilled();
     } else if (_streaming) {
         return getNextStreaming();
@@ -103,7 +109,12 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
         }
 
         if (!_sorterIterator->more()) {
-            dispose();
+            if (_partitioned) {
+                // Move on to the next partition.
+                _sorterIterator.reset();
+            } else {
+                dispose();
+            }
             break;
         }
 
@@ -126,6 +137,25 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
     return std::move(out);
 }
 
+DocumentSource::GetNextResult DocumentSourceGroup::getNextPartitioned() {
+    // Output one partition at a time. A partition is either a hash table of complete groups, or a
+    // sorted stream of partial groups that are merged like those of a spilled $group.
+    while (!_sorterIterator && groupsIterator == _groups->end()) {
+        if (!loadNextPartition()) {
+            dispose();
+            return GetNextResult::makeEOF();
+        }
+    }
+
+    if (_sorterIterator) {
+        return getNextSpilled();
+    }
+
+    Document out = makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->needsMerge);
+    ++groupsIterator;
+    return std::move(out);
+}
+
 DocumentSource::GetNextResult DocumentSourceGroup::getNextStreaming() {
     // Streaming optimization is active.
     if (!_firstDocOfNextGroup) {
@@ -166,6 +196,13 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextStreaming() {
 
 void DocumentSourceGroup::doDispose() {
     // Free our resources.
+    _pendingPartitions.clear();  // Waits for any partitions still being merged.
+    for (auto&& partition : _partitions) {
+        // Only the statistics of the partitions are kept, for explain.
+        partition->groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
+        partition->writer.reset();
+    }
+    _nextPartition = _partitions.size();
     _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
     _sorterIterator.reset();
 
@@ -224,6 +261,20 @@ Value DocumentSourceGroup::serialize(boost::optional<ExplainOptions::Verbosity>
     if (explain && findRelevantInputSort()) {
         return Value(DOC("$streamingGroup" << insides.freeze()));
     }
+
+    if (explain && *explain >= ExplainOptions::Verbosity::kExecStats && !_partitions.empty()) {
+        vector<Value> partitions;
+        partitions.reserve(_partitions.size());
+        for (auto&& partition : _partitions) {
+            partitions.push_back(Value(DOC(
+                "peakMemoryUsageBytes" << static_cast<long long>(partition->peakMemoryUsageBytes)
+                                       << "spills"
+                                       << partition->numSpills
+                                       << "spilledBytes"
+                                       << partition->spillStats.bytesSpilled.load())));
+        }
+        return Value(DOC(getSourceName() << insides.freeze() << "partitions" << partitions));
+    }
     return Value(DOC(getSourceName() << insides.freeze()));
 }
 
@@ -385,6 +436,55 @@ private:
     ValueComparator _valueComparator;
 };
 
+/**
+ * Returns the partial state of a group's accumulators the way spilled groups store it: nothing
+ * if there are no accumulators, the Value of a single accumulator, and an array otherwise.
+ */
+Value serializePartialGroup(const DocumentSourceGroup::Accumulators& accumulators) {
+    switch (accumulators.size()) {
+        case 0:
+            return Value();
+        case 1:
+            return accumulators[0]->getValue(/*toBeMerged=*/true);
+        default: {
+            vector<Value> accums;
+            accums.reserve(accumulators.size());
+            for (auto&& accumulator : accumulators) {
+                accums.push_back(accumulator->getValue(/*toBeMerged=*/true));
+            }
+            return Value(std::move(accums));
+        }
+    }
+}
+
+/**
+ * Merges partial state produced by serializePartialGroup() into 'accumulators'.
+ */
+void mergePartialGroup(const Value& partialGroup,
+                       const DocumentSourceGroup::Accumulators& accumulators) {
+    switch (accumulators.size()) {
+        case 0:
+            break;
+        case 1:
+            accumulators[0]->process(partialGroup, true);
+            break;
+        default: {
+            const vector<Value>& accumulatorStates = partialGroup.getArray();
+            for (size_t i = 0; i < accumulators.size(); i++) {
+                accumulators[i]->process(accumulatorStates[i], true);
+            }
+        }
+    }
+}
+
+size_t getMemoryUsage(const DocumentSourceGroup::Accumulators& accumulators) {
+    size_t memoryUsageBytes = 0;
+    for (auto&& accumulator : accumulators) {
+        memoryUsageBytes += accumulator->memUsageForSorter();
+    }
+    return memoryUsageBytes;
+}
+
 bool containsOnlyFieldPathsAndConstants(ExpressionObject* expressionObj) {
     for (auto&& it : expressionObj->getChildExpressions()) {
         const intrusive_ptr<Expression>& childExp = it.second;
@@ -478,7 +578,8 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
     }
 
 
-    // Barring any pausing, this loop exhausts 'pSource' and populates '_groups'.
+    // Barring any pausing, this loop exhausts 'pSource' and populates '_groups', or '_partitions'
+    // once the groups have been partitioned.
     GetNextResult input = pSource->getNext();
     for (; input.isAdvanced(); input = pSource->getNext()) {
         if (_memoryUsageBytes > _maxMemoryUsageBytes) {
@@ -486,8 +587,17 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
                     "Exceeded memory limit for $group, but didn't allow external sort."
                     " Pass allowDiskUse:true to opt in.",
                     _allowDiskUse);
-            _sortedFiles.push_back(spill());
-            _memoryUsageBytes = 0;
+            const int numPartitions = internalDocumentSourceGroupHashPartitions.load();
+            if (_partitions.empty() && _sortedFiles.empty() && numPartitions > 0) {
+                partitionGroups(numPartitions);
+            }
+
+            if (!_partitions.empty()) {
+                spillLargestPartitions();
+            } else {
+                _sortedFiles.push_back(spill());
+                _memoryUsageBytes = 0;
+            }
         }
 
         // We release the result document here so that it does not outlive the end of this loop
@@ -495,12 +605,16 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         auto rootDocument = input.releaseDocument();
         Value id = computeId(rootDocument);
 
+        Partition* partition = _partitions.empty() ? nullptr : getPartition(id);
+        GroupsMap& groups = partition ? partition->groups : *_groups;
+        const size_t oldMemoryUsageBytes = _memoryUsageBytes;
+
         // Look for the _id value in the map. If it's not there, add a new entry with a blank
         // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
-        // looking it up in '_groups' multiple times.
-        const size_t oldSize = _groups->size();
-        vector<intrusive_ptr<Accumulator>>& group = (*_groups)[id];
-        const bool inserted = _groups->size() != oldSize;
+        // looking it up in 'groups' multiple times.
+        const size_t oldSize = groups.size();
+        vector<intrusive_ptr<Accumulator>>& group = groups[id];
+        const bool inserted = groups.size() != oldSize;
 
         if (inserted) {
             _memoryUsageBytes += id.getApproximateSize();
@@ -527,6 +641,13 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
             _memoryUsageBytes += group[i]->memUsageForSorter();
         }
 
+        if (partition) {
+            // The difference is correct even if the group shrank, since size_t arithmetic wraps.
+            partition->memoryUsageBytes += _memoryUsageBytes - oldMemoryUsageBytes;
+            partition->peakMemoryUsageBytes =
+                std::max(partition->peakMemoryUsageBytes, partition->memoryUsageBytes);
+        }
+
         if (kDebugBuild && !storageGlobalParams.readOnly) {
             // In debug mode, spill every time we have a duplicate id to stress merge logic.
             if (!inserted &&                 // is a dup
@@ -548,7 +669,21 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         }
         case DocumentSource::GetNextResult::ReturnStatus::kEOF: {
             // Do any final steps necessary to prepare to output results.
-            if (!_sortedFiles.empty()) {
+            if (!_partitions.empty()) {
+                _partitioned = true;
+                _numPartitionThreads = internalDocumentSourceGroupPartitionThreads.load();
+
+                // Partitions are moved into '_groups' one at a time as they are output.
+                _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
+                groupsIterator = _groups->end();
+
+                // Prepare current to merge the partial groups of partitions that don't fit in
+                // memory.
+                _currentAccumulators.reserve(numAccumulators);
+                for (auto&& accumulatedField : _accumulatedFields) {
+                    _currentAccumulators.push_back(accumulatedField.makeAccumulator(pExpCtx));
+                }
+            } else if (!_sortedFiles.empty()) {
                 _spilled = true;
                 if (!_groups->empty()) {
                     _sortedFiles.push_back(spill());
@@ -591,7 +726,9 @@ shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
 
     stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator(pExpCtx->getValueComparator()));
 
-    SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir));
+    SorterSpillStats spillStats;
+    SortedFileWriter<Value, Value> writer(
+        SortOptions().TempDir(pExpCtx->tempDir).SpillStats(&spillStats));
     switch (_accumulatedFields.size()) {  // same as ptrs[i]->second.size() for all i.
         case 0:                           // no values, essentially a distinct
             for (size_t i = 0; i < ptrs.size(); i++) {
@@ -619,7 +756,184 @@ shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
 
     _groups->clear();
 
-    return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
+    shared_ptr<Sorter<Value, Value>::Iterator> iterator(writer.done());
+    if (pExpCtx->opCtx) {
+        auto& metrics = CurOp::get(pExpCtx->opCtx)->debug().additiveMetrics;
+        metrics.incrementSorterBytesSpilled(spillStats.bytesSpilled.load());
+        metrics.incrementSorterBytesWritten(spillStats.bytesWritten.load());
+    }
+    return iterator;
+}
+
+void DocumentSourceGroup::partitionGroups(size_t numPartitions) {
+    invariant(_partitions.empty());
+    _partitions.reserve(numPartitions);
+    for (size_t i = 0; i < numPartitions; i++) {
+        _partitions.push_back(stdx::make_unique<Partition>(
+            pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>()));
+    }
+
+    for (auto&& group : *_groups) {
+        Partition* partition = getPartition(group.first);
+        partition->memoryUsageBytes +=
+            group.first.getApproximateSize() + getMemoryUsage(group.second);
+        partition->groups.emplace(group.first, std::move(group.second));
+    }
+    for (auto&& partition : _partitions) {
+        partition->peakMemoryUsageBytes = partition->memoryUsageBytes;
+    }
+
+    _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
+}
+
+DocumentSourceGroup::Partition* DocumentSourceGroup::getPartition(const Value& id) const {
+    // Scramble the hash and pick the partition from its high bits. Hashes of small numbers only
+    // differ in their high bits, and the partition shouldn't correlate with the bucket 'id' falls
+    // into within the partition's own hash table.
+    const uint64_t hash = (pExpCtx->getValueComparator().hash(id) * 0x9E3779B97F4A7C15ULL) >> 32;
+    return _partitions[(hash * _partitions.size()) >> 32].get();
+}
+
+void DocumentSourceGroup::spillLargestPartitions() {
+    // Spilling down to half of the limit, rather than just below it, keeps the partitions from
+    // being flushed in small pieces over and over.
+    while (_memoryUsageBytes > _maxMemoryUsageBytes / 2) {
+        auto largest = std::max_element(
+            _partitions.begin(), _partitions.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs->memoryUsageBytes < rhs->memoryUsageBytes;
+            });
+        Partition* partition = largest->get();
+        if (partition->groups.empty()) {
+            break;
+        }
+
+        if (!partition->writer) {
+            partition->writer = stdx::make_unique<SortedFileWriter<Value, Value>>(
+                SortOptions().TempDir(pExpCtx->tempDir).SpillStats(&partition->spillStats));
+        }
+
+        // The partial groups don't need to be sorted, since finalizePartition() merges them in a
+        // hash table and only sorts them itself if that doesn't fit in memory.
+        for (auto&& group : partition->groups) {
+            partition->writer->addAlreadySorted(group.first, serializePartialGroup(group.second));
+        }
+
+        partition->groups.clear();
+        _memoryUsageBytes -= partition->memoryUsageBytes;
+        partition->memoryUsageBytes = 0;
+        partition->numSpills++;
+    }
+}
+
+bool DocumentSourceGroup::loadNextPartition() {
+    if (_nextPartition == _partitions.size()) {
+        return false;
+    }
+
+    Partition* partition = _partitions[_nextPartition++].get();
+    if (partition->numSpills == 0) {
+        // Every group of this partition is complete and in memory.
+        _groups = std::move(partition->groups);
+        groupsIterator = _groups->begin();
+        partition->groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
+        return true;
+    }
+
+    FinalizedPartition finalized = takeFinalizedPartition();
+    if (pExpCtx->opCtx) {
+        auto& metrics = CurOp::get(pExpCtx->opCtx)->debug().additiveMetrics;
+        metrics.incrementSorterBytesSpilled(partition->spillStats.bytesSpilled.load());
+        metrics.incrementSorterBytesWritten(partition->spillStats.bytesWritten.load());
+    }
+
+    if (finalized.groups) {
+        _groups = std::move(*finalized.groups);
+        groupsIterator = _groups->begin();
+    } else if (finalized.sorted->more()) {
+        _sorterIterator = std::move(finalized.sorted);
+        _firstPartOfNextGroup = _sorterIterator->next();
+    }
+    return true;
+}
+
+DocumentSourceGroup::FinalizedPartition DocumentSourceGroup::takeFinalizedPartition() {
+    if (_numPartitionThreads <= 1) {
+        return finalizePartition(_partitions[_nextPartition - 1].get(), _maxMemoryUsageBytes);
+    }
+
+    // Keep up to '_numPartitionThreads' spilled partitions merging, starting with the one being
+    // taken. Each of them gets an equal share of the memory limit.
+    const size_t maxMemoryUsageBytes = _maxMemoryUsageBytes / _numPartitionThreads;
+    _nextPartitionToFinalize = std::max(_nextPartitionToFinalize, _nextPartition - 1);
+    while (_pendingPartitions.size() < _numPartitionThreads &&
+           _nextPartitionToFinalize < _partitions.size()) {
+        Partition* partition = _partitions[_nextPartitionToFinalize++].get();
+        if (partition->numSpills == 0) {
+            continue;
+        }
+        _pendingPartitions.push_back(
+            stdx::async(stdx::launch::async, [this, partition, maxMemoryUsageBytes] {
+                return finalizePartition(partition, maxMemoryUsageBytes);
+            }));
+    }
+
+    invariant(!_pendingPartitions.empty());
+    FinalizedPartition finalized = _pendingPartitions.front().get();
+    _pendingPartitions.pop_front();
+    return finalized;
+}
+
+DocumentSourceGroup::FinalizedPartition DocumentSourceGroup::finalizePartition(
+    Partition* partition, size_t maxMemoryUsageBytes) const {
+    GroupsMap groups = std::move(partition->groups);
+    size_t memoryUsageBytes = partition->memoryUsageBytes;
+    std::unique_ptr<Sorter<Value, Value>::Iterator> partialGroups(partition->writer->done());
+    partition->writer.reset();
+
+    while (partialGroups->more() && memoryUsageBytes <= maxMemoryUsageBytes) {
+        auto partialGroup = partialGroups->next();
+
+        const size_t oldSize = groups.size();
+        Accumulators& group = groups[partialGroup.first];
+        if (groups.size() != oldSize) {
+            memoryUsageBytes += partialGroup.first.getApproximateSize();
+            group.reserve(_accumulatedFields.size());
+            for (auto&& accumulatedField : _accumulatedFields) {
+                group.push_back(accumulatedField.makeAccumulator(pExpCtx));
+            }
+        } else {
+            memoryUsageBytes -= getMemoryUsage(group);
+        }
+
+        mergePartialGroup(partialGroup.second, group);
+        memoryUsageBytes += getMemoryUsage(group);
+    }
+
+    FinalizedPartition finalized;
+    if (!partialGroups->more()) {
+        finalized.groups = std::move(groups);
+        return finalized;
+    }
+
+    // The partition's groups don't fit in memory, so sort all of its partial groups instead. The
+    // caller merges partial groups with the same key as they come out of the sorter.
+    std::unique_ptr<Sorter<Value, Value>> sorter(
+        Sorter<Value, Value>::make(SortOptions()
+                                       .TempDir(pExpCtx->tempDir)
+                                       .ExtSortAllowed()
+                                       .MaxMemoryUsageBytes(maxMemoryUsageBytes)
+                                       .SpillStats(&partition->spillStats),
+                                   SorterComparator(pExpCtx->getValueComparator())));
+    for (auto it = groups.begin(); it != groups.end(); it = groups.erase(it)) {
+        sorter->add(it->first, serializePartialGroup(it->second));
+    }
+    while (partialGroups->more()) {
+        auto partialGroup = partialGroups->next();
+        sorter->add(partialGroup.first, partialGroup.second);
+    }
+
+    finalized.sorted.reset(sorter->done());
+    return finalized;
 }
 
 boost::optional<BSONObj> DocumentSourceGroup::findRelevantInputSort() const {
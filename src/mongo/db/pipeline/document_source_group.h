@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <utility>
 
@@ -35,6 +36,7 @@
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/sorter/sorter.h"
+#include "mongo/stdx/future.h"
 
 namespace mongo {
 
@@ -107,17 +109,45 @@ protected:
     void doDispose() final;
 
 private:
+    /**
+     * One hash partition of the groups. Once a $group that is allowed to use the disk exceeds its
+     * memory limit, its groups are split into partitions by the hash of their key, and only the
+     * largest partitions have their partial groups flushed to disk when memory runs out again.
+     */
+    struct Partition {
+        explicit Partition(GroupsMap groupsMap) : groups(std::move(groupsMap)) {}
+
+        GroupsMap groups;
+        size_t memoryUsageBytes = 0;
+        size_t peakMemoryUsageBytes = 0;
+        int numSpills = 0;
+
+        // Partial groups flushed to disk, in no particular order. Set by the first spill.
+        std::unique_ptr<SortedFileWriter<Value, Value>> writer;
+        SorterSpillStats spillStats;
+    };
+
+    /**
+     * The groups of a spilled partition once its partial groups have been merged, either in a hash
+     * table or, if that did not fit in memory, as a stream of partial groups sorted by key.
+     */
+    struct FinalizedPartition {
+        boost::optional<GroupsMap> groups;
+        std::unique_ptr<Sorter<Value, Value>::Iterator> sorted;
+    };
+
     explicit DocumentSourceGroup(const boost::intrusive_ptr<ExpressionContext>& pExpCtx,
                                  size_t maxMemoryUsageBytes = kDefaultMaxMemoryUsageBytes);
 
     /**
-     * getNext() dispatches to one of these three depending on what type of $group it is. All three
+     * getNext() dispatches to one of these four depending on what type of $group it is. All four
      * of these methods expect '_currentAccumulators' to have been reset before being called, and
      * also expect initialize() to have been called already.
      */
     GetNextResult getNextStreaming();
     GetNextResult getNextSpilled();
     GetNextResult getNextStandard();
+    GetNextResult getNextPartitioned();
 
     /**
      * Attempt to identify an input sort order that allows us to turn into a streaming $group. If we
@@ -144,6 +174,36 @@ private:
      */
     std::shared_ptr<Sorter<Value, Value>::Iterator> spill();
 
+    /**
+     * Splits '_groups' into 'numPartitions' hash partitions. All groups are kept in the partitions
+     * from then on.
+     */
+    void partitionGroups(size_t numPartitions);
+
+    /**
+     * Flushes the largest partitions to disk until at most half of the memory limit is in use.
+     */
+    void spillLargestPartitions();
+
+    Partition* getPartition(const Value& id) const;
+
+    /**
+     * Moves on to the next partition to output, returning false if there are none left.
+     */
+    bool loadNextPartition();
+
+    /**
+     * Returns the next spilled partition merged, starting to merge the ones after it on other
+     * threads if 'internalDocumentSourceGroupPartitionThreads' allows it.
+     */
+    FinalizedPartition takeFinalizedPartition();
+
+    /**
+     * Merges the partial groups 'partition' spilled with the groups it still holds in memory. Only
+     * reads state that doesn't change once the input is exhausted, so it may run on any thread.
+     */
+    FinalizedPartition finalizePartition(Partition* partition, size_t maxMemoryUsageBytes) const;
+
     Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
     /**
@@ -183,13 +243,26 @@ private:
     // Only used when '_spilled' is false.
     GroupsMap::iterator groupsIterator;
 
-    // Only used when '_spilled' is true.
+    // Only used when '_spilled' is true, or when '_partitioned' is true and the current partition
+    // did not fit in memory.
     std::unique_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
     const bool _allowDiskUse;
 
+    // Set once the groups have been split into '_partitions'. Unlike a $group that has '_spilled',
+    // a partitioned $group does not output its groups in sorted order.
+    bool _partitioned = false;
+    std::vector<std::unique_ptr<Partition>> _partitions;
+    size_t _numPartitionThreads = 1;
+    size_t _nextPartition = 0;            // The next partition to output.
+    size_t _nextPartitionToFinalize = 0;  // The next partition to consider merging ahead.
+
     std::pair<Value, Value> _firstPartOfNextGroup;
     // Only used when '_sorted' is true.
     boost::optional<Document> _firstDocOfNextGroup;
+
+    // Spilled partitions being merged on other threads, in partition order. Declared last so that
+    // it waits for them before anything they use is destroyed.
+    std::deque<stdx::future<FinalizedPartition>> _pendingPartitions;
 };
 
 }  // namespace mongo
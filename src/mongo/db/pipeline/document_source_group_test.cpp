@@ -47,12 +47,14 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_test_service_context.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/stdx/unordered_set.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -189,6 +191,103 @@ TEST_F(DocumentSourceGroupTest, ShouldCorrectlyTrackMemoryUsageBetweenPauses) {
     ASSERT_THROWS_CODE(group->getNext(), AssertionException, 16945);
 }
 
+/**
+ * Groups 'numKeys' distinct keys, each of which appears three times, with a memory limit that is
+ * far too small for all of the groups. Checks the results and returns the $group's explain output.
+ */
+Document runSpillingGroup(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                          int numKeys,
+                          int numPartitions,
+                          int numPartitionThreads) {
+    const int oldNumPartitions = internalDocumentSourceGroupHashPartitions.load();
+    const int oldNumPartitionThreads = internalDocumentSourceGroupPartitionThreads.load();
+    internalDocumentSourceGroupHashPartitions.store(numPartitions);
+    internalDocumentSourceGroupPartitionThreads.store(numPartitionThreads);
+    ON_BLOCK_EXIT([&] {
+        internalDocumentSourceGroupHashPartitions.store(oldNumPartitions);
+        internalDocumentSourceGroupPartitionThreads.store(oldNumPartitionThreads);
+    });
+
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    const size_t maxMemoryUsageBytes = 16 * 1024;
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement countStatement{"count",
+                                         ExpressionConstant::create(expCtx, Value(1)),
+                                         AccumulationStatement::getFactory("$sum")};
+    AccumulationStatement pushStatement{"strs",
+                                        ExpressionFieldPath::parse(expCtx, "$str", vps),
+                                        AccumulationStatement::getFactory("$push")};
+    auto group = DocumentSourceGroup::create(expCtx,
+                                             ExpressionFieldPath::parse(expCtx, "$_id", vps),
+                                             {countStatement, pushStatement},
+                                             maxMemoryUsageBytes);
+
+    deque<DocumentSource::GetNextResult> inputs;
+    const string str(64, 'x');
+    for (int round = 0; round < 3; round++) {
+        for (int key = 0; key < numKeys; key++) {
+            inputs.emplace_back(Document{{"_id", key}, {"str", str}});
+        }
+    }
+    auto mock = DocumentSourceMock::create(inputs);
+    group->setSource(mock.get());
+
+    std::vector<int> seen(numKeys, 0);
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        const int key = doc["_id"].coerceToInt();
+        ASSERT_GTE(key, 0);
+        ASSERT_LT(key, numKeys);
+        seen[key]++;
+        ASSERT_EQ(doc["count"].coerceToInt(), 3);
+        ASSERT_EQ(doc["strs"].getArrayLength(), 3UL);
+    }
+    ASSERT_TRUE(group->getNext().isEOF());
+    for (int key = 0; key < numKeys; key++) {
+        ASSERT_EQ(seen[key], 1);
+    }
+
+    return group->serialize(ExplainOptions::Verbosity::kExecStats).getDocument();
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldOnlySpillLargestHashPartitions) {
+    auto explain = runSpillingGroup(getExpCtx(), 50, 16, 1);
+
+    // Only some of the partitions needed to be flushed to disk.
+    const vector<Value>& partitions = explain["partitions"].getArray();
+    ASSERT_EQ(partitions.size(), 16UL);
+    int numSpilledPartitions = 0;
+    for (auto&& partition : partitions) {
+        if (partition["spills"].coerceToInt() > 0) {
+            ASSERT_GT(partition["peakMemoryUsageBytes"].coerceToLong(), 0);
+            ASSERT_GT(partition["spilledBytes"].coerceToLong(), 0);
+            numSpilledPartitions++;
+        }
+    }
+    ASSERT_GT(numSpilledPartitions, 0);
+    ASSERT_LT(numSpilledPartitions, 16);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldMergeSpilledHashPartitionsOnMultipleThreads) {
+    auto explain = runSpillingGroup(getExpCtx(), 1000, 16, 4);
+    ASSERT_EQ(explain["partitions"].getArrayLength(), 16UL);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldSortHashPartitionThatDoesNotFitInMemory) {
+    // A single partition has to hold every group, so merging it falls back to sorting.
+    auto explain = runSpillingGroup(getExpCtx(), 1000, 1, 1);
+    ASSERT_EQ(explain["partitions"].getArrayLength(), 1UL);
+    ASSERT_GT(explain["partitions"][0]["spills"].coerceToInt(), 1);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldSpillSortedRunsWithoutHashPartitions) {
+    auto explain = runSpillingGroup(getExpCtx(), 1000, 0, 1);
+    ASSERT_TRUE(explain["partitions"].missing());
+}
+
 BSONObj toBson(const intrusive_ptr<DocumentSource>& source) {
     vector<Value> arr;
     source->serializeToArray(arr);
@@ -40,6 +40,7 @@
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/util/stringutils.h"
 
 namespace mongo {
 
@@ -47,6 +48,18 @@ using boost::intrusive_ptr;
 using std::vector;
 
 namespace {
+StringData joinStrategyToString(DocumentSourceLookUp::JoinStrategy strategy) {
+    switch (strategy) {
+        case DocumentSourceLookUp::JoinStrategy::kNestedLoop:
+            return "nestedLoop"_sd;
+        case DocumentSourceLookUp::JoinStrategy::kBatchedNestedLoop:
+            return "batchedNestedLoop"_sd;
+        case DocumentSourceLookUp::JoinStrategy::kHashJoin:
+            return "hashJoin"_sd;
+    }
+    MONGO_UNREACHABLE;
+}
+
 std::string pipelineToString(const vector<BSONObj>& pipeline) {
     StringBuilder sb;
     sb << "[";
@@ -66,6 +79,7 @@ std::string pipelineToString(const vector<BSONObj>& pipeline) {
 }  // namespace
 
 constexpr size_t DocumentSourceLookUp::kMaxSubPipelineDepth;
+constexpr size_t DocumentSourceLookUp::kHashJoinPartitions;
 
 DocumentSourceLookUp::DocumentSourceLookUp(NamespaceString fromNs,
                                            std::string as,
@@ -210,7 +224,8 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
         return unwindResult();
     }
 
-    auto nextInput = pSource->getNext();
+    boost::optional<std::vector<Document>> joinedMatches;
+    auto nextInput = getNextJoinedInput(&joinedMatches);
     if (!nextInput.isAdvanced()) {
         return nextInput;
     }
@@ -221,27 +236,36 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
 
-    if (!wasConstructedWithPipelineSyntax()) {
-        auto matchStage =
-            makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
-        // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-        _resolvedPipeline.back() = matchStage;
-    }
-
-    auto pipeline = buildPipeline(inputDoc);
-
     std::vector<Value> results;
     int objsize = 0;
 
-    while (auto result = pipeline->getNext()) {
-        objsize += result->getApproximateSize();
+    auto appendResult = [&](Document result) {
+        objsize += result.getApproximateSize();
         uassert(4568,
                 str::stream() << "Total size of documents in " << _fromNs.coll()
                               << " matching pipeline "
-                              << getUserPipelineDefinition()
+                              << getUserPipelineDefinition(inputDoc)
                               << " exceeds maximum document size",
                 objsize <= BSONObjMaxInternalSize);
-        results.emplace_back(std::move(*result));
+        results.emplace_back(std::move(result));
+    };
+
+    if (joinedMatches) {
+        for (auto&& result : *joinedMatches) {
+            appendResult(std::move(result));
+        }
+    } else {
+        if (!wasConstructedWithPipelineSyntax()) {
+            auto matchStage = makeMatchStageFromInput(
+                inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
+            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
+            _resolvedPipeline.back() = matchStage;
+        }
+
+        auto pipeline = buildPipeline(inputDoc);
+        while (auto result = pipeline->getNext()) {
+            appendResult(std::move(*result));
+        }
     }
 
     MutableDocument output(std::move(inputDoc));
@@ -420,12 +444,13 @@ Pipeline::SourceContainer::iterator DocumentSourceLookUp::doOptimizeAt(
     return itr;
 }
 
-std::string DocumentSourceLookUp::getUserPipelineDefinition() {
+std::string DocumentSourceLookUp::getUserPipelineDefinition(const Document& inputDoc) {
     if (wasConstructedWithPipelineSyntax()) {
         return pipelineToString(_userPipeline);
     }
 
-    return _resolvedPipeline.back().toString();
+    return makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj())
+        .toString();
 }
 
 void DocumentSourceLookUp::doDispose() {
@@ -433,6 +458,209 @@ void DocumentSourceLookUp::doDispose() {
         _pipeline->dispose(pExpCtx->opCtx);
         _pipeline.reset();
     }
+    _joinedMatches.clear();
+    _joinedInputs.clear();
+}
+
+DocumentSourceLookUp::JoinStrategy DocumentSourceLookUp::getJoinStrategy() const {
+    invariant(!wasConstructedWithPipelineSyntax());
+    return _joinStrategy ? *_joinStrategy : chooseJoinStrategy();
+}
+
+DocumentSourceLookUp::JoinStrategy DocumentSourceLookUp::chooseJoinStrategy() const {
+    if (wasConstructedWithPipelineSyntax()) {
+        return JoinStrategy::kNestedLoop;
+    }
+
+    // Both hash and batched joins match foreign documents to input documents themselves. A query
+    // treats numeric components of 'foreignField' as array positions as well as field names, which
+    // they do not model.
+    for (size_t i = 1; i < _foreignField->getPathLength(); ++i) {
+        if (parseUnsignedBase10Integer(_foreignField->getFieldName(i))) {
+            return JoinStrategy::kNestedLoop;
+        }
+    }
+
+    const long long maxBytes = internalDocumentSourceLookupHashJoinMaxBytes.load();
+    if (maxBytes > 0) {
+        const auto dataSize =
+            pExpCtx->mongoProcessInterface->getCollectionDataSize(pExpCtx->opCtx, _resolvedNs);
+        if (dataSize && *dataSize <= maxBytes &&
+            !pExpCtx->mongoProcessInterface->hasIndexForEqualityMatch(
+                pExpCtx->opCtx, _resolvedNs, *_foreignField, _fromExpCtx->getCollator())) {
+            return JoinStrategy::kHashJoin;
+        }
+    }
+    return chooseNestedLoopJoinStrategy();
+}
+
+DocumentSourceLookUp::JoinStrategy DocumentSourceLookUp::chooseNestedLoopJoinStrategy() {
+    return internalDocumentSourceLookupBatchSize.load() > 1 ? JoinStrategy::kBatchedNestedLoop
+                                                            : JoinStrategy::kNestedLoop;
+}
+
+void DocumentSourceLookUp::initializeJoinStrategy() {
+    if (_joinStrategy) {
+        return;
+    }
+
+    _joinStrategy = chooseJoinStrategy();
+    if (*_joinStrategy == JoinStrategy::kHashJoin) {
+        buildHashTable();
+    }
+}
+
+void DocumentSourceLookUp::buildHashTable() {
+    invariant(!_hashTable);
+
+    // Scan the foreign collection through any view pipeline, leaving out the placeholder for the
+    // per-document $match, but applying any $match absorbed from after an $unwind.
+    std::vector<BSONObj> scanPipeline(_resolvedPipeline.begin(),
+                                      std::prev(_resolvedPipeline.end()));
+    if (_additionalFilter) {
+        scanPipeline.push_back(BSON("$match" << *_additionalFilter));
+    }
+    auto pipeline =
+        uassertStatusOK(pExpCtx->mongoProcessInterface->makePipeline(scanPipeline, _fromExpCtx));
+
+    _hashTable.emplace(_fromExpCtx->getValueComparator(),
+                       kHashJoinPartitions,
+                       internalDocumentSourceLookupHashJoinMaxBytes.load());
+    while (auto next = pipeline->getNext()) {
+        _hashTable->insert(*next, *_foreignField);
+
+        // Most keys would have to be joined by querying the foreign collection anyway, so stop
+        // scanning it.
+        if (_hashTable->numEvictedPartitions() * 2 > _hashTable->numPartitions()) {
+            _hashTable.reset();
+            _joinStrategy = chooseNestedLoopJoinStrategy();
+            return;
+        }
+    }
+}
+
+boost::optional<std::vector<Value>> DocumentSourceLookUp::getLocalJoinKeys(
+    const Document& inputDoc) const {
+    // Missing and null values must also be matched against foreign documents which lack
+    // 'foreignField', and an undefined value must be rejected with the same error as the query
+    // would raise. Leave these to the query. So too for regular expressions, which would turn the
+    // batch's $in into a $or with a clause per key.
+    std::vector<Value> keys;
+    bool requiresQuery = false;
+    document_path_support::visitAllValuesAtPath(inputDoc, *_localField, [&](const Value& value) {
+        requiresQuery = requiresQuery || value.nullish() || value.getType() == BSONType::RegEx;
+        keys.push_back(value);
+    });
+    if (keys.empty() || requiresQuery) {
+        return boost::none;
+    }
+    return keys;
+}
+
+DocumentSource::GetNextResult DocumentSourceLookUp::getNextJoinedInput(
+    boost::optional<std::vector<Document>>* matches) {
+    if (_joinedInputs.empty()) {
+        if (_deferredInput) {
+            auto deferredInput = std::move(*_deferredInput);
+            _deferredInput = boost::none;
+            return deferredInput;
+        }
+
+        auto nextInput = pSource->getNext();
+        if (!nextInput.isAdvanced() || wasConstructedWithPipelineSyntax()) {
+            *matches = boost::none;
+            return nextInput;
+        }
+
+        // Defer choosing the strategy until there is an input document to join, so that an empty
+        // input never scans the foreign collection.
+        initializeJoinStrategy();
+
+        if (*_joinStrategy != JoinStrategy::kBatchedNestedLoop) {
+            auto inputDoc = nextInput.releaseDocument();
+            auto keys = _hashTable ? getLocalJoinKeys(inputDoc) : boost::none;
+            *matches = keys ? _hashTable->find(*keys) : boost::none;
+            return std::move(inputDoc);
+        }
+
+        joinBatch(nextInput.releaseDocument());
+    }
+
+    auto joinedInput = std::move(_joinedInputs.front());
+    _joinedInputs.pop_front();
+    *matches = std::move(joinedInput.second);
+    return std::move(joinedInput.first);
+}
+
+void DocumentSourceLookUp::joinBatch(Document firstInput) {
+    const size_t batchSize = internalDocumentSourceLookupBatchSize.load();
+    const auto& comparator = _fromExpCtx->getValueComparator();
+
+    // Gather input documents along with their keys, leaving those which need a query of their own
+    // without any.
+    std::vector<std::pair<Document, boost::optional<std::vector<Value>>>> inputs;
+    std::vector<Value> batchKeys;
+    size_t batchKeysBytes = 0;
+    auto addInput = [&](Document input) {
+        auto keys = getLocalJoinKeys(input);
+        if (keys) {
+            for (auto&& key : *keys) {
+                batchKeysBytes += key.getApproximateSize();
+                batchKeys.push_back(key);
+            }
+        }
+        inputs.emplace_back(std::move(input), std::move(keys));
+    };
+
+    // Stop at a pause or EOF from our source, which is returned once the batch has been consumed.
+    // Also keep the batch query comfortably within the maximum BSON size.
+    addInput(std::move(firstInput));
+    while (inputs.size() < batchSize && batchKeysBytes < BSONObjMaxUserSize / 2) {
+        auto nextInput = pSource->getNext();
+        if (!nextInput.isAdvanced()) {
+            _deferredInput = std::move(nextInput);
+            break;
+        }
+        addInput(nextInput.releaseDocument());
+    }
+
+    // Query for all the keys in the batch at once, in order, so that an index on 'foreignField' can
+    // be scanned in a single pass. Then redistribute the matches among the inputs by hashing them
+    // on 'foreignField'. Inputs whose keys were evicted from the table fall back to a query.
+    boost::optional<LookupHashTable> batchMatches;
+    if (!batchKeys.empty()) {
+        std::sort(batchKeys.begin(), batchKeys.end(), comparator.getLessThan());
+        batchKeys.erase(std::unique(batchKeys.begin(), batchKeys.end(), comparator.getEqualTo()),
+                        batchKeys.end());
+
+        _resolvedPipeline.back() = makeMatchStageFromValues(
+            batchKeys, _foreignField->fullPath(), _additionalFilter.value_or(BSONObj()));
+        auto pipeline = buildPipeline(inputs.front().first);
+
+        batchMatches.emplace(comparator,
+                             kHashJoinPartitions,
+                             internalDocumentSourceLookupBatchMaxBytes.load());
+        while (auto next = pipeline->getNext()) {
+            batchMatches->insert(*next, *_foreignField);
+        }
+    }
+
+    for (auto&& input : inputs) {
+        auto matches = input.second ? batchMatches->find(*input.second) : boost::none;
+        _joinedInputs.emplace_back(std::move(input.first), std::move(matches));
+    }
+}
+
+boost::optional<Document> DocumentSourceLookUp::getNextForeignMatch() {
+    if (_pipeline) {
+        return _pipeline->getNext();
+    }
+    if (_joinedMatches.empty()) {
+        return boost::none;
+    }
+    auto next = std::move(_joinedMatches.front());
+    _joinedMatches.pop_front();
+    return next;
 }
 
 BSONObj DocumentSourceLookUp::makeMatchStageFromInput(const Document& input,
@@ -442,18 +670,31 @@ BSONObj DocumentSourceLookUp::makeMatchStageFromInput(const Document& input,
     // Add the 'localFieldPath' of 'input' into 'localFieldList'. If 'localFieldPath' references a
     // field with an array in its path, we may need to join on multiple values, so we add each
     // element to 'localFieldList'.
-    BSONArrayBuilder arrBuilder;
-    bool containsRegex = false;
+    std::vector<Value> localFieldList;
     document_path_support::visitAllValuesAtPath(input, localFieldPath, [&](const Value& nextValue) {
-        arrBuilder << nextValue;
-        if (!containsRegex && nextValue.getType() == BSONType::RegEx) {
-            containsRegex = true;
-        }
+        localFieldList.push_back(nextValue);
     });
 
-    if (arrBuilder.arrSize() == 0) {
+    if (localFieldList.empty()) {
         // Missing values are treated as null.
-        arrBuilder << BSONNULL;
+        localFieldList.push_back(Value(BSONNULL));
+    }
+
+    return makeMatchStageFromValues(localFieldList, foreignFieldName, additionalFilter);
+}
+
+BSONObj DocumentSourceLookUp::makeMatchStageFromValues(const std::vector<Value>& values,
+                                                       const std::string& foreignFieldName,
+                                                       const BSONObj& additionalFilter) {
+    invariant(!values.empty());
+
+    BSONArrayBuilder arrBuilder;
+    bool containsRegex = false;
+    for (auto&& value : values) {
+        arrBuilder << value;
+        if (!containsRegex && value.getType() == BSONType::RegEx) {
+            containsRegex = true;
+        }
     }
 
     const auto localFieldListSize = arrBuilder.arrSize();
@@ -525,35 +766,43 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     // Loop until we get a document that has at least one match.
     // Note we may return early from this loop if our source stage is exhausted or if the unwind
     // source was asked to return empty arrays and we get a document without a match.
-    while (!_pipeline || !_nextValue) {
-        auto nextInput = pSource->getNext();
+    while (!_nextValue) {
+        boost::optional<std::vector<Document>> joinedMatches;
+        auto nextInput = getNextJoinedInput(&joinedMatches);
         if (!nextInput.isAdvanced()) {
             return nextInput;
         }
 
         _input = nextInput.releaseDocument();
 
-        if (!wasConstructedWithPipelineSyntax()) {
-            BSONObj filter = _additionalFilter.value_or(BSONObj());
-            auto matchStage =
-                makeMatchStageFromInput(*_input, *_localField, _foreignField->fullPath(), filter);
-            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-            _resolvedPipeline.back() = matchStage;
-        }
-
         if (_pipeline) {
             _pipeline->dispose(pExpCtx->opCtx);
+            _pipeline.reset();
         }
 
-        _pipeline = buildPipeline(*_input);
+        if (joinedMatches) {
+            _joinedMatches.assign(std::make_move_iterator(joinedMatches->begin()),
+                                  std::make_move_iterator(joinedMatches->end()));
+        } else {
+            if (!wasConstructedWithPipelineSyntax()) {
+                BSONObj filter = _additionalFilter.value_or(BSONObj());
+                auto matchStage = makeMatchStageFromInput(
+                    *_input, *_localField, _foreignField->fullPath(), filter);
+                // We've already allocated space for the trailing $match stage in
+                // '_resolvedPipeline'.
+                _resolvedPipeline.back() = matchStage;
+            }
 
-        // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
-        // potentially be used by multiple OperationContexts, and the $lookup stage is part of an
-        // outer Pipeline that will propagate dispose() calls before being destroyed.
-        _pipeline.get_deleter().dismissDisposal();
+            _pipeline = buildPipeline(*_input);
+
+            // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
+            // potentially be used by multiple OperationContexts, and the $lookup stage is part of
+            // an outer Pipeline that will propagate dispose() calls before being destroyed.
+            _pipeline.get_deleter().dismissDisposal();
+        }
 
         _cursorIndex = 0;
-        _nextValue = _pipeline->getNext();
+        _nextValue = getNextForeignMatch();
 
         if (_unwindSrc->preserveNullAndEmptyArrays() && !_nextValue) {
             // There were no results for this cursor, but the $unwind was asked to preserve empty
@@ -571,7 +820,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
     invariant(bool(_input) && bool(_nextValue));
     auto currentValue = *_nextValue;
-    _nextValue = _pipeline->getNext();
+    _nextValue = getNextForeignMatch();
 
     // Move input document into output if this is the last or only result, otherwise perform a copy.
     MutableDocument output(_nextValue ? *_input : std::move(*_input));
@@ -662,6 +911,25 @@ void DocumentSourceLookUp::serializeToArray(
             output[getSourceName()]["matching"] = Value(*_additionalFilter);
         }
 
+        if (!wasConstructedWithPipelineSyntax()) {
+            // The default nested loop join keeps the explain output of earlier versions.
+            const auto strategy = getJoinStrategy();
+            if (strategy != JoinStrategy::kNestedLoop) {
+                output[getSourceName()]["strategy"] = Value(joinStrategyToString(strategy));
+            }
+            if (_hashTable && *explain >= ExplainOptions::Verbosity::kExecStats) {
+                output[getSourceName()]["hashTable"] = Value(
+                    DOC("documents" << static_cast<long long>(_hashTable->numDocumentsInserted())
+                                    << "memoryUsageBytes"
+                                    << static_cast<long long>(_hashTable->getMemoryUsageBytes())
+                                    << "partitions"
+                                    << static_cast<long long>(_hashTable->numPartitions())
+                                    << "evictedPartitions"
+                                    << static_cast<long long>(
+                                           _hashTable->numEvictedPartitions())));
+            }
+        }
+
         array.push_back(Value(output.freeze()));
     } else {
         array.push_back(Value(output.freeze()));
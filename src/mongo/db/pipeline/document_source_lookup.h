@@ -29,6 +29,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <deque>
 
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_match.h"
@@ -36,6 +37,7 @@
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lite_parsed_pipeline.h"
+#include "mongo/db/pipeline/lookup_hash_table.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
 #include "mongo/db/pipeline/value_comparator.h"
 
@@ -49,6 +51,26 @@ class DocumentSourceLookUp final : public DocumentSource, public NeedsMergerDocu
 public:
     static constexpr size_t kMaxSubPipelineDepth = 20;
 
+    // The number of partitions the hash table of a hash join is split into. When the table exceeds
+    // its memory limit, whole partitions are evicted and their keys are joined by querying the
+    // foreign collection instead.
+    static constexpr size_t kHashJoinPartitions = 16;
+
+    /**
+     * How input documents are joined with the foreign collection when $lookup is specified with
+     * localField/foreignField syntax.
+     */
+    enum class JoinStrategy {
+        // Query the foreign collection for each input document.
+        kNestedLoop,
+        // Query the foreign collection once for a batch of input documents, on all of their local
+        // values together, and distribute the results among them.
+        kBatchedNestedLoop,
+        // Scan the foreign collection once into an in-memory hash table keyed on 'foreignField',
+        // and probe it for each input document.
+        kHashJoin,
+    };
+
     class LiteParsed final : public LiteParsedDocumentSource {
     public:
         static std::unique_ptr<LiteParsed> parse(const AggregationRequest& request,
@@ -159,6 +181,14 @@ public:
                                            const std::string& foreignFieldName,
                                            const BSONObj& additionalFilter);
 
+    /**
+     * Builds the $match used to query the foreign collection for documents whose
+     * 'foreignFieldName' is equal to any of 'values', which must not be empty.
+     */
+    static BSONObj makeMatchStageFromValues(const std::vector<Value>& values,
+                                            const std::string& foreignFieldName,
+                                            const BSONObj& additionalFilter);
+
     /**
      * Helper to absorb an $unwind stage. Only used for testing this special behavior.
      */
@@ -187,6 +217,12 @@ public:
         return buildPipeline(inputDoc);
     }
 
+    /**
+     * Returns the join strategy this stage is using, or would use if it had not started executing
+     * yet. Only valid for a $lookup with localField/foreignField syntax.
+     */
+    JoinStrategy getJoinStrategy() const;
+
 protected:
     void doDispose() final;
 
@@ -244,6 +280,55 @@ private:
 
     GetNextResult unwindResult();
 
+    /**
+     * Decides whether to join using a hash table, which requires the foreign collection to fit
+     * within the hash join memory limit and 'foreignField' to have no index which could serve the
+     * per-document lookups instead. Falls back to a nested loop join whenever the foreign
+     * collection size is unknown or the join could not be answered by equality lookups alone.
+     */
+    JoinStrategy chooseJoinStrategy() const;
+
+    /**
+     * Returns the nested loop strategy to use when a hash join is not possible, which depends on
+     * whether batching is enabled.
+     */
+    static JoinStrategy chooseNestedLoopJoinStrategy();
+
+    /**
+     * Chooses the join strategy, building the hash table if necessary, unless already done.
+     */
+    void initializeJoinStrategy();
+
+    /**
+     * Scans the foreign collection into '_hashTable'. If most of the table had to be evicted to
+     * stay within the memory limit, discards it and switches to a nested loop join.
+     */
+    void buildHashTable();
+
+    /**
+     * Returns the values of 'localField' in 'inputDoc' to join on, or boost::none if 'inputDoc'
+     * can only be joined by a query of its own.
+     */
+    boost::optional<std::vector<Value>> getLocalJoinKeys(const Document& inputDoc) const;
+
+    /**
+     * Returns the next input document. If its foreign matches are already known from the hash
+     * table or a batched query, they are returned through 'matches'. Otherwise 'matches' is set to
+     * boost::none and the input document must be joined by querying the foreign collection.
+     */
+    GetNextResult getNextJoinedInput(boost::optional<std::vector<Document>>* matches);
+
+    /**
+     * Reads a batch of input documents starting with 'firstInput' and joins them with a single
+     * query, appending them with their matches to '_joinedInputs'.
+     */
+    void joinBatch(Document firstInput);
+
+    /**
+     * Returns the next joined foreign document for '_input' when an $unwind has been absorbed.
+     */
+    boost::optional<Document> getNextForeignMatch();
+
     /**
      * Copies 'vars' and 'vps' to the Variables and VariablesParseState objects in 'expCtx'. These
      * copies provide access to 'let' defined variables in sub-pipeline execution.
@@ -270,10 +355,11 @@ private:
     std::unique_ptr<Pipeline, PipelineDeleter> buildPipeline(const Document& inputDoc);
 
     /**
-     * The pipeline supplied via the $lookup 'pipeline' argument. This may differ from pipeline that
-     * is executed in that it will not include optimizations or resolved views.
+     * The pipeline supplied via the $lookup 'pipeline' argument, or the query built from 'inputDoc'
+     * for localField/foreignField syntax. This may differ from pipeline that is executed in that it
+     * will not include optimizations or resolved views.
      */
-    std::string getUserPipelineDefinition();
+    std::string getUserPipelineDefinition(const Document& inputDoc);
 
     /**
      * Reinitialize the cache with a new max size. May only be called if this DSLookup was created
@@ -295,6 +381,17 @@ private:
     boost::optional<FieldPath> _localField;
     boost::optional<FieldPath> _foreignField;
 
+    // The join strategy, chosen once the first input document arrives. When it is 'kHashJoin', the
+    // foreign documents are held in '_hashTable'.
+    boost::optional<JoinStrategy> _joinStrategy;
+    boost::optional<LookupHashTable> _hashTable;
+
+    // Input documents which have already been joined by a batched query, along with their matches
+    // or boost::none if they still need to be joined by a query of their own. '_deferredInput'
+    // holds a pause or EOF from our source which ended the batch.
+    std::deque<std::pair<Document, boost::optional<std::vector<Document>>>> _joinedInputs;
+    boost::optional<GetNextResult> _deferredInput;
+
     // Holds 'let' defined variables defined both in this stage and in parent pipelines. These are
     // copied to the '_fromExpCtx' ExpressionContext's 'variables' and 'variablesParseState' for use
     // in foreign pipeline execution.
@@ -330,6 +427,7 @@ private:
     // not null.
     long long _cursorIndex = 0;
     std::unique_ptr<Pipeline, PipelineDeleter> _pipeline;
+    std::deque<Document> _joinedMatches;
     boost::optional<Document> _input;
     boost::optional<Document> _nextValue;
 };
@@ -47,6 +47,7 @@
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/server_options.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -490,14 +491,34 @@ TEST(MakeMatchStageFromInput, ArrayValueWithRegexUsesOrQuery) {
 class MockMongoInterface final : public StubMongoProcessInterface {
 public:
     MockMongoInterface(deque<DocumentSource::GetNextResult> mockResults,
-                       bool removeLeadingQueryStages = false)
+                       bool removeLeadingQueryStages = false,
+                       boost::optional<long long> collectionDataSize = boost::none,
+                       bool foreignFieldIndexed = false)
         : _mockResults(std::move(mockResults)),
-          _removeLeadingQueryStages(removeLeadingQueryStages) {}
+          _removeLeadingQueryStages(removeLeadingQueryStages),
+          _collectionDataSize(collectionDataSize),
+          _foreignFieldIndexed(foreignFieldIndexed) {}
 
     bool isSharded(OperationContext* opCtx, const NamespaceString& ns) final {
         return false;
     }
 
+    boost::optional<long long> getCollectionDataSize(OperationContext* opCtx,
+                                                     const NamespaceString& nss) const final {
+        return _collectionDataSize;
+    }
+
+    bool hasIndexForEqualityMatch(OperationContext* opCtx,
+                                  const NamespaceString& nss,
+                                  const FieldPath& field,
+                                  const CollatorInterface* collator) const final {
+        return _foreignFieldIndexed;
+    }
+
+    int numPipelinesAttached() const {
+        return _numPipelinesAttached;
+    }
+
     StatusWith<std::unique_ptr<Pipeline, PipelineDeleter>> makePipeline(
         const std::vector<BSONObj>& rawPipeline,
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
@@ -529,12 +550,16 @@ public:
         }
 
         pipeline->addInitialSource(DocumentSourceMock::create(_mockResults));
+        ++_numPipelinesAttached;
         return Status::OK();
     }
 
 private:
     deque<DocumentSource::GetNextResult> _mockResults;
     bool _removeLeadingQueryStages = false;
+    boost::optional<long long> _collectionDataSize;
+    bool _foreignFieldIndexed = false;
+    int _numPipelinesAttached = 0;
 };
 
 TEST_F(DocumentSourceLookUpTest, ShouldPropagatePauses) {
@@ -641,6 +666,445 @@ TEST_F(DocumentSourceLookUpTest, ShouldPropagatePausesWhileUnwinding) {
     lookup->dispose();
 }
 
+TEST_F(DocumentSourceLookUpTest, ShouldUseHashJoinWhenForeignCollectionFitsInMemory) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    const auto originalMaxBytes = internalDocumentSourceLookupHashJoinMaxBytes.load();
+    ON_BLOCK_EXIT([&] { internalDocumentSourceLookupHashJoinMaxBytes.store(originalMaxBytes); });
+    internalDocumentSourceLookupHashJoinMaxBytes.store(1024);
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{{"foreignId", 0}},
+         Document{{"foreignId", vector<Value>{Value(1), Value(0)}}},
+         Document{{"foreignId", 2}},
+         Document{{"otherId", 0}}});
+    lookup->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{{"_id", 0}},
+                                                             Document{{"_id", 1}}};
+    const bool removeLeadingQueryStages = false;
+    const long long collectionDataSize = 100;
+    auto mongoInterface = std::make_shared<MockMongoInterface>(
+        std::move(mockForeignContents), removeLeadingQueryStages, collectionDataSize);
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    ASSERT_TRUE(lookup->getJoinStrategy() == DocumentSourceLookUp::JoinStrategy::kHashJoin);
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"foreignId", 0}, {"foreignDocs", vector<Value>{Value(Document{{"_id", 0}})}}}));
+
+    // Matches are returned in the order they were read from the foreign collection.
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", vector<Value>{Value(1), Value(0)}},
+                                 {"foreignDocs",
+                                  vector<Value>{Value(Document{{"_id", 0}}),
+                                                Value(Document{{"_id", 1}})}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", 2}, {"foreignDocs", vector<Value>{}}}));
+
+    // The foreign collection has only been scanned once to build the hash table.
+    ASSERT_EQ(1, mongoInterface->numPipelinesAttached());
+
+    // A missing local field must also match foreign documents which lack the foreign field, so it
+    // is joined by querying the foreign collection.
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"otherId", 0}, {"foreignDocs", vector<Value>{}}}));
+    ASSERT_EQ(2, mongoInterface->numPipelinesAttached());
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+
+    vector<Value> explainedStages;
+    lookup->serializeToArray(explainedStages, ExplainOptions::Verbosity::kExecStats);
+    ASSERT_EQ(1U, explainedStages.size());
+    auto explained = explainedStages[0].getDocument()["$lookup"];
+    ASSERT_VALUE_EQ(explained["strategy"], Value("hashJoin"_sd));
+    ASSERT_VALUE_EQ(explained["hashTable"]["documents"], Value(2LL));
+    ASSERT_VALUE_EQ(explained["hashTable"]["evictedPartitions"], Value(0LL));
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldUseNestedLoopJoinWhenForeignCollectionSizeIsUnknown) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    const auto originalBatchSize = internalDocumentSourceLookupBatchSize.load();
+    ON_BLOCK_EXIT([&] { internalDocumentSourceLookupBatchSize.store(originalBatchSize); });
+    internalDocumentSourceLookupBatchSize.store(1);
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    auto mockLocalSource =
+        DocumentSourceMock::create({Document{{"foreignId", 0}}, Document{{"foreignId", 1}}});
+    lookup->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{{"_id", 0}},
+                                                             Document{{"_id", 1}}};
+    auto mongoInterface = std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    // The default strategy leaves the explain output unchanged.
+    vector<Value> explainedStages;
+    lookup->serializeToArray(explainedStages, kExplain);
+    ASSERT_TRUE(explainedStages[0].getDocument()["$lookup"]["strategy"].missing());
+
+    ASSERT_TRUE(lookup->getNext().isAdvanced());
+    ASSERT_TRUE(lookup->getNext().isAdvanced());
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_EQ(2, mongoInterface->numPipelinesAttached());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldUseNestedLoopJoinWhenForeignFieldIsIndexed) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    const auto originalMaxBytes = internalDocumentSourceLookupHashJoinMaxBytes.load();
+    ON_BLOCK_EXIT([&] { internalDocumentSourceLookupHashJoinMaxBytes.store(originalMaxBytes); });
+    internalDocumentSourceLookupHashJoinMaxBytes.store(1024);
+
+    const auto originalBatchSize = internalDocumentSourceLookupBatchSize.load();
+    ON_BLOCK_EXIT([&] { internalDocumentSourceLookupBatchSize.store(originalBatchSize); });
+    internalDocumentSourceLookupBatchSize.store(1);
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    auto mockLocalSource =
+        DocumentSourceMock::create({Document{{"foreignId", 0}}, Document{{"foreignId", 1}}});
+    lookup->setSource(mockLocalSource.get());
+
+    // The foreign collection fits in the hash table, but each lookup can be answered by a seek on
+    // the index over 'foreignField' instead.
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{{"_id", 0}},
+                                                             Document{{"_id", 1}}};
+    const bool removeLeadingQueryStages = false;
+    const long long collectionDataSize = 100;
+    const bool foreignFieldIndexed = true;
+    auto mongoInterface = std::make_shared<MockMongoInterface>(std::move(mockForeignContents),
+                                                               removeLeadingQueryStages,
+                                                               collectionDataSize,
+                                                               foreignFieldIndexed);
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    ASSERT_TRUE(lookup->getJoinStrategy() == DocumentSourceLookUp::JoinStrategy::kNestedLoop);
+
+    ASSERT_TRUE(lookup->getNext().isAdvanced());
+    ASSERT_TRUE(lookup->getNext().isAdvanced());
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_EQ(2, mongoInterface->numPipelinesAttached());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldFallBackToNestedLoopJoinWhenHashTableExceedsMemoryLimit) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    const auto originalMaxBytes = internalDocumentSourceLookupHashJoinMaxBytes.load();
+    ON_BLOCK_EXIT([&] { internalDocumentSourceLookupHashJoinMaxBytes.store(originalMaxBytes); });
+    internalDocumentSourceLookupHashJoinMaxBytes.store(1);
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    auto mockLocalSource = DocumentSourceMock::create(Document{{"foreignId", 5}});
+    lookup->setSource(mockLocalSource.get());
+
+    // The collection claims to be empty, but holds more than the hash table can.
+    deque<DocumentSource::GetNextResult> mockForeignContents;
+    for (int i = 0; i < 100; ++i) {
+        mockForeignContents.push_back(Document{{"_id", i}});
+    }
+    const bool removeLeadingQueryStages = false;
+    const long long collectionDataSize = 0;
+    auto mongoInterface = std::make_shared<MockMongoInterface>(
+        std::move(mockForeignContents), removeLeadingQueryStages, collectionDataSize);
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    ASSERT_TRUE(lookup->getJoinStrategy() == DocumentSourceLookUp::JoinStrategy::kHashJoin);
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"foreignId", 5}, {"foreignDocs", vector<Value>{Value(Document{{"_id", 5}})}}}));
+    ASSERT_TRUE(lookup->getNext().isEOF());
+
+    ASSERT_TRUE(lookup->getJoinStrategy() == DocumentSourceLookUp::JoinStrategy::kNestedLoop);
+    ASSERT_EQ(2, mongoInterface->numPipelinesAttached());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldJoinBatchOfInputDocumentsWithOneQuery) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    const auto originalBatchSize = internalDocumentSourceLookupBatchSize.load();
+    ON_BLOCK_EXIT([&] { internalDocumentSourceLookupBatchSize.store(originalBatchSize); });
+    internalDocumentSourceLookupBatchSize.store(1000);
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{{"foreignId", 0}},
+         Document{{"foreignId", vector<Value>{Value(1), Value(0)}}},
+         Document{{"otherId", 0}},
+         Document{{"foreignId", 3}},
+         DocumentSource::GetNextResult::makePauseExecution(),
+         Document{{"foreignId", 1}}});
+    lookup->setSource(mockLocalSource.get());
+
+    // The size of the foreign collection is unknown, so a hash join cannot be used.
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{{"_id", 0}}, Document{{"_id", 1}}, Document{{"_id", 2}}};
+    auto mongoInterface = std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    ASSERT_TRUE(lookup->getJoinStrategy() ==
+                DocumentSourceLookUp::JoinStrategy::kBatchedNestedLoop);
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"foreignId", 0}, {"foreignDocs", vector<Value>{Value(Document{{"_id", 0}})}}}));
+
+    // The whole batch up to the pause has been joined: once by a query for all of its keys, and
+    // once by a query for the document missing 'localField'.
+    ASSERT_EQ(2, mongoInterface->numPipelinesAttached());
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", vector<Value>{Value(1), Value(0)}},
+                                 {"foreignDocs",
+                                  vector<Value>{Value(Document{{"_id", 0}}),
+                                                Value(Document{{"_id", 1}})}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"otherId", 0}, {"foreignDocs", vector<Value>{}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", 3}, {"foreignDocs", vector<Value>{}}}));
+
+    ASSERT_TRUE(lookup->getNext().isPaused());
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"foreignId", 1}, {"foreignDocs", vector<Value>{Value(Document{{"_id", 1}})}}}));
+    ASSERT_EQ(3, mongoInterface->numPipelinesAttached());
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_TRUE(lookup->getNext().isEOF());
+
+    vector<Value> explainedStages;
+    lookup->serializeToArray(explainedStages, kExplain);
+    ASSERT_VALUE_EQ(explainedStages[0].getDocument()["$lookup"]["strategy"],
+                    Value("batchedNestedLoop"_sd));
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldJoinRegexKeysOutsideOfBatch) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    const auto originalBatchSize = internalDocumentSourceLookupBatchSize.load();
+    ON_BLOCK_EXIT([&] { internalDocumentSourceLookupBatchSize.store(originalBatchSize); });
+    internalDocumentSourceLookupBatchSize.store(1000);
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    const Value regex(BSONRegEx("^a", ""));
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{{"foreignId", regex}}, Document{{"foreignId", "b"_sd}}});
+    lookup->setSource(mockLocalSource.get());
+
+    // A regular expression only matches itself, not the strings it describes.
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{{"_id", regex}}, Document{{"_id", "abc"_sd}}, Document{{"_id", "b"_sd}}};
+    auto mongoInterface = std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", regex},
+                                 {"foreignDocs", vector<Value>{Value(Document{{"_id", regex}})}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"foreignId", "b"_sd},
+                  {"foreignDocs", vector<Value>{Value(Document{{"_id", "b"_sd}})}}}));
+    ASSERT_TRUE(lookup->getNext().isEOF());
+
+    // The regular expression is joined by its own query, the string by the batch's query.
+    ASSERT_EQ(2, mongoInterface->numPipelinesAttached());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldLimitNumberOfInputDocumentsPerBatch) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    const auto originalBatchSize = internalDocumentSourceLookupBatchSize.load();
+    ON_BLOCK_EXIT([&] { internalDocumentSourceLookupBatchSize.store(originalBatchSize); });
+    internalDocumentSourceLookupBatchSize.store(2);
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDoc"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    const bool preserveNullAndEmptyArrays = false;
+    const boost::optional<std::string> includeArrayIndex = boost::none;
+    lookup->setUnwindStage(DocumentSourceUnwind::create(
+        expCtx, "foreignDoc", preserveNullAndEmptyArrays, includeArrayIndex));
+
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{{"foreignId", 0}}, Document{{"foreignId", 1}}, Document{{"foreignId", 2}}});
+    lookup->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{{"_id", 0}}, Document{{"_id", 1}}, Document{{"_id", 2}}};
+    auto mongoInterface = std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    for (int i = 0; i < 3; ++i) {
+        auto next = lookup->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                           (Document{{"foreignId", i}, {"foreignDoc", Document{{"_id", i}}}}));
+    }
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_EQ(2, mongoInterface->numPipelinesAttached());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldUseHashJoinWhileUnwinding) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespace_forTest(fromNs, {fromNs, std::vector<BSONObj>{}});
+
+    const auto originalMaxBytes = internalDocumentSourceLookupHashJoinMaxBytes.load();
+    ON_BLOCK_EXIT([&] { internalDocumentSourceLookupHashJoinMaxBytes.store(originalMaxBytes); });
+    internalDocumentSourceLookupHashJoinMaxBytes.store(1024);
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDoc"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    const bool preserveNullAndEmptyArrays = false;
+    const boost::optional<std::string> includeArrayIndex = std::string("index");
+    lookup->setUnwindStage(DocumentSourceUnwind::create(
+        expCtx, "foreignDoc", preserveNullAndEmptyArrays, includeArrayIndex));
+
+    auto mockLocalSource = DocumentSourceMock::create(
+        {Document{{"foreignId", 2}}, Document{{"foreignId", vector<Value>{Value(0), Value(1)}}}});
+    lookup->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{{"_id", 0}},
+                                                             Document{{"_id", 1}}};
+    const bool removeLeadingQueryStages = false;
+    const long long collectionDataSize = 100;
+    auto mongoInterface = std::make_shared<MockMongoInterface>(
+        std::move(mockForeignContents), removeLeadingQueryStages, collectionDataSize);
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", vector<Value>{Value(0), Value(1)}},
+                                 {"foreignDoc", Document{{"_id", 0}}},
+                                 {"index", 0LL}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", vector<Value>{Value(0), Value(1)}},
+                                 {"foreignDoc", Document{{"_id", 1}}},
+                                 {"index", 1LL}}));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_EQ(1, mongoInterface->numPipelinesAttached());
+    lookup->dispose();
+}
+
 TEST_F(DocumentSourceLookUpTest, LookupReportsAsFieldIsModified) {
     auto expCtx = getExpCtx();
     NamespaceString fromNs("test", "foreign");
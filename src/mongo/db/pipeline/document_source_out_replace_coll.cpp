@@ -78,27 +78,11 @@ void DocumentSourceOutReplaceColl::initializeWriteNs() {
                               << info.toString(),
                 conn->runCommand(outputNs.db().toString(), cmd.done(), info));
     }
-
-    // Copy the indexes of the output collection to the temp collection.
-    for (auto indexSpec : _originalIndexes) {
-        MutableDocument index((Document(indexSpec)));
-        index.remove("_id");  // indexes shouldn't have _ids but some existing ones do
-        index["ns"] = Value(_tempNs.ns());
-
-        BSONObj indexBson = index.freeze().toBson();
-        conn->insert(_tempNs.getSystemIndexesCollection(), indexBson);
-        BSONObj err = conn->getLastErrorDetailed();
-        uassert(16995,
-                str::stream() << "copying index for $out failed."
-                              << " index: "
-                              << indexBson
-                              << " error: "
-                              << err,
-                DBClientBase::getLastErrorString(err).empty());
-    }
 };
 
 void DocumentSourceOutReplaceColl::finalize() {
+    buildIndexesOnTempCollection();
+
     const auto& outputNs = getOutputNs();
     auto renameCommandObj =
         BSON("renameCollection" << _tempNs.ns() << "to" << outputNs.ns() << "dropTarget" << true);
@@ -107,4 +91,28 @@ void DocumentSourceOutReplaceColl::finalize() {
         pExpCtx->opCtx, renameCommandObj, outputNs, _originalOutOptions, _originalIndexes);
 };
 
+void DocumentSourceOutReplaceColl::buildIndexesOnTempCollection() {
+    // The temp collection is only filled by this $out, so its indexes are built once all of the
+    // documents are in, which sorts each index's keys and writes the index in a single pass rather
+    // than inserting every key into the index as its document arrives.
+    std::vector<BSONObj> indexSpecs;
+    for (auto indexSpec : _originalIndexes) {
+        MutableDocument index((Document(indexSpec)));
+        index.remove("_id");  // indexes shouldn't have _ids but some existing ones do
+        index["ns"] = Value(_tempNs.ns());
+        indexSpecs.push_back(index.freeze().toBson());
+    }
+
+    try {
+        pExpCtx->mongoProcessInterface->createIndexes(pExpCtx->opCtx, _tempNs, indexSpecs);
+    } catch (const DBException& ex) {
+        // A unique index which the output violates is reported as it was when the index existed
+        // before the documents were inserted.
+        uassert(16996,
+                str::stream() << "insert for $out failed: " << ex.toStatus(),
+                ex.code() != ErrorCodes::DuplicateKey);
+        uasserted(16995, str::stream() << "copying indexes for $out failed: " << ex.toStatus());
+    }
+}
+
 }  // namespace mongo
@@ -52,14 +52,14 @@ public:
     }
 
     /**
-     * Sets up a temp collection which contains the same indexes and options as the output
-     * collection. All writes will be directed to the temp collection.
+     * Sets up a temp collection which has the same options as the output collection. All writes
+     * will be directed to the temp collection.
      */
     void initializeWriteNs() final;
 
     /**
-     * Renames the temp collection to the output collection with the 'dropTarget' option set to
-     * true.
+     * Builds the indexes of the output collection on the temp collection, then renames the temp
+     * collection to the output collection with the 'dropTarget' option set to true.
      */
     void finalize() final;
 
@@ -68,6 +68,12 @@ public:
     };
 
 private:
+    /**
+     * Creates each of the output collection's indexes on the temp collection, which by now holds
+     * all of the documents written by this $out.
+     */
+    void buildIndexesOnTempCollection();
+
     // Holds on to the original collection options and index specs so we can check they didn't
     // change during computation.
     BSONObj _originalOutOptions;
@@ -30,6 +30,7 @@
 
 #include "mongo/db/pipeline/document_source_sort.h"
 
+#include "mongo/db/curop.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_path_support.h"
@@ -40,6 +41,7 @@
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/query/collation/collation_index_key.h"
+#include "mongo/db/query/query_knobs.h"
 
 namespace mongo {
 
@@ -323,9 +325,11 @@ SortOptions DocumentSourceSort::makeSortOptions() const {
         opts.limit = _limitSrc->getLimit();
 
     opts.maxMemoryUsageBytes = _maxMemoryUsageBytes;
+    opts.parallelSortThreads = internalDocumentSourceSortParallelThreads.load();
     if (pExpCtx->allowDiskUse && !pExpCtx->inMongos) {
         opts.extSortAllowed = true;
         opts.tempDir = pExpCtx->tempDir;
+        opts.spillStats = &_spillStats;
     }
 
     return opts;
@@ -364,6 +368,12 @@ void DocumentSourceSort::loadingDone() {
     _output.reset(_sorter->done());
     _sorter.reset();
     _populated = true;
+
+    if (_spillStats.bytesSpilled.load() && pExpCtx->opCtx) {
+        auto& metrics = CurOp::get(pExpCtx->opCtx)->debug().additiveMetrics;
+        metrics.incrementSorterBytesSpilled(_spillStats.bytesSpilled.load());
+        metrics.incrementSorterBytesWritten(_spillStats.bytesWritten.load());
+    }
 }
 
 Value DocumentSourceSort::getCollationComparisonKey(const Value& val) const {
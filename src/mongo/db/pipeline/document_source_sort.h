@@ -263,6 +263,9 @@ private:
     uint64_t _maxMemoryUsageBytes;
     bool _done;
     bool _mergingPresorted;  // TODO SERVER-34009 Remove this flag.
+
+    // Must outlive '_sorter', which reports the data it spills to disk here.
+    mutable SorterSpillStats _spillStats;
     std::unique_ptr<MySorter> _sorter;
     std::unique_ptr<MySorter::Iterator> _output;
 };
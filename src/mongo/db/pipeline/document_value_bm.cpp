@@ -0,0 +1,145 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/field_path.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+std::string fieldName(int i) {
+    return str::stream() << "f" << i;
+}
+
+BSONObj makeBson(int numFields) {
+    BSONObjBuilder bob;
+    for (int i = 0; i < numFields; i++) {
+        if (i % 2) {
+            bob.append(fieldName(i), "some string value");
+        } else {
+            bob.append(fieldName(i), BSON("x" << i << "y" << BSON_ARRAY(1 << 2 << 3)));
+        }
+    }
+    return bob.obj();
+}
+
+/**
+ * Converts a BSONObj to a Document, as every document entering an aggregation pipeline is.
+ */
+void BM_DocumentFromBson(benchmark::State& state) {
+    const BSONObj bson = makeBson(state.range(0));
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(Document(bson));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * bson.objsize());
+}
+
+void BM_DocumentToBson(benchmark::State& state) {
+    const Document doc(makeBson(state.range(0)));
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(doc.toBson());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_MutableDocumentAddField(benchmark::State& state) {
+    std::vector<std::string> names;
+    for (int i = 0; i < state.range(0); i++) {
+        names.push_back(fieldName(i));
+    }
+
+    for (auto keepRunning : state) {
+        MutableDocument md;
+        for (int i = 0; i < state.range(0); i++) {
+            md.addField(names[i], Value(i));
+        }
+        benchmark::DoNotOptimize(md.freeze());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Looks up the last field of a document. Documents with fewer than four fields are searched
+ * linearly, and larger ones through a hash table.
+ */
+void BM_DocumentGetField(benchmark::State& state) {
+    const Document doc(makeBson(state.range(0)));
+    const std::string lastField = fieldName(state.range(0) - 1);
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(doc.getField(lastField));
+    }
+}
+
+void BM_DocumentGetNestedField(benchmark::State& state) {
+    const Document doc(makeBson(16));
+    const FieldPath path("f14.x");
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(doc.getNestedField(path));
+    }
+}
+
+void BM_ValueConstructScalars(benchmark::State& state) {
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(Value(42));
+        benchmark::DoNotOptimize(Value(42.5));
+        benchmark::DoNotOptimize(Value(StringData("short")));
+        benchmark::DoNotOptimize(Value(StringData("a string too long to be stored inline")));
+    }
+    state.SetItemsProcessed(state.iterations() * 4);
+}
+
+void BM_ValueConstructArray(benchmark::State& state) {
+    for (auto keepRunning : state) {
+        std::vector<Value> values;
+        values.reserve(state.range(0));
+        for (int i = 0; i < state.range(0); i++) {
+            values.emplace_back(i);
+        }
+        benchmark::DoNotOptimize(Value(std::move(values)));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_DocumentFromBson)->Arg(4)->Arg(64);
+BENCHMARK(BM_DocumentToBson)->Arg(4)->Arg(64);
+BENCHMARK(BM_MutableDocumentAddField)->Arg(4)->Arg(64);
+BENCHMARK(BM_DocumentGetField)->Arg(3)->Arg(64);
+BENCHMARK(BM_DocumentGetNestedField);
+BENCHMARK(BM_ValueConstructScalars);
+BENCHMARK(BM_ValueConstructArray)->Arg(10)->Arg(1000);
+
+}  // namespace
+}  // namespace mongo
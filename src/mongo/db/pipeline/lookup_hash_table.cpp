@@ -0,0 +1,198 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/lookup_hash_table.h"
+
+#include <algorithm>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+
+void visitJoinKeysHelper(const Document& doc,
+                         const FieldPath& path,
+                         size_t fieldPathIndex,
+                         const stdx::function<void(const Value&)>& callback) {
+    auto nextValue = doc.getField(path.getFieldName(fieldPathIndex));
+    ++fieldPathIndex;
+
+    if (fieldPathIndex == path.getPathLength()) {
+        // An equality match on an array field is satisfied by any of its elements or by the array
+        // as a whole, but not by the elements of nested arrays.
+        if (nextValue.isArray()) {
+            for (auto&& element : nextValue.getArray()) {
+                callback(element);
+            }
+        }
+        if (!nextValue.missing()) {
+            callback(nextValue);
+        }
+        return;
+    }
+
+    // As with a query, look for the rest of the path within any objects inside an array, but do
+    // not expand arrays within arrays.
+    if (nextValue.isArray()) {
+        for (auto&& subValue : nextValue.getArray()) {
+            if (subValue.getType() == BSONType::Object) {
+                visitJoinKeysHelper(subValue.getDocument(), path, fieldPathIndex, callback);
+            }
+        }
+    } else if (nextValue.getType() == BSONType::Object) {
+        visitJoinKeysHelper(nextValue.getDocument(), path, fieldPathIndex, callback);
+    }
+}
+
+}  // namespace
+
+void LookupHashTable::visitJoinKeys(const Document& doc,
+                                    const FieldPath& path,
+                                    const stdx::function<void(const Value&)>& callback) {
+    visitJoinKeysHelper(doc, path, 0, callback);
+}
+
+LookupHashTable::LookupHashTable(const ValueComparator& comparator,
+                                 size_t numPartitions,
+                                 size_t maxMemoryUsageBytes)
+    : _comparator(comparator), _maxMemoryUsageBytes(maxMemoryUsageBytes) {
+    invariant(numPartitions > 0);
+    _partitions.reserve(numPartitions);
+    for (size_t i = 0; i < numPartitions; ++i) {
+        _partitions.emplace_back(_comparator);
+    }
+}
+
+const LookupHashTable::Partition& LookupHashTable::getPartition(const Value& key) const {
+    // Scramble the hash before reducing it to a partition number, since the hashes of small
+    // numbers tend to differ only in their high bits.
+    const uint64_t hash = _comparator.getHasher()(key);
+    const uint64_t mixed = (hash * 0x9E3779B97F4A7C15ULL) >> 32;
+    return _partitions[(mixed * _partitions.size()) >> 32];
+}
+
+LookupHashTable::Partition& LookupHashTable::getPartition(const Value& key) {
+    return const_cast<Partition&>(static_cast<const LookupHashTable*>(this)->getPartition(key));
+}
+
+void LookupHashTable::insert(const Document& doc, const FieldPath& joinField) {
+    const size_t sequenceNumber = _numDocumentsInserted++;
+    const size_t docSize = doc.getApproximateSize();
+
+    visitJoinKeys(doc, joinField, [&](const Value& key) {
+        auto& partition = getPartition(key);
+        if (partition.evicted) {
+            return;
+        }
+
+        // A document with several keys in the same partition is only stored there once.
+        if (partition.documents.empty() || partition.documents.back().first != sequenceNumber) {
+            partition.documents.emplace_back(sequenceNumber, doc);
+            partition.memoryUsageBytes += docSize;
+            _memoryUsageBytes += docSize;
+        }
+        const size_t position = partition.documents.size() - 1;
+
+        auto it = partition.index.find(key);
+        if (it == partition.index.end()) {
+            it = partition.index.emplace(key, std::vector<size_t>()).first;
+            const size_t keySize = key.getApproximateSize();
+            partition.memoryUsageBytes += keySize;
+            _memoryUsageBytes += keySize;
+        }
+
+        // Skip a key which repeats within the document, as in {a: [1, 1]}.
+        if (it->second.empty() || it->second.back() != position) {
+            it->second.push_back(position);
+            partition.memoryUsageBytes += sizeof(size_t);
+            _memoryUsageBytes += sizeof(size_t);
+        }
+    });
+
+    evictLargestPartitions();
+}
+
+void LookupHashTable::evictLargestPartitions() {
+    while (_memoryUsageBytes > _maxMemoryUsageBytes) {
+        auto largest = std::max_element(_partitions.begin(),
+                                        _partitions.end(),
+                                        [](const Partition& lhs, const Partition& rhs) {
+                                            return lhs.memoryUsageBytes < rhs.memoryUsageBytes;
+                                        });
+        invariant(largest->memoryUsageBytes > 0);
+
+        _memoryUsageBytes -= largest->memoryUsageBytes;
+        largest->memoryUsageBytes = 0;
+        largest->index = _comparator.makeUnorderedValueMap<std::vector<size_t>>();
+        largest->documents = {};
+        largest->evicted = true;
+        ++_numEvictedPartitions;
+    }
+}
+
+boost::optional<std::vector<Document>> LookupHashTable::find(const std::vector<Value>& keys) const {
+    std::vector<const std::pair<size_t, Document>*> matches;
+    for (auto&& key : keys) {
+        const auto& partition = getPartition(key);
+        if (partition.evicted) {
+            return boost::none;
+        }
+
+        auto it = partition.index.find(key);
+        if (it == partition.index.end()) {
+            continue;
+        }
+        for (auto position : it->second) {
+            matches.push_back(&partition.documents[position]);
+        }
+    }
+
+    // A document may have been found under several keys, or in several partitions. Return each
+    // one once, in the order it was inserted.
+    std::sort(matches.begin(), matches.end(), [](const auto* lhs, const auto* rhs) {
+        return lhs->first < rhs->first;
+    });
+    matches.erase(std::unique(matches.begin(),
+                              matches.end(),
+                              [](const auto* lhs, const auto* rhs) {
+                                  return lhs->first == rhs->first;
+                              }),
+                  matches.end());
+
+    std::vector<Document> results;
+    results.reserve(matches.size());
+    for (auto&& match : matches) {
+        results.push_back(match->second);
+    }
+    return results;
+}
+
+}  // namespace mongo
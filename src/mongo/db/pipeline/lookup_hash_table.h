@@ -0,0 +1,140 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <utility>
+#include <vector>
+
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/field_path.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/stdx/functional.h"
+
+namespace mongo {
+
+/**
+ * An in-memory hash table over the documents of a foreign collection, keyed on every value that an
+ * equality predicate on the join field could match. Used by $lookup to probe the foreign side once
+ * per input document instead of issuing a query.
+ *
+ * The table is split into hash partitions. Once the table grows beyond its memory limit, the
+ * largest partition is evicted: its documents are released and any key which hashes to it is no
+ * longer tracked. Callers must fall back to querying the foreign collection for such keys.
+ */
+class LookupHashTable {
+public:
+    /**
+     * Calls 'callback' once for each value 'doc' can be joined on by an equality match on 'path':
+     * every value found at 'path' as well as any array found at the end of 'path' as a whole. For
+     * example, 'callback' will be invoked on 1, 2, [1, 2] and 3 for the path "a.b" in the document
+     * {a: [{b: [1, 2]}, {b: 3}]}.
+     *
+     * Numeric path components are treated as field names, so 'path' should not contain any.
+     */
+    static void visitJoinKeys(const Document& doc,
+                              const FieldPath& path,
+                              const stdx::function<void(const Value&)>& callback);
+
+    /**
+     * Constructs a table which compares keys using 'comparator'. The comparator must outlive the
+     * table.
+     */
+    LookupHashTable(const ValueComparator& comparator,
+                    size_t numPartitions,
+                    size_t maxMemoryUsageBytes);
+
+    /**
+     * Adds 'doc' under each of its join keys on 'joinField', evicting partitions as necessary to
+     * stay within the memory limit.
+     */
+    void insert(const Document& doc, const FieldPath& joinField);
+
+    /**
+     * Looks up the documents joined to any of 'keys', returning them in insertion order without
+     * duplicates. Returns boost::none if any of 'keys' hashes to an evicted partition, since the
+     * result would be incomplete.
+     */
+    boost::optional<std::vector<Document>> find(const std::vector<Value>& keys) const;
+
+    size_t getMemoryUsageBytes() const {
+        return _memoryUsageBytes;
+    }
+
+    size_t numPartitions() const {
+        return _partitions.size();
+    }
+
+    size_t numEvictedPartitions() const {
+        return _numEvictedPartitions;
+    }
+
+    /**
+     * Returns the number of documents inserted into the table, including those which have since
+     * been evicted.
+     */
+    size_t numDocumentsInserted() const {
+        return _numDocumentsInserted;
+    }
+
+private:
+    struct Partition {
+        explicit Partition(const ValueComparator& comparator)
+            : index(comparator.makeUnorderedValueMap<std::vector<size_t>>()) {}
+
+        // Maps each key to the positions of its documents in 'documents'.
+        ValueUnorderedMap<std::vector<size_t>> index;
+
+        // The documents with at least one key in this partition, paired with the order in which
+        // they were inserted into the table.
+        std::vector<std::pair<size_t, Document>> documents;
+
+        size_t memoryUsageBytes = 0;
+        bool evicted = false;
+    };
+
+    Partition& getPartition(const Value& key);
+    const Partition& getPartition(const Value& key) const;
+
+    /**
+     * Evicts the largest partitions until the table is within its memory limit.
+     */
+    void evictLargestPartitions();
+
+    const ValueComparator& _comparator;
+    const size_t _maxMemoryUsageBytes;
+
+    std::vector<Partition> _partitions;
+    size_t _memoryUsageBytes = 0;
+    size_t _numEvictedPartitions = 0;
+    size_t _numDocumentsInserted = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,155 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/db/pipeline/document_value_test_util.h"
+#include "mongo/db/pipeline/lookup_hash_table.h"
+#include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using std::vector;
+
+const ValueComparator defaultComparator{nullptr};
+const size_t kNoMemoryLimit = 100 * 1024 * 1024;
+
+std::vector<Value> getJoinKeys(const Document& doc, const FieldPath& path) {
+    std::vector<Value> keys;
+    LookupHashTable::visitJoinKeys(doc, path, [&](const Value& key) { keys.push_back(key); });
+    return keys;
+}
+
+TEST(LookupHashTableTest, VisitJoinKeysIncludesArrayElementsAndWholeArray) {
+    auto keys = getJoinKeys(Document{{"a", vector<Value>{Value(1), Value(2)}}}, "a");
+    ASSERT_EQ(3U, keys.size());
+    ASSERT_VALUE_EQ(Value(1), keys[0]);
+    ASSERT_VALUE_EQ(Value(2), keys[1]);
+    ASSERT_VALUE_EQ(Value(vector<Value>{Value(1), Value(2)}), keys[2]);
+}
+
+TEST(LookupHashTableTest, VisitJoinKeysTraversesObjectsInArraysButNotNestedArrays) {
+    auto doc = Document{{"a",
+                         vector<Value>{Value(Document{{"b", 1}}),
+                                       Value(vector<Value>{Value(Document{{"b", 2}})}),
+                                       Value(Document{{"b", vector<Value>{Value(3)}}}),
+                                       Value(Document{{"c", 4}})}}};
+    auto keys = getJoinKeys(doc, "a.b");
+    ASSERT_EQ(3U, keys.size());
+    ASSERT_VALUE_EQ(Value(1), keys[0]);
+    ASSERT_VALUE_EQ(Value(3), keys[1]);
+    ASSERT_VALUE_EQ(Value(vector<Value>{Value(3)}), keys[2]);
+}
+
+TEST(LookupHashTableTest, VisitJoinKeysSkipsMissingField) {
+    ASSERT_EQ(0U, getJoinKeys(Document{{"b", 1}}, "a").size());
+    ASSERT_EQ(0U, getJoinKeys(Document{{"a", 1}}, "a.b").size());
+}
+
+TEST(LookupHashTableTest, FindReturnsEachMatchOnceInInsertionOrder) {
+    LookupHashTable table(defaultComparator, 4, kNoMemoryLimit);
+    table.insert(Document{{"_id", 0}, {"a", vector<Value>{Value(1), Value(2), Value(1)}}}, "a");
+    table.insert(Document{{"_id", 1}, {"a", 3}}, "a");
+    table.insert(Document{{"_id", 2}, {"a", 1}}, "a");
+
+    auto matches = table.find({Value(2), Value(1), Value(3)});
+    ASSERT_TRUE(matches);
+    ASSERT_EQ(3U, matches->size());
+    ASSERT_DOCUMENT_EQ((Document{{"_id", 0}, {"a", vector<Value>{Value(1), Value(2), Value(1)}}}),
+                       (*matches)[0]);
+    ASSERT_DOCUMENT_EQ((Document{{"_id", 1}, {"a", 3}}), (*matches)[1]);
+    ASSERT_DOCUMENT_EQ((Document{{"_id", 2}, {"a", 1}}), (*matches)[2]);
+
+    matches = table.find({Value(4)});
+    ASSERT_TRUE(matches);
+    ASSERT_EQ(0U, matches->size());
+}
+
+TEST(LookupHashTableTest, FindMatchesNumbersOfDifferentTypes) {
+    LookupHashTable table(defaultComparator, 4, kNoMemoryLimit);
+    table.insert(Document{{"a", 1LL}}, "a");
+    table.insert(Document{{"a", 1.0}}, "a");
+
+    auto matches = table.find({Value(1)});
+    ASSERT_TRUE(matches);
+    ASSERT_EQ(2U, matches->size());
+}
+
+TEST(LookupHashTableTest, KeysRespectCollation) {
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kToLowerString);
+    ValueComparator comparator{&collator};
+    LookupHashTable table(comparator, 4, kNoMemoryLimit);
+    table.insert(Document{{"a", "foo"_sd}}, "a");
+    table.insert(Document{{"a", "FOO"_sd}}, "a");
+    table.insert(Document{{"a", "FOOz"_sd}}, "a");
+
+    auto matches = table.find({Value("FoO"_sd)});
+    ASSERT_TRUE(matches);
+    ASSERT_EQ(2U, matches->size());
+}
+
+TEST(LookupHashTableTest, EvictsLargestPartitionsWhenOverMemoryLimit) {
+    const size_t numDocs = 1000;
+    LookupHashTable unlimited(defaultComparator, 8, kNoMemoryLimit);
+    for (size_t i = 0; i < numDocs; ++i) {
+        unlimited.insert(Document{{"a", static_cast<int>(i)}}, "a");
+    }
+    ASSERT_EQ(0U, unlimited.numEvictedPartitions());
+
+    const size_t memoryLimit = unlimited.getMemoryUsageBytes() / 2;
+    LookupHashTable table(defaultComparator, 8, memoryLimit);
+    for (size_t i = 0; i < numDocs; ++i) {
+        table.insert(Document{{"a", static_cast<int>(i)}}, "a");
+    }
+    ASSERT_LTE(table.getMemoryUsageBytes(), memoryLimit);
+    ASSERT_GT(table.numEvictedPartitions(), 0U);
+    ASSERT_LT(table.numEvictedPartitions(), table.numPartitions());
+    ASSERT_EQ(numDocs, table.numDocumentsInserted());
+
+    // Keys in evicted partitions cannot be answered, but every other key still finds its document.
+    size_t numUnanswered = 0;
+    for (size_t i = 0; i < numDocs; ++i) {
+        auto matches = table.find({Value(static_cast<int>(i))});
+        if (!matches) {
+            ++numUnanswered;
+            continue;
+        }
+        ASSERT_EQ(1U, matches->size());
+        ASSERT_DOCUMENT_EQ((Document{{"a", static_cast<int>(i)}}), matches->front());
+    }
+    ASSERT_GT(numUnanswered, 0U);
+    ASSERT_LT(numUnanswered, numDocs);
+}
+
+}  // namespace
+}  // namespace mongo
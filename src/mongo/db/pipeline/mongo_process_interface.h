@@ -47,6 +47,7 @@
 
 namespace mongo {
 
+class CollatorInterface;
 class ExpressionContext;
 class Pipeline;
 class PipelineDeleter;
@@ -127,11 +128,41 @@ public:
                                      const NamespaceString& nss,
                                      BSONObjBuilder* builder) const = 0;
 
+    /**
+     * Returns the total size in bytes of the documents in collection "nss", or boost::none if it
+     * is not known on this node. A collection which does not exist has a size of zero.
+     */
+    virtual boost::optional<long long> getCollectionDataSize(OperationContext* opCtx,
+                                                             const NamespaceString& nss) const = 0;
+
+    /**
+     * Returns true if collection "nss" has a ready, non-partial index which can answer equality
+     * matches on "field" under "collator", that is an ascending, descending or hashed index whose
+     * first key field is "field" and whose collation matches.
+     */
+    virtual bool hasIndexForEqualityMatch(OperationContext* opCtx,
+                                          const NamespaceString& nss,
+                                          const FieldPath& field,
+                                          const CollatorInterface* collator) const = 0;
+
     /**
      * Gets the collection options for the collection given by 'nss'.
      */
     virtual BSONObj getCollectionOptions(const NamespaceString& nss) = 0;
 
+    /**
+     * Builds the indexes described by 'indexSpecs' on the collection given by 'nss', skipping those
+     * which already exist. The build runs in the foreground and writes each index from its sorted
+     * keys in one pass, so it is meant for a collection that only the caller writes to. The
+     * database is locked exclusively only to start and to commit the build; the documents are
+     * scanned under an exclusive lock on the collection.
+     *
+     * Throws if the build fails, e.g. with DuplicateKey if a unique index would be violated.
+     */
+    virtual void createIndexes(OperationContext* opCtx,
+                               const NamespaceString& nss,
+                               const std::vector<BSONObj>& indexSpecs) = 0;
+
     /**
      * Performs the given rename command if the collection given by 'targetNs' has the same options
      * as specified in 'originalCollectionOptions', and has the same indexes as 'originalIndexes'.
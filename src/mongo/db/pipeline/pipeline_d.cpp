@@ -34,42 +34,57 @@
 
 #include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/background.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/catalog/document_validation.h"
 #include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/catalog/index_catalog_entry.h"
+#include "mongo/db/catalog/index_create.h"
 #include "mongo/db/catalog/uuid_catalog.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/collection_scan.h"
 #include "mongo/db/exec/fetch.h"
 #include "mongo/db/exec/index_iterator.h"
 #include "mongo/db/exec/multi_iterator.h"
 #include "mongo/db/exec/shard_filter.h"
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/field_ref.h"
 #include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index_names.h"
 #include "mongo/db/kill_sessions.h"
+#include "mongo/db/matcher/extensions_callback_noop.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/op_observer.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_change_stream.h"
+#include "mongo/db/pipeline/document_source_column_scan.h"
 #include "mongo/db/pipeline/document_source_cursor.h"
+#include "mongo/db/pipeline/document_source_exchange.h"
 #include "mongo/db/pipeline/document_source_geo_near.h"
 #include "mongo/db/pipeline/document_source_geo_near_cursor.h"
+#include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_merge_cursors.h"
 #include "mongo/db/pipeline/document_source_sample.h"
 #include "mongo/db/pipeline/document_source_sample_from_random_cursor.h"
 #include "mongo/db/pipeline/document_source_single_document_transformation.h"
 #include "mongo/db/pipeline/document_source_sort.h"
+#include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/planner_ixselect.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/s/collection_sharding_state.h"
 #include "mongo/db/s/sharding_state.h"
 #include "mongo/db/service_context.h"
@@ -85,6 +100,7 @@
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/grid.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/unordered_set.h"
 #include "mongo/util/log.h"
 #include "mongo/util/time_support.h"
 
@@ -270,6 +286,110 @@ StringData extractGeoNearFieldFromIndexes(OperationContext* opCtx, Collection* c
     }
     MONGO_UNREACHABLE;
 }
+/**
+ * Returns true if 'expr' or any of its children needs more of the document than the fields it
+ * reports as dependencies.
+ */
+bool needsWholeDocumentToMatch(const MatchExpression* expr) {
+    if (expr->matchType() == MatchExpression::WHERE || expr->matchType() == MatchExpression::TEXT) {
+        return true;
+    }
+    for (size_t i = 0; i < expr->numChildren(); i++) {
+        if (needsWholeDocumentToMatch(expr->getChild(i))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns true if any of 'collection''s indexes could answer a predicate in 'filter', which is how
+ * the query planner picks the indexes worth planning with.
+ */
+bool hasIndexedPredicate(OperationContext* opCtx,
+                         Collection* collection,
+                         const MatchExpression* filter) {
+    stdx::unordered_set<std::string> fields;
+    QueryPlannerIXSelect::getFields(filter, "", &fields);
+    if (fields.empty()) {
+        return false;
+    }
+
+    IndexCatalog::IndexIterator ii = collection->getIndexCatalog()->getIndexIterator(opCtx, false);
+    while (ii.more()) {
+        if (fields.count(ii.next()->keyPattern().firstElementFieldName())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns a $columnScan stage that reads the fields 'pipeline' depends on from the collection's
+ * column cache, or nullptr if the pipeline cannot be answered from cached columns. Only pipelines
+ * that continue with a $group are considered, since reducing a whole collection to a few groups
+ * is where skipping the collection scan pays off. A column scan reads every row, so queries
+ * whose $match an index could answer are left to the planner.
+ */
+intrusive_ptr<DocumentSource> createColumnScan(Collection* collection,
+                                               const AggregationRequest* aggRequest,
+                                               Pipeline* pipeline,
+                                               const DepsTracker& deps,
+                                               const BSONObj& queryObj) {
+    auto expCtx = pipeline->getContext();
+    auto opCtx = expCtx->opCtx;
+    const auto& sources = pipeline->getSources();
+
+    if (internalQueryColumnCacheMaxSizeMB.load() == 0 || !collection || collection->isCapped() ||
+        sources.empty() || !dynamic_cast<DocumentSourceGroup*>(sources.front().get())) {
+        return nullptr;
+    }
+
+    // Cached columns are only consistent with a snapshot opened now, so reads at a timestamp, in a
+    // transaction or within a write cannot use them. Explain needs a PlanExecutor to report on,
+    // and sharded reads need one to filter out orphans.
+    if (expCtx->explain || expCtx->fromMongos || expCtx->inMultiDocumentTransaction ||
+        (aggRequest && !aggRequest->getHint().isEmpty()) ||
+        opCtx->lockState()->inAWriteUnitOfWork() ||
+        opCtx->recoveryUnit()->getTimestampReadSource() != RecoveryUnit::ReadSource::kUnset) {
+        return nullptr;
+    }
+
+    if (deps.needWholeDocument || deps.getNeedsAnyMetadata()) {
+        return nullptr;
+    }
+    std::set<std::string> paths = deps.fields;
+
+    std::unique_ptr<MatchExpression> filter;
+    if (!queryObj.isEmpty()) {
+        filter = uassertStatusOK(MatchExpressionParser::parse(
+            queryObj, expCtx, ExtensionsCallbackNoop(), Pipeline::kAllowedMatcherFeatures));
+        filter = MatchExpression::optimize(std::move(filter));
+
+        DepsTracker filterDeps;
+        filter->addDependencies(&filterDeps);
+        if (filterDeps.needWholeDocument || needsWholeDocumentToMatch(filter.get()) ||
+            hasIndexedPredicate(opCtx, collection, filter.get())) {
+            return nullptr;
+        }
+        paths.insert(filterDeps.fields.begin(), filterDeps.fields.end());
+    }
+
+    // Columns hold whole top-level fields, which serve any dependency on their subfields.
+    std::set<std::string> fields;
+    for (auto&& path : paths) {
+        fields.insert(FieldRef(path).getPart(0).toString());
+    }
+
+    auto view = collection->infoCache()->getColumnCache()->getColumns(opCtx, collection, fields);
+    if (!view) {
+        return nullptr;
+    }
+
+    return DocumentSourceColumnScan::create(
+        expCtx, std::move(*view), fields, std::move(filter), queryObj);
+}
+
 }  // namespace
 
 void PipelineD::prepareCursorSource(Collection* collection,
@@ -353,6 +473,11 @@ void PipelineD::prepareGenericCursorSource(Collection* collection,
                                                      ? DepsTracker::MetadataAvailable::kTextScore
                                                      : DepsTracker::MetadataAvailable::kNoMetadata);
 
+    if (auto columnScan = createColumnScan(collection, aggRequest, pipeline, deps, queryObj)) {
+        pipeline->addInitialSource(std::move(columnScan));
+        return;
+    }
+
     BSONObj projForQuery = deps.toProjection();
 
     // Look for an initial sort; we'll try to add this to the Cursor we create. If we're successful
@@ -404,6 +529,75 @@ void PipelineD::prepareGenericCursorSource(Collection* collection,
                     projForQuery);
 }
 
+std::vector<RecordId> PipelineD::getExchangeSplitPoints(Collection* collection,
+                                                        const Pipeline* pipeline) {
+    const auto& sources = pipeline->getSources();
+    auto exchange =
+        sources.empty() ? nullptr : dynamic_cast<DocumentSourceExchange*>(sources.back().get());
+    if (!collection || collection->ns().isOplog() || !exchange || exchange->getConsumers() < 2) {
+        return {};
+    }
+
+    const auto& spec = exchange->getExchange()->getSpec();
+    if (spec.getPolicy() != ExchangePolicyEnum::kRoundRobin || spec.getOrderPreserving()) {
+        return {};
+    }
+
+    // A $text query needs its index, and stages such as $group or $limit would give each consumer
+    // a result over its own range only.
+    for (auto it = sources.begin(); it != std::prev(sources.end()); ++it) {
+        if (auto matchStage = dynamic_cast<DocumentSourceMatch*>(it->get())) {
+            if (matchStage->isTextQuery() ||
+                dynamic_cast<DocumentSourceOplogMatch*>(matchStage) != nullptr) {
+                return {};
+            }
+        } else if (!dynamic_cast<DocumentSourceSingleDocumentTransformation*>(it->get()) &&
+                   !dynamic_cast<DocumentSourceUnwind*>(it->get())) {
+            return {};
+        }
+    }
+
+    return collection->getRecordStore()->getRangeSplitPoints(pipeline->getContext()->opCtx,
+                                                             exchange->getConsumers());
+}
+
+void PipelineD::prepareRangeCursorSource(Collection* collection,
+                                         const RecordId& minRecord,
+                                         const RecordId& maxRecord,
+                                         Pipeline* pipeline) {
+    auto expCtx = pipeline->getContext();
+    auto opCtx = expCtx->opCtx;
+
+    // We are going to generate an input cursor, so we need to be holding the collection lock.
+    dassert(opCtx->lockState()->isCollectionLockedForMode(collection->ns().ns(), MODE_IS));
+
+    CollectionScanParams params;
+    params.collection = collection;
+    params.direction = CollectionScanParams::FORWARD;
+    params.minRecord = minRecord;
+    params.maxRecord = maxRecord;
+
+    auto ws = stdx::make_unique<WorkingSet>();
+    std::unique_ptr<PlanStage> stage =
+        stdx::make_unique<CollectionScan>(opCtx, params, ws.get(), nullptr);
+
+    // If we're in a sharded environment, we need to filter out documents we don't own.
+    if (ShardingState::get(opCtx)->needCollectionMetadata(opCtx, collection->ns().ns())) {
+        stage = stdx::make_unique<ShardFilterStage>(
+            opCtx,
+            CollectionShardingState::get(opCtx, collection->ns())->getMetadata(opCtx),
+            ws.get(),
+            stage.release());
+    }
+
+    auto exec = uassertStatusOK(PlanExecutor::make(
+        opCtx, std::move(ws), std::move(stage), collection, PlanExecutor::YIELD_AUTO));
+
+    addCursorSource(pipeline,
+                    DocumentSourceCursor::create(collection, std::move(exec), expCtx),
+                    pipeline->getDependencies(DepsTracker::MetadataAvailable::kNoMetadata));
+}
+
 void PipelineD::prepareGeoNearCursorSource(Collection* collection,
                                            const NamespaceString& nss,
                                            const AggregationRequest* aggRequest,
@@ -515,6 +709,14 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
         plannerOpts |= QueryPlannerParams::TRACK_LATEST_OPLOG_TS;
     }
 
+    // A sub-pipeline, such as that of a $lookup, is typically executed once per input document
+    // with only its constants changing. Its queries therefore all share a shape, and once a plan
+    // for that shape is active in the plan cache each of them only needs a short trial to confirm
+    // that the plan still performs as well as when it was cached.
+    if (expCtx->subPipelineDepth > 0) {
+        plannerOpts |= QueryPlannerParams::SHORT_CACHED_PLAN_TRIAL;
+    }
+
     const BSONObj emptyProjection;
     const BSONObj metaSortProjection = BSON("$meta"
                                             << "sortKey");
@@ -674,6 +876,10 @@ std::string PipelineD::getPlanSummaryStr(const Pipeline* pPipeline) {
         return docSourceCursor->getPlanSummaryStr();
     }
 
+    if (dynamic_cast<DocumentSourceColumnScan*>(pPipeline->_sources.front().get())) {
+        return "COLUMN_SCAN";
+    }
+
     return "";
 }
 
@@ -756,11 +962,119 @@ Status PipelineD::MongoDInterface::appendRecordCount(OperationContext* opCtx,
     return appendCollectionRecordCount(opCtx, nss, builder);
 }
 
+boost::optional<long long> PipelineD::MongoDInterface::getCollectionDataSize(
+    OperationContext* opCtx, const NamespaceString& nss) const {
+    AutoGetCollectionForRead autoColl(opCtx, nss);
+    Collection* collection = autoColl.getCollection();
+    if (!collection) {
+        return 0LL;
+    }
+    return collection->dataSize(opCtx);
+}
+
+bool PipelineD::MongoDInterface::hasIndexForEqualityMatch(OperationContext* opCtx,
+                                                          const NamespaceString& nss,
+                                                          const FieldPath& field,
+                                                          const CollatorInterface* collator) const {
+    AutoGetCollectionForRead autoColl(opCtx, nss);
+    Collection* collection = autoColl.getCollection();
+    if (!collection) {
+        return false;
+    }
+
+    const IndexCatalog* indexCatalog = collection->getIndexCatalog();
+    IndexCatalog::IndexIterator it = indexCatalog->getIndexIterator(opCtx, false);
+    while (it.more()) {
+        const IndexDescriptor* desc = it.next();
+        if (desc->isPartial()) {
+            continue;
+        }
+
+        const BSONObj& keyPattern = desc->keyPattern();
+        const auto pluginName = IndexNames::findPluginName(keyPattern);
+        if (pluginName != IndexNames::BTREE && pluginName != IndexNames::HASHED) {
+            continue;
+        }
+
+        if (keyPattern.firstElementFieldName() == field.fullPath() &&
+            CollatorInterface::collatorsMatch(indexCatalog->getEntry(desc)->getCollator(),
+                                              collator)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 BSONObj PipelineD::MongoDInterface::getCollectionOptions(const NamespaceString& nss) {
     const auto infos = _client.getCollectionInfos(nss.db().toString(), BSON("name" << nss.coll()));
     return infos.empty() ? BSONObj() : infos.front().getObjectField("options").getOwned();
 }
 
+void PipelineD::MongoDInterface::createIndexes(OperationContext* opCtx,
+                                               const NamespaceString& nss,
+                                               const std::vector<BSONObj>& indexSpecs) {
+    // Do not use AutoGetCollection because the database lock is relocked in mode IX while the
+    // documents are scanned.
+    Lock::DBLock dbLock(opCtx, nss.db(), MODE_X);
+    uassert(ErrorCodes::NotMaster,
+            str::stream() << "Not primary while creating indexes in " << nss.ns(),
+            repl::ReplicationCoordinator::get(opCtx)->canAcceptWritesFor(opCtx, nss));
+
+    // From here on a failed build must always be able to relock the database to clean up.
+    UninterruptibleLockGuard noInterrupt(opCtx->lockState());
+
+    Database* db = DatabaseHolder::getDatabaseHolder().get(opCtx, nss.db());
+    Collection* collection = db ? db->getCollection(opCtx, nss) : nullptr;
+    uassert(ErrorCodes::NamespaceNotFound,
+            str::stream() << "collection " << nss.ns() << " does not exist",
+            collection);
+
+    MultiIndexBlock indexer(opCtx, collection);
+    indexer.allowInterruption();
+
+    auto specs = indexSpecs;
+    indexer.removeExistingIndexes(&specs);
+    if (specs.empty()) {
+        return;
+    }
+
+    writeConflictRetry(opCtx, "createIndexes", nss.ns(), [&] {
+        uassertStatusOK(indexer.init(specs).getStatus());
+    });
+
+    // Registering the build keeps the collection and its database from being dropped or renamed
+    // while only the collection is locked exclusively.
+    BackgroundOperation backgroundOp(nss.ns());
+    opCtx->recoveryUnit()->abandonSnapshot();
+    dbLock.relockWithMode(MODE_IX);
+
+    try {
+        Lock::CollectionLock collLock(opCtx->lockState(), nss.ns(), MODE_X);
+        uassertStatusOK(indexer.insertAllDocumentsInCollection());
+    } catch (const DBException&) {
+        // The indexer cleans up the failed build when it is destroyed, which needs the exclusive
+        // database lock.
+        opCtx->recoveryUnit()->abandonSnapshot();
+        dbLock.relockWithMode(MODE_X);
+        throw;
+    }
+
+    opCtx->recoveryUnit()->abandonSnapshot();
+    dbLock.relockWithMode(MODE_X);
+    uassert(ErrorCodes::NotMaster,
+            str::stream() << "Not primary while completing index build in " << nss.ns(),
+            repl::ReplicationCoordinator::get(opCtx)->canAcceptWritesFor(opCtx, nss));
+
+    writeConflictRetry(opCtx, "createIndexes", nss.ns(), [&] {
+        WriteUnitOfWork wunit(opCtx);
+        indexer.commit([opCtx, &nss, collection](const BSONObj& spec) {
+            opCtx->getServiceContext()->getOpObserver()->onCreateIndex(
+                opCtx, nss, collection->uuid(), spec, false);
+        });
+        wunit.commit();
+    });
+}
+
 void PipelineD::MongoDInterface::renameIfOptionsAndIndexesHaveNotChanged(
     OperationContext* opCtx,
     const BSONObj& renameCommandObj,
@@ -30,6 +30,7 @@
 
 #include <boost/intrusive_ptr.hpp>
 #include <memory>
+#include <vector>
 
 #include "mongo/bson/bsonobj.h"
 #include "mongo/db/dbdirectclient.h"
@@ -38,6 +39,7 @@
 #include "mongo/db/pipeline/document_source_cursor.h"
 #include "mongo/db/pipeline/mongo_process_common.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/record_id.h"
 
 namespace mongo {
 class Collection;
@@ -85,7 +87,16 @@ public:
         Status appendRecordCount(OperationContext* opCtx,
                                  const NamespaceString& nss,
                                  BSONObjBuilder* builder) const final;
+        boost::optional<long long> getCollectionDataSize(OperationContext* opCtx,
+                                                         const NamespaceString& nss) const final;
+        bool hasIndexForEqualityMatch(OperationContext* opCtx,
+                                      const NamespaceString& nss,
+                                      const FieldPath& field,
+                                      const CollatorInterface* collator) const final;
         BSONObj getCollectionOptions(const NamespaceString& nss) final;
+        void createIndexes(OperationContext* opCtx,
+                           const NamespaceString& nss,
+                           const std::vector<BSONObj>& indexSpecs) final;
         void renameIfOptionsAndIndexesHaveNotChanged(
             OperationContext* opCtx,
             const BSONObj& renameCommandObj,
@@ -172,6 +183,32 @@ public:
                                            const AggregationRequest* aggRequest,
                                            Pipeline* pipeline);
 
+    /**
+     * Returns the RecordIds at which 'collection' can be split so that each consumer of the
+     * $exchange ending 'pipeline' reads its own range of the collection instead of sharing one
+     * producer, or an empty vector if the consumers must share the producer. See
+     * prepareRangeCursorSource().
+     *
+     * This is only done for a roundrobin $exchange which need not preserve order, when every stage
+     * before the $exchange filters or transforms single documents, so that those stages give the
+     * same results whichever consumer runs them. 'pipeline' must already be optimized and must not
+     * have a cursor source yet.
+     */
+    static std::vector<RecordId> getExchangeSplitPoints(Collection* collection,
+                                                        const Pipeline* pipeline);
+
+    /**
+     * Attaches a cursor source to the front of 'pipeline' which scans the records of 'collection'
+     * with ids in ['minRecord', 'maxRecord') without using an index. A null bound leaves that side
+     * of the range open. Unlike prepareCursorSource(), an initial $match stays in the pipeline.
+     *
+     * Callers must take care to ensure that the collection is locked in at least IS-mode.
+     */
+    static void prepareRangeCursorSource(Collection* collection,
+                                         const RecordId& minRecord,
+                                         const RecordId& maxRecord,
+                                         Pipeline* pipeline);
+
     /**
      * Injects a MongodInterface into stages which require access to mongod-specific functionality.
      */
@@ -88,10 +88,28 @@ public:
         MONGO_UNREACHABLE;
     }
 
+    boost::optional<long long> getCollectionDataSize(OperationContext* opCtx,
+                                                     const NamespaceString& nss) const override {
+        return boost::none;
+    }
+
+    bool hasIndexForEqualityMatch(OperationContext* opCtx,
+                                  const NamespaceString& nss,
+                                  const FieldPath& field,
+                                  const CollatorInterface* collator) const override {
+        return false;
+    }
+
     BSONObj getCollectionOptions(const NamespaceString& nss) override {
         MONGO_UNREACHABLE;
     }
 
+    void createIndexes(OperationContext* opCtx,
+                       const NamespaceString& nss,
+                       const std::vector<BSONObj>& indexSpecs) override {
+        MONGO_UNREACHABLE;
+    }
+
     void renameIfOptionsAndIndexesHaveNotChanged(
         OperationContext* opCtx,
         const BSONObj& renameCommandObj,
@@ -0,0 +1,270 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/collection_statistics.h"
+
+#include <algorithm>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/concurrency/locker.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/db/service_context.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+namespace {
+
+const auto getCollectionStatisticsCache =
+    ServiceContext::declareDecoration<CollectionStatisticsCache>();
+
+const char kCollectionField[] = "collection";
+const char kFieldField[] = "field";
+
+// The number of candidate solutions discarded before multi-planning because the statistics
+// estimated them to be much more expensive than another candidate.
+Counter64 solutionsPrunedByStatistics;
+ServerStatusMetricField<Counter64> displaySolutionsPrunedByStatistics(
+    "query.planner.solutionsPrunedByStatistics", &solutionsPrunedByStatistics);
+
+boost::optional<double> estimateNodeCost(OperationContext* opCtx,
+                                         Collection* collection,
+                                         const QuerySolutionNode* node) {
+    switch (node->getType()) {
+        case STAGE_COLLSCAN:
+            return static_cast<double>(collection->numRecords(opCtx));
+        case STAGE_IXSCAN: {
+            auto ixscan = static_cast<const IndexScanNode*>(node);
+            const IndexEntry& index = ixscan->index;
+
+            // Statistics describe the values of the fields, not the keys of indexes which
+            // transform them or omit some of the documents.
+            if (index.type != INDEX_BTREE || index.collator || index.filterExpr ||
+                ixscan->bounds.isSimpleRange || ixscan->bounds.fields.empty()) {
+                return boost::none;
+            }
+
+            auto stats = CollectionStatisticsCache::get(opCtx).find(
+                opCtx, collection, index.keyPattern.firstElementFieldName());
+            if (!stats) {
+                return boost::none;
+            }
+
+            // Only the bounds of the leading field are estimated, so scans which are further
+            // restricted by the bounds of the other fields are over-estimated.
+            double keys = 0;
+            for (auto&& interval : ixscan->bounds.fields[0].intervals) {
+                keys += stats->estimateKeys(interval);
+            }
+            return keys;
+        }
+        default:
+            break;
+    }
+
+    if (node->children.empty()) {
+        return boost::none;
+    }
+
+    double cost = 0;
+    for (auto&& child : node->children) {
+        auto childCost = estimateNodeCost(opCtx, collection, child);
+        if (!childCost) {
+            return boost::none;
+        }
+        cost += *childCost;
+    }
+    return cost;
+}
+
+}  // namespace
+
+CollectionStatisticsCache& CollectionStatisticsCache::get(ServiceContext* service) {
+    return getCollectionStatisticsCache(service);
+}
+
+CollectionStatisticsCache& CollectionStatisticsCache::get(OperationContext* opCtx) {
+    return getCollectionStatisticsCache(opCtx->getServiceContext());
+}
+
+BSONObj CollectionStatisticsCache::makeId(CollectionUUID uuid, StringData path) {
+    BSONObjBuilder builder;
+    uuid.appendToBuilder(&builder, kCollectionField);
+    builder.append(kFieldField, path);
+    return builder.obj();
+}
+
+std::shared_ptr<const FieldStatistics> CollectionStatisticsCache::find(OperationContext* opCtx,
+                                                                       Collection* collection,
+                                                                       StringData path) {
+    auto uuid = collection->uuid();
+    if (!uuid) {
+        return nullptr;
+    }
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        auto it = _collections.find(*uuid);
+        if (it != _collections.end()) {
+            auto fieldIt = it->second.find(path);
+            return fieldIt == it->second.end() ? nullptr : fieldIt->second;
+        }
+    }
+
+    // Read the statistics without holding the mutex. If another operation loads them first, its
+    // copy is kept.
+    FieldMap fields = load(opCtx, collection, *uuid);
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto& cached = _collections.emplace(*uuid, std::move(fields)).first->second;
+    auto fieldIt = cached.find(path);
+    return fieldIt == cached.end() ? nullptr : fieldIt->second;
+}
+
+void CollectionStatisticsCache::onExternalChange(OperationContext* opCtx) {
+    auto clear = [service = opCtx->getServiceContext()] {
+        auto& cache = get(service);
+        stdx::lock_guard<stdx::mutex> lk(cache._mutex);
+        cache._collections.clear();
+    };
+
+    if (!opCtx->lockState()->inAWriteUnitOfWork()) {
+        clear();
+        return;
+    }
+    opCtx->recoveryUnit()->onCommit([clear](boost::optional<Timestamp>) { clear(); });
+}
+
+CollectionStatisticsCache::FieldMap CollectionStatisticsCache::load(OperationContext* opCtx,
+                                                                    Collection* collection,
+                                                                    CollectionUUID uuid) {
+    FieldMap fields;
+
+    const NamespaceString statsNss(collection->ns().db(),
+                                   NamespaceString::kSystemDotStatisticsCollectionName);
+
+    // The caller only holds a lock on the collection being queried, and the database lock which
+    // that implies.
+    Lock::CollectionLock statsLock(opCtx->lockState(), statsNss.ns(), MODE_IS);
+    Database* db = DatabaseHolder::getDatabaseHolder().get(opCtx, statsNss.db());
+    Collection* statsCollection = db ? db->getCollection(opCtx, statsNss) : nullptr;
+    if (!statsCollection) {
+        return fields;
+    }
+
+    // There is one document per analyzed field of the database, so a collection scan is cheap.
+    auto exec = InternalPlanner::collectionScan(
+        opCtx, statsNss.ns(), statsCollection, PlanExecutor::NO_YIELD);
+    BSONObj obj;
+    while (exec->getNext(&obj, nullptr) == PlanExecutor::ADVANCED) {
+        BSONElement id = obj["_id"];
+        if (id.type() != Object) {
+            continue;
+        }
+        auto docUUID = UUID::parse(id[kCollectionField]);
+        if (!docUUID.isOK() || docUUID.getValue() != uuid ||
+            id[kFieldField].type() != String) {
+            continue;
+        }
+
+        auto stats = FieldStatistics::parse(obj);
+        if (!stats.isOK()) {
+            warning() << "Ignoring invalid statistics " << redact(id.toString(false)) << " in "
+                      << statsNss << ": " << stats.getStatus();
+            continue;
+        }
+        fields[id[kFieldField].valueStringData()] =
+            std::make_shared<const FieldStatistics>(std::move(stats.getValue()));
+    }
+    return fields;
+}
+
+boost::optional<double> estimateSolutionCost(OperationContext* opCtx,
+                                             Collection* collection,
+                                             const QuerySolution& solution) {
+    return estimateNodeCost(opCtx, collection, solution.root.get());
+}
+
+void rankSolutionsUsingStatistics(OperationContext* opCtx,
+                                  Collection* collection,
+                                  const CanonicalQuery& query,
+                                  std::vector<std::unique_ptr<QuerySolution>>* solutions) {
+    const QueryRequest& qr = query.getQueryRequest();
+    if (solutions->size() < 2 || qr.getLimit() || qr.getNToReturn()) {
+        return;
+    }
+
+    std::vector<std::pair<double, std::unique_ptr<QuerySolution>>> estimated;
+    std::vector<std::unique_ptr<QuerySolution>> unknown;
+    for (auto&& solution : *solutions) {
+        if (auto cost = estimateSolutionCost(opCtx, collection, *solution)) {
+            estimated.emplace_back(*cost, std::move(solution));
+        } else {
+            unknown.push_back(std::move(solution));
+        }
+    }
+    solutions->clear();
+
+    std::stable_sort(estimated.begin(),
+                     estimated.end(),
+                     [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+    // Compare against at least one key, so that an estimate of zero for the cheapest solution
+    // does not discard every other one.
+    const double maxCost = estimated.empty()
+        ? 0
+        : std::max(estimated.front().first, 1.0) *
+            internalQueryPlannerStatisticsPruneFactor.load();
+    for (auto&& candidate : estimated) {
+        if (!solutions->empty() && candidate.first > maxCost) {
+            LOG(2) << "Discarding solution estimated to examine " << candidate.first
+                   << " keys and documents: " << redact(candidate.second->toString());
+            solutionsPrunedByStatistics.increment();
+            continue;
+        }
+        solutions->push_back(std::move(candidate.second));
+    }
+    for (auto&& solution : unknown) {
+        solutions->push_back(std::move(solution));
+    }
+}
+
+}  // namespace mongo
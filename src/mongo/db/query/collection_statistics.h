@@ -0,0 +1,116 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <memory>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/query/field_statistics.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/unordered_map.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+class CanonicalQuery;
+class Collection;
+class OperationContext;
+class ServiceContext;
+struct QuerySolution;
+
+/**
+ * Caches the field statistics built by the 'analyze' command. Statistics are persisted in the
+ * 'system.statistics' collection of the analyzed collection's database, one document per field
+ * with the _id {collection: <uuid>, field: <path>}, and are read from there the first time the
+ * planner needs the statistics of a collection.
+ */
+class CollectionStatisticsCache {
+    MONGO_DISALLOW_COPYING(CollectionStatisticsCache);
+
+public:
+    CollectionStatisticsCache() = default;
+
+    static CollectionStatisticsCache& get(ServiceContext* service);
+    static CollectionStatisticsCache& get(OperationContext* opCtx);
+
+    /**
+     * Returns the _id of the 'system.statistics' document for field 'path' of the collection with
+     * UUID 'uuid'.
+     */
+    static BSONObj makeId(CollectionUUID uuid, StringData path);
+
+    /**
+     * Returns the statistics of field 'path' of 'collection', or nullptr if the field has not been
+     * analyzed. The caller must hold at least an intent lock on the collection's database.
+     */
+    std::shared_ptr<const FieldStatistics> find(OperationContext* opCtx,
+                                                Collection* collection,
+                                                StringData path);
+
+    /**
+     * Called when a 'system.statistics' collection is written, including by replication. Forgets
+     * all of the cached statistics once the write commits, so that they are read again.
+     */
+    static void onExternalChange(OperationContext* opCtx);
+
+private:
+    using FieldMap = StringMap<std::shared_ptr<const FieldStatistics>>;
+
+    FieldMap load(OperationContext* opCtx, Collection* collection, CollectionUUID uuid);
+
+    stdx::mutex _mutex;
+    stdx::unordered_map<CollectionUUID, FieldMap, CollectionUUID::Hash> _collections;
+};
+
+/**
+ * Returns the estimated number of index keys and documents 'solution' examines, according to the
+ * statistics of the fields it scans, or boost::none if any of them has not been analyzed or the
+ * solution uses a stage whose cost cannot be estimated.
+ */
+boost::optional<double> estimateSolutionCost(OperationContext* opCtx,
+                                             Collection* collection,
+                                             const QuerySolution& solution);
+
+/**
+ * Orders 'solutions' by their estimated cost, cheapest first, and discards those estimated to
+ * cost more than 'internalQueryPlannerStatisticsPruneFactor' times as much as the cheapest. The
+ * solutions whose cost cannot be estimated are kept, after the others. Leaves 'solutions'
+ * untouched for queries with a limit, as the cost model does not account for scans that stop
+ * early.
+ */
+void rankSolutionsUsingStatistics(OperationContext* opCtx,
+                                  Collection* collection,
+                                  const CanonicalQuery& query,
+                                  std::vector<std::unique_ptr<QuerySolution>>* solutions);
+
+}  // namespace mongo
@@ -0,0 +1,366 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/column_cache.h"
+
+#include <algorithm>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/concurrency/locker.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/db/storage/recovery_unit.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+namespace {
+
+const uint64_t kWritesInProgressMask = 0xffffffff;
+
+// Adding this to the write state counts one more write in progress; adding kWriteFinished then
+// moves it to the finished writes.
+const uint64_t kWriteStarted = 1;
+const uint64_t kWriteFinished = (uint64_t(1) << 32) - 1;
+
+// How many changed records are fetched between interrupt checks.
+const size_t kInterruptCheckPeriod = 1024;
+
+// Bytes held by the cached columns of all collections.
+AtomicInt64 totalCachedBytes(0);
+
+size_t maxCachedBytes() {
+    return static_cast<size_t>(internalQueryColumnCacheMaxSizeMB.load()) * 1024 * 1024;
+}
+
+/**
+ * Past this many changed rows, fetching them on every read costs more than rebuilding the
+ * columns once.
+ */
+size_t maxChangedIds(long long numRows) {
+    return std::max(1024LL, numRows / 16);
+}
+
+bool fieldNameLess(const std::string& a, StringData b) {
+    return StringData(a) < b;
+}
+
+}  // namespace
+
+/**
+ * Counts a write as finished once its unit of work commits or rolls back.
+ */
+class ColumnCache::WriteTracker : public RecoveryUnit::Change {
+public:
+    explicit WriteTracker(ColumnCache* cache) : _cache(cache) {}
+
+    void commit(boost::optional<Timestamp>) final {
+        _cache->_writeState.fetchAndAdd(kWriteFinished);
+    }
+
+    void rollback() final {
+        _cache->_writeState.fetchAndAdd(kWriteFinished);
+    }
+
+private:
+    ColumnCache* const _cache;
+};
+
+void ColumnCache::Column::append(const BSONElement& elem) {
+    if (elem.eoo()) {
+        _offsets.push_back(kMissing);
+        return;
+    }
+
+    _offsets.push_back(_data.size());
+    _data.insert(_data.end(), elem.rawdata(), elem.rawdata() + elem.size());
+}
+
+ColumnCache::ColumnSet::ColumnSet(const std::set<std::string>& fields)
+    : fieldNames(fields.begin(), fields.end()), columns(fields.size()) {}
+
+const ColumnCache::Column* ColumnCache::ColumnSet::getColumn(StringData fieldName) const {
+    auto it = std::lower_bound(fieldNames.begin(), fieldNames.end(), fieldName, fieldNameLess);
+    if (it == fieldNames.end() || StringData(*it) != fieldName) {
+        return nullptr;
+    }
+    return &columns[it - fieldNames.begin()];
+}
+
+bool ColumnCache::ColumnSet::containsFields(const std::set<std::string>& fields) const {
+    return std::includes(fieldNames.begin(), fieldNames.end(), fields.begin(), fields.end());
+}
+
+void ColumnCache::ColumnSet::appendRow(const RecordId& id, const BSONObj& doc) {
+    invariant(recordIds.empty() || recordIds.back() < id);
+
+    size_t numFound = 0;
+    for (BSONObjIterator it(doc); it.more() && numFound < columns.size();) {
+        const BSONElement elem = it.next();
+        auto name = std::lower_bound(
+            fieldNames.begin(), fieldNames.end(), elem.fieldNameStringData(), fieldNameLess);
+        if (name == fieldNames.end() || *name != elem.fieldNameStringData()) {
+            continue;
+        }
+
+        // Like BSONObj::getField(), use the first occurrence of a field name.
+        Column& column = columns[name - fieldNames.begin()];
+        if (column.size() == numRows) {
+            column.append(elem);
+            bytes += elem.size();
+            numFound++;
+        }
+    }
+
+    for (auto&& column : columns) {
+        if (column.size() == numRows) {
+            column.append(BSONElement());
+        }
+    }
+    recordIds.push_back(id);
+    bytes += columns.size() * sizeof(uint32_t) + sizeof(RecordId);
+    numRows++;
+}
+
+ColumnCache::~ColumnCache() {
+    if (_columns) {
+        totalCachedBytes.subtractAndFetch(_columns->bytes);
+    }
+}
+
+void ColumnCache::notifyOfWrite(OperationContext* opCtx, const RecordId& id) {
+    if (_writeStarted(opCtx)) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _changedIds.insert(id);
+        if (_changedIds.size() > _maxChangedIds) {
+            _dropColumns_inlock();
+            _trackingWrites.store(false);
+        }
+    }
+}
+
+void ColumnCache::notifyOfInserts(OperationContext* opCtx, const std::vector<Record>& records) {
+    if (_writeStarted(opCtx)) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        for (auto&& record : records) {
+            _changedIds.insert(record.id);
+        }
+        if (_changedIds.size() > _maxChangedIds) {
+            _dropColumns_inlock();
+            _trackingWrites.store(false);
+        }
+    }
+}
+
+void ColumnCache::notifyOfTruncate(OperationContext* opCtx) {
+    _writeStarted(opCtx);
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _dropColumns_inlock();
+    _trackingWrites.store(false);
+}
+
+bool ColumnCache::_writeStarted(OperationContext* opCtx) {
+    invariant(opCtx->lockState()->inAWriteUnitOfWork());
+    _writeState.fetchAndAdd(kWriteStarted);
+    opCtx->recoveryUnit()->registerChange(new WriteTracker(this));
+
+    // A build sets '_trackingWrites' before checking that no write is in progress, so either it
+    // waits for this write to finish or this write sees it is tracking.
+    return _trackingWrites.load();
+}
+
+boost::optional<ColumnCache::View> ColumnCache::getColumns(OperationContext* opCtx,
+                                                           Collection* collection,
+                                                           const std::set<std::string>& fields) {
+    invariant(!opCtx->lockState()->inAWriteUnitOfWork());
+
+    bool cached;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        cached = _columns && _columns->containsFields(fields);
+    }
+    if (!cached && !_buildColumns(opCtx, collection, fields)) {
+        return boost::none;
+    }
+
+    return _makeView(opCtx, collection, fields);
+}
+
+bool ColumnCache::_buildColumns(OperationContext* opCtx,
+                                Collection* collection,
+                                const std::set<std::string>& fields) {
+    const uint64_t writeState = _writeState.load();
+
+    std::set<std::string> fieldsToBuild = fields;
+    uint64_t epoch;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_building) {
+            return false;
+        }
+
+        // Rebuild the cached fields as well, so that queries on different fields can share one
+        // set of columns.
+        if (_columns) {
+            fieldsToBuild.insert(_columns->fieldNames.begin(), _columns->fieldNames.end());
+        }
+
+        if (!_tooLargeFields.empty() && _tooLargeWriteState == writeState &&
+            std::includes(fieldsToBuild.begin(),
+                          fieldsToBuild.end(),
+                          _tooLargeFields.begin(),
+                          _tooLargeFields.end())) {
+            return false;
+        }
+
+        // A write in progress may have changed records without recording them, so the scan
+        // could not tell which of its rows are stale. Leave any cached columns in place and let a
+        // later query build the new ones.
+        _trackingWrites.store(true);
+        if ((_writeState.load() & kWritesInProgressMask) != 0) {
+            _trackingWrites.store(bool(_columns));
+            return false;
+        }
+
+        // Every record changed from here on is recorded, so rows the scan reads before they
+        // change, or reads from different snapshots across yields, are known to be stale.
+        _dropColumns_inlock();
+        _maxChangedIds = maxChangedIds(collection->numRecords(opCtx));
+        _building = true;
+        epoch = _epoch;
+    }
+
+    ON_BLOCK_EXIT([ this, epoch, alive = std::weak_ptr<bool>(_alive) ] {
+        if (alive.expired()) {
+            return;
+        }
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_building && _epoch == epoch) {
+            _dropColumns_inlock();
+            _trackingWrites.store(false);
+        }
+    });
+
+    // The operation may already hold a snapshot opened before tracking started, for example one an
+    // outer cursor is still reading from. A write committed since then would be neither visible
+    // to the scan nor recorded, so start the scan from a new snapshot.
+    opCtx->recoveryUnit()->abandonSnapshot();
+
+    const size_t maxBytes = maxCachedBytes();
+    auto columns = std::make_shared<ColumnSet>(fieldsToBuild);
+    auto exec = InternalPlanner::collectionScan(
+        opCtx, collection->ns().ns(), collection, PlanExecutor::YIELD_AUTO);
+
+    BSONObj doc;
+    RecordId id;
+    PlanExecutor::ExecState state;
+    while (PlanExecutor::ADVANCED == (state = exec->getNext(&doc, &id))) {
+        columns->appendRow(id, doc);
+        if (columns->bytes > maxBytes) {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _tooLargeFields = std::move(fieldsToBuild);
+            _tooLargeWriteState = writeState;
+            return false;
+        }
+    }
+    if (state != PlanExecutor::IS_EOF) {
+        uassertStatusOK(WorkingSetCommon::getMemberObjectStatus(doc));
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (_epoch != epoch) {
+        // The collection was truncated, or too many records changed, during the scan.
+        return false;
+    }
+
+    // If too many records changed during the scan, or other collections' columns already use up
+    // the budget, the guard stops tracking writes.
+    _maxChangedIds = maxChangedIds(columns->numRows);
+    if (_changedIds.size() > _maxChangedIds) {
+        return false;
+    }
+    if (totalCachedBytes.addAndFetch(columns->bytes) > static_cast<long long>(maxBytes)) {
+        totalCachedBytes.subtractAndFetch(columns->bytes);
+        return false;
+    }
+
+    _columns = std::move(columns);
+    _building = false;
+    return true;
+}
+
+boost::optional<ColumnCache::View> ColumnCache::_makeView(OperationContext* opCtx,
+                                                          Collection* collection,
+                                                          const std::set<std::string>& fields) {
+    // Open the snapshot before reading '_changedIds'. Every write records the records it changes
+    // before it commits, so all changes visible in the snapshot are then listed.
+    opCtx->recoveryUnit()->abandonSnapshot();
+    opCtx->recoveryUnit()->preallocateSnapshot();
+
+    View view;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (!_columns || !_columns->containsFields(fields)) {
+            // Dropped since they were found or built.
+            return boost::none;
+        }
+        view.columns = _columns;
+        view.changedIds.assign(_changedIds.begin(), _changedIds.end());
+    }
+
+    auto changedRows = std::make_shared<ColumnSet>(
+        std::set<std::string>(view.columns->fieldNames.begin(), view.columns->fieldNames.end()));
+    auto cursor = collection->getCursor(opCtx);
+    for (size_t i = 0; i < view.changedIds.size(); i++) {
+        if (i % kInterruptCheckPeriod == 0) {
+            opCtx->checkForInterrupt();
+        }
+        if (auto record = cursor->seekExact(view.changedIds[i])) {
+            changedRows->appendRow(record->id, record->data.toBson());
+        }
+    }
+    view.changedRows = std::move(changedRows);
+    return view;
+}
+
+void ColumnCache::_dropColumns_inlock() {
+    if (_columns) {
+        totalCachedBytes.subtractAndFetch(_columns->bytes);
+        _columns.reset();
+    }
+    _changedIds.clear();
+    _building = false;
+    _epoch++;
+}
+
+}  // namespace mongo
@@ -0,0 +1,228 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonelement.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/record_id.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/mutex.h"
+
+namespace mongo {
+
+class Collection;
+class OperationContext;
+struct Record;
+
+/**
+ * An in-memory, column-oriented copy of some top-level fields of every document in a collection.
+ * Analytic aggregations that only need those fields read the columns instead of scanning and
+ * decoding the collection's documents.
+ *
+ * The columns are built lazily by the first query that needs them. Writes do not touch them:
+ * each write records the ids of the records it changes, and readers fetch the current values of
+ * those records in their own snapshot and use them in place of the cached rows. Once more than a
+ * small fraction of the rows have changed, the columns are dropped and rebuilt by the next query,
+ * so the cache suits collections that are read far more often than they are written.
+ *
+ * All methods are thread-safe.
+ */
+class ColumnCache {
+    MONGO_DISALLOW_COPYING(ColumnCache);
+
+public:
+    /**
+     * The values of one field, one element per document in RecordId order. Elements are stored
+     * back to back with their field names, so they can be handed out as BSONElements.
+     */
+    class Column {
+    public:
+        size_t size() const {
+            return _offsets.size();
+        }
+
+        /**
+         * Returns the value of the field in the document at position 'row', or an EOO element if
+         * the document does not have the field.
+         */
+        BSONElement at(size_t row) const {
+            const uint32_t offset = _offsets[row];
+            return offset == kMissing ? BSONElement() : BSONElement(_data.data() + offset);
+        }
+
+        /**
+         * Appends the value of the field in the next document. 'elem' may be EOO.
+         */
+        void append(const BSONElement& elem);
+
+        size_t bytes() const {
+            return _data.size() + _offsets.size() * sizeof(uint32_t);
+        }
+
+    private:
+        static constexpr uint32_t kMissing = 0xffffffff;
+
+        std::vector<char> _data;
+        std::vector<uint32_t> _offsets;
+    };
+
+    /**
+     * A set of columns holding the same documents, immutable once built.
+     */
+    struct ColumnSet {
+        explicit ColumnSet(const std::set<std::string>& fields);
+
+        // Sorted field names, parallel to 'columns'.
+        std::vector<std::string> fieldNames;
+        std::vector<Column> columns;
+
+        // The id of the document in each row, in increasing order.
+        std::vector<RecordId> recordIds;
+
+        size_t numRows = 0;
+        size_t bytes = 0;
+
+        /**
+         * Returns the column holding 'fieldName', or nullptr if it is not part of this set.
+         */
+        const Column* getColumn(StringData fieldName) const;
+
+        bool containsFields(const std::set<std::string>& fields) const;
+
+        /**
+         * Appends a row holding the fields of 'doc'. 'id' must be greater than the id of every
+         * row already appended.
+         */
+        void appendRow(const RecordId& id, const BSONObj& doc);
+    };
+
+    /**
+     * The documents of a collection as of one snapshot. They are the rows of 'columns', except
+     * that the rows whose ids are in 'changedIds' must be skipped: 'changedRows' holds the current
+     * values of those documents that exist in the snapshot instead.
+     */
+    struct View {
+        std::shared_ptr<const ColumnSet> columns;
+        std::vector<RecordId> changedIds;  // Sorted.
+        std::shared_ptr<const ColumnSet> changedRows;
+    };
+
+    ColumnCache() = default;
+    ~ColumnCache();
+
+    /**
+     * One of these must be called by every write to the collection from within the write's
+     * WriteUnitOfWork, after the records have been written but before the write commits.
+     */
+    void notifyOfWrite(OperationContext* opCtx, const RecordId& id);
+    void notifyOfInserts(OperationContext* opCtx, const std::vector<Record>& records);
+    void notifyOfTruncate(OperationContext* opCtx);
+
+    /**
+     * Returns the documents of 'collection' as of a snapshot opened during this call, holding at
+     * least the top-level fields in 'fields'. If the cached columns do not hold those fields, they
+     * are built first by a collection scan, which yields its locks like any other. Returns
+     * boost::none if the columns would exceed internalQueryColumnCacheMaxSizeMB, or if they cannot
+     * be built right now because another operation is building them or writes are in progress.
+     *
+     * Abandons the operation's snapshot, so the caller must hold at least an intent shared lock
+     * on the collection, must not be in a WriteUnitOfWork and must not be reading at a timestamp.
+     * Throws if the collection is dropped while the scan yields.
+     */
+    boost::optional<View> getColumns(OperationContext* opCtx,
+                                     Collection* collection,
+                                     const std::set<std::string>& fields);
+
+private:
+    class WriteTracker;
+
+    /**
+     * Counts a write as in progress until its unit of work ends. Returns true if the ids of the
+     * records it changes must be added to '_changedIds'.
+     */
+    bool _writeStarted(OperationContext* opCtx);
+
+    /**
+     * Builds columns holding 'fields' and the fields already cached, and caches them. Returns
+     * false if they were not cached.
+     */
+    bool _buildColumns(OperationContext* opCtx,
+                       Collection* collection,
+                       const std::set<std::string>& fields);
+
+    boost::optional<View> _makeView(OperationContext* opCtx,
+                                    Collection* collection,
+                                    const std::set<std::string>& fields);
+
+    /**
+     * Drops the cached columns and the records changed since they were built. A build in progress
+     * will not be cached. Leaves '_trackingWrites' to the caller.
+     */
+    void _dropColumns_inlock();
+
+    // The low 32 bits count the writes in progress and the high 32 bits count finished writes,
+    // so any write that starts or finishes changes the value.
+    AtomicUInt64 _writeState{0};
+
+    // Set while columns are cached or being built, so that writes record the records they change.
+    AtomicWord<bool> _trackingWrites{false};
+
+    stdx::mutex _mutex;
+    std::shared_ptr<const ColumnSet> _columns;
+
+    // The records changed since '_columns', or the columns being built, were started.
+    std::set<RecordId> _changedIds;
+    size_t _maxChangedIds = 0;
+
+    bool _building = false;
+
+    // Incremented each time the columns are dropped, so that a build started before that is not
+    // cached.
+    uint64_t _epoch = 0;
+
+    // The fields of the last column set found to be too large, and the write state at that time,
+    // so that the same columns are not rebuilt until the collection changes.
+    std::set<std::string> _tooLargeFields;
+    uint64_t _tooLargeWriteState = 0;
+
+    // Destroyed with the cache. A build whose scan yielded checks it before touching the cache
+    // again, since the collection may have been dropped meanwhile.
+    const std::shared_ptr<bool> _alive = std::make_shared<bool>(true);
+};
+
+}  // namespace mongo
@@ -356,6 +356,11 @@ void Explain::statsToBSON(const PlanStageStats& stats,
                 bob->appendNumber(string(stream() << "failedAnd_" << i), spec->failedAnd[i]);
             }
         }
+    } else if (STAGE_CACHED_PLAN == stats.stageType) {
+        CachedPlanStats* spec = static_cast<CachedPlanStats*>(stats.specific.get());
+        if (spec->planCacheVariant) {
+            bob->appendNumber("planCacheVariant", static_cast<long long>(*spec->planCacheVariant));
+        }
     } else if (STAGE_COLLSCAN == stats.stageType) {
         CollectionScanStats* spec = static_cast<CollectionScanStats*>(stats.specific.get());
         bob->append("direction", spec->direction > 0 ? "forward" : "backward");
@@ -781,6 +786,16 @@ void Explain::generateExecutionInfo(PlanExecutor* exec,
     const auto winningExecStats = getWinningPlanStatsTree(exec);
     generateSinglePlanExecutionInfo(winningExecStats.get(), verbosity, totalTimeMillis, &execBob);
 
+    // If several plans were ranked against each other, report the cost of the trial period.
+    if (const auto mps = getMultiPlanStage(exec->getRootStage())) {
+        const auto* mpsStats = static_cast<const MultiPlanStats*>(mps->getSpecificStats());
+        BSONObjBuilder trialBob(execBob.subobjStart("multiPlannerTrial"));
+        trialBob.appendNumber("candidates", mps->getChildren().size());
+        trialBob.appendNumber("candidatesPruned", mpsStats->candidatesPruned);
+        trialBob.appendNumber("works", mpsStats->trialWorks);
+        trialBob.doneFast();
+    }
+
     // Also generate exec stats for all plans, if the verbosity level is high enough.
     // These stats reflect what happened during the trial period that ranked the plans.
     if (verbosity >= ExplainOptions::Verbosity::kExecAllPlans) {
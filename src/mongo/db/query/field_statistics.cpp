@@ -0,0 +1,339 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/field_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "mongo/bson/bsonelement_comparator.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/query/interval.h"
+#include "mongo/platform/bits.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+namespace {
+
+const char kNumDocumentsField[] = "numDocuments";
+const char kNumSampledField[] = "numSampled";
+const char kSketchField[] = "sketch";
+const char kBoundsField[] = "bounds";
+const char kCountsField[] = "counts";
+const char kDistinctField[] = "distinct";
+
+// Values are compared and hashed as an index would order them, ignoring their field names.
+const BSONElementComparator kValueComparator(BSONElementComparator::FieldNamesMode::kIgnore,
+                                             nullptr);
+
+// The number of hash bits used to select a register of a DistinctValueSketch.
+const int kRegisterBits = 10;
+static_assert(DistinctValueSketch::kNumRegisters == (1 << kRegisterBits),
+              "the number of registers must match the register bits");
+
+/**
+ * The 64-bit finalizer of MurmurHash3, which spreads the comparator's hash over all of the bits
+ * a HyperLogLog sketch examines.
+ */
+uint64_t mixHash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+StatusWith<std::vector<long long>> parseCounts(const BSONObj& obj, StringData fieldName) {
+    BSONElement elem = obj[fieldName];
+    if (elem.type() != Array) {
+        return Status(ErrorCodes::FailedToParse,
+                      str::stream() << "field statistics must have an array '" << fieldName
+                                    << "'");
+    }
+
+    std::vector<long long> counts;
+    for (auto&& count : elem.Obj()) {
+        if (!count.isNumber() || count.safeNumberLong() <= 0) {
+            return Status(ErrorCodes::FailedToParse,
+                          str::stream() << "field statistics '" << fieldName
+                                        << "' must contain positive numbers");
+        }
+        counts.push_back(count.safeNumberLong());
+    }
+    return {std::move(counts)};
+}
+
+}  // namespace
+
+void DistinctValueSketch::add(const BSONElement& value) {
+    const uint64_t hash = mixHash(kValueComparator.hash(value));
+    const size_t index = hash >> (64 - kRegisterBits);
+    const uint64_t remaining = hash << kRegisterBits;
+    const uint8_t rank = std::min(countLeadingZeros64(remaining), 64 - kRegisterBits) + 1;
+    _registers[index] = std::max(_registers[index], rank);
+}
+
+double DistinctValueSketch::estimate() const {
+    const double m = kNumRegisters;
+    double sum = 0;
+    size_t zeroRegisters = 0;
+    for (auto reg : _registers) {
+        sum += std::ldexp(1.0, -reg);
+        if (reg == 0) {
+            ++zeroRegisters;
+        }
+    }
+
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+    const double raw = alpha * m * m / sum;
+
+    // Small cardinalities are estimated more accurately by counting the empty registers.
+    if (raw <= 2.5 * m && zeroRegisters > 0) {
+        return m * std::log(m / zeroRegisters);
+    }
+    return raw;
+}
+
+void DistinctValueSketch::appendTo(StringData fieldName, BSONObjBuilder* builder) const {
+    builder->appendBinData(fieldName, _registers.size(), BinDataGeneral, _registers.data());
+}
+
+StatusWith<DistinctValueSketch> DistinctValueSketch::parse(const BSONElement& elem) {
+    int len = 0;
+    const char* data = elem.type() == BinData ? elem.binData(len) : nullptr;
+    if (!data || static_cast<size_t>(len) != kNumRegisters) {
+        return Status(ErrorCodes::FailedToParse,
+                      str::stream() << "distinct value sketch must be BinData of length "
+                                    << kNumRegisters);
+    }
+
+    DistinctValueSketch sketch;
+    std::memcpy(sketch._registers.data(), data, kNumRegisters);
+    return {std::move(sketch)};
+}
+
+FieldStatistics FieldStatistics::build(std::vector<BSONElement> values,
+                                       long long numSampled,
+                                       long long numDocuments,
+                                       size_t maxBuckets) {
+    invariant(maxBuckets > 0);
+
+    FieldStatistics stats;
+    stats._numSampled = numSampled;
+    stats._numDocuments = numDocuments;
+
+    for (auto&& value : values) {
+        stats._sketch.add(value);
+    }
+
+    std::sort(values.begin(), values.end(), kValueComparator.makeLessThan());
+
+    BSONArrayBuilder bounds;
+    if (!values.empty()) {
+        bounds.append(values.front());
+
+        const size_t depth = (values.size() + maxBuckets - 1) / maxBuckets;
+        Bucket bucket{0, 0};
+        for (size_t i = 0; i < values.size(); ++i) {
+            ++bucket.count;
+            if (i == 0 || kValueComparator.evaluate(values[i] != values[i - 1])) {
+                ++bucket.distinct;
+            }
+
+            // Close the bucket once it is deep enough, but never between two equal values, so
+            // that each value falls in exactly one bucket.
+            const bool isLast = (i + 1 == values.size());
+            if (isLast ||
+                (static_cast<size_t>(bucket.count) >= depth &&
+                 kValueComparator.evaluate(values[i + 1] != values[i]))) {
+                bounds.append(values[i]);
+                stats._buckets.push_back(bucket);
+                bucket = Bucket{0, 0};
+            }
+        }
+    }
+
+    stats.setBounds(bounds.arr());
+    return stats;
+}
+
+StatusWith<FieldStatistics> FieldStatistics::parse(const BSONObj& obj) {
+    FieldStatistics stats;
+
+    BSONElement numDocuments = obj[kNumDocumentsField];
+    BSONElement numSampled = obj[kNumSampledField];
+    if (!numDocuments.isNumber() || !numSampled.isNumber()) {
+        return Status(ErrorCodes::FailedToParse,
+                      str::stream() << "field statistics must have numeric '"
+                                    << kNumDocumentsField
+                                    << "' and '"
+                                    << kNumSampledField
+                                    << "'");
+    }
+    stats._numDocuments = numDocuments.safeNumberLong();
+    stats._numSampled = numSampled.safeNumberLong();
+
+    auto sketch = DistinctValueSketch::parse(obj[kSketchField]);
+    if (!sketch.isOK()) {
+        return sketch.getStatus();
+    }
+    stats._sketch = std::move(sketch.getValue());
+
+    auto counts = parseCounts(obj, kCountsField);
+    if (!counts.isOK()) {
+        return counts.getStatus();
+    }
+    auto distinct = parseCounts(obj, kDistinctField);
+    if (!distinct.isOK()) {
+        return distinct.getStatus();
+    }
+
+    BSONElement bounds = obj[kBoundsField];
+    if (bounds.type() != Array) {
+        return Status(ErrorCodes::FailedToParse,
+                      str::stream() << "field statistics must have an array '" << kBoundsField
+                                    << "'");
+    }
+    stats.setBounds(bounds.Obj().getOwned());
+
+    const size_t numBuckets = counts.getValue().size();
+    if (distinct.getValue().size() != numBuckets ||
+        stats._boundElems.size() != (numBuckets ? numBuckets + 1 : 0)) {
+        return Status(ErrorCodes::FailedToParse,
+                      "field statistics must have one bound more than they have buckets");
+    }
+    for (size_t i = 0; i < numBuckets; ++i) {
+        stats._buckets.push_back(Bucket{counts.getValue()[i], distinct.getValue()[i]});
+    }
+
+    return {std::move(stats)};
+}
+
+BSONObj FieldStatistics::toBSON() const {
+    BSONObjBuilder builder;
+    builder.append(kNumDocumentsField, _numDocuments);
+    builder.append(kNumSampledField, _numSampled);
+    _sketch.appendTo(kSketchField, &builder);
+    builder.appendArray(kBoundsField, _bounds);
+
+    BSONArrayBuilder counts(builder.subarrayStart(kCountsField));
+    for (auto&& bucket : _buckets) {
+        counts.append(bucket.count);
+    }
+    counts.doneFast();
+
+    BSONArrayBuilder distinct(builder.subarrayStart(kDistinctField));
+    for (auto&& bucket : _buckets) {
+        distinct.append(bucket.distinct);
+    }
+    distinct.doneFast();
+
+    return builder.obj();
+}
+
+double FieldStatistics::estimateKeys(const Interval& interval) const {
+    if (_buckets.empty() || _numSampled <= 0 || interval.isNull()) {
+        return 0;
+    }
+
+    // Intervals over descending index fields run from high to low.
+    BSONElement low = interval.start;
+    BSONElement high = interval.end;
+    bool lowInclusive = interval.startInclusive;
+    bool highInclusive = interval.endInclusive;
+    if (kValueComparator.compare(low, high) > 0) {
+        std::swap(low, high);
+        std::swap(lowInclusive, highInclusive);
+    }
+    const bool isPoint = interval.isPoint();
+
+    double keys = 0;
+    for (size_t i = 0; i < _buckets.size(); ++i) {
+        const BSONElement& lower = _boundElems[i];
+        const BSONElement& upper = _boundElems[i + 1];
+        const bool lowerInclusive = (i == 0);
+
+        // Skip the buckets that end before the interval starts or start after it ends.
+        const int lowVsUpper = kValueComparator.compare(low, upper);
+        if (lowVsUpper > 0 || (lowVsUpper == 0 && !lowInclusive)) {
+            continue;
+        }
+        const int highVsLower = kValueComparator.compare(high, lower);
+        if (highVsLower < 0 || (highVsLower == 0 && !(highInclusive && lowerInclusive))) {
+            continue;
+        }
+
+        const Bucket& bucket = _buckets[i];
+        if (isPoint) {
+            // Assume that the values in a bucket are equally frequent.
+            keys += static_cast<double>(bucket.count) / bucket.distinct;
+            continue;
+        }
+
+        const int lowVsLower = kValueComparator.compare(low, lower);
+        const int highVsUpper = kValueComparator.compare(high, upper);
+        const bool coversLower =
+            lowVsLower < 0 || (lowVsLower == 0 && (lowInclusive || !lowerInclusive));
+        const bool coversUpper = highVsUpper > 0 || (highVsUpper == 0 && highInclusive);
+        if (coversLower && coversUpper) {
+            keys += bucket.count;
+            continue;
+        }
+
+        // The interval covers part of the bucket. Interpolate between numeric bounds, and
+        // otherwise assume that it covers half of the bucket.
+        const BSONElement& from = coversLower ? lower : low;
+        const BSONElement& to = coversUpper ? upper : high;
+        double fraction = 0.5;
+        if (lower.isNumber() && upper.isNumber() && from.isNumber() && to.isNumber()) {
+            const double width = upper.numberDouble() - lower.numberDouble();
+            if (width > 0) {
+                fraction = std::min(
+                    1.0, std::max(0.0, (to.numberDouble() - from.numberDouble()) / width));
+            }
+        }
+        keys += fraction * bucket.count;
+    }
+
+    return keys * _numDocuments / _numSampled;
+}
+
+void FieldStatistics::setBounds(BSONObj bounds) {
+    _bounds = std::move(bounds);
+    _boundElems.clear();
+    for (auto&& elem : _bounds) {
+        _boundElems.push_back(elem);
+    }
+}
+
+}  // namespace mongo
@@ -0,0 +1,145 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "mongo/base/status_with.h"
+#include "mongo/bson/bsonelement.h"
+#include "mongo/bson/bsonobj.h"
+
+namespace mongo {
+
+struct Interval;
+
+/**
+ * A HyperLogLog sketch estimating the number of distinct values added to it, in a fixed amount of
+ * memory and regardless of how many values are added.
+ */
+class DistinctValueSketch {
+public:
+    // The number of registers. The standard error of the estimate is about
+    // 1.04 / sqrt(kNumRegisters), or 3%.
+    static constexpr size_t kNumRegisters = 1024;
+
+    void add(const BSONElement& value);
+
+    /**
+     * Returns the estimated number of distinct values added to this sketch.
+     */
+    double estimate() const;
+
+    /**
+     * Appends the registers of this sketch as BinData named 'fieldName' to 'builder'.
+     */
+    void appendTo(StringData fieldName, BSONObjBuilder* builder) const;
+
+    static StatusWith<DistinctValueSketch> parse(const BSONElement& elem);
+
+private:
+    std::array<uint8_t, kNumRegisters> _registers{};
+};
+
+/**
+ * Statistics describing the values of one field in a collection, built from a sample of its
+ * documents by the 'analyze' command. They consist of an equi-depth histogram of the sampled
+ * values, in which each bucket holds roughly the same number of values, and a sketch of the
+ * number of distinct values.
+ *
+ * Each element of an array is counted as a separate value, as it is in a multikey index, and
+ * documents missing the field are counted as having the value null.
+ */
+class FieldStatistics {
+public:
+    struct Bucket {
+        // The number of sampled values less than or equal to the upper bound of this bucket and
+        // greater than the upper bound of the previous bucket.
+        long long count;
+
+        // The number of distinct sampled values in this bucket.
+        long long distinct;
+    };
+
+    /**
+     * Builds statistics from the values of the field in 'numSampled' sampled documents out of a
+     * collection of 'numDocuments' documents, using at most 'maxBuckets' buckets. The elements
+     * of 'values' need not be sorted, and are not referenced once this returns.
+     */
+    static FieldStatistics build(std::vector<BSONElement> values,
+                                 long long numSampled,
+                                 long long numDocuments,
+                                 size_t maxBuckets);
+
+    static StatusWith<FieldStatistics> parse(const BSONObj& obj);
+
+    BSONObj toBSON() const;
+
+    /**
+     * Returns the estimated number of values of the field in the whole collection which fall in
+     * 'interval', that is, the number of keys an index scan over 'interval' would examine.
+     */
+    double estimateKeys(const Interval& interval) const;
+
+    long long getNumDocuments() const {
+        return _numDocuments;
+    }
+
+    long long getNumSampled() const {
+        return _numSampled;
+    }
+
+    double getDistinctEstimate() const {
+        return _sketch.estimate();
+    }
+
+    const std::vector<Bucket>& getBuckets() const {
+        return _buckets;
+    }
+
+private:
+    FieldStatistics() = default;
+
+    void setBounds(BSONObj bounds);
+
+    long long _numDocuments = 0;
+    long long _numSampled = 0;
+
+    // Holds the lowest sampled value followed by the upper bound of each bucket. '_boundElems'
+    // points into it, so that bucket i spans the values in (_boundElems[i], _boundElems[i + 1]],
+    // except that the first bucket includes its lower bound.
+    BSONObj _bounds;
+    std::vector<BSONElement> _boundElems;
+    std::vector<Bucket> _buckets;
+
+    DistinctValueSketch _sketch;
+};
+
+}  // namespace mongo
@@ -0,0 +1,185 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/field_statistics.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/interval.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+std::vector<BSONElement> elementsOf(const BSONObj& arr) {
+    std::vector<BSONElement> elems;
+    for (auto&& elem : arr) {
+        elems.push_back(elem);
+    }
+    return elems;
+}
+
+BSONObj sequence(int begin, int end) {
+    BSONArrayBuilder builder;
+    for (int i = begin; i < end; ++i) {
+        builder.append(i);
+    }
+    return builder.arr();
+}
+
+TEST(DistinctValueSketchTest, EstimatesSmallCardinality) {
+    BSONObj values = sequence(0, 100);
+    DistinctValueSketch sketch;
+    for (int repeat = 0; repeat < 3; ++repeat) {
+        for (auto&& value : values) {
+            sketch.add(value);
+        }
+    }
+    ASSERT_APPROX_EQUAL(sketch.estimate(), 100.0, 5.0);
+}
+
+TEST(DistinctValueSketchTest, EstimatesLargeCardinality) {
+    DistinctValueSketch sketch;
+    for (int i = 0; i < 100000; ++i) {
+        sketch.add(BSON("" << i).firstElement());
+    }
+    ASSERT_APPROX_EQUAL(sketch.estimate(), 100000.0, 10000.0);
+}
+
+TEST(DistinctValueSketchTest, NumbersOfDifferentTypesAreTheSameValue) {
+    DistinctValueSketch sketch;
+    sketch.add(BSON("" << 1).firstElement());
+    sketch.add(BSON("" << 1LL).firstElement());
+    sketch.add(BSON("" << 1.0).firstElement());
+    ASSERT_APPROX_EQUAL(sketch.estimate(), 1.0, 0.1);
+}
+
+TEST(FieldStatisticsTest, BucketsHaveEqualDepth) {
+    BSONObj values = sequence(0, 1000);
+    auto stats = FieldStatistics::build(elementsOf(values), 1000, 1000, 10);
+
+    ASSERT_EQ(stats.getBuckets().size(), 10U);
+    for (auto&& bucket : stats.getBuckets()) {
+        ASSERT_EQ(bucket.count, 100);
+        ASSERT_EQ(bucket.distinct, 100);
+    }
+    ASSERT_APPROX_EQUAL(stats.getDistinctEstimate(), 1000.0, 50.0);
+}
+
+TEST(FieldStatisticsTest, EqualValuesAreNeverSplitAcrossBuckets) {
+    BSONArrayBuilder builder;
+    for (int i = 0; i < 500; ++i) {
+        builder.append(1);
+    }
+    for (int i = 2; i < 502; ++i) {
+        builder.append(i);
+    }
+    BSONObj values = builder.arr();
+    auto stats = FieldStatistics::build(elementsOf(values), 1000, 1000, 10);
+
+    ASSERT_EQ(stats.getBuckets()[0].count, 500);
+    ASSERT_EQ(stats.getBuckets()[0].distinct, 1);
+    long long total = 0;
+    for (auto&& bucket : stats.getBuckets()) {
+        total += bucket.count;
+    }
+    ASSERT_EQ(total, 1000);
+}
+
+TEST(FieldStatisticsTest, EstimatesPointsFromBucketFrequency) {
+    BSONArrayBuilder builder;
+    for (int i = 0; i < 500; ++i) {
+        builder.append(1);
+    }
+    for (int i = 2; i < 502; ++i) {
+        builder.append(i);
+    }
+    BSONObj values = builder.arr();
+
+    // Half of the collection was sampled, so estimates are scaled by two.
+    auto stats = FieldStatistics::build(elementsOf(values), 1000, 2000, 10);
+
+    ASSERT_APPROX_EQUAL(stats.estimateKeys(Interval(BSON("" << 1 << "" << 1), true, true)),
+                        1000.0,
+                        1.0);
+    ASSERT_APPROX_EQUAL(stats.estimateKeys(Interval(BSON("" << 100 << "" << 100), true, true)),
+                        2.0,
+                        1.0);
+    ASSERT_EQ(stats.estimateKeys(Interval(BSON("" << 1000 << "" << 1000), true, true)), 0.0);
+    ASSERT_EQ(stats.estimateKeys(Interval(BSON("" << 0 << "" << 0), true, true)), 0.0);
+}
+
+TEST(FieldStatisticsTest, EstimatesRangesByInterpolatingNumericBuckets) {
+    BSONObj values = sequence(0, 1000);
+    auto stats = FieldStatistics::build(elementsOf(values), 1000, 1000, 10);
+
+    ASSERT_APPROX_EQUAL(stats.estimateKeys(Interval(BSON("" << 0 << "" << 499), true, true)),
+                        500.0,
+                        10.0);
+    ASSERT_APPROX_EQUAL(
+        stats.estimateKeys(Interval(BSON("" << 250 << "" << MAXKEY), true, true)), 750.0, 10.0);
+
+    // Descending index bounds run from high to low.
+    ASSERT_APPROX_EQUAL(stats.estimateKeys(Interval(BSON("" << 499 << "" << 0), true, true)),
+                        500.0,
+                        10.0);
+}
+
+TEST(FieldStatisticsTest, RoundTripsThroughBSON) {
+    BSONObj values = sequence(0, 1000);
+    auto stats = FieldStatistics::build(elementsOf(values), 1000, 4000, 20);
+
+    auto parsed = FieldStatistics::parse(stats.toBSON());
+    ASSERT_OK(parsed.getStatus());
+    ASSERT_EQ(parsed.getValue().getNumDocuments(), 4000);
+    ASSERT_EQ(parsed.getValue().getNumSampled(), 1000);
+    ASSERT_EQ(parsed.getValue().getBuckets().size(), 20U);
+    ASSERT_EQ(parsed.getValue().getDistinctEstimate(), stats.getDistinctEstimate());
+
+    Interval interval(BSON("" << 100 << "" << 300), true, false);
+    ASSERT_EQ(parsed.getValue().estimateKeys(interval), stats.estimateKeys(interval));
+}
+
+TEST(FieldStatisticsTest, ParseRejectsMismatchedBuckets) {
+    BSONObj values = sequence(0, 100);
+    BSONObj obj = FieldStatistics::build(elementsOf(values), 100, 100, 10).toBSON();
+
+    BSONObjBuilder builder;
+    for (auto&& elem : obj) {
+        if (elem.fieldNameStringData() == "counts") {
+            builder.append("counts", BSON_ARRAY(10 << 10));
+        } else {
+            builder.append(elem);
+        }
+    }
+    ASSERT_EQ(FieldStatistics::parse(builder.obj()).getStatus(), ErrorCodes::FailedToParse);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -37,8 +37,10 @@
 #include <memory>
 
 #include "mongo/base/error_codes.h"
+#include "mongo/base/counter.h"
 #include "mongo/base/parse_number.h"
 #include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/exec/cached_plan.h"
 #include "mongo/db/exec/collection_scan.h"
 #include "mongo/db/exec/count.h"
@@ -57,6 +59,7 @@
 #include "mongo/db/matcher/extensions_callback_real.h"
 #include "mongo/db/ops/update_lifecycle.h"
 #include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/collection_statistics.h"
 #include "mongo/db/query/collation/collator_factory_interface.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/index_bounds_builder.h"
@@ -118,6 +121,15 @@ void filterAllowedIndexEntries(const AllowedIndicesFilter& allowedIndicesFilter,
 namespace {
 // The body is below in the "count hack" section but getExecutor calls it.
 bool turnIxscanIntoCount(QuerySolution* soln);
+
+// Counts how often queries issued by aggregation sub-pipelines, such as those of $lookup, started
+// from a cached plan, which only needs a short trial, versus having to be planned from scratch.
+Counter64 subPipelinePlansReused;
+Counter64 subPipelinePlansRebuilt;
+ServerStatusMetricField<Counter64> displaySubPipelinePlansReused(
+    "query.subPipelinePlans.reused", &subPipelinePlansReused);
+ServerStatusMetricField<Counter64> displaySubPipelinePlansRebuilt(
+    "query.subPipelinePlans.rebuilt", &subPipelinePlansRebuilt);
 }  // namespace
 
 
@@ -374,6 +386,10 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
             verify(StageBuilder::build(
                 opCtx, collection, *canonicalQuery, *querySolution, ws, &rawRoot));
 
+            if (plannerParams.options & QueryPlannerParams::SHORT_CACHED_PLAN_TRIAL) {
+                subPipelinePlansReused.increment();
+            }
+
             // Add a CachedPlanStage on top of the previous root.
             //
             // 'decisionWorks' is used to determine whether the existing cache entry should
@@ -390,6 +406,10 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
         }
     }
 
+    if (plannerParams.options & QueryPlannerParams::SHORT_CACHED_PLAN_TRIAL) {
+        subPipelinePlansRebuilt.increment();
+    }
+
     if (internalQueryPlanOrChildrenIndependently.load() &&
         SubplanStage::canUseSubplanning(*canonicalQuery)) {
         LOG(2) << "Running query as sub-queries: " << redact(canonicalQuery->toStringShort());
@@ -434,6 +454,12 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
         }
     }
 
+    // Use the statistics gathered by 'analyze', if any, to discard the candidates which would
+    // examine far more data than the others before they are trialled.
+    if (solutions.size() > 1 && internalQueryPlannerUseStatistics.load()) {
+        rankSolutionsUsingStatistics(opCtx, collection, *canonicalQuery, &solutions);
+    }
+
     if (1 == solutions.size()) {
         // Only one possible plan.  Run it.  Build the stages from the solution.
         PlanStage* rawRoot;
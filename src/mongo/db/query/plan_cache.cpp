@@ -33,13 +33,16 @@
 #include "mongo/db/query/plan_cache.h"
 
 #include <algorithm>
+#include <cmath>
 #include <math.h>
 #include <memory>
+#include <numeric>
 #include <vector>
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
+#include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/query_knobs.h"
@@ -61,6 +64,24 @@ const char kEncodeChildrenSeparator = ',';
 const char kEncodeSortSection = '~';
 const char kEncodeProjectionSection = '|';
 const char kEncodeCollationSection = '#';
+const char kEncodeVariantSection = '%';
+
+// The largest value accepted for 'internalQueryCacheMaxVariantsPerShape'.
+const size_t kMaxVariantsPerShape = 16;
+
+// Predicates are assigned a selectivity class between 0 and 'kMaxSelectivityClass', where higher
+// classes are expected to match more documents.
+const unsigned kMaxSelectivityClass = 7;
+
+// A plan variant's trial works budget is only taken from its works histogram once this many cached
+// runs have been recorded, and is then based on the given quantile of those runs.
+const long long kMinRunsForTrialWorksEstimate = 8;
+const double kTrialWorksQuantile = 0.9;
+
+// The cache is split into at most this many partitions, each with its own lock, but never into
+// partitions holding fewer than 'kMinEntriesPerPartition' entries.
+const size_t kMaxPartitions = 16;
+const size_t kMinEntriesPerPartition = 64;
 
 /**
  * Encode user-provided string. Cache key delimiters seen in the
@@ -78,6 +99,7 @@ void encodeUserString(StringData s, StringBuilder* keyBuilder) {
             case kEncodeSortSection:
             case kEncodeProjectionSection:
             case kEncodeCollationSection:
+            case kEncodeVariantSection:
             case '\\':
                 *keyBuilder << '\\';
             // Fall through to default case.
@@ -307,6 +329,108 @@ void encodeGeoNearMatchExpression(const GeoNearMatchExpression* tree, StringBuil
     }
 }
 
+/**
+ * Returns the value of a range bound as a double if the distance between two such bounds is
+ * meaningful, that is for numbers and dates.
+ */
+boost::optional<double> rangeBoundValue(const BSONElement& elem) {
+    if (elem.isNumber()) {
+        return elem.numberDouble();
+    }
+    if (elem.type() == BSONType::Date) {
+        return static_cast<double>(elem.date().toMillisSinceEpoch());
+    }
+    return boost::none;
+}
+
+/**
+ * Returns the selectivity class of a range whose bounds are 'width' apart: class 0 for a single
+ * point, and then one more class for every factor of 16 in width.
+ */
+unsigned rangeSelectivityClass(double width) {
+    if (!(width >= 1)) {
+        return 0;
+    }
+    return std::min(kMaxSelectivityClass, 1U + static_cast<unsigned>(std::ilogb(width)) / 4);
+}
+
+/**
+ * Appends to 'classes' the selectivity class of each predicate in 'tree' whose selectivity depends
+ * on its constants. The classes are appended in the order of the canonicalized tree, so queries of
+ * the same shape always produce the same number of classes in the same order.
+ */
+void appendSelectivityClasses(const MatchExpression* tree, std::vector<unsigned>* classes) {
+    switch (tree->matchType()) {
+        case MatchExpression::EQ: {
+            // Equality with null also matches documents which are missing the field entirely.
+            const auto& rhs = static_cast<const ComparisonMatchExpression*>(tree)->getData();
+            classes->push_back(rhs.type() == BSONType::jstNULL ? kMaxSelectivityClass : 0);
+            return;
+        }
+        case MatchExpression::MATCH_IN: {
+            // One class per doubling of the number of values being looked up.
+            const auto* inExpr = static_cast<const InMatchExpression*>(tree);
+            const size_t numValues = inExpr->getEqualities().size() + inExpr->getRegexes().size();
+            unsigned inClass = inExpr->hasNull() ? kMaxSelectivityClass : 0;
+            for (size_t n = 1; n < numValues && inClass < kMaxSelectivityClass; n <<= 1) {
+                ++inClass;
+            }
+            classes->push_back(inClass);
+            return;
+        }
+        case MatchExpression::AND: {
+            // A range is only bounded on both sides when a conjunction holds a lower and an upper
+            // bound on the same path. Ranges are appended in the order of their first bound.
+            struct Range {
+                StringData path;
+                boost::optional<double> lower;
+                boost::optional<double> upper;
+            };
+            std::vector<Range> ranges;
+            for (size_t i = 0; i < tree->numChildren(); ++i) {
+                const MatchExpression* child = tree->getChild(i);
+                const auto matchType = child->matchType();
+                const bool isLower = matchType == MatchExpression::GT ||
+                    matchType == MatchExpression::GTE;
+                const bool isUpper = matchType == MatchExpression::LT ||
+                    matchType == MatchExpression::LTE;
+                if (!isLower && !isUpper) {
+                    appendSelectivityClasses(child, classes);
+                    continue;
+                }
+
+                const auto bound = rangeBoundValue(
+                    static_cast<const ComparisonMatchExpression*>(child)->getData());
+                if (!bound) {
+                    continue;
+                }
+                auto range = std::find_if(ranges.begin(), ranges.end(), [&](const Range& r) {
+                    return r.path == child->path();
+                });
+                if (range == ranges.end()) {
+                    range = ranges.insert(ranges.end(), Range{child->path(), {}, {}});
+                }
+                auto& slot = isLower ? range->lower : range->upper;
+                if (!slot) {
+                    slot = bound;
+                }
+            }
+            for (const auto& range : ranges) {
+                if (range.lower && range.upper) {
+                    classes->push_back(rangeSelectivityClass(*range.upper - *range.lower));
+                }
+            }
+            return;
+        }
+        default:
+            break;
+    }
+
+    for (size_t i = 0; i < tree->numChildren(); ++i) {
+        appendSelectivityClasses(tree->getChild(i), classes);
+    }
+}
+
 }  // namespace
 
 //
@@ -368,7 +492,8 @@ CachedSolution::CachedSolution(const PlanCacheKey& key, const PlanCacheEntry& en
       sort(entry.sort.getOwned()),
       projection(entry.projection.getOwned()),
       collation(entry.collation.getOwned()),
-      decisionWorks(entry.works) {
+      decisionWorks(entry.expectedTrialWorks()),
+      variant(entry.variant) {
     // CachedSolution should not having any references into
     // cache entry. All relevant data should be cloned/copied.
     for (size_t i = 0; i < entry.plannerData.size(); ++i) {
@@ -386,6 +511,53 @@ CachedSolution::~CachedSolution() {
     }
 }
 
+//
+// PlanCacheHistogram
+//
+
+void PlanCacheHistogram::record(size_t value) {
+    size_t bucket = 0;
+    while (value > 0 && bucket < kNumBuckets - 1) {
+        value >>= 1;
+        ++bucket;
+    }
+    ++counts[bucket];
+}
+
+long long PlanCacheHistogram::total() const {
+    return std::accumulate(counts.begin(), counts.end(), 0LL);
+}
+
+size_t PlanCacheHistogram::quantileUpperBound(double quantile) const {
+    const long long numValues = total();
+    if (numValues == 0) {
+        return 0;
+    }
+
+    // Bucket i holds values below 2^i.
+    const long long rank =
+        std::max(1LL, static_cast<long long>(std::ceil(quantile * numValues)));
+    long long numSeen = 0;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+        numSeen += counts[i];
+        if (numSeen >= rank) {
+            return size_t{1} << i;
+        }
+    }
+    return size_t{1} << (kNumBuckets - 1);
+}
+
+BSONArray PlanCacheHistogram::toBSON() const {
+    BSONArrayBuilder arrBuilder;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+        if (counts[i] > 0) {
+            const long long lowerBound = (i == 0) ? 0 : (1LL << (i - 1));
+            arrBuilder.append(BSON("lowerBound" << lowerBound << "count" << counts[i]));
+        }
+    }
+    return arrBuilder.arr();
+}
+
 //
 // PlanCacheEntry
 //
@@ -433,6 +605,9 @@ PlanCacheEntry* PlanCacheEntry::clone() const {
     entry->timeOfCreation = timeOfCreation;
     entry->isActive = isActive;
     entry->works = works;
+    entry->worksHistogram = worksHistogram;
+    entry->cachedSolution = cachedSolution;
+    entry->variant = variant;
 
     // Copy performance stats.
     for (size_t i = 0; i < feedback.size(); ++i) {
@@ -448,10 +623,20 @@ std::string PlanCacheEntry::toString() const {
     return str::stream() << "(query: " << query.toString() << ";sort: " << sort.toString()
                          << ";projection: " << projection.toString()
                          << ";collation: " << collation.toString()
+                         << ";variant: " << (variant ? std::to_string(*variant) : "none")
                          << ";solutions: " << plannerData.size()
                          << ";timeOfCreation: " << timeOfCreation.toString() << ")";
 }
 
+size_t PlanCacheEntry::expectedTrialWorks() const {
+    // A histogram bucket's upper bound may be up to twice the runs it holds, so it only ever
+    // tightens the budget. Raising it would let a degraded plan run longer before being evicted.
+    if (!variant || worksHistogram.total() < kMinRunsForTrialWorksEstimate) {
+        return works;
+    }
+    return std::min(works, worksHistogram.quantileUpperBound(kTrialWorksQuantile));
+}
+
 std::string CachedSolution::toString() const {
     return str::stream() << "key: " << key << '\n';
 }
@@ -557,9 +742,19 @@ std::string SolutionCacheData::toString() const {
 
 PlanCache::PlanCache() : PlanCache(internalQueryCacheSize.load()) {}
 
-PlanCache::PlanCache(size_t size) : _cache(size) {}
+PlanCache::PlanCache(size_t size) {
+    // Small caches keep a single partition, and so an exact LRU policy.
+    const size_t numPartitions =
+        std::max(size_t(1), std::min(kMaxPartitions, size / kMinEntriesPerPartition));
+    const size_t partitionSize = (size + numPartitions - 1) / numPartitions;
+    for (size_t i = 0; i < numPartitions; ++i) {
+        _partitions.push_back(stdx::make_unique<Partition>(partitionSize));
+    }
+}
 
-PlanCache::PlanCache(const std::string& ns) : _cache(internalQueryCacheSize.load()), _ns(ns) {}
+PlanCache::PlanCache(const std::string& ns) : PlanCache(internalQueryCacheSize.load()) {
+    _ns = ns;
+}
 
 PlanCache::~PlanCache() {}
 
@@ -567,7 +762,7 @@ PlanCache::~PlanCache() {}
  * Determine whether or not the cache should be used. If it shouldn't be used because the cache
  * entry exists but is inactive, log a message.
  */
-std::unique_ptr<CachedSolution> PlanCache::getCacheEntryIfCacheable(
+std::shared_ptr<const CachedSolution> PlanCache::getCacheEntryIfCacheable(
     const CanonicalQuery& cq) const {
     if (!PlanCache::shouldCacheQuery(cq)) {
         return nullptr;
@@ -819,35 +1014,18 @@ Status PlanCache::set(const CanonicalQuery& query,
                       "candidate ordering entries in decision must match solutions");
     }
 
-    const auto key = computeKey(query);
+    boost::optional<size_t> variant;
+    const auto key = computeEntryKey(query, &variant);
     const size_t newWorks = why->stats[0]->common.works;
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    bool isNewEntryActive = false;
-    if (internalQueryCacheDisableInactiveEntries.load()) {
-        // All entries are always active.
-        isNewEntryActive = true;
-    } else {
-        PlanCacheEntry* oldEntry = nullptr;
-        Status cacheStatus = _cache.get(key, &oldEntry);
-        invariant(cacheStatus.isOK() || cacheStatus == ErrorCodes::NoSuchKey);
-        auto newState = getNewEntryState(
-            query,
-            oldEntry,
-            newWorks,
-            worksGrowthCoefficient.get_value_or(internalQueryCacheWorksGrowthCoefficient));
-
-        if (!newState.shouldBeCreated) {
-            return Status::OK();
-        }
-        isNewEntryActive = newState.shouldBeActive;
-    }
 
+    // Build the new entry and its snapshot before taking the partition's lock, since that involves
+    // deep copies of the solutions.
     auto newEntry = std::make_unique<PlanCacheEntry>(solns, why.release());
     const QueryRequest& qr = query.getQueryRequest();
     newEntry->query = qr.getFilter().getOwned();
     newEntry->sort = qr.getSort().getOwned();
-    newEntry->isActive = isNewEntryActive;
     newEntry->works = newWorks;
+    newEntry->variant = variant;
     if (query.getCollator()) {
         newEntry->collation = query.getCollator()->getSpec().toBSON();
     }
@@ -864,8 +1042,37 @@ Status PlanCache::set(const CanonicalQuery& query,
         projBuilder.append(elem);
     }
     newEntry->projection = projBuilder.obj();
+    newEntry->cachedSolution = std::make_shared<const CachedSolution>(key, *newEntry);
+
+    auto& partition = getPartition(key);
+    stdx::lock_guard<stdx::mutex> cacheLock(partition.mutex);
+    bool isNewEntryActive = false;
+    if (internalQueryCacheDisableInactiveEntries.load()) {
+        // All entries are always active.
+        isNewEntryActive = true;
+    } else {
+        PlanCacheEntry* oldEntry = nullptr;
+        Status cacheStatus = partition.cache.get(key, &oldEntry);
+        invariant(cacheStatus.isOK() || cacheStatus == ErrorCodes::NoSuchKey);
+        const size_t oldTrialWorks = oldEntry ? oldEntry->expectedTrialWorks() : 0;
+        auto newState = getNewEntryState(
+            query,
+            oldEntry,
+            newWorks,
+            worksGrowthCoefficient.get_value_or(internalQueryCacheWorksGrowthCoefficient));
+
+        if (!newState.shouldBeCreated) {
+            // The existing entry's works may have been raised instead.
+            if (oldEntry->expectedTrialWorks() != oldTrialWorks) {
+                oldEntry->cachedSolution = std::make_shared<const CachedSolution>(key, *oldEntry);
+            }
+            return Status::OK();
+        }
+        isNewEntryActive = newState.shouldBeActive;
+    }
+    newEntry->isActive = isNewEntryActive;
 
-    std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(key, newEntry.release());
+    std::unique_ptr<PlanCacheEntry> evictedEntry = partition.cache.add(key, newEntry.release());
 
     if (NULL != evictedEntry.get()) {
         LOG(1) << _ns << ": plan cache maximum size exceeded - "
@@ -881,10 +1088,11 @@ void PlanCache::deactivate(const CanonicalQuery& query) {
         return;
     }
 
-    PlanCacheKey key = computeKey(query);
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    PlanCacheKey key = computeEntryKey(query);
+    auto& partition = getPartition(key);
+    stdx::lock_guard<stdx::mutex> cacheLock(partition.mutex);
     PlanCacheEntry* entry = nullptr;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = partition.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         invariant(cacheStatus == ErrorCodes::NoSuchKey);
         return;
@@ -894,11 +1102,12 @@ void PlanCache::deactivate(const CanonicalQuery& query) {
 }
 
 PlanCache::GetResult PlanCache::get(const CanonicalQuery& query) const {
-    PlanCacheKey key = computeKey(query);
+    PlanCacheKey key = computeEntryKey(query);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    auto& partition = getPartition(key);
+    stdx::lock_guard<stdx::mutex> cacheLock(partition.mutex);
     PlanCacheEntry* entry = nullptr;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = partition.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         invariant(cacheStatus == ErrorCodes::NoSuchKey);
         return {CacheEntryState::kNotPresent, nullptr};
@@ -907,7 +1116,7 @@ PlanCache::GetResult PlanCache::get(const CanonicalQuery& query) const {
 
     auto state =
         entry->isActive ? CacheEntryState::kPresentActive : CacheEntryState::kPresentInactive;
-    return {state, stdx::make_unique<CachedSolution>(key, *entry)};
+    return {state, entry->cachedSolution};
 }
 
 Status PlanCache::feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* feedback) {
@@ -915,16 +1124,30 @@ Status PlanCache::feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* fee
         return Status(ErrorCodes::BadValue, "feedback is NULL");
     }
     std::unique_ptr<PlanCacheEntryFeedback> autoFeedback(feedback);
-    PlanCacheKey ck = computeKey(cq);
+    PlanCacheKey ck = computeEntryKey(cq);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    auto& partition = getPartition(ck);
+    stdx::lock_guard<stdx::mutex> cacheLock(partition.mutex);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(ck, &entry);
+    Status cacheStatus = partition.cache.get(ck, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
     invariant(entry);
 
+    // Feedback is given by the CachedPlanStage at the end of its trial period, during which it
+    // works the cached plan's root directly. Those are the works which expectedTrialWorks() has to
+    // predict for later trials.
+    const auto& planStats = autoFeedback->stats->children.empty()
+        ? autoFeedback->stats->common
+        : autoFeedback->stats->children[0]->common;
+    const size_t oldTrialWorks = entry->expectedTrialWorks();
+    entry->worksHistogram.record(planStats.works);
+    if (entry->expectedTrialWorks() != oldTrialWorks) {
+        // Queries already holding the old snapshot keep using it.
+        entry->cachedSolution = std::make_shared<const CachedSolution>(ck, *entry);
+    }
+
     // We store up to a constant number of feedback entries.
     if (entry->feedback.size() < static_cast<size_t>(internalQueryCacheFeedbacksStored.load())) {
         entry->feedback.push_back(autoFeedback.release());
@@ -934,13 +1157,32 @@ Status PlanCache::feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* fee
 }
 
 Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.remove(computeKey(canonicalQuery));
+    const PlanCacheKey shapeKey = computeKey(canonicalQuery);
+    auto removeKey = [this](const PlanCacheKey& key) {
+        auto& partition = getPartition(key);
+        stdx::lock_guard<stdx::mutex> cacheLock(partition.mutex);
+        return partition.cache.remove(key);
+    };
+
+    Status status = removeKey(shapeKey);
+
+    // Remove every variant which may have been cached for the shape, including those beyond the
+    // current 'internalQueryCacheMaxVariantsPerShape' if it has since been lowered.
+    for (size_t variant = 0; variant < kMaxVariantsPerShape; ++variant) {
+        StringBuilder keyBuilder;
+        keyBuilder << shapeKey << kEncodeVariantSection << variant;
+        if (removeKey(keyBuilder.str()).isOK()) {
+            status = Status::OK();
+        }
+    }
+    return status;
 }
 
 void PlanCache::clear() {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    _cache.clear();
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> cacheLock(partition->mutex);
+        partition->cache.clear();
+    }
 }
 
 PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
@@ -951,12 +1193,45 @@ PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
     return keyBuilder.str();
 }
 
+boost::optional<size_t> PlanCache::computeVariant(const CanonicalQuery& cq) const {
+    const size_t numVariants = internalQueryCacheMaxVariantsPerShape.load();
+    if (numVariants <= 1) {
+        return boost::none;
+    }
+
+    std::vector<unsigned> classes;
+    appendSelectivityClasses(cq.root(), &classes);
+
+    size_t signature = 0;
+    for (auto selectivityClass : classes) {
+        signature = signature * (kMaxSelectivityClass + 1) + selectivityClass;
+    }
+    return signature % numVariants;
+}
+
+PlanCacheKey PlanCache::computeEntryKey(const CanonicalQuery& cq,
+                                        boost::optional<size_t>* variantOut) const {
+    PlanCacheKey key = computeKey(cq);
+    auto variant = computeVariant(cq);
+    if (variantOut) {
+        *variantOut = variant;
+    }
+    if (!variant) {
+        return key;
+    }
+
+    StringBuilder keyBuilder;
+    keyBuilder << key << kEncodeVariantSection << *variant;
+    return keyBuilder.str();
+}
+
 StatusWith<std::unique_ptr<PlanCacheEntry>> PlanCache::getEntry(const CanonicalQuery& query) const {
-    PlanCacheKey key = computeKey(query);
+    PlanCacheKey key = computeEntryKey(query);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    auto& partition = getPartition(key);
+    stdx::lock_guard<stdx::mutex> cacheLock(partition.mutex);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = partition.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -966,20 +1241,34 @@ StatusWith<std::unique_ptr<PlanCacheEntry>> PlanCache::getEntry(const CanonicalQ
 }
 
 std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
     std::vector<PlanCacheEntry*> entries;
     typedef std::list<std::pair<PlanCacheKey, PlanCacheEntry*>>::const_iterator ConstIterator;
-    for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
-        PlanCacheEntry* entry = i->second;
-        entries.push_back(entry->clone());
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> cacheLock(partition->mutex);
+        for (ConstIterator i = partition->cache.begin(); i != partition->cache.end(); i++) {
+            PlanCacheEntry* entry = i->second;
+            entries.push_back(entry->clone());
+        }
     }
 
     return entries;
 }
 
 size_t PlanCache::size() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.size();
+    size_t size = 0;
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> cacheLock(partition->mutex);
+        size += partition->cache.size();
+    }
+    return size;
+}
+
+size_t PlanCache::numPartitions() const {
+    return _partitions.size();
+}
+
+PlanCache::Partition& PlanCache::getPartition(const PlanCacheKey& key) const {
+    return *_partitions[std::hash<PlanCacheKey>()(key) % _partitions.size()];
 }
 
 void PlanCache::notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries) {
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <array>
 #include <boost/optional/optional.hpp>
 #include <set>
 
@@ -62,6 +63,35 @@ struct PlanCacheEntryFeedback {
     double score;
 };
 
+/**
+ * Counts the values observed for some metric of a cached plan's runs, such as the number of works
+ * performed, in buckets whose bounds are powers of two. Bucket 0 counts values of zero and bucket
+ * i > 0 counts values in [2^(i-1), 2^i), with the last bucket also counting anything larger.
+ */
+struct PlanCacheHistogram {
+    static constexpr size_t kNumBuckets = 32;
+
+    void record(size_t value);
+
+    /**
+     * Returns the number of values recorded.
+     */
+    long long total() const;
+
+    /**
+     * Returns the exclusive upper bound of the bucket holding the 'quantile' fraction of recorded
+     * values, or 0 if nothing has been recorded.
+     */
+    size_t quantileUpperBound(double quantile) const;
+
+    /**
+     * Returns an array with a {lowerBound, count} document for each non-empty bucket.
+     */
+    BSONArray toBSON() const;
+
+    std::array<long long, kNumBuckets> counts{};
+};
+
 // TODO: Replace with opaque type.
 typedef std::string PlanID;
 
@@ -191,7 +221,8 @@ struct SolutionCacheData {
 class PlanCacheEntry;
 
 /**
- * Information returned from a get(...) query.
+ * Information returned from a get(...) query. Each cache entry keeps one, which get() shares with
+ * every query that uses the entry, so it is never modified once it has been built.
  */
 class CachedSolution {
 private:
@@ -218,9 +249,13 @@ public:
     BSONObj projection;
     BSONObj collation;
 
-    // The number of work cycles taken to decide on a winning plan when the plan was first
-    // cached.
+    // The number of work cycles the cached plan is expected to need during its trial period. See
+    // PlanCacheEntry::expectedTrialWorks().
     size_t decisionWorks;
+
+    // Which of the query shape's plan variants this solution was taken from, if the cache is
+    // keeping several variants per shape.
+    boost::optional<size_t> variant;
 };
 
 /**
@@ -249,6 +284,15 @@ public:
     // For debugging.
     std::string toString() const;
 
+    /**
+     * Returns the number of work cycles a trial run of the cached plan is expected to need, which
+     * the CachedPlanStage scales by 'internalQueryCacheEvictionRatio' to decide when to replan.
+     * This is the works taken to pick the plan. For one of several plan variants of a shape, it is
+     * lowered once enough cached runs have been recorded in 'worksHistogram' to show that the
+     * variant's queries routinely need fewer, so that a query which needs more replans sooner.
+     */
+    size_t expectedTrialWorks() const;
+
     //
     // Planner data
     //
@@ -281,6 +325,22 @@ public:
     // runs when they complete.
     std::vector<PlanCacheEntryFeedback*> feedback;
 
+    // The works performed by the trial period of every cached run for which feedback was provided.
+    // Unlike 'feedback', this is not capped. For a plan variant, it may lower the works budget of
+    // later trials to what the variant's queries have been seen to need.
+    PlanCacheHistogram worksHistogram;
+
+    // A snapshot of this entry for get() to share, built whenever the planner data or the decision
+    // works change. This keeps the deep copy out of get()'s critical section, so that queries of a
+    // single hot shape only serialize on the LRU lookup.
+    std::shared_ptr<const CachedSolution> cachedSolution;
+
+    // If the cache is keeping several plan variants for this entry's query shape, which variant
+    // this entry holds. Queries are assigned to a variant by the estimated selectivity of their
+    // parameters, so that a plan which suits narrow predicates need not be shared with queries
+    // whose predicates are broad, and vice versa.
+    boost::optional<size_t> variant;
+
     // Whether or not the cache entry is active. Inactive cache entries should not be used for
     // planning.
     bool isActive = false;
@@ -326,7 +386,7 @@ public:
      */
     struct GetResult {
         CacheEntryState state;
-        std::unique_ptr<CachedSolution> cachedSolution;
+        std::shared_ptr<const CachedSolution> cachedSolution;
     };
 
     /**
@@ -388,7 +448,7 @@ public:
      * entry exists but is inactive, log a message. Returns nullptr if the cache should not be
      * used, and a CachedSolution otherwise.
      */
-    std::unique_ptr<CachedSolution> getCacheEntryIfCacheable(const CanonicalQuery& cq) const;
+    std::shared_ptr<const CachedSolution> getCacheEntryIfCacheable(const CanonicalQuery& cq) const;
 
     /**
      * When the CachedPlanStage runs a plan out of the cache, we want to record data about the
@@ -406,8 +466,9 @@ public:
     Status feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* feedback);
 
     /**
-     * Remove the entry corresponding to 'ck' from the cache.  Returns Status::OK() if the plan
-     * was present and removed and an error status otherwise.
+     * Remove the entry corresponding to 'ck' from the cache, along with any other plan variants
+     * for its query shape.  Returns Status::OK() if a plan was present and removed and an error
+     * status otherwise.
      */
     Status remove(const CanonicalQuery& canonicalQuery);
 
@@ -427,6 +488,17 @@ public:
      */
     PlanCacheKey computeKey(const CanonicalQuery&) const;
 
+    /**
+     * Returns the plan variant which 'cq' is assigned to, or boost::none if the cache is keeping
+     * a single plan per query shape. See 'internalQueryCacheMaxVariantsPerShape'.
+     *
+     * The variant is derived from the estimated selectivity of those predicates whose selectivity
+     * depends on their constants rather than on the query shape alone: the number of values in an
+     * $in, the width of a numeric or date range bounded on both sides, and equality with null.
+     * Queries whose predicates fall into the same selectivity classes share a variant.
+     */
+    boost::optional<size_t> computeVariant(const CanonicalQuery& cq) const;
+
     /**
      * Returns a copy of a cache entry.
      * Used by planCacheListPlans to display plan details.
@@ -449,6 +521,12 @@ public:
      */
     size_t size() const;
 
+    /**
+     * Returns the number of independently locked partitions the cache is split into.
+     * Used for testing.
+     */
+    size_t numPartitions() const;
+
     /**
      * Updates internal state kept about the collection's indexes.  Must be called when the set
      * of indexes on the associated collection have changed.
@@ -458,6 +536,21 @@ public:
     void notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries);
 
 private:
+    /**
+     * A slice of the cache. Entries are assigned to a partition by the hash of their key, and
+     * each partition has its own lock and LRU list, so that queries of different shapes need not
+     * contend on a single mutex. Least recently used entries are only evicted relative to the
+     * other entries of their partition.
+     */
+    struct Partition {
+        explicit Partition(size_t size) : cache(size) {}
+
+        LRUKeyValue<PlanCacheKey, PlanCacheEntry> cache;
+
+        // Protects 'cache'.
+        mutable stdx::mutex mutex;
+    };
+
     struct NewEntryState {
         bool shouldBeCreated = false;
         bool shouldBeActive = false;
@@ -468,14 +561,20 @@ private:
                                    size_t newWorks,
                                    double growthCoefficient);
 
+    /**
+     * Returns the key of the cache entry which holds the plan for 'cq'. This is the query shape's
+     * key, extended with the query's plan variant if the cache keeps several per shape.
+     */
+    PlanCacheKey computeEntryKey(const CanonicalQuery& cq,
+                                 boost::optional<size_t>* variantOut = nullptr) const;
+
+    Partition& getPartition(const PlanCacheKey& key) const;
+
     void encodeKeyForMatch(const MatchExpression* tree, StringBuilder* keyBuilder) const;
     void encodeKeyForSort(const BSONObj& sortObj, StringBuilder* keyBuilder) const;
     void encodeKeyForProj(const BSONObj& projObj, StringBuilder* keyBuilder) const;
 
-    LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
-
-    // Protects _cache.
-    mutable stdx::mutex _cacheMutex;
+    std::vector<std::unique_ptr<Partition>> _partitions;
 
     // Full namespace of collection.
     std::string _ns;
@@ -0,0 +1,202 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/db/exec/plan_stats.h"
+#include "mongo/db/matcher/extensions_callback_noop.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/db/query/query_test_service_context.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+const int kMaxPerfThreads = 16;  // max number of threads looking up plans concurrently
+const size_t kCacheSize = 5000;
+
+const NamespaceString nss("test.collection");
+
+std::unique_ptr<CanonicalQuery> canonicalize(OperationContext* opCtx, const BSONObj& queryObj) {
+    auto qr = stdx::make_unique<QueryRequest>(nss);
+    qr->setFilter(queryObj);
+    const boost::intrusive_ptr<ExpressionContext> expCtx;
+    return uassertStatusOK(
+        CanonicalQuery::canonicalize(opCtx,
+                                     std::move(qr),
+                                     expCtx,
+                                     ExtensionsCallbackNoop(),
+                                     MatchExpressionParser::kAllowAllSpecialFeatures));
+}
+
+std::unique_ptr<PlanRankingDecision> createDecision(size_t works) {
+    auto why = stdx::make_unique<PlanRankingDecision>();
+    auto stats = stdx::make_unique<PlanStageStats>(CommonStats("COLLSCAN"), STAGE_COLLSCAN);
+    stats->specific = stdx::make_unique<CollectionScanStats>();
+    stats->common.works = works;
+    why->stats.push_back(std::move(stats));
+    why->scores.push_back(0U);
+    why->candidateOrder.push_back(0U);
+    return why;
+}
+
+/**
+ * Fills a plan cache with an active entry for each of 'numShapes' distinct query shapes, and
+ * returns a query of each shape. Each cached plan's index tree has 'numTreeChildren' children
+ * below its root.
+ */
+std::vector<std::unique_ptr<CanonicalQuery>> populatePlanCache(OperationContext* opCtx,
+                                                               PlanCache* planCache,
+                                                               size_t numShapes,
+                                                               size_t numTreeChildren = 0) {
+    QuerySolution qs;
+    qs.cacheData = stdx::make_unique<SolutionCacheData>();
+    qs.cacheData->tree = stdx::make_unique<PlanCacheIndexTree>();
+    for (size_t i = 0; i < numTreeChildren; ++i) {
+        qs.cacheData->tree->children.push_back(new PlanCacheIndexTree());
+    }
+    std::vector<QuerySolution*> solns = {&qs};
+
+    std::vector<std::unique_ptr<CanonicalQuery>> queries;
+    for (size_t i = 0; i < numShapes; ++i) {
+        queries.push_back(canonicalize(opCtx, BSON((str::stream() << "field" << i) << 1)));
+
+        // The first set() creates an inactive entry, and the second one activates it.
+        uassertStatusOK(planCache->set(*queries.back(), solns, createDecision(2), Date_t()));
+        uassertStatusOK(planCache->set(*queries.back(), solns, createDecision(1), Date_t()));
+    }
+    return queries;
+}
+
+/**
+ * Benchmarks PlanCache::get() from a varying number of threads sharing one plan cache, as happens
+ * when many queries run against the same collection. The argument is the number of distinct query
+ * shapes the threads look up, with a single shape being the worst case for lock contention.
+ */
+void BM_PlanCacheGet(benchmark::State& state) {
+    static std::unique_ptr<QueryTestServiceContext> serviceContext;
+    static std::unique_ptr<PlanCache> planCache;
+    static std::vector<std::unique_ptr<CanonicalQuery>> queries;
+
+    if (state.thread_index == 0) {
+        serviceContext = stdx::make_unique<QueryTestServiceContext>();
+        auto opCtx = serviceContext->makeOperationContext();
+        planCache = stdx::make_unique<PlanCache>(kCacheSize);
+        queries = populatePlanCache(opCtx.get(), planCache.get(), state.range(0));
+    }
+
+    size_t i = state.thread_index;
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(planCache->get(*queries[i++ % queries.size()]));
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index == 0) {
+        queries.clear();
+        planCache.reset();
+        serviceContext.reset();
+    }
+}
+
+/**
+ * Benchmarks PlanCache::get() of a single hot query shape from a varying number of threads. The
+ * argument is the number of children in the cached plan's index tree, which determines how much
+ * of the cached plan a lookup would have to copy while holding the shape's lock.
+ */
+void BM_PlanCacheGetHotShape(benchmark::State& state) {
+    static std::unique_ptr<QueryTestServiceContext> serviceContext;
+    static std::unique_ptr<PlanCache> planCache;
+    static std::vector<std::unique_ptr<CanonicalQuery>> queries;
+
+    if (state.thread_index == 0) {
+        serviceContext = stdx::make_unique<QueryTestServiceContext>();
+        auto opCtx = serviceContext->makeOperationContext();
+        planCache = stdx::make_unique<PlanCache>(kCacheSize);
+        queries = populatePlanCache(opCtx.get(), planCache.get(), 1, state.range(0));
+    }
+
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(planCache->get(*queries.front()));
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index == 0) {
+        queries.clear();
+        planCache.reset();
+        serviceContext.reset();
+    }
+}
+
+/**
+ * Benchmarks the lookup and subsequent feedback which the CachedPlanStage performs for each query
+ * run from the plan cache, both of which lock the entry's partition.
+ */
+void BM_PlanCacheGetAndFeedback(benchmark::State& state) {
+    static std::unique_ptr<QueryTestServiceContext> serviceContext;
+    static std::unique_ptr<PlanCache> planCache;
+    static std::vector<std::unique_ptr<CanonicalQuery>> queries;
+
+    if (state.thread_index == 0) {
+        serviceContext = stdx::make_unique<QueryTestServiceContext>();
+        auto opCtx = serviceContext->makeOperationContext();
+        planCache = stdx::make_unique<PlanCache>(kCacheSize);
+        queries = populatePlanCache(opCtx.get(), planCache.get(), state.range(0));
+    }
+
+    size_t i = state.thread_index;
+    for (auto keepRunning : state) {
+        const auto& cq = *queries[i++ % queries.size()];
+        benchmark::DoNotOptimize(planCache->get(cq));
+
+        auto feedback = stdx::make_unique<PlanCacheEntryFeedback>();
+        feedback->stats =
+            stdx::make_unique<PlanStageStats>(CommonStats("CACHED_PLAN"), STAGE_CACHED_PLAN);
+        feedback->score = 0;
+        planCache->feedback(cq, feedback.release()).ignore();
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index == 0) {
+        queries.clear();
+        planCache.reset();
+        serviceContext.reset();
+    }
+}
+
+BENCHMARK(BM_PlanCacheGet)->Arg(1)->Arg(100)->ThreadRange(1, kMaxPerfThreads);
+BENCHMARK(BM_PlanCacheGetHotShape)->Arg(0)->Arg(16)->ThreadRange(1, kMaxPerfThreads);
+BENCHMARK(BM_PlanCacheGetAndFeedback)->Arg(1)->Arg(100)->ThreadRange(1, kMaxPerfThreads);
+
+}  // namespace
+}  // namespace mongo
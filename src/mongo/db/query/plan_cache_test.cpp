@@ -762,6 +762,276 @@ TEST(PlanCacheTest, DeactivateCacheEntry) {
     ASSERT_EQ(entry->works, 20U);
 }
 
+TEST(PlanCacheTest, SmallCacheHasSinglePartition) {
+    PlanCache planCache(2);
+    ASSERT_EQ(planCache.numPartitions(), 1U);
+}
+
+TEST(PlanCacheTest, EntriesAreSpreadAcrossPartitions) {
+    PlanCache planCache(5000);
+    ASSERT_GT(planCache.numPartitions(), 1U);
+
+    auto qs = getQuerySolutionForCaching();
+    std::vector<QuerySolution*> solns = {qs.get()};
+
+    // Cache queries of many different shapes, each filtering on a different field.
+    const size_t numShapes = 100;
+    std::vector<unique_ptr<CanonicalQuery>> queries;
+    QueryTestServiceContext serviceContext;
+    for (size_t i = 0; i < numShapes; ++i) {
+        queries.push_back(canonicalize(BSON((str::stream() << "field" << i) << 1)));
+        ASSERT_OK(planCache.set(*queries.back(), solns, createDecision(1U), Date_t{}));
+    }
+
+    ASSERT_EQ(planCache.size(), numShapes);
+    for (auto&& cq : queries) {
+        ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kPresentInactive);
+    }
+
+    std::vector<PlanCacheEntry*> entries = planCache.getAllEntries();
+    ASSERT_EQ(entries.size(), numShapes);
+    for (auto* entry : entries) {
+        delete entry;
+    }
+
+    ASSERT_OK(planCache.remove(*queries.front()));
+    ASSERT_EQ(planCache.size(), numShapes - 1);
+
+    planCache.clear();
+    ASSERT_EQ(planCache.size(), 0U);
+}
+
+TEST(PlanCacheTest, QueriesOfSameShapeShareEntryWhenVariantsDisabled) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cqA(canonicalize("{a: 1}"));
+    unique_ptr<CanonicalQuery> cqB(canonicalize("{a: 2}"));
+    auto qs = getQuerySolutionForCaching();
+    std::vector<QuerySolution*> solns = {qs.get()};
+
+    QueryTestServiceContext serviceContext;
+    ASSERT_OK(planCache.set(*cqA, solns, createDecision(1U, 20), Date_t{}));
+    ASSERT_OK(planCache.set(*cqB, solns, createDecision(1U, 10), Date_t{}));
+    ASSERT_EQ(planCache.size(), 1U);
+    ASSERT_EQ(planCache.get(*cqA).state, PlanCache::CacheEntryState::kPresentActive);
+
+    ASSERT_FALSE(planCache.computeVariant(*cqA));
+    auto entry = assertGet(planCache.getEntry(*cqA));
+    ASSERT_FALSE(entry->variant);
+}
+
+TEST(PlanCacheTest, QueriesOfSameShapeAreCachedPerVariant) {
+    internalQueryCacheMaxVariantsPerShape.store(16);
+    ON_BLOCK_EXIT([] { internalQueryCacheMaxVariantsPerShape.store(1); });
+
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cqA(canonicalize("{a: {$in: [1, 2]}}"));
+    unique_ptr<CanonicalQuery> cqB(canonicalize(
+        "{a: {$in: [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20]}}"));
+    ASSERT_EQ(planCache.computeKey(*cqA), planCache.computeKey(*cqB));
+    const auto variantA = planCache.computeVariant(*cqA);
+    ASSERT_TRUE(variantA);
+    ASSERT_TRUE(planCache.computeVariant(*cqB));
+    ASSERT_NE(*variantA, *planCache.computeVariant(*cqB));
+
+    auto qs = getQuerySolutionForCaching();
+    std::vector<QuerySolution*> solns = {qs.get()};
+
+    // Each variant goes through the inactive and active states independently.
+    QueryTestServiceContext serviceContext;
+    ASSERT_OK(planCache.set(*cqA, solns, createDecision(1U, 20), Date_t{}));
+    ASSERT_EQ(planCache.get(*cqA).state, PlanCache::CacheEntryState::kPresentInactive);
+    ASSERT_EQ(planCache.get(*cqB).state, PlanCache::CacheEntryState::kNotPresent);
+
+    ASSERT_OK(planCache.set(*cqA, solns, createDecision(1U, 10), Date_t{}));
+    ASSERT_OK(planCache.set(*cqB, solns, createDecision(1U, 30), Date_t{}));
+    ASSERT_EQ(planCache.size(), 2U);
+    ASSERT_EQ(planCache.get(*cqA).state, PlanCache::CacheEntryState::kPresentActive);
+    ASSERT_EQ(planCache.get(*cqB).state, PlanCache::CacheEntryState::kPresentInactive);
+
+    auto entryA = assertGet(planCache.getEntry(*cqA));
+    ASSERT_TRUE(entryA->variant == variantA);
+    ASSERT_EQ(entryA->works, 10U);
+    auto entryB = assertGet(planCache.getEntry(*cqB));
+    ASSERT_TRUE(entryB->variant == planCache.computeVariant(*cqB));
+    ASSERT_EQ(entryB->works, 30U);
+
+    // Deactivating one variant leaves the other alone.
+    ASSERT_OK(planCache.set(*cqB, solns, createDecision(1U, 30), Date_t{}));
+    planCache.deactivate(*cqA);
+    ASSERT_EQ(planCache.get(*cqA).state, PlanCache::CacheEntryState::kPresentInactive);
+    ASSERT_EQ(planCache.get(*cqB).state, PlanCache::CacheEntryState::kPresentActive);
+
+    // Removing the shape removes all of its variants, even after variants have been disabled.
+    internalQueryCacheMaxVariantsPerShape.store(1);
+    ASSERT_OK(planCache.remove(*cqA));
+    ASSERT_EQ(planCache.size(), 0U);
+}
+
+TEST(PlanCacheTest, VariantIsChosenBySelectivityOfParameters) {
+    internalQueryCacheMaxVariantsPerShape.store(16);
+    ON_BLOCK_EXIT([] { internalQueryCacheMaxVariantsPerShape.store(1); });
+    PlanCache planCache;
+
+    auto variantOf = [&](const char* queryStr) {
+        unique_ptr<CanonicalQuery> cq(canonicalize(queryStr));
+        auto variant = planCache.computeVariant(*cq);
+        ASSERT_TRUE(variant);
+        return *variant;
+    };
+
+    // Equality on non-null values is equally selective whatever the value.
+    ASSERT_EQ(variantOf("{a: 1}"), variantOf("{a: 'abc'}"));
+    ASSERT_NE(variantOf("{a: 1}"), variantOf("{a: null}"));
+
+    // $in lists are grouped by their length.
+    ASSERT_EQ(variantOf("{a: {$in: [1, 2, 3]}}"), variantOf("{a: {$in: [7, 8, 9, 10]}}"));
+    ASSERT_NE(variantOf("{a: {$in: [1, 2]}}"), variantOf("{a: {$in: [1, 2, 3, 4, 5]}}"));
+
+    // Ranges bounded on both sides are grouped by their width, wherever they lie.
+    ASSERT_EQ(variantOf("{a: {$gte: 0, $lte: 5}}"), variantOf("{a: {$gte: 1000, $lt: 1010}}"));
+    ASSERT_NE(variantOf("{a: {$gte: 0, $lte: 5}}"), variantOf("{a: {$gte: 0, $lte: 5000}}"));
+    ASSERT_EQ(variantOf("{a: {$gte: new Date(0), $lt: new Date(1000)}}"),
+              variantOf("{a: {$gte: new Date(5000), $lt: new Date(6000)}}"));
+
+    // A range bounded on one side only says nothing about its selectivity.
+    ASSERT_EQ(variantOf("{a: {$gte: 0}}"), variantOf("{a: {$gte: 1000000}}"));
+
+    // Each predicate of a conjunction contributes to the variant.
+    ASSERT_EQ(variantOf("{a: {$in: [1, 2]}, b: {$gt: 0, $lt: 5}}"),
+              variantOf("{a: {$in: [3, 4]}, b: {$gt: 10, $lt: 15}}"));
+    ASSERT_NE(variantOf("{a: {$in: [1, 2]}, b: {$gt: 0, $lt: 5}}"),
+              variantOf("{a: {$in: [1, 2]}, b: {$gt: 0, $lt: 5000}}"));
+}
+
+TEST(PlanCacheTest, FeedbackIsRecordedInHistograms) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+    auto qs = getQuerySolutionForCaching();
+    std::vector<QuerySolution*> solns = {qs.get()};
+
+    QueryTestServiceContext serviceContext;
+    ASSERT_OK(planCache.set(*cq, solns, createDecision(1U), Date_t{}));
+
+    for (size_t works : {5U, 6U, 100U}) {
+        auto planStats = stdx::make_unique<PlanStageStats>(CommonStats("COLLSCAN"), STAGE_COLLSCAN);
+        planStats->common.works = works;
+        planStats->common.advanced = 1;
+        auto feedback = stdx::make_unique<PlanCacheEntryFeedback>();
+        feedback->stats =
+            stdx::make_unique<PlanStageStats>(CommonStats("CACHED_PLAN"), STAGE_CACHED_PLAN);
+        feedback->stats->children.push_back(std::move(planStats));
+        feedback->score = 0;
+        ASSERT_OK(planCache.feedback(*cq, feedback.release()));
+    }
+
+    auto entry = assertGet(planCache.getEntry(*cq));
+    ASSERT_BSONOBJ_EQ(entry->worksHistogram.toBSON(),
+                      BSON_ARRAY(BSON("lowerBound" << 4LL << "count" << 2LL)
+                                 << BSON("lowerBound" << 64LL << "count" << 1LL)));
+}
+
+TEST(PlanCacheTest, WorksHistogramLowersExpectedTrialWorksOfVariants) {
+    internalQueryCacheMaxVariantsPerShape.store(16);
+    ON_BLOCK_EXIT([] { internalQueryCacheMaxVariantsPerShape.store(1); });
+
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+    auto qs = getQuerySolutionForCaching();
+    std::vector<QuerySolution*> solns = {qs.get()};
+
+    QueryTestServiceContext serviceContext;
+    ASSERT_OK(planCache.set(*cq, solns, createDecision(1U, 100), Date_t{}));
+
+    auto giveFeedback = [&](size_t works) {
+        auto planStats = stdx::make_unique<PlanStageStats>(CommonStats("COLLSCAN"), STAGE_COLLSCAN);
+        planStats->common.works = works;
+        auto feedback = stdx::make_unique<PlanCacheEntryFeedback>();
+        feedback->stats =
+            stdx::make_unique<PlanStageStats>(CommonStats("CACHED_PLAN"), STAGE_CACHED_PLAN);
+        feedback->stats->children.push_back(std::move(planStats));
+        feedback->score = 0;
+        ASSERT_OK(planCache.feedback(*cq, feedback.release()));
+    };
+
+    // Until enough runs have been recorded, the works taken to pick the plan are used.
+    for (int i = 0; i < 7; ++i) {
+        giveFeedback(10);
+    }
+    auto entry = assertGet(planCache.getEntry(*cq));
+    ASSERT_EQ(entry->expectedTrialWorks(), 100U);
+    ASSERT_EQ(CachedSolution(planCache.computeKey(*cq), *entry).decisionWorks, 100U);
+
+    // After that, the 90th percentile of the recorded runs is used if it is lower.
+    giveFeedback(10);
+    entry = assertGet(planCache.getEntry(*cq));
+    ASSERT_EQ(entry->expectedTrialWorks(), 16U);
+    ASSERT_EQ(CachedSolution(planCache.computeKey(*cq), *entry).decisionWorks, 16U);
+
+    // Runs which needed more works than the plan was picked with never raise it.
+    planCache.clear();
+    ASSERT_OK(planCache.set(*cq, solns, createDecision(1U, 10), Date_t{}));
+    for (int i = 0; i < 20; ++i) {
+        giveFeedback(100);
+    }
+    ASSERT_EQ(assertGet(planCache.getEntry(*cq))->expectedTrialWorks(), 10U);
+}
+
+TEST(PlanCacheTest, GetSharesEntrySnapshotUntilTrialWorksChange) {
+    internalQueryCacheMaxVariantsPerShape.store(16);
+    ON_BLOCK_EXIT([] { internalQueryCacheMaxVariantsPerShape.store(1); });
+
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+    auto qs = getQuerySolutionForCaching();
+    std::vector<QuerySolution*> solns = {qs.get()};
+
+    QueryTestServiceContext serviceContext;
+    ASSERT_OK(planCache.set(*cq, solns, createDecision(1U, 100), Date_t{}));
+
+    auto oldSolution = planCache.get(*cq).cachedSolution;
+    ASSERT(oldSolution);
+    ASSERT_EQ(planCache.get(*cq).cachedSolution, oldSolution);
+
+    for (int i = 0; i < 8; ++i) {
+        auto planStats = stdx::make_unique<PlanStageStats>(CommonStats("COLLSCAN"), STAGE_COLLSCAN);
+        planStats->common.works = 10;
+        auto feedback = stdx::make_unique<PlanCacheEntryFeedback>();
+        feedback->stats =
+            stdx::make_unique<PlanStageStats>(CommonStats("CACHED_PLAN"), STAGE_CACHED_PLAN);
+        feedback->stats->children.push_back(std::move(planStats));
+        feedback->score = 0;
+        ASSERT_OK(planCache.feedback(*cq, feedback.release()));
+    }
+
+    // Lowering the trial works replaces the snapshot, leaving the one already handed out intact.
+    auto newSolution = planCache.get(*cq).cachedSolution;
+    ASSERT_NE(newSolution, oldSolution);
+    ASSERT_EQ(newSolution->decisionWorks, 16U);
+    ASSERT_EQ(oldSolution->decisionWorks, 100U);
+}
+
+TEST(PlanCacheTest, WorksHistogramDoesNotChangeExpectedTrialWorksWithoutVariants) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+    auto qs = getQuerySolutionForCaching();
+    std::vector<QuerySolution*> solns = {qs.get()};
+
+    QueryTestServiceContext serviceContext;
+    ASSERT_OK(planCache.set(*cq, solns, createDecision(1U, 100), Date_t{}));
+
+    for (int i = 0; i < 20; ++i) {
+        auto planStats = stdx::make_unique<PlanStageStats>(CommonStats("COLLSCAN"), STAGE_COLLSCAN);
+        planStats->common.works = 10;
+        auto feedback = stdx::make_unique<PlanCacheEntryFeedback>();
+        feedback->stats =
+            stdx::make_unique<PlanStageStats>(CommonStats("CACHED_PLAN"), STAGE_CACHED_PLAN);
+        feedback->stats->children.push_back(std::move(planStats));
+        feedback->score = 0;
+        ASSERT_OK(planCache.feedback(*cq, feedback.release()));
+    }
+    ASSERT_EQ(assertGet(planCache.getEntry(*cq))->expectedTrialWorks(), 100U);
+}
+
 
 /**
  * Each test in the CachePlanSelectionTest suite goes through
@@ -48,6 +48,14 @@ extern AtomicDouble internalQueryPlanEvaluationCollFraction;
 // Stop working plans once a plan returns this many results.
 extern AtomicInt32 internalQueryPlanEvaluationMaxResults;
 
+// If non-zero, stop working a candidate plan during the trial period once its productivity (results
+// per work) falls below this fraction of the most productive remaining candidate's. Zero disables
+// pruning, so that every candidate is worked for the whole trial period.
+extern AtomicDouble internalQueryPlanEvaluationPruneRatio;
+
+// The number of times a candidate plan must have been worked before it may be pruned.
+extern AtomicInt32 internalQueryPlanEvaluationPruneMinWorks;
+
 // Do we give a big ranking bonus to intersection plans?
 extern AtomicBool internalQueryForceIntersectionPlans;
 
@@ -79,6 +87,11 @@ extern AtomicDouble internalQueryCacheWorksGrowthCoefficient;
 // Whether or not cache entries can be marked as "inactive."
 extern AtomicBool internalQueryCacheDisableInactiveEntries;
 
+// How many plans may be cached for each query shape. Queries of the same shape are assigned to one
+// of these variants by the estimated selectivity of their parameters, and each variant is cached
+// and replanned independently, so that narrow and broad predicates need not share a plan.
+extern AtomicInt32 internalQueryCacheMaxVariantsPerShape;
+
 //
 // Planning and enumeration.
 //
@@ -95,6 +108,14 @@ extern AtomicInt32 internalQueryEnumerationMaxIntersectPerAnd;
 // Do we want to plan each child of the OR independently?
 extern AtomicBool internalQueryPlanOrChildrenIndependently;
 
+// Whether the planner consults the statistics built by the 'analyze' command to estimate how many
+// keys and documents each candidate solution examines before multi-planning.
+extern AtomicBool internalQueryPlannerUseStatistics;
+
+// When using statistics, candidate solutions estimated to examine more than this many times as
+// many keys and documents as the cheapest candidate are discarded before multi-planning.
+extern AtomicDouble internalQueryPlannerStatisticsPruneFactor;
+
 // How many index scans are we willing to produce in order to obtain a sort order
 // during explodeForSort?
 extern AtomicInt32 internalQueryMaxScansToExplode;
@@ -129,8 +150,39 @@ extern AtomicInt32 internalDocumentSourceCursorBatchSizeBytes;
 
 extern AtomicInt32 internalDocumentSourceLookupCacheSizeBytes;
 
+// Maximum number of bytes of foreign documents a $lookup on localField/foreignField may hold in an
+// in-memory hash table, so that the foreign collection is scanned once rather than queried for
+// every input document. A hash join is never chosen when 'foreignField' is indexed, since each
+// lookup of the nested loop join is then a single index seek. 0, the default, disables hash joins.
+extern AtomicInt32 internalDocumentSourceLookupHashJoinMaxBytes;
+
+// Number of input documents a $lookup on localField/foreignField joins with a single query against
+// the foreign collection when it does not use a hash join. 1, the default, queries once per input
+// document.
+extern AtomicInt32 internalDocumentSourceLookupBatchSize;
+
+// Maximum number of bytes of foreign documents a batched $lookup holds in memory for one batch.
+// Input documents whose matches do not fit are joined by querying for them individually.
+extern AtomicInt32 internalDocumentSourceLookupBatchMaxBytes;
+
+// Number of threads a blocking $sort may use to sort its in-memory runs, spill them to disk in the
+// background and prefetch spilled blocks while merging. 1 disables parallel sorting.
+extern AtomicInt32 internalDocumentSourceSortParallelThreads;
+
+// Number of hash partitions a $group splits its groups into once it exceeds its memory limit with
+// 'allowDiskUse', so that only the largest partitions are written to disk. 0 makes $group spill
+// all of its groups as sorted runs instead.
+extern AtomicInt32 internalDocumentSourceGroupHashPartitions;
+
+// Number of spilled $group partitions that may be merged back into memory concurrently.
+extern AtomicInt32 internalDocumentSourceGroupPartitionThreads;
+
 extern AtomicBool internalQueryProhibitBlockingMergeOnMongoS;
 
+// Maximum total size, across all collections, of the columns that aggregations ending in a $group
+// may cache to avoid scanning collections. 0 disables the column cache.
+extern AtomicInt32 internalQueryColumnCacheMaxSizeMB;
+
 //
 // In-progress features.
 //
@@ -99,6 +99,13 @@ struct QueryPlannerParams {
 
         // Set this so that collection scans on the oplog wait for visibility before reading.
         OPLOG_SCAN_WAIT_FOR_VISIBLE = 1 << 13,
+
+        // Set this to end the trial period of a cached plan as soon as it produces its first
+        // result, rather than a full batch. The plan is still replanned if it needs more works to
+        // get there than the cache entry allows. Used by aggregation sub-pipelines which issue
+        // many queries of the same shape, where buffering a full trial batch for every one of
+        // them would dominate.
+        SHORT_CACHED_PLAN_TRIAL = 1 << 14,
     };
 
     // See Options enum above.
@@ -106,38 +106,44 @@ Status CollectionBulkLoaderImpl::init(const std::vector<BSONObj>& secondaryIndex
 
 Status CollectionBulkLoaderImpl::insertDocuments(const std::vector<BSONObj>::const_iterator begin,
                                                  const std::vector<BSONObj>::const_iterator end) {
-    int count = 0;
     return _runTaskReleaseResourcesOnFailure([&]() -> Status {
         UnreplicatedWritesBlock uwb(_opCtx.get());
 
-        for (auto iter = begin; iter != end; ++iter) {
-            std::vector<MultiIndexBlock*> indexers;
-            if (_idIndexBlock) {
-                indexers.push_back(_idIndexBlock.get());
-            }
-            if (_secondaryIndexesBlock) {
-                indexers.push_back(_secondaryIndexesBlock.get());
-            }
+        std::vector<MultiIndexBlock*> indexers;
+        if (_idIndexBlock) {
+            indexers.push_back(_idIndexBlock.get());
+        }
+        if (_secondaryIndexesBlock) {
+            indexers.push_back(_secondaryIndexesBlock.get());
+        }
 
+        if (!indexers.empty()) {
+            // This flavor of insertDocuments will not update any pre-existing indexes, only the
+            // indexers passed in. The whole batch goes to the record store in one call, and the
+            // indexes are built from sorted keys in commit().
+            return writeConflictRetry(
+                _opCtx.get(), "CollectionBulkLoaderImpl::insertDocuments", _nss.ns(), [&] {
+                    WriteUnitOfWork wunit(_opCtx.get());
+                    const auto status = _autoColl->getCollection()->insertDocuments(
+                        _opCtx.get(), begin, end, indexers);
+                    if (!status.isOK()) {
+                        return status;
+                    }
+                    wunit.commit();
+                    return Status::OK();
+                });
+        }
+
+        for (auto iter = begin; iter != end; ++iter) {
             Status status = writeConflictRetry(
                 _opCtx.get(), "CollectionBulkLoaderImpl::insertDocuments", _nss.ns(), [&] {
                     WriteUnitOfWork wunit(_opCtx.get());
-                    if (!indexers.empty()) {
-                        // This flavor of insertDocument will not update any pre-existing indexes,
-                        // only the indexers passed in.
-                        const auto status = _autoColl->getCollection()->insertDocument(
-                            _opCtx.get(), *iter, indexers);
-                        if (!status.isOK()) {
-                            return status;
-                        }
-                    } else {
-                        // For capped collections, we use regular insertDocument, which will update
-                        // pre-existing indexes.
-                        const auto status = _autoColl->getCollection()->insertDocument(
-                            _opCtx.get(), InsertStatement(*iter), nullptr);
-                        if (!status.isOK()) {
-                            return status;
-                        }
+                    // For capped collections, we use regular insertDocument, which will update
+                    // pre-existing indexes.
+                    const auto status = _autoColl->getCollection()->insertDocument(
+                        _opCtx.get(), InsertStatement(*iter), nullptr);
+                    if (!status.isOK()) {
+                        return status;
                     }
 
                     wunit.commit();
@@ -148,8 +154,6 @@ Status CollectionBulkLoaderImpl::insertDocuments(const std::vector<BSONObj>::con
             if (!status.isOK()) {
                 return status;
             }
-
-            ++count;
         }
         return Status::OK();
     });
@@ -32,6 +32,7 @@
 
 #include "mongo/db/repl/collection_cloner.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "mongo/base/string_data.h"
@@ -68,6 +69,31 @@ MONGO_EXPORT_SERVER_PARAMETER(numInitialSyncCollectionCountAttempts, int, 3);
 MONGO_EXPORT_SERVER_PARAMETER(numInitialSyncListIndexesAttempts, int, 3);
 // The number of attempts for the find command, which gets the data.
 MONGO_EXPORT_SERVER_PARAMETER(numInitialSyncCollectionFindAttempts, int, 3);
+
+// The maximum number of _id ranges a collection is split into, each cloned over its own cursor.
+MONGO_EXPORT_SERVER_PARAMETER(initialSyncCollectionClonerRanges, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 64) {
+            return Status(ErrorCodes::BadValue,
+                          "initialSyncCollectionClonerRanges must be between 1 and 64");
+        }
+
+        return Status::OK();
+    });
+
+// The minimum number of documents in each _id range, so that only large collections are split.
+MONGO_EXPORT_SERVER_PARAMETER(initialSyncCollectionClonerMinDocumentsPerRange, int, 100 * 1000)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "initialSyncCollectionClonerMinDocumentsPerRange must be at least 1");
+        }
+
+        return Status::OK();
+    });
+
+// The number of _id values sampled per range to pick the split points from.
+const int kSampledIdsPerRange = 20;
 }  // namespace
 
 // Failpoint which causes initial sync to hang before establishing its cursor to clone the
@@ -263,6 +289,12 @@ void CollectionCloner::_cancelRemainingWork_inlock() {
     if (_establishCollectionCursorsScheduler) {
         _establishCollectionCursorsScheduler->shutdown();
     }
+    if (_sampleIdsScheduler) {
+        _sampleIdsScheduler->shutdown();
+    }
+    for (auto&& scheduler : _establishRangeCursorsSchedulers) {
+        scheduler->shutdown();
+    }
     if (_verifyCollectionDroppedScheduler) {
         _verifyCollectionDroppedScheduler->shutdown();
     }
@@ -475,13 +507,6 @@ void CollectionCloner::_beginCollectionCallback(const executor::TaskExecutor::Ca
 
     _collLoader = std::move(collectionBulkLoader.getValue());
 
-    BSONObjBuilder cmdObj;
-
-    cmdObj.appendElements(makeCommandWithUUIDorCollectionName("find", _options.uuid, _sourceNss));
-    cmdObj.append("noCursorTimeout", true);
-    // Set batchSize to be 0 to establish the cursor without fetching any documents,
-    cmdObj.append("batchSize", 0);
-
     Client::initThreadIfNotAlready();
     auto opCtx = cc().getOperationContext();
 
@@ -496,6 +521,171 @@ void CollectionCloner::_beginCollectionCallback(const executor::TaskExecutor::Ca
         }
     }
 
+    UniqueLock lk(_mutex);
+    const auto numRanges = _getNumRangesToClone_inlock();
+    if (numRanges > 1 && _state == State::kRunning) {
+        // Sample the _id values of the collection to split it into ranges of roughly equal size.
+        const int sampleSize = numRanges * kSampledIdsPerRange;
+        auto cmdObj = BSON("aggregate" << _sourceNss.coll() << "pipeline"
+                                       << BSON_ARRAY(BSON("$sample" << BSON("size" << sampleSize))
+                                                     << BSON("$project" << BSON("_id" << 1)))
+                                       << "cursor"
+                                       << BSON("batchSize" << sampleSize));
+        _sampleIdsScheduler = stdx::make_unique<RemoteCommandRetryScheduler>(
+            _executor,
+            RemoteCommandRequest(_source,
+                                 _sourceNss.db().toString(),
+                                 cmdObj,
+                                 ReadPreferenceSetting::secondaryPreferredMetadata(),
+                                 opCtx,
+                                 RemoteCommandRequest::kNoTimeout),
+            [=](const RemoteCommandCallbackArgs& rcbd) { _sampleIdsCallback(numRanges, rcbd); },
+            RemoteCommandRetryScheduler::makeNoRetryPolicy());
+        auto scheduleStatus = _sampleIdsScheduler->startup();
+        if (scheduleStatus.isOK()) {
+            return;
+        }
+        _sampleIdsScheduler.reset();
+        warning() << "Failed to sample _id values of collection " << _sourceNss.ns()
+                  << ", cloning it over a single cursor: " << redact(scheduleStatus);
+    }
+    lk.unlock();
+
+    _establishCollectionCursors(opCtx);
+}
+
+size_t CollectionCloner::_getNumRangesToClone_inlock() const {
+    // Ranges are bounded by _id values, compared without regard to any collation, so only
+    // collections with a simple _id index are split. Capped collections must be cloned in order.
+    const size_t maxRanges = initialSyncCollectionClonerRanges.load();
+    if (maxRanges <= 1 || _idIndexSpec.isEmpty() || _options.capped ||
+        !_options.collation.isEmpty()) {
+        return 1;
+    }
+    const size_t minDocumentsPerRange = initialSyncCollectionClonerMinDocumentsPerRange.load();
+    return std::max<size_t>(1, std::min(maxRanges, _stats.documentToCopy / minDocumentsPerRange));
+}
+
+void CollectionCloner::_sampleIdsCallback(size_t numRanges, const RemoteCommandCallbackArgs& rcbd) {
+    if (_isShuttingDown() || rcbd.response.status == ErrorCodes::CallbackCanceled) {
+        _finishCallback({ErrorCodes::CallbackCanceled, "Cloner shutting down."});
+        return;
+    }
+
+    // Failing to sample the collection is not fatal, the collection is then cloned over a single
+    // cursor.
+    std::vector<BSONObj> ids;
+    auto status = rcbd.response.status;
+    if (status.isOK()) {
+        auto cursorResponse = CursorResponse::parseFromBSON(rcbd.response.data);
+        status = cursorResponse.getStatus();
+        if (status.isOK()) {
+            for (auto&& doc : cursorResponse.getValue().getBatch()) {
+                if (doc.hasField("_id")) {
+                    ids.push_back(doc.getOwned());
+                }
+            }
+            _sendKillCursors(cursorResponse.getValue().getCursorId(),
+                             cursorResponse.getValue().getNSS());
+        }
+    }
+    if (!status.isOK()) {
+        warning() << "Failed to sample _id values of collection " << _sourceNss.ns()
+                  << ", cloning it over a single cursor: " << redact(status);
+    }
+
+    const auto lessThan = [](const BSONObj& lhs, const BSONObj& rhs) {
+        return lhs.firstElement().woCompare(rhs.firstElement(), false) < 0;
+    };
+    std::sort(ids.begin(), ids.end(), lessThan);
+    std::vector<BSONObj> splitPoints;
+    for (size_t i = 1; i < numRanges && !ids.empty(); ++i) {
+        const auto& splitPoint = ids[i * ids.size() / numRanges];
+        if (splitPoints.empty() || lessThan(splitPoints.back(), splitPoint)) {
+            splitPoints.push_back(BSON("_id" << splitPoint.firstElement()));
+        }
+    }
+
+    {
+        LockGuard lk(_mutex);
+        _splitPoints = std::move(splitPoints);
+        if (!_splitPoints.empty()) {
+            _stats.ranges.resize(_splitPoints.size() + 1);
+            _stats.ranges.front().min = BSON("_id" << MINKEY);
+            for (size_t range = 1; range < _stats.ranges.size(); ++range) {
+                _stats.ranges[range - 1].max = _splitPoints[range - 1];
+                _stats.ranges[range].min = _splitPoints[range - 1];
+            }
+            _stats.ranges.back().max = BSON("_id" << MAXKEY);
+        }
+    }
+
+    _establishCollectionCursors(nullptr);
+}
+
+void CollectionCloner::_establishCollectionCursors(OperationContext* opCtx) {
+    UniqueLock lk(_mutex);
+    if (!_splitPoints.empty()) {
+        const size_t numRanges = _splitPoints.size() + 1;
+        LOG(1) << "Collection cloner splitting " << _sourceNss.ns() << " into " << numRanges
+               << " _id ranges.";
+        _rangeCursorResponses.resize(numRanges);
+        for (size_t range = 0; range < numRanges; ++range) {
+            BSONObjBuilder cmdObj;
+            cmdObj.appendElements(
+                makeCommandWithUUIDorCollectionName("find", _options.uuid, _sourceNss));
+            cmdObj.append("noCursorTimeout", true);
+            cmdObj.append("batchSize", 0);
+            cmdObj.append("hint", BSON("_id" << 1));
+            if (range > 0) {
+                cmdObj.append("min", _splitPoints[range - 1]);
+            }
+            if (range < numRanges - 1) {
+                cmdObj.append("max", _splitPoints[range]);
+            }
+            auto scheduler = stdx::make_unique<RemoteCommandRetryScheduler>(
+                _executor,
+                RemoteCommandRequest(_source,
+                                     _sourceNss.db().toString(),
+                                     cmdObj.obj(),
+                                     ReadPreferenceSetting::secondaryPreferredMetadata(),
+                                     opCtx,
+                                     RemoteCommandRequest::kNoTimeout),
+                [=](const RemoteCommandCallbackArgs& rcbd) {
+                    _establishRangeCursorCallback(range, rcbd);
+                },
+                RemoteCommandRetryScheduler::makeRetryPolicy(
+                    numInitialSyncCollectionFindAttempts.load(),
+                    executor::RemoteCommandRequest::kNoTimeout,
+                    RemoteCommandRetryScheduler::kAllRetriableErrors));
+            auto scheduleStatus = scheduler->startup();
+            if (!scheduleStatus.isOK()) {
+                // Count the ranges not scheduled as responded to and cancel the ones that were, so
+                // that the last of their callbacks finishes the cloner with this status.
+                _establishRangeCursorsStatus = scheduleStatus;
+                _numRangeCursorResponses += numRanges - range;
+                for (auto&& scheduled : _establishRangeCursorsSchedulers) {
+                    scheduled->shutdown();
+                }
+                if (_numRangeCursorResponses == numRanges) {
+                    lk.unlock();
+                    _finishCallback(scheduleStatus);
+                }
+                return;
+            }
+            _establishRangeCursorsSchedulers.push_back(std::move(scheduler));
+        }
+        return;
+    }
+    lk.unlock();
+
+    BSONObjBuilder cmdObj;
+
+    cmdObj.appendElements(makeCommandWithUUIDorCollectionName("find", _options.uuid, _sourceNss));
+    cmdObj.append("noCursorTimeout", true);
+    // Set batchSize to be 0 to establish the cursor without fetching any documents,
+    cmdObj.append("batchSize", 0);
+
     _establishCollectionCursorsScheduler = stdx::make_unique<RemoteCommandRetryScheduler>(
         _executor,
         RemoteCommandRequest(_source,
@@ -559,6 +749,89 @@ void CollectionCloner::_establishCollectionCursorsCallback(const RemoteCommandCa
         _finishCallback(parseResponseStatus);
         return;
     }
+    _startFetchingDocuments(std::move(cursorResponses));
+}
+
+void CollectionCloner::_establishRangeCursorCallback(size_t range,
+                                                     const RemoteCommandCallbackArgs& rcbd) {
+    UniqueLock lk(_mutex);
+    auto status = rcbd.response.status;
+    if (status.isOK()) {
+        status = getStatusFromCommandResult(rcbd.response.data);
+    }
+    if (status.isOK()) {
+        auto cursorResponse = CursorResponse::parseFromBSON(rcbd.response.data);
+        if (cursorResponse.isOK()) {
+            _rangeCursorResponses[range] = std::move(cursorResponse.getValue());
+        } else {
+            status = cursorResponse.getStatus().withContext(
+                str::stream() << "Error parsing the 'find' query against collection '"
+                              << _sourceNss.ns()
+                              << "'");
+        }
+    } else if (status.code() != ErrorCodes::NamespaceNotFound &&
+               status.code() != ErrorCodes::CallbackCanceled) {
+        status = status.withContext(str::stream() << "Error querying collection '"
+                                                  << _sourceNss.ns()
+                                                  << "'");
+    }
+    if (status.isOK() && _state == State::kShuttingDown) {
+        status = {ErrorCodes::CallbackCanceled, "Cloner shutting down."};
+    }
+    if (!status.isOK() && _establishRangeCursorsStatus.isOK()) {
+        _establishRangeCursorsStatus = status;
+    }
+
+    if (++_numRangeCursorResponses < _rangeCursorResponses.size()) {
+        return;
+    }
+
+    std::vector<CursorResponse> cursorResponses;
+    for (auto&& cursorResponse : _rangeCursorResponses) {
+        if (cursorResponse) {
+            cursorResponses.push_back(std::move(*cursorResponse));
+        }
+    }
+    _rangeCursorResponses.clear();
+    const auto finalStatus = _establishRangeCursorsStatus;
+    lk.unlock();
+
+    if (!finalStatus.isOK()) {
+        for (auto&& cursorResponse : cursorResponses) {
+            _sendKillCursors(cursorResponse.getCursorId(), cursorResponse.getNSS());
+        }
+        _finishCallback(finalStatus == ErrorCodes::NamespaceNotFound ? Status::OK()
+                                                                      : finalStatus);
+        return;
+    }
+
+    _startFetchingDocuments(std::move(cursorResponses));
+}
+
+void CollectionCloner::_sendKillCursors(CursorId id, const NamespaceString& nss) {
+    if (!id) {
+        return;
+    }
+    auto logKillCursorsResult = [](const RemoteCommandCallbackArgs& args) {
+        if (!args.response.isOK()) {
+            warning() << "killCursors command task failed: " << redact(args.response.status);
+            return;
+        }
+        auto status = getStatusFromCommandResult(args.response.data);
+        if (!status.isOK()) {
+            warning() << "killCursors command failed: " << redact(status);
+        }
+    };
+    auto cmdObj = BSON("killCursors" << nss.coll() << "cursors" << BSON_ARRAY(id));
+    auto scheduleResult = _executor->scheduleRemoteCommand(
+        RemoteCommandRequest(_source, nss.db().toString(), cmdObj, nullptr), logKillCursorsResult);
+    if (!scheduleResult.isOK()) {
+        warning() << "failed to schedule killCursors command: "
+                  << redact(scheduleResult.getStatus());
+    }
+}
+
+void CollectionCloner::_startFetchingDocuments(std::vector<CursorResponse> cursorResponses) {
     LOG(1) << "Collection cloner running with " << cursorResponses.size()
            << " cursors established.";
 
@@ -805,6 +1078,11 @@ void CollectionCloner::_insertDocumentsCallback(
     }
     _documentsToInsert.swap(docs);
     _stats.documentsCopied += docs.size();
+    if (!_splitPoints.empty()) {
+        for (auto&& doc : docs) {
+            ++_stats.ranges[_getRangeForId_inlock(doc["_id"])].documentsCopied;
+        }
+    }
     ++_stats.fetchBatches;
     _progressMeter.hit(int(docs.size()));
     invariant(_collLoader);
@@ -834,6 +1112,17 @@ void CollectionCloner::_insertDocumentsCallback(
     }
 }
 
+size_t CollectionCloner::_getRangeForId_inlock(const BSONElement& id) const {
+    auto splitPoint = std::upper_bound(
+        _splitPoints.cbegin(),
+        _splitPoints.cend(),
+        id,
+        [](const BSONElement& value, const BSONObj& point) {
+            return value.woCompare(point.firstElement(), false) < 0;
+        });
+    return splitPoint - _splitPoints.cbegin();
+}
+
 void CollectionCloner::_finishCallback(const Status& status) {
     log() << "CollectionCloner ns:" << _destNss
           << " finished cloning with status: " << redact(status);
@@ -908,6 +1197,15 @@ void CollectionCloner::Stats::append(BSONObjBuilder* builder) const {
             builder->appendNumber("elapsedMillis", elapsedMillis);
         }
     }
+    if (!ranges.empty()) {
+        BSONArrayBuilder rangesBuilder(builder->subarrayStart("ranges"));
+        for (auto&& range : ranges) {
+            BSONObjBuilder rangeBuilder(rangesBuilder.subobjStart());
+            rangeBuilder.append("min", range.min);
+            rangeBuilder.append("max", range.max);
+            rangeBuilder.appendNumber(kDocumentsCopiedFieldName, range.documentsCopied);
+        }
+    }
 }
 }  // namespace repl
 }  // namespace mongo
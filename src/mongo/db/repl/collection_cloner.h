@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <memory>
 #include <string>
 #include <vector>
@@ -73,6 +74,15 @@ public:
         static constexpr StringData kDocumentsToCopyFieldName = "documentsToCopy"_sd;
         static constexpr StringData kDocumentsCopiedFieldName = "documentsCopied"_sd;
 
+        /**
+         * Progress of one _id range, when the collection is cloned over one cursor per range.
+         */
+        struct RangeStats {
+            BSONObj min;  // Inclusive, {_id: MinKey} for the first range.
+            BSONObj max;  // Exclusive, {_id: MaxKey} for the last range.
+            size_t documentsCopied{0};
+        };
+
         std::string ns;
         Date_t start;
         Date_t end;
@@ -80,6 +90,7 @@ public:
         size_t documentsCopied{0};
         size_t indexes{0};
         size_t fetchBatches{0};
+        std::vector<RangeStats> ranges;
 
         std::string toString() const;
         BSONObj toBSON() const;
@@ -189,12 +200,51 @@ private:
      */
     void _beginCollectionCallback(const executor::TaskExecutor::CallbackArgs& callbackData);
 
+    /**
+     * Returns the number of _id ranges to split the collection into, each cloned over its own
+     * cursor, or 1 if the collection should be cloned over a single cursor.
+     */
+    size_t _getNumRangesToClone_inlock() const;
+
+    /**
+     * Picks the _id values at which to split the collection into 'numRanges' ranges from a sample
+     * of the collection's _id values, then establishes the cursors.
+     */
+    void _sampleIdsCallback(size_t numRanges, const RemoteCommandCallbackArgs& rcbd);
+
+    /**
+     * Establishes one cursor per range delimited by '_splitPoints' or, if there are no split
+     * points, a single cursor over the whole collection.
+     */
+    void _establishCollectionCursors(OperationContext* opCtx);
+
     /**
      * Parses the cursor responses from the 'find' command and passes them into the
      * 'AsyncResultsMerger'.
      */
     void _establishCollectionCursorsCallback(const RemoteCommandCallbackArgs& rcbd);
 
+    /**
+     * Records the cursor established for range 'range'. Once every range has a response, passes
+     * the cursors into the 'AsyncResultsMerger', or on error kills the cursors established.
+     */
+    void _establishRangeCursorCallback(size_t range, const RemoteCommandCallbackArgs& rcbd);
+
+    /**
+     * Kills the cursor 'id' on the sync source without waiting for the response.
+     */
+    void _sendKillCursors(CursorId id, const NamespaceString& nss);
+
+    /**
+     * Creates the 'AsyncResultsMerger' over the established cursors and starts fetching documents.
+     */
+    void _startFetchingDocuments(std::vector<CursorResponse> cursorResponses);
+
+    /**
+     * Returns the index of the range, delimited by '_splitPoints', that the _id 'id' belongs to.
+     */
+    size_t _getRangeForId_inlock(const BSONElement& id) const;
+
     /**
      * Takes a cursors buffer and parses the 'find' response into cursor
      * responses that are pushed onto the buffer.
@@ -290,6 +340,19 @@ private:
     // (M) Scheduler used to establish the initial cursor or set of cursors.
     std::unique_ptr<RemoteCommandRetryScheduler> _establishCollectionCursorsScheduler;
 
+    // (M) Scheduler used to sample _id values to split a large collection into ranges.
+    std::unique_ptr<RemoteCommandRetryScheduler> _sampleIdsScheduler;
+
+    // (M) _id values, as {_id: <value>} in ascending order, delimiting the ranges the collection is
+    // cloned in, each over its own cursor. Empty if the collection is cloned over a single cursor.
+    std::vector<BSONObj> _splitPoints;
+
+    // (M) Schedulers used to establish one cursor per range, and the responses received so far.
+    std::vector<std::unique_ptr<RemoteCommandRetryScheduler>> _establishRangeCursorsSchedulers;
+    std::vector<boost::optional<CursorResponse>> _rangeCursorResponses;
+    size_t _numRangeCursorResponses = 0;
+    Status _establishRangeCursorsStatus = Status::OK();
+
     // (M) Scheduler used to determine if a cursor was closed because the collection was dropped.
     std::unique_ptr<RemoteCommandRetryScheduler> _verifyCollectionDroppedScheduler;
 
@@ -37,6 +37,7 @@
 #include "mongo/db/repl/collection_cloner.h"
 #include "mongo/db/repl/storage_interface.h"
 #include "mongo/db/repl/storage_interface_mock.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/unittest/task_executor_proxy.h"
 #include "mongo/unittest/unittest.h"
@@ -1299,6 +1300,105 @@ TEST_F(CollectionClonerTest,
     ASSERT_EQUALS(ErrorCodes::OperationFailed, getStatus());
 }
 
+class CollectionClonerRangesTest : public CollectionClonerTest {
+protected:
+    void setUp() override {
+        CollectionClonerTest::setUp();
+        _setParameter("initialSyncCollectionClonerRanges", "2");
+        _setParameter("initialSyncCollectionClonerMinDocumentsPerRange", "1");
+    }
+
+    void tearDown() override {
+        _setParameter("initialSyncCollectionClonerRanges", "1");
+        _setParameter("initialSyncCollectionClonerMinDocumentsPerRange", "100000");
+        CollectionClonerTest::tearDown();
+    }
+
+private:
+    void _setParameter(const std::string& name, const std::string& value) {
+        auto&& parameters = ServerParameterSet::getGlobal()->getMap();
+        auto parameter = parameters.find(name);
+        ASSERT(parameter != parameters.end());
+        ASSERT_OK(parameter->second->setFromString(value));
+    }
+};
+
+TEST_F(CollectionClonerRangesTest, CollectionIsClonedOverOneCursorPerIdRange) {
+    ASSERT_OK(collectionCloner->startup());
+    {
+        executor::NetworkInterfaceMock::InNetworkGuard guard(getNet());
+        processNetworkResponse(createCountResponse(4));
+        processNetworkResponse(createListIndexesResponse(0, BSON_ARRAY(idIndexSpec)));
+    }
+    collectionCloner->waitForDbWorker();
+    ASSERT_TRUE(collectionCloner->isActive());
+
+    BSONArray emptyArray;
+    {
+        executor::NetworkInterfaceMock::InNetworkGuard guard(getNet());
+
+        // The sampled _id values split the collection at {_id: 3}.
+        ASSERT_TRUE(getNet()->hasReadyRequests());
+        auto noi = getNet()->getNextReadyRequest();
+        ASSERT_EQUALS("aggregate"_sd, noi->getRequest().cmdObj.firstElementFieldName());
+        scheduleNetworkResponse(noi,
+                                createCursorResponse(0,
+                                                     BSON_ARRAY(BSON("_id" << 4)
+                                                                << BSON("_id" << 1)
+                                                                << BSON("_id" << 3)
+                                                                << BSON("_id" << 2))));
+        getNet()->runReadyNetworkOperations();
+
+        for (int i = 0; i < 2; ++i) {
+            ASSERT_TRUE(getNet()->hasReadyRequests());
+            noi = getNet()->getNextReadyRequest();
+            auto cmdObj = noi->getRequest().cmdObj;
+            ASSERT_EQUALS("find"_sd, cmdObj.firstElementFieldName());
+            ASSERT_BSONOBJ_EQ(BSON("_id" << 1), cmdObj["hint"].Obj());
+            if (cmdObj.hasField("max")) {
+                ASSERT_FALSE(cmdObj.hasField("min"));
+                ASSERT_BSONOBJ_EQ(BSON("_id" << 3), cmdObj["max"].Obj());
+                scheduleNetworkResponse(noi, createCursorResponse(1, emptyArray));
+            } else {
+                ASSERT_BSONOBJ_EQ(BSON("_id" << 3), cmdObj["min"].Obj());
+                scheduleNetworkResponse(noi, createCursorResponse(2, emptyArray));
+            }
+        }
+        getNet()->runReadyNetworkOperations();
+
+        for (int i = 0; i < 2; ++i) {
+            ASSERT_TRUE(getNet()->hasReadyRequests());
+            noi = getNet()->getNextReadyRequest();
+            auto cmdObj = noi->getRequest().cmdObj;
+            ASSERT_EQUALS("getMore"_sd, cmdObj.firstElementFieldName());
+            if (cmdObj["getMore"].numberLong() == 1) {
+                scheduleNetworkResponse(noi,
+                                        createFinalCursorResponse(
+                                            BSON_ARRAY(BSON("_id" << 1) << BSON("_id" << 2))));
+            } else {
+                scheduleNetworkResponse(noi,
+                                        createFinalCursorResponse(
+                                            BSON_ARRAY(BSON("_id" << 3) << BSON("_id" << 4))));
+            }
+        }
+        getNet()->runReadyNetworkOperations();
+    }
+
+    collectionCloner->join();
+    ASSERT_OK(getStatus());
+    ASSERT_EQUALS(4, collectionStats.insertCount);
+    ASSERT_TRUE(collectionStats.commitCalled);
+
+    auto stats = collectionCloner->getStats();
+    ASSERT_EQUALS(2U, stats.ranges.size());
+    ASSERT_BSONOBJ_EQ(BSON("_id" << MINKEY), stats.ranges[0].min);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 3), stats.ranges[0].max);
+    ASSERT_EQUALS(2U, stats.ranges[0].documentsCopied);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 3), stats.ranges[1].min);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << MAXKEY), stats.ranges[1].max);
+    ASSERT_EQUALS(2U, stats.ranges[1].documentsCopied);
+}
+
 class CollectionClonerUUIDTest : public CollectionClonerTest {
 protected:
     // The UUID tests should deal gracefully with renamed collections, so start the cloner with
@@ -60,6 +60,10 @@ MONGO_EXPORT_STARTUP_SERVER_PARAMETER(initialSyncOplogBuffer,
 // Set this to specify size of read ahead buffer in the OplogBufferCollection.
 MONGO_EXPORT_STARTUP_SERVER_PARAMETER(initialSyncOplogBufferPeekCacheSize, int, 10000);
 
+// Set this to specify how many consecutive oplog entries the OplogBufferCollection stores together
+// in one document.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(initialSyncOplogBufferMaxEntriesPerDocument, int, 100);
+
 MONGO_INITIALIZER(initialSyncOplogBuffer)(InitializerContext*) {
     if ((initialSyncOplogBuffer != kCollectionOplogBufferName) &&
         (initialSyncOplogBuffer != kBlockingQueueOplogBufferName)) {
@@ -134,8 +138,10 @@ std::unique_ptr<OplogBuffer> DataReplicatorExternalStateImpl::makeInitialSyncOpl
     OperationContext* opCtx) const {
     if (initialSyncOplogBuffer == kCollectionOplogBufferName) {
         invariant(initialSyncOplogBufferPeekCacheSize >= 0);
+        invariant(initialSyncOplogBufferMaxEntriesPerDocument >= 0);
         OplogBufferCollection::Options options;
         options.peekCacheSize = std::size_t(initialSyncOplogBufferPeekCacheSize);
+        options.maxEntriesPerDocument = std::size_t(initialSyncOplogBufferMaxEntriesPerDocument);
         return stdx::make_unique<OplogBufferProxy>(
             stdx::make_unique<OplogBufferCollection>(StorageInterface::get(opCtx), options));
     } else {
@@ -36,7 +36,6 @@
 #include <numeric>
 
 #include "mongo/base/string_data.h"
-#include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/bson/util/bson_extract.h"
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/repl/storage_interface.h"
@@ -54,6 +53,35 @@ const StringData kIdFieldName = "_id"_sd;
 const StringData kTimestampFieldName = "ts"_sd;
 const StringData kSentinelFieldName = "s"_sd;
 const StringData kIdIdxName = "_id_"_sd;
+const StringData kEntriesFieldName = "entries"_sd;
+
+// Upper bound on the total size of the entries stored together in one document. A larger entry is
+// still stored, on its own.
+const std::size_t kMaxBatchedEntriesBytes = 1024 * 1024;
+
+// Number of documents read at a time when counting the entries of an existing collection.
+const std::size_t kCountEntriesBatchSize = 1000;
+
+/**
+ * Returns the entries stored in 'doc', sharing its buffer. A document written as part of a batch
+ * holds its entries in the 'entries' array. Any other document holds a single entry, which is
+ * empty for a sentinel.
+ */
+std::vector<BSONObj> extractEntries(const BSONObj& doc) {
+    std::vector<BSONObj> entries;
+    auto entriesElem = doc[kEntriesFieldName];
+    if (entriesElem.eoo()) {
+        entries.push_back(OplogBufferCollection::extractEmbeddedOplogDocument(doc));
+    } else {
+        for (auto&& elem : entriesElem.Obj()) {
+            entries.push_back(elem.Obj());
+        }
+    }
+    for (auto&& entry : entries) {
+        entry.shareOwnershipWith(doc);
+    }
+    return entries;
+}
 
 }  // namespace
 
@@ -106,6 +134,7 @@ void OplogBufferCollection::startup(OperationContext* opCtx) {
         return;
     }
 
+    stdx::lock_guard<stdx::mutex> pushLk(_pushMutex);
     stdx::lock_guard<stdx::mutex> lk(_mutex);
     // If we are starting from an existing collection, we must populate the in memory state of the
     // buffer.
@@ -116,6 +145,9 @@ void OplogBufferCollection::startup(OperationContext* opCtx) {
     auto countResult = _storageInterface->getCollectionCount(opCtx, _nss);
     fassert(40404, countResult);
     _count = countResult.getValue();
+    if (_count > 0 && _options.maxEntriesPerDocument > 1) {
+        _count = _countEntries_inlock(opCtx);
+    }
 
     // We always start from the beginning, with _lastPoppedKey being empty. This is safe because
     // it is always safe to replay old oplog entries in order. We explicitly reset all fields
@@ -123,6 +155,7 @@ void OplogBufferCollection::startup(OperationContext* opCtx) {
     // have changed since the last time we used this OplogBufferCollection.
     _lastPoppedKey = {};
     _peekCache = std::queue<BSONObj>();
+    _peekCacheFrontEntries.clear();
 
     if (_count == 0) {
         _sentinelCount = 0;
@@ -148,6 +181,7 @@ void OplogBufferCollection::startup(OperationContext* opCtx) {
 
 void OplogBufferCollection::shutdown(OperationContext* opCtx) {
     if (_options.dropCollectionAtShutdown) {
+        stdx::lock_guard<stdx::mutex> pushLk(_pushMutex);
         stdx::lock_guard<stdx::mutex> lk(_mutex);
         _dropCollection(opCtx);
         _size = 0;
@@ -156,6 +190,7 @@ void OplogBufferCollection::shutdown(OperationContext* opCtx) {
         _lastPushedTimestamp = {};
         _lastPoppedKey = {};
         _peekCache = std::queue<BSONObj>();
+        _peekCacheFrontEntries.clear();
     }
 }
 
@@ -175,21 +210,63 @@ void OplogBufferCollection::pushAllNonBlocking(OperationContext* opCtx,
         return;
     }
     size_t numDocs = std::distance(begin, end);
-    std::vector<InsertStatement> docsToInsert(numDocs);
-    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    const std::size_t maxEntriesPerDocument =
+        std::max<std::size_t>(1U, _options.maxEntriesPerDocument);
+    std::vector<InsertStatement> docsToInsert;
+
+    // Pushes are serialized so that documents are inserted in _id order, but _mutex is not held
+    // while writing to the collection so that peeks and pops served from the peek cache do not wait
+    // for the write. The new documents are counted, and so become poppable, once they are written.
+    stdx::lock_guard<stdx::mutex> pushLk(_pushMutex);
     auto ts = _lastPushedTimestamp;
     auto sentinelCount = _sentinelCount;
-    std::transform(begin, end, docsToInsert.begin(), [&sentinelCount, &ts](const Value& value) {
-        BSONObj doc;
-        auto previousTimestamp = ts;
-        std::tie(doc, ts, sentinelCount) = addIdToDocument(value, ts, sentinelCount);
-        invariant(value.isEmpty() ? ts == previousTimestamp : ts > previousTimestamp);
-        return InsertStatement(doc);
-    });
+
+    // Consecutive entries are stored together, in documents whose _id has the timestamp of their
+    // last entry. Sentinels are always stored on their own.
+    std::vector<BSONObj> group;
+    std::size_t groupBytes = 0;
+    auto storeGroup = [&] {
+        if (group.size() == 1) {
+            docsToInsert.emplace_back(std::get<0>(addIdToDocument(group.front(), ts, 0)));
+        } else if (group.size() > 1) {
+            BSONObjBuilder bob;
+            bob.append(kIdFieldName, BSON(kTimestampFieldName << ts << kSentinelFieldName << 0));
+            BSONArrayBuilder entries(bob.subarrayStart(kEntriesFieldName));
+            for (auto&& entry : group) {
+                entries.append(entry);
+            }
+            entries.done();
+            docsToInsert.emplace_back(bob.obj());
+        }
+        group.clear();
+        groupBytes = 0;
+    };
+    for (auto it = begin; it != end; ++it) {
+        const auto previousTimestamp = ts;
+        if (it->isEmpty()) {
+            storeGroup();
+            BSONObj doc;
+            std::tie(doc, ts, sentinelCount) = addIdToDocument(*it, ts, sentinelCount);
+            invariant(ts == previousTimestamp);
+            docsToInsert.emplace_back(doc);
+            continue;
+        }
+        if (group.size() == maxEntriesPerDocument ||
+            (!group.empty() && groupBytes + it->objsize() > kMaxBatchedEntriesBytes)) {
+            storeGroup();
+        }
+        ts = (*it)[kTimestampFieldName].timestamp();
+        invariant(ts > previousTimestamp);
+        sentinelCount = 0;
+        group.push_back(*it);
+        groupBytes += it->objsize();
+    }
+    storeGroup();
 
     auto status = _storageInterface->insertDocuments(opCtx, _nss, docsToInsert);
     fassert(40161, status);
 
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
     _lastPushedTimestamp = ts;
     _sentinelCount = sentinelCount;
     _count += numDocs;
@@ -221,6 +298,7 @@ std::size_t OplogBufferCollection::getCount() const {
 }
 
 void OplogBufferCollection::clear(OperationContext* opCtx) {
+    stdx::lock_guard<stdx::mutex> pushLk(_pushMutex);
     stdx::lock_guard<stdx::mutex> lk(_mutex);
     _dropCollection(opCtx);
     _createCollection(opCtx);
@@ -230,6 +308,7 @@ void OplogBufferCollection::clear(OperationContext* opCtx) {
     _lastPushedTimestamp = {};
     _lastPoppedKey = {};
     _peekCache = std::queue<BSONObj>();
+    _peekCacheFrontEntries.clear();
 }
 
 bool OplogBufferCollection::tryPop(OperationContext* opCtx, Value* value) {
@@ -254,7 +333,7 @@ bool OplogBufferCollection::peek(OperationContext* opCtx, Value* value) {
     if (_count == 0) {
         return false;
     }
-    *value = _peek_inlock(opCtx, PeekMode::kExtractEmbeddedDocument);
+    *value = _peek_inlock(opCtx);
     return true;
 }
 
@@ -263,9 +342,7 @@ boost::optional<OplogBuffer::Value> OplogBufferCollection::lastObjectPushed(
     stdx::lock_guard<stdx::mutex> lk(_mutex);
     auto lastDocumentPushed = _lastDocumentPushed_inlock(opCtx);
     if (lastDocumentPushed) {
-        BSONObj entryObj = extractEmbeddedOplogDocument(*lastDocumentPushed);
-        entryObj.shareOwnershipWith(*lastDocumentPushed);
-        return entryObj;
+        return extractEntries(*lastDocumentPushed).back();
     }
     return boost::none;
 }
@@ -289,14 +366,15 @@ boost::optional<OplogBuffer::Value> OplogBufferCollection::_lastDocumentPushed_i
 }
 
 bool OplogBufferCollection::_pop_inlock(OperationContext* opCtx, Value* value) {
-    BSONObj docFromCollection =
-        _peek_inlock(opCtx, PeekMode::kReturnUnmodifiedDocumentFromCollection);
-    _lastPoppedKey = docFromCollection[kIdFieldName].wrap("");
-    *value = extractEmbeddedOplogDocument(docFromCollection).getOwned();
+    *value = _peek_inlock(opCtx);
+    _peekCacheFrontEntries.pop_front();
 
+    // Documents are only skipped by later reads once all of their entries are popped.
     invariant(!_peekCache.empty());
-    invariant(!SimpleBSONObjComparator::kInstance.compare(docFromCollection, _peekCache.front()));
-    _peekCache.pop();
+    if (_peekCacheFrontEntries.empty()) {
+        _lastPoppedKey = _peekCache.front()[kIdFieldName].wrap("");
+        _peekCache.pop();
+    }
 
     invariant(_count > 0);
     invariant(_size >= std::size_t(value->objsize()));
@@ -305,8 +383,11 @@ bool OplogBufferCollection::_pop_inlock(OperationContext* opCtx, Value* value) {
     return true;
 }
 
-BSONObj OplogBufferCollection::_peek_inlock(OperationContext* opCtx, PeekMode peekMode) {
+BSONObj OplogBufferCollection::_peek_inlock(OperationContext* opCtx) {
     invariant(_count > 0);
+    if (!_peekCacheFrontEntries.empty()) {
+        return _peekCacheFrontEntries.front();
+    }
 
     BSONObj startKey;
     auto boundInclusion = BoundInclusion::kIncludeStartKeyOnly;
@@ -323,6 +404,9 @@ BSONObj OplogBufferCollection::_peek_inlock(OperationContext* opCtx, PeekMode pe
     // when size of read ahead cache is greater than zero in the options.
     if (_peekCache.empty()) {
         std::size_t limit = isPeekCacheEnabled ? _options.peekCacheSize : 1U;
+        if (_options.maxEntriesPerDocument > 1) {
+            limit = std::max<std::size_t>(1U, limit / _options.maxEntriesPerDocument);
+        }
         const auto docs =
             fassert(40163,
                     _storageInterface->findDocuments(opCtx,
@@ -339,17 +423,37 @@ BSONObj OplogBufferCollection::_peek_inlock(OperationContext* opCtx, PeekMode pe
     }
     auto&& doc = _peekCache.front();
 
-    switch (peekMode) {
-        case PeekMode::kExtractEmbeddedDocument:
-            return extractEmbeddedOplogDocument(doc).getOwned();
-            break;
-        case PeekMode::kReturnUnmodifiedDocumentFromCollection:
-            invariant(doc.isOwned());
-            return doc;
-            break;
-    }
+    // Share the buffer of the cached document rather than copying the entries out of it.
+    invariant(doc.isOwned());
+    auto entries = extractEntries(doc);
+    _peekCacheFrontEntries.assign(entries.begin(), entries.end());
+    return _peekCacheFrontEntries.front();
+}
 
-    MONGO_UNREACHABLE;
+std::size_t OplogBufferCollection::_countEntries_inlock(OperationContext* opCtx) const {
+    std::size_t count = 0;
+    BSONObj startKey;
+    auto boundInclusion = BoundInclusion::kIncludeStartKeyOnly;
+    while (true) {
+        const auto docs =
+            fassert(50906,
+                    _storageInterface->findDocuments(opCtx,
+                                                     _nss,
+                                                     kIdIdxName,
+                                                     StorageInterface::ScanDirection::kForward,
+                                                     startKey,
+                                                     boundInclusion,
+                                                     kCountEntriesBatchSize));
+        for (const auto& doc : docs) {
+            auto entriesElem = doc[kEntriesFieldName];
+            count += entriesElem.eoo() ? 1U : std::size_t(entriesElem.Obj().nFields());
+        }
+        if (docs.size() < kCountEntriesBatchSize) {
+            return count;
+        }
+        startKey = docs.back()[kIdFieldName].wrap("");
+        boundInclusion = BoundInclusion::kIncludeEndKeyOnly;
+    }
 }
 
 void OplogBufferCollection::_createCollection(OperationContext* opCtx) {
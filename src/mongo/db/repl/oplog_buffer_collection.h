@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <deque>
 #include <queue>
 #include <tuple>
 
@@ -44,6 +45,13 @@ class StorageInterface;
 /**
  * Oplog buffer backed by a temporary collection. This collection is created in startup() and
  * removed in shutdown(). The documents will be popped and peeked in timestamp order.
+ *
+ * With Options::maxEntriesPerDocument greater than 1, consecutive entries of a push are stored
+ * together in documents of the form:
+ * {
+ *     _id: {ts: 'ts' field of the last entry, s: 0},
+ *     entries: [<entry>, ...]
+ * }
  */
 class OplogBufferCollection : public OplogBuffer {
 public:
@@ -53,6 +61,12 @@ public:
     struct Options {
         // If equal to 0, the cache size will be set to 1.
         std::size_t peekCacheSize = 0;
+        // Maximum number of consecutive entries of one push stored together in a single document.
+        // Values greater than 1 reduce the number of documents inserted and read per entry, and
+        // count the peek cache size in entries rather than documents. Documents of either format
+        // can always be read, but a collection written with batches must be started up again
+        // with a value greater than 1 to count its entries correctly.
+        std::size_t maxEntriesPerDocument = 1;
         bool dropCollectionAtStartup = true;
         bool dropCollectionAtShutdown = true;
         Options() {}
@@ -150,12 +164,16 @@ private:
      */
     void _dropCollection(OperationContext* opCtx);
 
-    enum class PeekMode { kExtractEmbeddedDocument, kReturnUnmodifiedDocumentFromCollection };
     /**
      * Returns the oldest oplog entry in the buffer.
      * Assumes the buffer is not empty.
      */
-    BSONObj _peek_inlock(OperationContext* opCtx, PeekMode peekMode);
+    BSONObj _peek_inlock(OperationContext* opCtx);
+
+    /**
+     * Returns the number of entries stored in the collection, reading every document.
+     */
+    std::size_t _countEntries_inlock(OperationContext* opCtx) const;
 
     // Storage interface used to perform storage engine level functions on the collection.
     StorageInterface* _storageInterface;
@@ -181,7 +199,12 @@ private:
     // _mutex below.
     stdx::condition_variable _cvNoLongerEmpty;
 
+    // Serializes pushes, and excludes them while the collection is created or dropped. Acquired
+    // before _mutex. Pushes write to the collection holding only this mutex.
+    stdx::mutex _pushMutex;
+
     // Protects member data below and synchronizes it with the underlying collection.
+    // '_sentinelCount' and '_lastPushedTimestamp' are only modified with _pushMutex held as well.
     mutable stdx::mutex _mutex;
 
     // Number of documents in buffer.
@@ -200,6 +223,10 @@ private:
     // Used by _peek_inlock() to hold results of the read ahead query that will be used for pop/peek
     // results.
     std::queue<BSONObj> _peekCache;
+
+    // The entries of the document at the front of '_peekCache' that have not been popped yet. The
+    // document is removed from '_peekCache' once all of them are popped.
+    std::deque<BSONObj> _peekCacheFrontEntries;
 };
 
 }  // namespace repl
@@ -45,6 +45,7 @@
 #include "mongo/unittest/barrier.h"
 #include "mongo/unittest/death_test.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/timer.h"
 
 namespace {
 
@@ -1650,4 +1651,166 @@ TEST_F(OplogBufferCollectionTest, PeekFillsCacheWithDocumentsFromCollection) {
     _assertDocumentsEqualCache({}, oplogBuffer.getPeekCache_forTest());
 }
 
+const int kNumBatches = 100;
+const int kBatchSize = 100;
+const int kNumDocs = kNumBatches * kBatchSize;
+
+/**
+ * Pushes 'kNumBatches' batches of 'kBatchSize' oplog entries from one thread while popping on this
+ * one, so that peek cache refills race with the inserts of the pushing thread. Checks that every
+ * entry is popped in order, and returns the number of documents the entries were stored in.
+ */
+std::size_t _pushAndPopConcurrently(OperationContext* opCtx,
+                                    StorageInterface* storageInterface,
+                                    const NamespaceString& nss,
+                                    const OplogBufferCollection::Options& opts) {
+    OplogBufferCollection oplogBuffer(storageInterface, nss, opts);
+    oplogBuffer.startup(opCtx);
+
+    Timer timer;
+    stdx::thread pushingThread([&]() {
+        Client::initThread("pushingThread");
+        auto pushingOpCtx = cc().makeOperationContext();
+        for (int batch = 0; batch < kNumBatches; batch++) {
+            OplogBuffer::Batch oplog;
+            for (int i = 1; i <= kBatchSize; i++) {
+                oplog.push_back(makeOplogEntry(batch * kBatchSize + i));
+            }
+            oplogBuffer.pushAllNonBlocking(pushingOpCtx.get(), oplog.cbegin(), oplog.cend());
+        }
+    });
+
+    int numPopped = 0;
+    while (numPopped < kNumDocs && oplogBuffer.waitForData(Seconds(30))) {
+        BSONObj doc;
+        while (oplogBuffer.tryPop(opCtx, &doc)) {
+            numPopped++;
+            ASSERT_BSONOBJ_EQ(makeOplogEntry(numPopped), doc);
+        }
+    }
+    pushingThread.join();
+    unittest::log() << "Pushed and popped " << kNumDocs << " oplog entries in batches of "
+                    << kBatchSize << " with up to " << opts.maxEntriesPerDocument
+                    << " entries per document in " << timer.millis() << "ms";
+
+    ASSERT_EQUALS(kNumDocs, numPopped);
+    ASSERT_TRUE(oplogBuffer.isEmpty());
+    ASSERT_EQUALS(0UL, oplogBuffer.getSize());
+    ASSERT_EQUALS(Timestamp(kNumDocs, kNumDocs), oplogBuffer.getLastPoppedTimestamp_forTest());
+
+    // Popped documents are not removed from the collection.
+    return unittest::assertGet(storageInterface->getCollectionCount(opCtx, nss));
+}
+
+TEST_F(OplogBufferCollectionTest, ConcurrentPushesAndPopsReturnDocumentsInOrder) {
+    OplogBufferCollection::Options opts;
+    opts.peekCacheSize = 1000U;
+    ASSERT_EQUALS(
+        std::size_t(kNumDocs),
+        _pushAndPopConcurrently(_opCtx.get(), _storageInterface, makeNamespace(_agent), opts));
+}
+
+TEST_F(OplogBufferCollectionTest, ConcurrentBatchedPushesAndPopsStoreOneDocumentPerBatch) {
+    OplogBufferCollection::Options opts;
+    opts.peekCacheSize = 1000U;
+    opts.maxEntriesPerDocument = kBatchSize;
+    ASSERT_EQUALS(
+        std::size_t(kNumBatches),
+        _pushAndPopConcurrently(_opCtx.get(), _storageInterface, makeNamespace(_agent), opts));
+}
+
+/**
+ * Returns the documents in the collection in _id order.
+ */
+std::vector<BSONObj> _findAllDocuments(OperationContext* opCtx,
+                                       StorageInterface* storageInterface,
+                                       const NamespaceString& nss) {
+    return unittest::assertGet(
+        storageInterface->findDocuments(opCtx,
+                                        nss,
+                                        "_id_"_sd,
+                                        StorageInterface::ScanDirection::kForward,
+                                        {},
+                                        BoundInclusion::kIncludeStartKeyOnly,
+                                        1000U));
+}
+
+TEST_F(OplogBufferCollectionTest, BatchedPushesStoreConsecutiveEntriesTogether) {
+    auto nss = makeNamespace(_agent);
+    OplogBufferCollection::Options opts;
+    opts.maxEntriesPerDocument = 2U;
+    OplogBufferCollection oplogBuffer(_storageInterface, nss, opts);
+    oplogBuffer.startup(_opCtx.get());
+
+    const std::vector<BSONObj> oplog = {
+        makeOplogEntry(1), makeOplogEntry(2), makeOplogEntry(3), makeOplogEntry(4),
+        makeOplogEntry(5), BSONObj(),         makeOplogEntry(6),
+    };
+    oplogBuffer.pushAllNonBlocking(_opCtx.get(), oplog.cbegin(), oplog.cbegin() + 5);
+    oplogBuffer.push(_opCtx.get(), oplog[5]);
+    oplogBuffer.push(_opCtx.get(), oplog[6]);
+    ASSERT_EQUALS(oplogBuffer.getCount(), 7UL);
+    ASSERT_EQUALS(0UL, oplogBuffer.getSentinelCount_forTest());
+    ASSERT_EQUALS(Timestamp(6, 6), oplogBuffer.getLastPushedTimestamp_forTest());
+    ASSERT_BSONOBJ_EQ(oplog[6], *oplogBuffer.lastObjectPushed(_opCtx.get()));
+
+    const std::vector<BSONObj> expectedDocs = {
+        BSON("_id" << BSON("ts" << Timestamp(2, 2) << "s" << 0) << "entries"
+                   << BSON_ARRAY(oplog[0] << oplog[1])),
+        BSON("_id" << BSON("ts" << Timestamp(4, 4) << "s" << 0) << "entries"
+                   << BSON_ARRAY(oplog[2] << oplog[3])),
+        BSON("_id" << BSON("ts" << Timestamp(5, 5) << "s" << 0) << "entry" << oplog[4]),
+        BSON("_id" << BSON("ts" << Timestamp(5, 5) << "s" << 1)),
+        BSON("_id" << BSON("ts" << Timestamp(6, 6) << "s" << 0) << "entry" << oplog[6]),
+    };
+    auto docs = _findAllDocuments(_opCtx.get(), _storageInterface, nss);
+    ASSERT_EQUALS(expectedDocs.size(), docs.size());
+    for (std::size_t i = 0; i < docs.size(); i++) {
+        ASSERT_BSONOBJ_EQ(expectedDocs[i], docs[i]);
+    }
+
+    for (const auto& entry : oplog) {
+        BSONObj doc;
+        ASSERT_TRUE(oplogBuffer.peek(_opCtx.get(), &doc));
+        ASSERT_BSONOBJ_EQ(entry, doc);
+        ASSERT_TRUE(oplogBuffer.tryPop(_opCtx.get(), &doc));
+        ASSERT_BSONOBJ_EQ(entry, doc);
+    }
+    ASSERT_TRUE(oplogBuffer.isEmpty());
+    ASSERT_EQUALS(0UL, oplogBuffer.getSize());
+    ASSERT_EQUALS(Timestamp(6, 6), oplogBuffer.getLastPoppedTimestamp_forTest());
+}
+
+TEST_F(OplogBufferCollectionTest, StartupWithExistingBatchedCollectionCountsEntries) {
+    auto nss = makeNamespace(_agent);
+    OplogBufferCollection::Options opts;
+    opts.maxEntriesPerDocument = 3U;
+    opts.dropCollectionAtShutdown = false;
+    std::vector<BSONObj> oplog;
+    for (int i = 0; i < 5; ++i) {
+        oplog.push_back(makeOplogEntry(i + 1));
+    }
+    {
+        OplogBufferCollection oplogBuffer(_storageInterface, nss, opts);
+        oplogBuffer.startup(_opCtx.get());
+        oplogBuffer.pushAllNonBlocking(_opCtx.get(), oplog.cbegin(), oplog.cend());
+        oplogBuffer.shutdown(_opCtx.get());
+    }
+    ASSERT_EQUALS(2UL, _findAllDocuments(_opCtx.get(), _storageInterface, nss).size());
+
+    opts.dropCollectionAtStartup = false;
+    OplogBufferCollection oplogBuffer(_storageInterface, nss, opts);
+    oplogBuffer.startup(_opCtx.get());
+    ASSERT_EQUALS(oplogBuffer.getCount(), 5UL);
+    ASSERT_EQUALS(Timestamp(5, 5), oplogBuffer.getLastPushedTimestamp_forTest());
+    ASSERT_BSONOBJ_EQ(oplog[4], *oplogBuffer.lastObjectPushed(_opCtx.get()));
+
+    for (const auto& entry : oplog) {
+        BSONObj doc;
+        ASSERT_TRUE(oplogBuffer.tryPop(_opCtx.get(), &doc));
+        ASSERT_BSONOBJ_EQ(entry, doc);
+    }
+    ASSERT_TRUE(oplogBuffer.isEmpty());
+}
+
 }  // namespace
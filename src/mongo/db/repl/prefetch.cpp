@@ -0,0 +1,139 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kReplication
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/prefetch.h"
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/catalog_raii.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/dbhelpers.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/repl/oplog_entry.h"
+#include "mongo/db/repl/replication_coordinator.h"
+#include "mongo/db/stats/timer_stats.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+// The number of and time spent in lookups of the documents and index entries touched by
+// operations ahead of their application.
+TimerStats prefetchDocStats;
+ServerStatusMetricField<TimerStats> displayPrefetchDocPages("repl.preload.docs", &prefetchDocStats);
+TimerStats prefetchIndexStats;
+ServerStatusMetricField<TimerStats> displayPrefetchIndexPages("repl.preload.indexes",
+                                                              &prefetchIndexStats);
+
+/**
+ * Pages in the entries for the keys generated from 'obj' in the _id index only, or in every index
+ * of the collection, including those still being built.
+ */
+void prefetchIndexPages(OperationContext* opCtx,
+                        Collection* collection,
+                        ReplSettings::IndexPrefetchConfig prefetchConfig,
+                        const BSONObj& obj) {
+    TimerHolder timer(&prefetchIndexStats);
+    auto indexCatalog = collection->getIndexCatalog();
+    if (prefetchConfig == ReplSettings::IndexPrefetchConfig::PREFETCH_ID_ONLY) {
+        if (auto desc = indexCatalog->findIdIndex(opCtx)) {
+            indexCatalog->getIndex(desc)->touch(opCtx, obj).transitional_ignore();
+        }
+        return;
+    }
+
+    auto ii = indexCatalog->getIndexIterator(opCtx, true);
+    while (ii.more()) {
+        auto desc = ii.next();
+        indexCatalog->getIndex(desc)->touch(opCtx, obj).transitional_ignore();
+    }
+}
+
+/**
+ * Pages in the document with _id 'id' through the _id index and returns it, or returns an empty
+ * object if there is no such document.
+ */
+BSONObj prefetchDocument(OperationContext* opCtx, Collection* collection, const BSONElement& id) {
+    TimerHolder timer(&prefetchDocStats);
+    auto recordId = Helpers::findById(opCtx, collection, id.wrap());
+    Snapshotted<BSONObj> doc;
+    if (recordId.isNull() || !collection->findDoc(opCtx, recordId, &doc)) {
+        return BSONObj();
+    }
+    return doc.value().getOwned();
+}
+
+}  // namespace
+
+void prefetchPagesForReplicatedOp(OperationContext* opCtx, const OplogEntry& oplogEntry) {
+    if (!oplogEntry.isCrudOpType()) {
+        return;
+    }
+
+    const auto prefetchConfig = ReplicationCoordinator::get(opCtx)->getIndexPrefetchConfig();
+    const auto& nss = oplogEntry.getNamespace();
+    try {
+        auto uuid = oplogEntry.getUuid();
+        AutoGetCollection autoColl(
+            opCtx,
+            uuid ? NamespaceStringOrUUID(nss.db().toString(), *uuid) : NamespaceStringOrUUID(nss),
+            MODE_IS);
+        auto collection = autoColl.getCollection();
+        if (!collection) {
+            return;
+        }
+
+        // An insert touches the index entries for the keys of the new document. Updates and deletes
+        // first look up the document they modify, whose index entries they change or remove.
+        BSONObj doc;
+        if (oplogEntry.getOpType() == OpTypeEnum::kInsert) {
+            doc = oplogEntry.getObject();
+        } else if (collection->getIndexCatalog()->findIdIndex(opCtx)) {
+            auto id = oplogEntry.getIdElement();
+            if (!id.eoo()) {
+                doc = prefetchDocument(opCtx, collection, id);
+            }
+        }
+
+        if (!doc.isEmpty() && prefetchConfig != ReplSettings::IndexPrefetchConfig::PREFETCH_NONE) {
+            prefetchIndexPages(opCtx, collection, prefetchConfig, doc);
+        }
+    } catch (const DBException& e) {
+        LOG(2) << "ignoring exception prefetching pages for " << redact(oplogEntry.toBSON())
+               << ": " << redact(e);
+    }
+}
+
+}  // namespace repl
+}  // namespace mongo
@@ -360,6 +360,10 @@ ReplicationCoordinatorImpl::ReplicationCoordinatorImpl(
 
     invariant(_service);
 
+    if (settings.isPrefetchIndexModeSet()) {
+        _indexPrefetchConfig = settings.getPrefetchIndexMode();
+    }
+
     if (!isReplEnabled()) {
         return;
     }
@@ -606,6 +606,34 @@ TEST_F(StorageInterfaceImplTest, CreateCollectionWithIDIndexCommits) {
     ASSERT_EQ(count, 2LL);
 }
 
+TEST_F(StorageInterfaceImplTest, CreateCollectionWithSecondaryIndexesCommitsBatches) {
+    auto opCtx = getOperationContext();
+    StorageInterfaceImpl storage;
+    auto nss = makeNamespace(_agent);
+    CollectionOptions opts = generateOptionsWithUuid();
+    std::vector<BSONObj> indexes = {BSON("v" << 1 << "key" << BSON("x" << 1) << "name"
+                                             << "x_1"
+                                             << "ns"
+                                             << nss.ns())};
+    auto loader = unittest::assertGet(
+        storage.createCollectionForBulkLoading(nss, opts, makeIdIndexSpec(nss), indexes));
+    std::vector<BSONObj> firstBatch = {BSON("_id" << 3 << "x" << 1), BSON("_id" << 1 << "x" << 2)};
+    std::vector<BSONObj> secondBatch = {BSON("_id" << 2 << "x" << BSON_ARRAY(3 << 4)),
+                                        BSON("_id" << 4)};
+    ASSERT_OK(loader->insertDocuments(firstBatch.begin(), firstBatch.end()));
+    ASSERT_OK(loader->insertDocuments(secondBatch.begin(), secondBatch.end()));
+    ASSERT_OK(loader->commit());
+
+    AutoGetCollectionForReadCommand autoColl(opCtx, nss);
+    auto coll = autoColl.getCollection();
+    ASSERT(coll);
+    ASSERT_EQ(coll->getRecordStore()->numRecords(opCtx), 4LL);
+    auto collIdxCat = coll->getIndexCatalog();
+    ASSERT_EQ(getIndexKeyCount(opCtx, collIdxCat, collIdxCat->findIdIndex(opCtx)), 4LL);
+    ASSERT_EQ(getIndexKeyCount(opCtx, collIdxCat, collIdxCat->findIndexByName(opCtx, "x_1")),
+              5LL);
+}
+
 void _testDestroyUncommitedCollectionBulkLoader(
     OperationContext* opCtx,
     const NamespaceString& nss,
@@ -33,12 +33,14 @@
 #include "mongo/db/repl/sync_tail.h"
 
 #include "third_party/murmurhash3/MurmurHash3.h"
+#include <algorithm>
 #include <boost/functional/hash.hpp>
 #include <memory>
 
 #include "mongo/base/counter.h"
 #include "mongo/bson/bsonelement_comparator.h"
 #include "mongo/bson/timestamp.h"
+#include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_holder.h"
@@ -62,21 +64,25 @@
 #include "mongo/db/repl/initial_syncer.h"
 #include "mongo/db/repl/multiapplier.h"
 #include "mongo/db/repl/oplogreader.h"
+#include "mongo/db/repl/prefetch.h"
 #include "mongo/db/repl/repl_client_info.h"
 #include "mongo/db/repl/repl_set_config.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/repl/session_update_tracker.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/session.h"
 #include "mongo/db/session_txn_record_gen.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/unordered_map.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/net/socket_exception.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -101,6 +107,81 @@ ServerStatusMetricField<Counter64> displayAttemptsToBecomeSecondary(
 TimerStats applyBatchStats;
 ServerStatusMetricField<TimerStats> displayOpBatchesApplied("repl.apply.batches", &applyBatchStats);
 
+// Time spent in each stage of batch application: writing the oplog entries of a batch, splitting
+// it into dependency chains, and applying those chains on the writer threads.
+TimerStats oplogWriteStageStats;
+ServerStatusMetricField<TimerStats> displayOplogWriteStage("repl.apply.stages.oplogWrite",
+                                                           &oplogWriteStageStats);
+TimerStats partitionStageStats;
+ServerStatusMetricField<TimerStats> displayPartitionStage("repl.apply.stages.partition",
+                                                          &partitionStageStats);
+TimerStats applyStageStats;
+ServerStatusMetricField<TimerStats> displayApplyStage("repl.apply.stages.apply", &applyStageStats);
+
+// Number of batches whose oplog entries were written while the previous batch was being applied.
+Counter64 pipelinedBatchesStats;
+ServerStatusMetricField<Counter64> displayPipelinedBatches("repl.apply.pipelinedBatches",
+                                                           &pipelinedBatchesStats);
+
+// When enabled, steady state replication writes the oplog entries of the next batch and splits it
+// into dependency chains while the current batch is being applied.
+MONGO_EXPORT_SERVER_PARAMETER(replPipelinedBatchApplication, bool, false);
+
+// The number of threads paging in the documents and index entries that a batch will touch, while
+// the previous batch is being applied. Zero disables prefetching.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(replPrefetcherThreadCount, int, 0)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 256) {
+            return Status(ErrorCodes::BadValue,
+                          "replPrefetcherThreadCount must be between 0 and 256");
+        }
+
+        return Status::OK();
+    });
+
+/**
+ * Reports, for each writer, the total time it has spent applying operations and the total time it
+ * has spent idle waiting for the other writers to finish their share of a batch. A large idle time
+ * on most writers means batches are bound by a few long dependency chains.
+ */
+class WriterUtilizationMetric : public ServerStatusMetric {
+public:
+    WriterUtilizationMetric() : ServerStatusMetric("repl.apply.writers") {}
+
+    /**
+     * Records one batch. 'busyMicros' holds the time each writer spent applying operations, and
+     * 'batchMicros' the time from dispatching the batch until the last writer finished.
+     */
+    void record(const std::vector<long long>& busyMicros, long long batchMicros) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_writers.size() < busyMicros.size()) {
+            _writers.resize(busyMicros.size());
+        }
+        for (size_t i = 0; i < busyMicros.size(); i++) {
+            _writers[i].busyMicros += busyMicros[i];
+            _writers[i].idleMicros += std::max(0LL, batchMicros - busyMicros[i]);
+        }
+    }
+
+    void appendAtLeaf(BSONObjBuilder& b) const override {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        BSONArrayBuilder writers(b.subarrayStart(_leafName));
+        for (auto&& writer : _writers) {
+            writers.append(
+                BSON("busyMicros" << writer.busyMicros << "idleMicros" << writer.idleMicros));
+        }
+    }
+
+private:
+    struct WriterTimes {
+        long long busyMicros = 0;
+        long long idleMicros = 0;
+    };
+
+    mutable stdx::mutex _mutex;
+    std::vector<WriterTimes> _writers;
+} writerUtilizationMetric;
+
 class ApplyBatchFinalizer {
 public:
     ApplyBatchFinalizer(ReplicationCoordinator* replCoord) : _replCoord(replCoord) {}
@@ -348,31 +429,89 @@ const OplogApplier::Options& SyncTail::getOptions() const {
 
 namespace {
 
-// Doles out all the work to the writer pool threads.
-// Does not modify writerVectors, but passes non-const pointers to inner vectors into func.
-void applyOps(std::vector<MultiApplier::OperationPtrs>& writerVectors,
+// Operations of a batch that must be applied in order relative to each other, keyed by the hash
+// of what they depend on: the document they write or, when documents of a collection cannot be
+// written concurrently, the collection. Operations in different chains are independent.
+using OperationChains = stdx::unordered_map<uint32_t, MultiApplier::OperationPtrs>;
+
+// Each writer takes roughly this many tasks' worth of operations from a batch, so that a writer
+// finishing early finds more chains to take over while the others are still busy.
+const size_t kTasksPerWriter = 4;
+
+// Doles out all the work to the writer pool threads. Every writer repeatedly claims whole chains,
+// largest first, until it has at least 'opsPerTask' operations and applies them with a single call
+// to func, so a long chain occupies one writer while the others drain the remaining chains.
+// Does not modify chains, and each writer passes func its own vector of operation pointers.
+void applyOps(const std::vector<MultiApplier::OperationPtrs>& chains,
+              size_t opsPerTask,
               ThreadPool* writerPool,
               const SyncTail::MultiSyncApplyFunc& func,
               SyncTail* st,
+              AtomicUInt64* nextChain,
               std::vector<Status>* statusVector,
-              std::vector<WorkerMultikeyPathInfo>* workerMultikeyPathInfo) {
-    invariant(writerVectors.size() == statusVector->size());
-    for (size_t i = 0; i < writerVectors.size(); i++) {
-        if (!writerVectors[i].empty()) {
-            invariant(writerPool->schedule([
-                &func,
-                st,
-                &writer = writerVectors.at(i),
-                &status = statusVector->at(i),
-                &workerMultikeyPathInfo = workerMultikeyPathInfo->at(i)
-            ] {
+              std::vector<WorkerMultikeyPathInfo>* workerMultikeyPathInfo,
+              std::vector<long long>* busyMicros) {
+    invariant(statusVector->size() == workerMultikeyPathInfo->size());
+    invariant(statusVector->size() == busyMicros->size());
+    for (size_t i = 0; i < statusVector->size() && i < chains.size(); i++) {
+        invariant(writerPool->schedule([
+            &func,
+            st,
+            &chains,
+            opsPerTask,
+            nextChain,
+            &status = statusVector->at(i),
+            &workerMultikeyPathInfo = workerMultikeyPathInfo->at(i),
+            &busyMicros = busyMicros->at(i)
+        ] {
+            Timer timer;
+            MultiApplier::OperationPtrs ops;
+            while (status.isOK()) {
+                ops.clear();
+                while (ops.size() < opsPerTask) {
+                    const auto chain = nextChain->fetchAndAdd(1);
+                    if (chain >= chains.size()) {
+                        break;
+                    }
+                    ops.insert(ops.end(), chains[chain].begin(), chains[chain].end());
+                }
+                if (ops.empty()) {
+                    break;
+                }
+
                 auto opCtx = cc().makeOperationContext();
-                status = func(opCtx.get(), &writer, st, &workerMultikeyPathInfo);
-            }));
-        }
+                WorkerMultikeyPathInfo newPaths;
+                status = func(opCtx.get(), &ops, st, &newPaths);
+                workerMultikeyPathInfo.insert(
+                    workerMultikeyPathInfo.end(), newPaths.begin(), newPaths.end());
+            }
+            busyMicros = timer.micros();
+        }));
     }
 }
 
+// Writes the oplog entries for 'ops' in the range [begin, end) to the oplog.
+void writeOplogEntries(OperationContext* opCtx,
+                       StorageInterface* storageInterface,
+                       const MultiApplier::Operations& ops,
+                       size_t begin,
+                       size_t end) {
+    UnreplicatedWritesBlock uwb(opCtx);
+    ShouldNotConflictWithSecondaryBatchApplicationBlock shouldNotConflictBlock(opCtx->lockState());
+
+    std::vector<InsertStatement> docs;
+    docs.reserve(end - begin);
+    for (size_t i = begin; i < end; i++) {
+        // Add as unowned BSON to avoid unnecessary ref-count bumps.
+        // 'ops' will outlive 'docs' so the BSON lifetime will be guaranteed.
+        docs.emplace_back(InsertStatement{
+            ops[i].raw, ops[i].getOpTime().getTimestamp(), ops[i].getOpTime().getTerm()});
+    }
+
+    fassert(40141,
+            storageInterface->insertDocuments(opCtx, NamespaceString::kRsOplogNamespace, docs));
+}
+
 // Schedules the writes to the oplog for 'ops' into threadPool. The caller must guarantee that 'ops'
 // stays valid until all scheduled work in the thread pool completes.
 void scheduleWritesToOplog(OperationContext* opCtx,
@@ -386,22 +525,7 @@ void scheduleWritesToOplog(OperationContext* opCtx,
         // guarantees that 'ops' will stay in scope until the spawned threads complete.
         return [storageInterface, &ops, begin, end] {
             auto opCtx = cc().makeOperationContext();
-            UnreplicatedWritesBlock uwb(opCtx.get());
-            ShouldNotConflictWithSecondaryBatchApplicationBlock shouldNotConflictBlock(
-                opCtx->lockState());
-
-            std::vector<InsertStatement> docs;
-            docs.reserve(end - begin);
-            for (size_t i = begin; i < end; i++) {
-                // Add as unowned BSON to avoid unnecessary ref-count bumps.
-                // 'ops' will outlive 'docs' so the BSON lifetime will be guaranteed.
-                docs.emplace_back(InsertStatement{
-                    ops[i].raw, ops[i].getOpTime().getTimestamp(), ops[i].getOpTime().getTerm()});
-            }
-
-            fassert(40141,
-                    storageInterface->insertDocuments(
-                        opCtx.get(), NamespaceString::kRsOplogNamespace, docs));
+            writeOplogEntries(opCtx.get(), storageInterface, ops, begin, end);
         };
     };
 
@@ -482,21 +606,20 @@ private:
 /**
  * ops - This only modifies the isForCappedCollection field on each op. It does not alter the ops
  *      vector in any other way.
- * writerVectors - Set of operations for each worker thread to apply.
+ * chains - Operations grouped by what they depend on, each group in the order it must be applied.
  * derivedOps - If provided, this function inserts a decomposition of applyOps operations
  *      and instructions for updating the transactions table.
  * sessionUpdateTracker - if provided, keeps track of session info from ops.
  */
-void fillWriterVectors(OperationContext* opCtx,
-                       MultiApplier::Operations* ops,
-                       std::vector<MultiApplier::OperationPtrs>* writerVectors,
-                       std::vector<MultiApplier::Operations>* derivedOps,
-                       SessionUpdateTracker* sessionUpdateTracker) {
+void fillOperationChains(OperationContext* opCtx,
+                         MultiApplier::Operations* ops,
+                         OperationChains* chains,
+                         std::vector<MultiApplier::Operations>* derivedOps,
+                         SessionUpdateTracker* sessionUpdateTracker) {
     const auto serviceContext = opCtx->getServiceContext();
     const auto storageEngine = serviceContext->getStorageEngine();
 
     const bool supportsDocLocking = storageEngine->supportsDocLocking();
-    const uint32_t numWriters = writerVectors->size();
 
     CachedCollectionProperties collPropertiesCache;
 
@@ -509,7 +632,7 @@ void fillWriterVectors(OperationContext* opCtx,
         if (sessionUpdateTracker) {
             if (auto newOplogWrites = sessionUpdateTracker->updateOrFlush(op)) {
                 derivedOps->emplace_back(std::move(*newOplogWrites));
-                fillWriterVectors(opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr);
+                fillOperationChains(opCtx, &derivedOps->back(), chains, derivedOps, nullptr);
             }
         }
 
@@ -545,8 +668,8 @@ void fillWriterVectors(OperationContext* opCtx,
             }
             try {
                 derivedOps->emplace_back(ApplyOps::extractOperations(op));
-                fillWriterVectors(
-                    opCtx, &derivedOps->back(), writerVectors, derivedOps, sessionUpdateTracker);
+                fillOperationChains(
+                    opCtx, &derivedOps->back(), chains, derivedOps, sessionUpdateTracker);
             } catch (...) {
                 fassertFailedWithStatusNoTrace(
                     50711,
@@ -557,31 +680,77 @@ void fillWriterVectors(OperationContext* opCtx,
             continue;
         }
 
-        auto& writer = (*writerVectors)[hash % numWriters];
-        if (writer.empty()) {
-            writer.reserve(8);  // Skip a few growth rounds
-        }
-        writer.push_back(&op);
+        (*chains)[hash].push_back(&op);
     }
 }
 
-void fillWriterVectors(OperationContext* opCtx,
-                       MultiApplier::Operations* ops,
-                       std::vector<MultiApplier::OperationPtrs>* writerVectors,
-                       std::vector<MultiApplier::Operations>* derivedOps) {
+void fillOperationChains(OperationContext* opCtx,
+                         MultiApplier::Operations* ops,
+                         OperationChains* chains,
+                         std::vector<MultiApplier::Operations>* derivedOps) {
     SessionUpdateTracker sessionUpdateTracker;
-    fillWriterVectors(opCtx, ops, writerVectors, derivedOps, &sessionUpdateTracker);
+    fillOperationChains(opCtx, ops, chains, derivedOps, &sessionUpdateTracker);
 
     auto newOplogWrites = sessionUpdateTracker.flushAll();
     if (!newOplogWrites.empty()) {
         derivedOps->emplace_back(std::move(newOplogWrites));
-        fillWriterVectors(opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr);
+        fillOperationChains(opCtx, &derivedOps->back(), chains, derivedOps, nullptr);
     }
 }
 
 }  // namespace
 
 namespace {
+/**
+ * Returns the pool of threads prefetching the pages batches will touch, or nullptr if prefetching
+ * is disabled.
+ */
+std::unique_ptr<ThreadPool> makePrefetcherPool() {
+    if (replPrefetcherThreadCount <= 0) {
+        return nullptr;
+    }
+
+    ThreadPool::Options options;
+    options.threadNamePrefix = "repl prefetch worker ";
+    options.poolName = "repl prefetch worker Pool";
+    options.maxThreads = options.minThreads = static_cast<size_t>(replPrefetcherThreadCount);
+    options.onCreateThread = [](const std::string&) {
+        Client::initThreadIfNotAlready();
+        AuthorizationSession::get(cc())->grantInternalAuthorization();
+    };
+    auto pool = stdx::make_unique<ThreadPool>(options);
+    pool->startup();
+    return pool;
+}
+
+/**
+ * Pages in the documents and index entries that 'ops' will touch, with every thread of
+ * 'prefetcherPool' claiming operations in turn, and waits for them to be done.
+ */
+void prefetchOps(const std::vector<OplogEntry>& ops, ThreadPool* prefetcherPool) {
+    AtomicUInt64 nextOp;
+    auto prefetch = [&] {
+        auto opCtx = cc().makeOperationContext();
+
+        // The previous batch is applying under the parallel batch writer lock, which must not hold
+        // up prefetching for the next one.
+        ShouldNotConflictWithSecondaryBatchApplicationBlock shouldNotConflictBlock(
+            opCtx->lockState());
+        for (auto i = nextOp.fetchAndAdd(1); i < ops.size(); i = nextOp.fetchAndAdd(1)) {
+            prefetchPagesForReplicatedOp(opCtx.get(), ops[i]);
+
+            // Don't pin a snapshot across operations while the previous batch is being written.
+            opCtx->recoveryUnit()->abandonSnapshot();
+        }
+    };
+    for (int i = 0; i < replPrefetcherThreadCount; ++i) {
+        if (!prefetcherPool->schedule(prefetch).isOK()) {
+            break;
+        }
+    }
+    prefetcherPool->waitForIdle();
+}
+
 void tryToGoLiveAsASecondary(OperationContext* opCtx,
                              ReplicationCoordinator* replCoord,
                              OpTime minValid) {
@@ -630,6 +799,30 @@ void tryToGoLiveAsASecondary(OperationContext* opCtx,
 }
 }
 
+struct SyncTail::PreparedBatch {
+    explicit PreparedBatch(MultiApplier::Operations batchOps) : ops(std::move(batchOps)) {}
+
+    MultiApplier::Operations ops;
+
+    // Holds 'pseudo operations' generated by secondaries to aid in replication.
+    // Keep in scope until all operations in 'ops' and 'derivedOps' have been applied.
+    // Pseudo operations include:
+    // - applyOps operations expanded to individual ops.
+    // - ops to update config.transactions. Normal writes to config.transactions in the
+    //   primary don't create an oplog entry, so extract info from writes with transactions
+    //   and create a pseudo oplog.
+    std::vector<MultiApplier::Operations> derivedOps;
+
+    // The operations in 'ops' and 'derivedOps' split into dependency chains, longest first.
+    std::vector<MultiApplier::OperationPtrs> chains;
+
+    // Minimum number of operations each writer applies per call to the apply function.
+    size_t opsPerTask = 1;
+
+    // Set once the oplog entries have been written and the chains computed.
+    bool prepared = false;
+};
+
 class SyncTail::OpQueueBatcher {
     MONGO_DISALLOW_COPYING(OpQueueBatcher);
 
@@ -639,6 +832,7 @@ public:
           _storageInterface(storageInterface),
           _oplogBuffer(oplogBuffer),
           _ops(0),
+          _prefetcherPool(makePrefetcherPool()),
           _thread([this] { run(); }) {}
     ~OpQueueBatcher() {
         invariant(_isDead);
@@ -660,6 +854,23 @@ public:
         return ops;
     }
 
+    /**
+     * Returns the next batch if one is ready, without waiting for it. Never returns the empty batch
+     * signaling shutdown, which is left for getNextBatch().
+     */
+    boost::optional<OpQueue> tryGetNextBatch() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_ops.empty()) {
+            return boost::none;
+        }
+
+        OpQueue ops = std::move(_ops);
+        _ops = OpQueue(0);
+        _cv.notify_all();
+
+        return std::move(ops);
+    }
+
 private:
     /**
      * If slaveDelay is enabled, this function calculates the most recent timestamp of any oplog
@@ -702,6 +913,12 @@ private:
                 continue;  // Don't emit empty batches.
             }
 
+            // Page in what this batch will touch while the previous one is being applied, so that
+            // the writers don't stall on cache misses one operation at a time.
+            if (_prefetcherPool && !ops.empty()) {
+                prefetchOps(ops.getBatch(), _prefetcherPool.get());
+            }
+
             stdx::unique_lock<stdx::mutex> lk(_mutex);
             // Block until the previous batch has been taken.
             _cv.wait(lk, [&] { return _ops.empty(); });
@@ -722,6 +939,10 @@ private:
     stdx::condition_variable _cv;
     OpQueue _ops;
 
+    // Pages in the documents and index entries each batch will touch. Null if prefetching is
+    // disabled.
+    std::unique_ptr<ThreadPool> _prefetcherPool;
+
     // This only exists so the destructor invariants rather than deadlocking.
     // TODO remove once we trust noexcept enough to mark oplogApplication() as noexcept.
     bool _isDead = false;
@@ -747,6 +968,13 @@ void SyncTail::_oplogApplication(OplogBuffer* oplogBuffer,
             ? new ApplyBatchFinalizerForJournal(replCoord)
             : new ApplyBatchFinalizer(replCoord)};
 
+    // Prepares batches ahead of their application when batches are pipelined.
+    auto preparerPool = OplogApplier::makeWriterPool(1);
+
+    // When batches are pipelined, the batch following the one just applied. It was prepared while
+    // that batch was being applied.
+    std::unique_ptr<PreparedBatch> nextBatch;
+
     // Get replication consistency markers.
     OpTime minValid;
 
@@ -777,26 +1005,30 @@ void SyncTail::_oplogApplication(OplogBuffer* oplogBuffer,
         // Transition to SECONDARY state, if possible.
         tryToGoLiveAsASecondary(&opCtx, replCoord, minValid);
 
-        long long termWhenBufferIsEmpty = replCoord->getTerm();
-        // Blocks up to a second waiting for a batch to be ready to apply. If one doesn't become
-        // ready in time, we'll loop again so we can do the above checks periodically.
-        OpQueue ops = batcher->getNextBatch(Seconds(1));
-        if (ops.empty()) {
-            if (ops.mustShutdown()) {
-                // Shut down and exit oplog application loop.
-                return;
-            }
-            if (MONGO_FAIL_POINT(rsSyncApplyStop)) {
-                continue;
+        std::unique_ptr<PreparedBatch> batch = std::move(nextBatch);
+        if (!batch) {
+            long long termWhenBufferIsEmpty = replCoord->getTerm();
+            // Blocks up to a second waiting for a batch to be ready to apply. If one doesn't become
+            // ready in time, we'll loop again so we can do the above checks periodically.
+            OpQueue ops = batcher->getNextBatch(Seconds(1));
+            if (ops.empty()) {
+                if (ops.mustShutdown()) {
+                    // Shut down and exit oplog application loop.
+                    return;
+                }
+                if (MONGO_FAIL_POINT(rsSyncApplyStop)) {
+                    continue;
+                }
+                // Signal drain complete if we're in Draining state and the buffer is empty.
+                replCoord->signalDrainComplete(&opCtx, termWhenBufferIsEmpty);
+                continue;  // Try again.
             }
-            // Signal drain complete if we're in Draining state and the buffer is empty.
-            replCoord->signalDrainComplete(&opCtx, termWhenBufferIsEmpty);
-            continue;  // Try again.
+            batch = stdx::make_unique<PreparedBatch>(ops.releaseBatch());
         }
 
-        // Extract some info from ops that we'll need after releasing the batch below.
-        const auto firstOpTimeInBatch = ops.front().getOpTime();
-        const auto lastOpTimeInBatch = ops.back().getOpTime();
+        // Extract some info from ops that we'll need after applying the batch below.
+        const auto firstOpTimeInBatch = batch->ops.front().getOpTime();
+        const auto lastOpTimeInBatch = batch->ops.back().getOpTime();
         const auto lastAppliedOpTimeAtStartOfBatch = replCoord->getMyLastAppliedOpTime();
 
         // Make sure the oplog doesn't go back in time or repeat an entry.
@@ -813,10 +1045,56 @@ void SyncTail::_oplogApplication(OplogBuffer* oplogBuffer,
         // Don't allow the fsync+lock thread to see intermediate states of batch application.
         stdx::lock_guard<SimpleMutex> fsynclk(filesLockedFsync);
 
-        // Apply the operations in this batch. 'multiApply' returns the optime of the last op that
+        // While this batch is being applied, write the oplog entries of the next batch and split
+        // it into dependency chains. That batch is not partitioned until this one is applied if
+        // this one may change the collections it writes to, since partitioning depends on whether
+        // a collection is capped and on its collation.
+        auto prepareNextBatch = [&] {
+            if (!replPipelinedBatchApplication.load() || _options.skipWritesToOplog ||
+                !std::all_of(batch->ops.cbegin(),
+                             batch->ops.cend(),
+                             [](const OplogEntry& op) { return op.isCrudOpType(); })) {
+                return;
+            }
+
+            auto ops = batcher->tryGetNextBatch();
+            if (!ops) {
+                return;
+            }
+
+            // Make sure the oplog doesn't go back in time or repeat an entry before writing it.
+            if (ops->front().getOpTime() <= lastOpTimeInBatch) {
+                fassert(50907,
+                        Status(ErrorCodes::OplogOutOfOrder,
+                               str::stream() << "Attempted to apply an oplog entry ("
+                                             << ops->front().getOpTime().toString()
+                                             << ") which is not greater than the last OpTime in "
+                                                "the batch being applied ("
+                                             << lastOpTimeInBatch.toString()
+                                             << ")."));
+            }
+
+            nextBatch = stdx::make_unique<PreparedBatch>(ops->releaseBatch());
+            invariant(preparerPool->schedule([ this, batchToPrepare = nextBatch.get() ] {
+                auto prepareOpCtx = cc().makeOperationContext();
+
+                // This batch is applying under the parallel batch writer lock, which the writes
+                // made while preparing the next one must not wait for.
+                ShouldNotConflictWithSecondaryBatchApplicationBlock shouldNotConflictBlock(
+                    prepareOpCtx->lockState());
+                _prepareBatch(prepareOpCtx.get(), batchToPrepare, nullptr);
+                pipelinedBatchesStats.increment();
+            }));
+        };
+
+        // Apply the operations in this batch. '_applyBatch' returns the optime of the last op that
         // was applied, which should be the last optime in the batch.
-        auto lastOpTimeAppliedInBatch =
-            fassertNoTrace(34437, multiApply(&opCtx, ops.releaseBatch()));
+        auto applyResult = _applyBatch(&opCtx, batch.get(), prepareNextBatch);
+
+        // The next batch must be fully prepared before the fsync+lock thread may run.
+        preparerPool->waitForIdle();
+
+        auto lastOpTimeAppliedInBatch = fassertNoTrace(34437, applyResult);
         invariant(lastOpTimeAppliedInBatch == lastOpTimeInBatch);
 
         // In order to provide resilience in the event of a crash in the middle of batch
@@ -1211,7 +1489,71 @@ Status multiSyncApply(OperationContext* opCtx,
     return Status::OK();
 }
 
+void SyncTail::_prepareBatch(OperationContext* opCtx,
+                             PreparedBatch* batch,
+                             ThreadPool* oplogWriterPool) {
+    invariant(!batch->prepared);
+    const auto& ops = batch->ops;
+
+    // Write batch of ops into oplog.
+    Timer oplogWriteTimer;
+    if (!_options.skipWritesToOplog) {
+        _consistencyMarkers->setOplogTruncateAfterPoint(opCtx, ops.front().getTimestamp());
+        if (oplogWriterPool) {
+            scheduleWritesToOplog(opCtx, _storageInterface, oplogWriterPool, ops);
+        } else {
+            writeOplogEntries(opCtx, _storageInterface, ops, 0, ops.size());
+        }
+    }
+
+    {
+        TimerHolder timer(&partitionStageStats);
+
+        OperationChains chainsByKey;
+        fillOperationChains(opCtx, &batch->ops, &chainsByKey, &batch->derivedOps);
+
+        // Start the longest chains first, so that they are not left to run on their own at the
+        // end of the batch while the other writers sit idle.
+        batch->chains.reserve(chainsByKey.size());
+        size_t numOps = 0;
+        for (auto&& chain : chainsByKey) {
+            numOps += chain.second.size();
+            batch->chains.push_back(std::move(chain.second));
+        }
+        std::stable_sort(batch->chains.begin(),
+                         batch->chains.end(),
+                         [](const MultiApplier::OperationPtrs& lhs,
+                            const MultiApplier::OperationPtrs& rhs) {
+                             return lhs.size() > rhs.size();
+                         });
+        const size_t numWriters = _writerPool->getStats().numThreads;
+        batch->opsPerTask = std::max(size_t(1), numOps / (numWriters * kTasksPerWriter));
+    }
+
+    if (!_options.skipWritesToOplog) {
+        // Wait for writes to finish before applying ops.
+        if (oplogWriterPool) {
+            oplogWriterPool->waitForIdle();
+        }
+        oplogWriteStageStats.record(oplogWriteTimer);
+
+        // Reset consistency markers in case the node fails while applying ops.
+        _consistencyMarkers->setOplogTruncateAfterPoint(opCtx, Timestamp());
+        _consistencyMarkers->setMinValidToAtLeast(opCtx, ops.back().getOpTime());
+    }
+
+    batch->prepared = true;
+}
+
 StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::Operations ops) {
+    PreparedBatch batch(std::move(ops));
+    return _applyBatch(opCtx, &batch, {});
+}
+
+StatusWith<OpTime> SyncTail::_applyBatch(OperationContext* opCtx,
+                                         PreparedBatch* batch,
+                                         const stdx::function<void()>& whileApplying) {
+    const auto& ops = batch->ops;
     invariant(!ops.empty());
 
     LOG(2) << "replication batch size is " << ops.size();
@@ -1226,7 +1568,8 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
                 "attempting to replicate ops while primary"};
     }
 
-    std::vector<WorkerMultikeyPathInfo> multikeyVector(_writerPool->getStats().numThreads);
+    const size_t numWriters = _writerPool->getStats().numThreads;
+    std::vector<WorkerMultikeyPathInfo> multikeyVector(numWriters);
     {
         // Each node records cumulative batch application stats for itself using this timer.
         TimerHolder timer(&applyBatchStats);
@@ -1235,37 +1578,31 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
         // because the spawned threads refer to objects on the stack
         ON_BLOCK_EXIT([&] { _writerPool->waitForIdle(); });
 
-        // Write batch of ops into oplog.
-        if (!_options.skipWritesToOplog) {
-            _consistencyMarkers->setOplogTruncateAfterPoint(opCtx, ops.front().getTimestamp());
-            scheduleWritesToOplog(opCtx, _storageInterface, _writerPool, ops);
+        if (!batch->prepared) {
+            _prepareBatch(opCtx, batch, _writerPool);
         }
 
-        // Holds 'pseudo operations' generated by secondaries to aid in replication.
-        // Keep in scope until all operations in 'ops' and 'derivedOps' have been applied.
-        // Pseudo operations include:
-        // - applyOps operations expanded to individual ops.
-        // - ops to update config.transactions. Normal writes to config.transactions in the
-        //   primary don't create an oplog entry, so extract info from writes with transactions
-        //   and create a pseudo oplog.
-        std::vector<MultiApplier::Operations> derivedOps;
-
-        std::vector<MultiApplier::OperationPtrs> writerVectors(_writerPool->getStats().numThreads);
-        fillWriterVectors(opCtx, &ops, &writerVectors, &derivedOps);
-
-        // Wait for writes to finish before applying ops.
-        _writerPool->waitForIdle();
-
-        // Reset consistency markers in case the node fails while applying ops.
-        if (!_options.skipWritesToOplog) {
-            _consistencyMarkers->setOplogTruncateAfterPoint(opCtx, Timestamp());
-            _consistencyMarkers->setMinValidToAtLeast(opCtx, ops.back().getOpTime());
+        if (whileApplying) {
+            whileApplying();
         }
 
         {
-            std::vector<Status> statusVector(_writerPool->getStats().numThreads, Status::OK());
-            applyOps(writerVectors, _writerPool, _applyFunc, this, &statusVector, &multikeyVector);
+            TimerHolder applyStageTimer(&applyStageStats);
+            std::vector<Status> statusVector(numWriters, Status::OK());
+            std::vector<long long> busyMicros(numWriters, 0);
+            AtomicUInt64 nextChain;
+            Timer applyTimer;
+            applyOps(batch->chains,
+                     batch->opsPerTask,
+                     _writerPool,
+                     _applyFunc,
+                     this,
+                     &nextChain,
+                     &statusVector,
+                     &multikeyVector,
+                     &busyMicros);
             _writerPool->waitForIdle();
+            writerUtilizationMetric.record(busyMicros, applyTimer.micros());
 
             // If any of the statuses is not ok, return error.
             for (auto it = statusVector.cbegin(); it != statusVector.cend(); ++it) {
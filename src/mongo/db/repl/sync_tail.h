@@ -248,6 +248,27 @@ private:
                            ReplicationCoordinator* replCoord,
                            OpQueueBatcher* batcher) noexcept;
 
+    /**
+     * A batch of operations, and once it has been prepared, the dependency chains it is applied in.
+     */
+    struct PreparedBatch;
+
+    /**
+     * Writes the oplog entries of 'batch' to the local oplog, advancing 'minValid' past them, and
+     * splits the batch into dependency chains. Uses 'oplogWriterPool' to write the oplog entries
+     * if one is given, otherwise writes them on the calling thread.
+     */
+    void _prepareBatch(OperationContext* opCtx, PreparedBatch* batch, ThreadPool* oplogWriterPool);
+
+    /**
+     * Implements multiApply(), preparing 'batch' first unless that has already been done.
+     * 'whileApplying', if set, is called once the oplog entries of 'batch' have been written and
+     * just before its operations are handed to the writer threads.
+     */
+    StatusWith<OpTime> _applyBatch(OperationContext* opCtx,
+                                   PreparedBatch* batch,
+                                   const stdx::function<void()>& whileApplying);
+
     OplogApplier::Observer* const _observer;
     ReplicationConsistencyMarkers* const _consistencyMarkers;
     StorageInterface* const _storageInterface;
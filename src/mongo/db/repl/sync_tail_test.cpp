@@ -518,6 +518,70 @@ TEST_F(SyncTailTest, MultiApplyAssignsOperationsToWriterThreadsBasedOnNamespaceH
     ASSERT_EQUALS(op2, lastEntry);
 }
 
+TEST_F(SyncTailTest, MultiApplyKeepsOperationsOnTheSameDocumentTogetherAndInOrder) {
+    NamespaceString hotNss("test.hot");
+    NamespaceString coldNss("test.cold");
+    auto writerPool = OplogApplier::makeWriterPool(4);
+
+    stdx::mutex mutex;
+    std::vector<MultiApplier::Operations> operationsApplied;
+    auto applyOperationFn =
+        [&mutex, &operationsApplied](OperationContext* opCtx,
+                                     MultiApplier::OperationPtrs* operationsForWriterThreadToApply,
+                                     SyncTail* st,
+                                     WorkerMultikeyPathInfo*) -> Status {
+        stdx::lock_guard<stdx::mutex> lock(mutex);
+        operationsApplied.emplace_back();
+        for (auto&& opPtr : *operationsForWriterThreadToApply) {
+            operationsApplied.back().push_back(*opPtr);
+        }
+        return Status::OK();
+    };
+
+    // Interleave a long chain of writes to a single document with writes to distinct documents.
+    const int kOpsPerNamespace = 20;
+    MultiApplier::Operations ops;
+    std::vector<OplogEntry> hotOps;
+    for (int i = 0; i < kOpsPerNamespace; i++) {
+        hotOps.push_back(makeInsertDocumentOplogEntry(
+            {Timestamp(Seconds(2 * i + 1), 0), 1LL}, hotNss, BSON("_id" << 0 << "x" << i)));
+        ops.push_back(hotOps.back());
+        ops.push_back(makeInsertDocumentOplogEntry(
+            {Timestamp(Seconds(2 * i + 2), 0), 1LL}, coldNss, BSON("_id" << i << "x" << i)));
+    }
+
+    SyncTail syncTail(nullptr,
+                      getConsistencyMarkers(),
+                      getStorageInterface(),
+                      applyOperationFn,
+                      writerPool.get());
+    auto lastOpTime = unittest::assertGet(syncTail.multiApply(_opCtx.get(), ops));
+    ASSERT_EQUALS(ops.back().getOpTime(), lastOpTime);
+
+    // The writes to the hot document must all be handed to one writer, in oplog order, and must
+    // not hold back the writes to the other collection.
+    stdx::lock_guard<stdx::mutex> lock(mutex);
+    ASSERT_GREATER_THAN(operationsApplied.size(), 1U);
+    size_t numApplied = 0;
+    size_t numCallsWithHotOps = 0;
+    for (auto&& operationsAppliedByThread : operationsApplied) {
+        numApplied += operationsAppliedByThread.size();
+
+        std::vector<OplogEntry> hotOpsApplied;
+        for (auto&& oplogEntry : operationsAppliedByThread) {
+            if (oplogEntry.getNamespace() == hotNss) {
+                hotOpsApplied.push_back(oplogEntry);
+            }
+        }
+        if (!hotOpsApplied.empty()) {
+            numCallsWithHotOps++;
+            ASSERT(hotOps == hotOpsApplied);
+        }
+    }
+    ASSERT_EQUALS(1U, numCallsWithHotOps);
+    ASSERT_EQUALS(ops.size(), numApplied);
+}
+
 TEST_F(SyncTailTest, MultiSyncApplyUsesSyncApplyToApplyOperation) {
     NamespaceString nss("local." + _agent.getSuiteName() + "_" + _agent.getTestName());
     auto op = makeCreateCollectionOplogEntry({Timestamp(Seconds(1), 0), 1LL}, nss);
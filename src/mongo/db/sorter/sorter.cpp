@@ -48,7 +48,6 @@
 #include "mongo/db/sorter/sorter.h"
 
 #include <boost/filesystem/operations.hpp>
-#include <snappy.h>
 #include <vector>
 
 #include "mongo/base/string_data.h"
@@ -59,8 +58,12 @@
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/s/is_mongos.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/stdx/future.h"
+#include "mongo/stdx/memory.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/bufreader.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/destructor_guard.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/unowned_ptr.h"
@@ -79,6 +82,33 @@ inline std::string myErrnoWithDescription() {
     return sb.str();
 }
 
+// Parallel sorts don't hand chunks smaller than this to a helper thread.
+const size_t kMinElementsPerSortThread = 16 * 1024;
+
+// Number of blocks adaptive compression tries to compress before deciding whether it pays off.
+const int kAdaptiveCompressionSampleBlocks = 4;
+
+// Prefix-compressed keys store lengths below this value in a single byte. Longer ones are stored
+// as this value followed by the length as a little-endian 32-bit integer.
+const unsigned char kLongKeyLength = 0xFF;
+
+inline void appendKeyLength(BufBuilder* buffer, size_t length) {
+    if (length < kLongKeyLength) {
+        buffer->appendUChar(length);
+        return;
+    }
+    buffer->appendUChar(kLongKeyLength);
+    buffer->appendNum(static_cast<unsigned>(length));
+}
+
+inline size_t readKeyLength(BufReader* reader) {
+    const auto length = reader->read<unsigned char>();
+    if (length < kLongKeyLength) {
+        return length;
+    }
+    return reader->read<LittleEndian<uint32_t>>();
+}
+
 template <typename Data, typename Comparator>
 void dassertCompIsSane(const Comparator& comp, const Data& lhs, const Data& rhs) {
 #if defined(MONGO_CONFIG_DEBUG_BUILD) && !defined(_MSC_VER)
@@ -102,6 +132,137 @@ void dassertCompIsSane(const Comparator& comp, const Data& lhs, const Data& rhs)
 #endif
 }
 
+/**
+ * Runs a function on a ThreadPool, or on the first thread to wait for its result if no pool thread
+ * has started it by then. Waiting therefore never depends on a free pool thread, so tasks on a
+ * bounded pool may wait for other tasks on the same pool, as a background spill does when it
+ * sorts its run in parallel.
+ *
+ * Destroying a task that has not started cancels it; one that has started is waited for.
+ */
+template <typename T>
+class PoolTask {
+    MONGO_DISALLOW_COPYING(PoolTask);
+
+public:
+    /**
+     * Schedules 'fn' on 'pool'. If 'pool' is null or cannot take the task, get() runs it.
+     */
+    PoolTask(ThreadPool* pool, stdx::function<T()> fn)
+        : _state(std::make_shared<State>(std::move(fn))), _result(_state->task.get_future()) {
+        if (pool) {
+            auto state = _state;
+            pool->schedule([state] { state->runOnce(); }).ignore();
+        }
+    }
+
+    ~PoolTask() {
+        if (_state->claimed.swap(true) && _result.valid()) {
+            _result.wait();
+        }
+    }
+
+    /**
+     * Returns the result, running the function on this thread if no pool thread has started it.
+     * May only be called once.
+     */
+    T get() {
+        _state->runOnce();
+        return _result.get();
+    }
+
+private:
+    struct State {
+        explicit State(stdx::function<T()> fn) : task(std::move(fn)) {}
+
+        void runOnce() {
+            if (!claimed.swap(true)) {
+                task();
+            }
+        }
+
+        stdx::packaged_task<T()> task;
+        AtomicWord<bool> claimed{false};
+    };
+
+    std::shared_ptr<State> _state;
+    stdx::future<T> _result;
+};
+
+/**
+ * Stable-sorts [begin, end) using up to 'numThreads' threads from 'pool' and the calling thread.
+ * The range is split into equally sized chunks which are sorted concurrently and then merged
+ * pairwise, also concurrently, until a single sorted range remains. Falls back to
+ * std::stable_sort for small inputs or without a pool.
+ */
+template <typename RandomIt, typename LessThan>
+void parallelStableSort(
+    RandomIt begin, RandomIt end, const LessThan& less, size_t numThreads, ThreadPool* pool) {
+    const size_t size = std::distance(begin, end);
+    numThreads = std::min(numThreads, size / kMinElementsPerSortThread);
+    if (numThreads <= 1 || !pool) {
+        std::stable_sort(begin, end, less);
+        return;
+    }
+
+    std::vector<RandomIt> bounds;
+    for (size_t i = 0; i <= numThreads; i++) {
+        bounds.push_back(begin + (size * i / numThreads));
+    }
+
+    // The tasks are declared after 'bounds' so that if anything throws, their destructors cancel
+    // or wait for outstanding ones before 'bounds' dies.
+    {
+        std::vector<std::unique_ptr<PoolTask<void>>> tasks;
+        for (size_t i = 0; i < numThreads; i++) {
+            tasks.push_back(stdx::make_unique<PoolTask<void>>(pool, [&bounds, &less, i] {
+                std::stable_sort(bounds[i], bounds[i + 1], less);
+            }));
+        }
+        for (auto&& task : tasks) {
+            task->get();
+        }
+    }
+
+    // Merging adjacent chunks keeps equal elements in input order, preserving stability.
+    while (bounds.size() > 2) {
+        std::vector<RandomIt> merged;
+        std::vector<std::unique_ptr<PoolTask<void>>> tasks;
+        for (size_t i = 0; i + 2 < bounds.size(); i += 2) {
+            merged.push_back(bounds[i]);
+            tasks.push_back(stdx::make_unique<PoolTask<void>>(pool, [&bounds, &less, i] {
+                std::inplace_merge(bounds[i], bounds[i + 1], bounds[i + 2], less);
+            }));
+        }
+        if (bounds.size() % 2 == 0) {
+            // An odd number of chunks leaves the last one unpaired for this round.
+            merged.push_back(bounds[bounds.size() - 2]);
+        }
+        merged.push_back(bounds.back());
+
+        for (auto&& task : tasks) {
+            task->get();
+        }
+        bounds.swap(merged);
+    }
+}
+
+/**
+ * Returns a pool of up to 'numThreads' threads for one sort. Its runs are sorted and spilled, and
+ * its spilled files read their next block ahead of the merge, on this pool. Threads are only
+ * started while tasks are outstanding.
+ */
+inline std::shared_ptr<ThreadPool> makeThreadPool(size_t numThreads) {
+    ThreadPool::Options options;
+    options.poolName = "Sorter";
+    options.threadNamePrefix = "Sorter-";
+    options.minThreads = 0;
+    options.maxThreads = numThreads;
+    auto pool = std::make_shared<ThreadPool>(options);
+    pool->startup();
+    return pool;
+}
+
 /** Ensures a named file is deleted when this object goes out of scope */
 class FileDeleter {
 public:
@@ -143,7 +304,13 @@ private:
     std::deque<Data> _data;
 };
 
-/** Returns results in order from a single file */
+/**
+ * Returns results in order from a single file.
+ *
+ * Compressed blocks are decoded with 'codec'. With 'readAheadPool' set, the next block is read,
+ * decrypted and decompressed as a task on that pool while the current one is being consumed. If
+ * 'prefixCompressedKeys' is set, keys were written as described by SortOptions::prefixCompressKeys.
+ */
 template <typename Key, typename Value>
 class FileIterator : public SortIteratorInterface<Key, Value> {
 public:
@@ -154,8 +321,14 @@ public:
 
     FileIterator(const std::string& fileName,
                  const Settings& settings,
-                 std::shared_ptr<FileDeleter> fileDeleter)
+                 std::shared_ptr<FileDeleter> fileDeleter,
+                 const SpillCodec* codec,
+                 std::shared_ptr<ThreadPool> readAheadPool = nullptr,
+                 bool prefixCompressedKeys = false)
         : _settings(settings),
+          _codec(codec),
+          _readAheadPool(std::move(readAheadPool)),
+          _prefixCompressedKeys(prefixCompressedKeys),
           _done(false),
           _fileName(fileName),
           _fileDeleter(fileDeleter),
@@ -181,12 +354,36 @@ public:
         fillIfNeeded();
 
         // Note: key must be read before value so can't pass directly to Data constructor
-        auto first = Key::deserializeForSorter(*_reader, _settings.first);
+        auto first = _prefixCompressedKeys ? readPrefixCompressedKey()
+                                           : Key::deserializeForSorter(*_reader, _settings.first);
         auto second = Value::deserializeForSorter(*_reader, _settings.second);
         return Data(std::move(first), std::move(second));
     }
 
 private:
+    /** A decoded block of serialized data. A null 'data' means the end of the file was reached. */
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+    };
+
+    /**
+     * Rebuilds the next key from the prefix it shares with the previous key of its block. The
+     * returned key may refer to '_key', so it is only valid until the next call.
+     */
+    Key readPrefixCompressedKey() {
+        const size_t sharedSize = readKeyLength(_reader.get());
+        const size_t suffixSize = readKeyLength(_reader.get());
+        massert(50905,
+                str::stream() << "corrupt prefix-compressed key in file \"" << _fileName << "\"",
+                sharedSize <= _key.size());
+
+        _key.resize(sharedSize);
+        _key.append(static_cast<const char*>(_reader->skip(suffixSize)), suffixSize);
+        BufReader keyReader(_key.data(), _key.size());
+        return Key::deserializeForSorter(keyReader, _settings.first);
+    }
+
     void fillIfNeeded() {
         verify(!_done);
 
@@ -195,25 +392,44 @@ private:
     }
 
     void fill() {
-        int32_t rawSize;
-        read(&rawSize, sizeof(rawSize));
-        if (_done)
+        Block block = _nextBlock ? _nextBlock->get() : readBlock();
+        _nextBlock.reset();
+        if (!block.data) {
+            _done = true;
             return;
+        }
+
+        _buffer.swap(block.data);
+        _reader.reset(new BufReader(_buffer.get(), block.size));
+        _key.clear();  // Every block starts with a key which shares no prefix.
+
+        if (_readAheadPool) {
+            // Only one read is ever outstanding, so _file is never accessed concurrently.
+            _nextBlock = stdx::make_unique<PoolTask<Block>>(_readAheadPool.get(),
+                                                            [this] { return readBlock(); });
+        }
+    }
+
+    Block readBlock() {
+        Block block;
+
+        int32_t rawSize;
+        if (!read(&rawSize, sizeof(rawSize)))
+            return block;
 
         // negative size means compressed
         const bool compressed = rawSize < 0;
         int32_t blockSize = std::abs(rawSize);
 
-        _buffer.reset(new char[blockSize]);
-        read(_buffer.get(), blockSize);
-        massert(16816, "file too short?", !_done);
+        std::unique_ptr<char[]> buffer(new char[blockSize]);
+        massert(16816, "file too short?", read(buffer.get(), blockSize));
 
         auto encryptionHooks = EncryptionHooks::get(getGlobalServiceContext());
         if (encryptionHooks->enabled()) {
             std::unique_ptr<char[]> out(new char[blockSize]);
             size_t outLen;
             Status status =
-                encryptionHooks->unprotectTmpData(reinterpret_cast<uint8_t*>(_buffer.get()),
+                encryptionHooks->unprotectTmpData(reinterpret_cast<uint8_t*>(buffer.get()),
                                                   blockSize,
                                                   reinterpret_cast<uint8_t*>(out.get()),
                                                   blockSize,
@@ -222,57 +438,57 @@ private:
                     str::stream() << "Failed to unprotect data: " << status.toString(),
                     status.isOK());
             blockSize = outLen;
-            _buffer.swap(out);
+            buffer.swap(out);
         }
 
         if (!compressed) {
-            _reader.reset(new BufReader(_buffer.get(), blockSize));
-            return;
+            block.data.swap(buffer);
+            block.size = blockSize;
+            return block;
         }
 
-        dassert(snappy::IsValidCompressedBuffer(_buffer.get(), blockSize));
-
-        size_t uncompressedSize;
-        massert(17061,
-                "couldn't get uncompressed length",
-                snappy::GetUncompressedLength(_buffer.get(), blockSize, &uncompressedSize));
-
-        std::unique_ptr<char[]> decompressionBuffer(new char[uncompressedSize]);
-        massert(17062,
-                "decompression failed",
-                snappy::RawUncompress(_buffer.get(), blockSize, decompressionBuffer.get()));
-
-        // hold on to decompressed data and throw out compressed data at block exit
-        _buffer.swap(decompressionBuffer);
-        _reader.reset(new BufReader(_buffer.get(), uncompressedSize));
+        massert(50903, "compressed block in a file written without compression", _codec);
+        block.data = _codec->uncompress(buffer.get(), blockSize, &block.size);
+        return block;
     }
 
-    // sets _done to true on EOF - asserts on any other error
-    void read(void* out, size_t size) {
+    // returns false on EOF - asserts on any other error
+    bool read(void* out, size_t size) {
         _file.read(reinterpret_cast<char*>(out), size);
         if (!_file.good()) {
-            if (_file.eof()) {
-                _done = true;
-                return;
-            }
+            if (_file.eof())
+                return false;
 
             msgasserted(16817,
                         str::stream() << "error reading file \"" << _fileName << "\": "
                                       << myErrnoWithDescription());
         }
         verify(_file.gcount() == static_cast<std::streamsize>(size));
+        return true;
     }
 
     const Settings _settings;
+    const SpillCodec* const _codec;
+    const std::shared_ptr<ThreadPool> _readAheadPool;
+    const bool _prefixCompressedKeys;
     bool _done;
     std::unique_ptr<char[]> _buffer;
     std::unique_ptr<BufReader> _reader;
+    std::string _key;  // The last prefix-compressed key read.
     std::string _fileName;
     std::shared_ptr<FileDeleter> _fileDeleter;  // Must outlive _file
     std::ifstream _file;
+    std::unique_ptr<PoolTask<Block>> _nextBlock;  // Finished before _file is destroyed
 };
 
-/** Merge-sorts results from 0 or more FileIterators */
+/**
+ * Merge-sorts results from 0 or more FileIterators.
+ *
+ * The merge is driven by a loser tree: every internal node of a complete binary tree over the
+ * input streams remembers the stream that lost the match played there, and slot 0 holds the
+ * overall winner. Once the winner has been consumed only the matches on the path from its leaf to
+ * the root are replayed, which costs ceil(log2(k)) comparisons per result for k inputs.
+ */
 template <typename Key, typename Value, typename Comparator>
 class MergeIterator : public SortIteratorInterface<Key, Value> {
 public:
@@ -286,32 +502,30 @@ public:
         : _opts(opts),
           _remaining(opts.limit ? opts.limit : std::numeric_limits<unsigned long long>::max()),
           _first(true),
-          _greater(comp) {
+          _comp(comp) {
         for (size_t i = 0; i < iters.size(); i++) {
             if (iters[i]->more()) {
-                _heap.push_back(std::make_shared<Stream>(i, iters[i]->next(), iters[i]));
+                _streams.emplace_back(i, iters[i]->next(), iters[i]);
             }
         }
 
-        if (_heap.empty()) {
+        if (_streams.empty()) {
             _remaining = 0;
             return;
         }
 
-        std::make_heap(_heap.begin(), _heap.end(), _greater);
-        std::pop_heap(_heap.begin(), _heap.end(), _greater);
-        _current = _heap.back();
-        _heap.pop_back();
+        _numActive = _streams.size();
+        buildTree();
     }
 
     bool more() {
-        if (_remaining > 0 && (_first || !_heap.empty() || _current->more()))
+        if (_remaining > 0 && (_first || _numActive > 1 || _streams[_tree[0]].more()))
             return true;
 
         // We are done so clean up resources.
         // Can't do this in next() due to lifetime guarantees of unowned Data.
-        _heap.clear();
-        _current.reset();
+        _streams.clear();
+        _tree.clear();
         _remaining = 0;
 
         return false;
@@ -324,22 +538,17 @@ public:
 
         if (_first) {
             _first = false;
-            return _current->current();
+            return _streams[_tree[0]].current();
         }
 
-        if (!_current->advance()) {
-            verify(!_heap.empty());
-
-            std::pop_heap(_heap.begin(), _heap.end(), _greater);
-            _current = _heap.back();
-            _heap.pop_back();
-        } else if (!_heap.empty() && _greater(_current, _heap.front())) {
-            std::pop_heap(_heap.begin(), _heap.end(), _greater);
-            std::swap(_current, _heap.back());
-            std::push_heap(_heap.begin(), _heap.end(), _greater);
+        const size_t winner = _tree[0];
+        if (!_streams[winner].advance()) {
+            verify(_numActive > 1);
+            _numActive--;
         }
+        replay(winner);
 
-        return _current->current();
+        return _streams[_tree[0]].current();
     }
 
 
@@ -356,46 +565,97 @@ private:
             return _rest->more();
         }
         bool advance() {
-            if (!_rest->more())
+            if (!_rest->more()) {
+                _exhausted = true;
                 return false;
+            }
 
             _current = _rest->next();
             return true;
         }
+        bool exhausted() const {
+            return _exhausted;
+        }
 
         const size_t fileNum;
 
     private:
         Data _current;
         std::shared_ptr<Input> _rest;
+        bool _exhausted = false;
     };
 
-    class STLComparator {  // uses greater rather than less-than to maintain a MinHeap
-    public:
-        explicit STLComparator(const Comparator& comp) : _comp(comp) {}
-        bool operator()(unowned_ptr<const Stream> lhs, unowned_ptr<const Stream> rhs) const {
-            // first compare data
-            dassertCompIsSane(_comp, lhs->current(), rhs->current());
-            int ret = _comp(lhs->current(), rhs->current());
-            if (ret)
-                return ret > 0;
+    /**
+     * Returns true if the stream at index 'lhs' must be output before the one at 'rhs'. Exhausted
+     * streams lose every match they play.
+     */
+    bool beats(size_t lhs, size_t rhs) const {
+        const Stream& left = _streams[lhs];
+        const Stream& right = _streams[rhs];
+        if (left.exhausted())
+            return false;
+        if (right.exhausted())
+            return true;
+
+        // first compare data
+        dassertCompIsSane(_comp, left.current(), right.current());
+        int ret = _comp(left.current(), right.current());
+        if (ret)
+            return ret < 0;
+
+        // then compare fileNums to ensure stability
+        return left.fileNum < right.fileNum;
+    }
 
-            // then compare fileNums to ensure stability
-            return lhs->fileNum > rhs->fileNum;
+    /**
+     * Plays the initial tournament. Node n has children 2n and 2n+1, and the leaf for stream i is
+     * node k+i, so internal nodes are 1 through k-1 for any number k of streams.
+     */
+    void buildTree() {
+        const size_t k = _streams.size();
+        _tree.assign(k, 0);
+
+        std::vector<size_t> winners(2 * k);
+        for (size_t i = 0; i < k; i++) {
+            winners[k + i] = i;
         }
+        for (size_t node = k - 1; node >= 1; node--) {
+            const size_t left = winners[2 * node];
+            const size_t right = winners[2 * node + 1];
+            const bool leftWins = beats(left, right);
+            winners[node] = leftWins ? left : right;
+            _tree[node] = leftWins ? right : left;
+        }
+        _tree[0] = (k == 1) ? 0 : winners[1];
+    }
 
-    private:
-        const Comparator _comp;
-    };
+    /** Replays the matches from the leaf of 'stream' to the root after it has been advanced. */
+    void replay(size_t stream) {
+        size_t winner = stream;
+        for (size_t node = (_streams.size() + stream) / 2; node >= 1; node /= 2) {
+            if (beats(_tree[node], winner)) {
+                std::swap(_tree[node], winner);
+            }
+        }
+        _tree[0] = winner;
+    }
 
     SortOptions _opts;
     unsigned long long _remaining;
     bool _first;
-    std::shared_ptr<Stream> _current;
-    std::vector<std::shared_ptr<Stream>> _heap;  // MinHeap
-    STLComparator _greater;                      // named so calls make sense
+    size_t _numActive = 0;  // Streams that still have a current value.
+    std::vector<Stream> _streams;
+    std::vector<size_t> _tree;  // Slot 0 is the winner, the rest are the losers of each node.
+    const Comparator _comp;
 };
 
+/**
+ * Sorts an unbounded amount of data, spilling sorted runs to disk when the memory limit is hit.
+ *
+ * When SortOptions::parallelSortThreads is greater than one, each run is sorted with that many
+ * threads. If external sorting is allowed, runs are also spilled on the sort's thread pool while
+ * the next one accumulates; to stay within the memory limit, each run then only gets half of it.
+ */
 template <typename Key, typename Value, typename Comparator>
 class NoLimitSorter : public Sorter<Key, Value> {
 public:
@@ -418,23 +678,24 @@ public:
         _memUsed += key.memUsageForSorter();
         _memUsed += val.memUsageForSorter();
 
-        if (_memUsed > _opts.maxMemoryUsageBytes)
+        if (_memUsed > maxRunMemoryUsageBytes())
             spill();
     }
 
     Iterator* done() {
-        if (_iters.empty()) {
-            sort();
+        if (_iters.empty() && !_pendingSpill) {
+            sort(&_data);
             return new InMemIterator<Key, Value>(_data);
         }
 
         spill();
+        waitForPendingSpill();
         return Iterator::merge(_iters, _opts, _comp);
     }
 
     // TEMP these are here for compatibility. Will be replaced with a general stats API
     int numFiles() const {
-        return _iters.size();
+        return _iters.size() + (_pendingSpill ? 1 : 0);
     }
     size_t memUsed() const {
         return _memUsed;
@@ -453,15 +714,36 @@ private:
         const Comparator& _comp;
     };
 
-    void sort() {
+    bool spillInBackground() const {
+        return _opts.extSortAllowed && _opts.parallelSortThreads > 1;
+    }
+
+    size_t maxRunMemoryUsageBytes() const {
+        return spillInBackground() ? _opts.maxMemoryUsageBytes / 2 : _opts.maxMemoryUsageBytes;
+    }
+
+    void sort(std::deque<Data>* data) const {
         STLComparator less(_comp);
-        std::stable_sort(_data.begin(), _data.end(), less);
+        parallelStableSort(
+            data->begin(), data->end(), less, _opts.parallelSortThreads, _opts.threadPool.get());
 
         // Does 2x more compares than stable_sort
         // TODO test on windows
         // std::sort(_data.begin(), _data.end(), comp);
     }
 
+    /** Sorts 'data' and writes it to a new file, leaving 'data' empty. */
+    std::shared_ptr<Iterator> sortAndWrite(std::deque<Data>* data) const {
+        sort(data);
+
+        SortedFileWriter<Key, Value> writer(_opts, _settings);
+        for (; !data->empty(); data->pop_front()) {
+            writer.addAlreadySorted(data->front().first, data->front().second);
+        }
+
+        return std::shared_ptr<Iterator>(writer.done());
+    }
+
     void spill() {
         if (_data.empty())
             return;
@@ -479,24 +761,40 @@ private:
                           << " Pass allowDiskUse:true to opt in.");
         }
 
-        sort();
-
-        SortedFileWriter<Key, Value> writer(_opts, _settings);
-        for (; !_data.empty(); _data.pop_front()) {
-            writer.addAlreadySorted(_data.front().first, _data.front().second);
+        if (!spillInBackground()) {
+            _iters.push_back(sortAndWrite(&_data));
+            _memUsed = 0;
+            return;
         }
 
-        _iters.push_back(std::shared_ptr<Iterator>(writer.done()));
+        // At most one run is in flight, so memory use stays bounded by two runs.
+        waitForPendingSpill();
+
+        auto run = std::make_shared<std::deque<Data>>();
+        run->swap(_data);
+        _pendingSpill = stdx::make_unique<PoolTask<std::shared_ptr<Iterator>>>(
+            _opts.threadPool.get(), [this, run] { return sortAndWrite(run.get()); });
 
         _memUsed = 0;
     }
 
+    void waitForPendingSpill() {
+        if (_pendingSpill) {
+            _iters.push_back(_pendingSpill->get());
+            _pendingSpill.reset();
+        }
+    }
+
     const Comparator _comp;
     const Settings _settings;
     SortOptions _opts;
     size_t _memUsed;
     std::deque<Data> _data;                         // the "current" data
     std::vector<std::shared_ptr<Iterator>> _iters;  // data that has already been spilled
+
+    // The run being sorted and written on the thread pool, if any. Declared last so that it is
+    // finished before the members the spill uses are destroyed.
+    std::unique_ptr<PoolTask<std::shared_ptr<Iterator>>> _pendingSpill;
 };
 
 template <typename Key, typename Value, typename Comparator>
@@ -806,7 +1104,12 @@ inline unsigned nextFileNumber() {
 
 template <typename Key, typename Value>
 SortedFileWriter<Key, Value>::SortedFileWriter(const SortOptions& opts, const Settings& settings)
-    : _settings(settings) {
+    : _settings(settings),
+      _readAheadPool(opts.threadPool),
+      _codec(sorter::SpillCodec::get(opts.compression)),
+      _adaptive(opts.compression == SorterCompression::kAdaptive),
+      _prefixCompressKeys(opts.prefixCompressKeys),
+      _stats(opts.spillStats) {
     namespace str = mongoutils::str;
 
     // This should be checked by consumers, but if we get here don't allow writes.
@@ -839,13 +1142,58 @@ SortedFileWriter<Key, Value>::SortedFileWriter(const SortOptions& opts, const Se
 
 template <typename Key, typename Value>
 void SortedFileWriter<Key, Value>::addAlreadySorted(const Key& key, const Value& val) {
-    key.serializeForSorter(_buffer);
+    if (_prefixCompressKeys) {
+        appendPrefixCompressedKey(key);
+    } else {
+        key.serializeForSorter(_buffer);
+    }
     val.serializeForSorter(_buffer);
 
     if (_buffer.len() > 64 * 1024)
         spill();
 }
 
+template <typename Key, typename Value>
+void SortedFileWriter<Key, Value>::appendPrefixCompressedKey(const Key& key) {
+    _keyBuffer.reset();
+    key.serializeForSorter(_keyBuffer);
+    const char* const data = _keyBuffer.buf();
+    const size_t size = _keyBuffer.len();
+
+    const size_t maxSharedSize = std::min(size, _previousKey.size());
+    size_t sharedSize = 0;
+    while (sharedSize < maxSharedSize && data[sharedSize] == _previousKey[sharedSize]) {
+        sharedSize++;
+    }
+
+    sorter::appendKeyLength(&_buffer, sharedSize);
+    sorter::appendKeyLength(&_buffer, size - sharedSize);
+    _buffer.appendBuf(data + sharedSize, size - sharedSize);
+    _previousKey.assign(data, size);
+}
+
+template <typename Key, typename Value>
+bool SortedFileWriter<Key, Value>::shouldTryCompression() const {
+    if (!_codec)
+        return false;
+
+    if (!_adaptive || _sampledBlocks < sorter::kAdaptiveCompressionSampleBlocks)
+        return true;
+
+    return _sampledCompressedBytes < _sampledUncompressedBytes / 10 * 9;
+}
+
+template <typename Key, typename Value>
+void SortedFileWriter<Key, Value>::recordCompressionSample(size_t uncompressedSize,
+                                                           size_t compressedSize) {
+    if (!_adaptive || _sampledBlocks >= sorter::kAdaptiveCompressionSampleBlocks)
+        return;
+
+    _sampledBlocks++;
+    _sampledUncompressedBytes += uncompressedSize;
+    _sampledCompressedBytes += compressedSize;
+}
+
 template <typename Key, typename Value>
 void SortedFileWriter<Key, Value>::spill() {
     namespace str = mongoutils::str;
@@ -856,14 +1204,21 @@ void SortedFileWriter<Key, Value>::spill() {
     if (size == 0)
         return;
 
-    std::string compressed;
-    snappy::Compress(outBuffer, size, &compressed);
-    verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
+    if (_stats)
+        _stats->bytesSpilled.fetchAndAdd(size);
 
-    const bool shouldCompress = compressed.size() < size_t(_buffer.len() / 10 * 9);
-    if (shouldCompress) {
-        size = compressed.size();
-        outBuffer = const_cast<char*>(compressed.data());
+    std::string compressed;
+    bool shouldCompress = false;
+    if (shouldTryCompression()) {
+        _codec->compress(outBuffer, size, &compressed);
+        verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
+        recordCompressionSample(size, compressed.size());
+
+        shouldCompress = compressed.size() < size_t(_buffer.len() / 10 * 9);
+        if (shouldCompress) {
+            size = compressed.size();
+            outBuffer = const_cast<char*>(compressed.data());
+        }
     }
 
     std::unique_ptr<char[]> out;
@@ -896,14 +1251,19 @@ void SortedFileWriter<Key, Value>::spill() {
                                   << sorter::myErrnoWithDescription());
     }
 
+    if (_stats)
+        _stats->bytesWritten.fetchAndAdd(sizeof(size) + std::abs(size));
+
     _buffer.reset();
+    _previousKey.clear();  // Blocks are decoded independently.
 }
 
 template <typename Key, typename Value>
 SortIteratorInterface<Key, Value>* SortedFileWriter<Key, Value>::done() {
     spill();
     _file.close();
-    return new sorter::FileIterator<Key, Value>(_fileName, _settings, _fileDeleter);
+    return new sorter::FileIterator<Key, Value>(
+        _fileName, _settings, _fileDeleter, _codec, _readAheadPool, _prefixCompressKeys);
 }
 
 //
@@ -933,13 +1293,19 @@ Sorter<Key, Value>* Sorter<Key, Value>::make(const SortOptions& opts,
             "Attempting to use external sort without setting SortOptions::tempDir",
             !(opts.extSortAllowed && opts.tempDir.empty()));
 
-    switch (opts.limit) {
+    // Sorting runs, spilling them and reading spilled files ahead all share one pool per sort.
+    SortOptions sortOpts = opts;
+    if (sortOpts.parallelSortThreads > 1 && !sortOpts.threadPool) {
+        sortOpts.threadPool = sorter::makeThreadPool(sortOpts.parallelSortThreads);
+    }
+
+    switch (sortOpts.limit) {
         case 0:
-            return new sorter::NoLimitSorter<Key, Value, Comparator>(opts, comp, settings);
+            return new sorter::NoLimitSorter<Key, Value, Comparator>(sortOpts, comp, settings);
         case 1:
-            return new sorter::LimitOneSorter<Key, Value, Comparator>(opts, comp);
+            return new sorter::LimitOneSorter<Key, Value, Comparator>(sortOpts, comp);
         default:
-            return new sorter::TopKSorter<Key, Value, Comparator>(opts, comp, settings);
+            return new sorter::TopKSorter<Key, Value, Comparator>(sortOpts, comp, settings);
     }
 }
 }
@@ -37,6 +37,7 @@
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/bson/util/builder.h"
+#include "mongo/db/sorter/sorter_compression.h"
 
 /**
  * This is the public API for the Sorter (both in-memory and external)
@@ -89,6 +90,8 @@ namespace sorter {
 class FileDeleter;
 }
 
+class ThreadPool;
+
 /**
  * Runtime options that control the Sorter's behavior
  */
@@ -98,8 +101,27 @@ struct SortOptions {
     bool extSortAllowed;         /// If false, uassert if more mem needed than allowed.
     std::string tempDir;         /// Directory to directly place files in.
                                  /// Must be explicitly set if extSortAllowed is true.
-
-    SortOptions() : limit(0), maxMemoryUsageBytes(64 * 1024 * 1024), extSortAllowed(false) {}
+    size_t parallelSortThreads;  /// Max threads used to sort runs and write/read spill files.
+                                 /// 1 keeps all work on the calling thread.
+    SorterCompression compression;  /// How spilled blocks are compressed. Defaults to the
+                                    /// sorterSpillCompression server parameter.
+    SorterSpillStats* spillStats;   /// If set, receives counts of spilled bytes. Not owned.
+    bool prefixCompressKeys;        /// If true, each spilled key is stored as the length of the
+                                    /// prefix it shares with the previous key of its block and
+                                    /// the remaining bytes. Suits keys with long common prefixes,
+                                    /// such as those of compound indexes.
+    std::shared_ptr<ThreadPool> threadPool;  /// If set, runs are sorted and spilled, and spilled
+                                             /// files read ahead, on this pool. Created once per
+                                             /// sort when parallelSortThreads > 1.
+
+    SortOptions()
+        : limit(0),
+          maxMemoryUsageBytes(64 * 1024 * 1024),
+          extSortAllowed(false),
+          parallelSortThreads(1),
+          compression(getDefaultSorterCompression()),
+          spillStats(nullptr),
+          prefixCompressKeys(false) {}
 
     /// Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
 
@@ -122,6 +144,26 @@ struct SortOptions {
         tempDir = newTempDir;
         return *this;
     }
+
+    SortOptions& ParallelSortThreads(size_t newParallelSortThreads) {
+        parallelSortThreads = newParallelSortThreads;
+        return *this;
+    }
+
+    SortOptions& Compression(SorterCompression newCompression) {
+        compression = newCompression;
+        return *this;
+    }
+
+    SortOptions& SpillStats(SorterSpillStats* newSpillStats) {
+        spillStats = newSpillStats;
+        return *this;
+    }
+
+    SortOptions& PrefixCompressKeys(bool newPrefixCompressKeys = true) {
+        prefixCompressKeys = newPrefixCompressKeys;
+        return *this;
+    }
 };
 
 /// This is the output from the sorting framework
@@ -199,11 +241,41 @@ public:
 private:
     void spill();
 
+    /**
+     * Appends 'key' to '_buffer' as the length of the prefix it shares with '_previousKey', the
+     * length of the rest of it and the rest of it.
+     */
+    void appendPrefixCompressedKey(const Key& key);
+
+    /**
+     * Returns whether the next block should be compressed. Adaptive compression is abandoned for
+     * the rest of the file once the first few blocks saved less than 10% overall.
+     */
+    bool shouldTryCompression() const;
+    void recordCompressionSample(size_t uncompressedSize, size_t compressedSize);
+
     const Settings _settings;
+    // If set, FileIterators returned from done() prefetch their next block on this pool.
+    const std::shared_ptr<ThreadPool> _readAheadPool;
+    const sorter::SpillCodec* const _codec;  // nullptr if blocks are never compressed.
+    const bool _adaptive;
+    const bool _prefixCompressKeys;
+    SorterSpillStats* const _stats;
+
+    // Totals over the blocks sampled so far by adaptive compression.
+    int _sampledBlocks = 0;
+    size_t _sampledUncompressedBytes = 0;
+    size_t _sampledCompressedBytes = 0;
+
     std::string _fileName;
     std::shared_ptr<sorter::FileDeleter> _fileDeleter;  // Must outlive _file
     std::ofstream _file;
     BufBuilder _buffer;
+
+    // The serialized key being added and the previous one of the current block, if keys are
+    // prefix-compressed.
+    BufBuilder _keyBuffer;
+    std::string _previousKey;
 };
 }
 
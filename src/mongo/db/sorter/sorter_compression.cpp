@@ -0,0 +1,191 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/sorter/sorter_compression.h"
+
+#include <snappy.h>
+#include <zlib.h>
+
+#include "mongo/base/data_view.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+AtomicInt32 sorterSpillCompression(static_cast<int>(SorterCompression::kSnappy));
+
+class SorterSpillCompressionParameter : public ServerParameter {
+public:
+    SorterSpillCompressionParameter()
+        : ServerParameter(ServerParameterSet::getGlobal(),
+                          "sorterSpillCompression",
+                          true,  // allowedToChangeAtStartup
+                          true   // allowedToChangeAtRuntime
+                          ) {}
+
+    virtual void append(OperationContext* opCtx, BSONObjBuilder& b, const std::string& name) {
+        b << name << sorterCompressionToString(getDefaultSorterCompression());
+    }
+
+    virtual Status set(const BSONElement& newValueElement) {
+        if (newValueElement.type() != String) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "Invalid value for sorterSpillCompression: "
+                                        << newValueElement);
+        }
+        return setFromString(newValueElement.String());
+    }
+
+    virtual Status setFromString(const std::string& str) {
+        auto swCompression = parseSorterCompression(str);
+        if (!swCompression.isOK()) {
+            return swCompression.getStatus();
+        }
+        sorterSpillCompression.store(static_cast<int>(swCompression.getValue()));
+        return Status::OK();
+    }
+} sorterSpillCompressionParameter;
+
+class SnappySpillCodec : public sorter::SpillCodec {
+public:
+    void compress(const char* data, size_t size, std::string* out) const override {
+        snappy::Compress(data, size, out);
+    }
+
+    std::unique_ptr<char[]> uncompress(const char* data,
+                                       size_t size,
+                                       size_t* uncompressedSize) const override {
+        dassert(snappy::IsValidCompressedBuffer(data, size));
+
+        massert(17061,
+                "couldn't get uncompressed length",
+                snappy::GetUncompressedLength(data, size, uncompressedSize));
+
+        std::unique_ptr<char[]> out(new char[*uncompressedSize]);
+        massert(17062, "decompression failed", snappy::RawUncompress(data, size, out.get()));
+        return out;
+    }
+};
+
+/**
+ * zlib doesn't record the uncompressed length, so blocks are prefixed with it as a little-endian
+ * uint32_t.
+ */
+class ZlibSpillCodec : public sorter::SpillCodec {
+public:
+    void compress(const char* data, size_t size, std::string* out) const override {
+        uLongf outLength = ::compressBound(size);
+        out->resize(sizeof(uint32_t) + outLength);
+        DataView(&(*out)[0]).write<LittleEndian<uint32_t>>(size);
+
+        int ret = ::compress2(reinterpret_cast<Bytef*>(&(*out)[sizeof(uint32_t)]),
+                              &outLength,
+                              reinterpret_cast<const Bytef*>(data),
+                              size,
+                              Z_DEFAULT_COMPRESSION);
+        massert(50900, str::stream() << "zlib compression failed: " << ret, ret == Z_OK);
+        out->resize(sizeof(uint32_t) + outLength);
+    }
+
+    std::unique_ptr<char[]> uncompress(const char* data,
+                                       size_t size,
+                                       size_t* uncompressedSize) const override {
+        massert(50901, "zlib compressed block too short", size >= sizeof(uint32_t));
+        *uncompressedSize = ConstDataView(data).read<LittleEndian<uint32_t>>();
+
+        std::unique_ptr<char[]> out(new char[*uncompressedSize]);
+        uLongf outLength = *uncompressedSize;
+        int ret = ::uncompress(reinterpret_cast<Bytef*>(out.get()),
+                               &outLength,
+                               reinterpret_cast<const Bytef*>(data + sizeof(uint32_t)),
+                               size - sizeof(uint32_t));
+        massert(50902,
+                str::stream() << "zlib decompression failed: " << ret,
+                ret == Z_OK && outLength == *uncompressedSize);
+        return out;
+    }
+};
+
+}  // namespace
+
+StatusWith<SorterCompression> parseSorterCompression(StringData name) {
+    if (name == "none")
+        return SorterCompression::kNone;
+    if (name == "snappy")
+        return SorterCompression::kSnappy;
+    if (name == "zlib")
+        return SorterCompression::kZlib;
+    if (name == "adaptive")
+        return SorterCompression::kAdaptive;
+    return Status(ErrorCodes::BadValue,
+                  str::stream() << "Unknown sorter compression '" << name
+                                << "', expected one of: none, snappy, zlib, adaptive");
+}
+
+StringData sorterCompressionToString(SorterCompression compression) {
+    switch (compression) {
+        case SorterCompression::kNone:
+            return "none"_sd;
+        case SorterCompression::kSnappy:
+            return "snappy"_sd;
+        case SorterCompression::kZlib:
+            return "zlib"_sd;
+        case SorterCompression::kAdaptive:
+            return "adaptive"_sd;
+    }
+    MONGO_UNREACHABLE;
+}
+
+SorterCompression getDefaultSorterCompression() {
+    return static_cast<SorterCompression>(sorterSpillCompression.load());
+}
+
+namespace sorter {
+
+const SpillCodec* SpillCodec::get(SorterCompression compression) {
+    static const SnappySpillCodec snappyCodec;
+    static const ZlibSpillCodec zlibCodec;
+
+    switch (compression) {
+        case SorterCompression::kNone:
+            return nullptr;
+        case SorterCompression::kSnappy:
+        case SorterCompression::kAdaptive:
+            return &snappyCodec;
+        case SorterCompression::kZlib:
+            return &zlibCodec;
+    }
+    MONGO_UNREACHABLE;
+}
+
+}  // namespace sorter
+}  // namespace mongo
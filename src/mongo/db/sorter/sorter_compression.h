@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "mongo/base/status_with.h"
+#include "mongo/base/string_data.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+/**
+ * How blocks of data spilled to disk by the Sorter are compressed.
+ */
+enum class SorterCompression {
+    kNone,      // Blocks are written as-is.
+    kSnappy,    // Blocks are snappy compressed and kept that way if it saves at least 10%.
+    kZlib,      // Like kSnappy, but trades CPU for a better ratio.
+    kAdaptive,  // Like kSnappy, but a file stops compressing if its first blocks didn't pay off.
+};
+
+StatusWith<SorterCompression> parseSorterCompression(StringData name);
+StringData sorterCompressionToString(SorterCompression compression);
+
+/**
+ * Returns the current value of the 'sorterSpillCompression' server parameter, which is the
+ * compression SortOptions use unless told otherwise.
+ */
+SorterCompression getDefaultSorterCompression();
+
+/**
+ * Counters for the data a sort has spilled to disk. They may be updated by background spill
+ * threads, so the owner must outlive the Sorter that reports into it.
+ */
+struct SorterSpillStats {
+    AtomicInt64 bytesSpilled;  // Serialized data handed to SortedFileWriters.
+    AtomicInt64 bytesWritten;  // Bytes written to spill files, after compression.
+};
+
+namespace sorter {
+
+/**
+ * Compresses and decompresses blocks of spill file data. Codecs are stateless and may be used
+ * from several threads at once.
+ */
+class SpillCodec {
+public:
+    virtual ~SpillCodec() = default;
+
+    /**
+     * Returns the codec that compresses blocks for 'compression', or nullptr for kNone.
+     */
+    static const SpillCodec* get(SorterCompression compression);
+
+    virtual void compress(const char* data, size_t size, std::string* out) const = 0;
+
+    /**
+     * Decompresses a block produced by compress(), storing its length in 'uncompressedSize'.
+     * Throws if the block is corrupt.
+     */
+    virtual std::unique_ptr<char[]> uncompress(const char* data,
+                                               size_t size,
+                                               size_t* uncompressedSize) const = 0;
+};
+
+}  // namespace sorter
+}  // namespace mongo
@@ -263,12 +263,72 @@ public:
             ASSERT_ITERATORS_EQUIVALENT(std::shared_ptr<IWIterator>(sorter.done()),
                                         make_shared<IntIterator>(0, 10 * 1000 * 1000));
         }
+        {  // big, with two files reading ahead on a single thread
+            SortOptions readAheadOpts = opts;
+            readAheadOpts.threadPool = sorter::makeThreadPool(1);
+            SortedFileWriter<IntWrapper, IntWrapper> evens(readAheadOpts);
+            SortedFileWriter<IntWrapper, IntWrapper> odds(readAheadOpts);
+            for (int i = 0; i < 1000 * 1000; i += 2) {
+                evens.addAlreadySorted(i, -i);
+                odds.addAlreadySorted(i + 1, -i - 1);
+            }
+
+            std::vector<std::shared_ptr<IWIterator>> iterators{
+                std::shared_ptr<IWIterator>(evens.done()),
+                std::shared_ptr<IWIterator>(odds.done())};
+            ASSERT_ITERATORS_EQUIVALENT(
+                std::shared_ptr<IWIterator>(IWIterator::merge(iterators, opts, IWComparator())),
+                make_shared<IntIterator>(0, 1000 * 1000));
+        }
+        {  // big, with prefix-compressed keys spanning many blocks
+            SortedFileWriter<IntWrapper, IntWrapper> sorter(SortOptions(opts).PrefixCompressKeys());
+            for (int i = 0; i < 1000 * 1000; i++)
+                sorter.addAlreadySorted(i, -i);
+
+            ASSERT_ITERATORS_EQUIVALENT(std::shared_ptr<IWIterator>(sorter.done()),
+                                        make_shared<IntIterator>(0, 1000 * 1000));
+        }
 
         ASSERT(boost::filesystem::is_empty(tempDir.path()));
     }
 };
 
 
+class SortedFileWriterCompressionTests : public ScopedGlobalServiceContextForTest {
+public:
+    void run() {
+        unittest::TempDir tempDir("sortedFileWriterCompressionTests");
+        for (auto compression : {SorterCompression::kNone,
+                                 SorterCompression::kSnappy,
+                                 SorterCompression::kZlib,
+                                 SorterCompression::kAdaptive}) {
+            ASSERT(parseSorterCompression(sorterCompressionToString(compression)).getValue() ==
+                   compression);
+
+            SorterSpillStats stats;
+            SortedFileWriter<IntWrapper, IntWrapper> sorter(
+                SortOptions().TempDir(tempDir.path()).Compression(compression).SpillStats(&stats));
+            for (int i = 0; i < 1000 * 1000; i++)
+                sorter.addAlreadySorted(i, -i);
+
+            ASSERT_ITERATORS_EQUIVALENT(std::shared_ptr<IWIterator>(sorter.done()),
+                                        make_shared<IntIterator>(0, 1000 * 1000));
+
+            // Consecutive integers compress well, so every codec should have paid off.
+            ASSERT_GREATER_THAN(stats.bytesSpilled.load(), 0);
+            if (compression == SorterCompression::kNone) {
+                ASSERT_GREATER_THAN(stats.bytesWritten.load(), stats.bytesSpilled.load());
+            } else {
+                ASSERT_LESS_THAN(stats.bytesWritten.load(), stats.bytesSpilled.load());
+            }
+        }
+
+        ASSERT_NOT_OK(parseSorterCompression("lz4").getStatus());
+        ASSERT(boost::filesystem::is_empty(tempDir.path()));
+    }
+};
+
+
 class MergeIteratorTests {
 public:
     void run() {
@@ -322,6 +382,79 @@ public:
                 mergeIterators(iterators, ASC, SortOptions().Limit(10)),
                 make_shared<LimitIterator>(10, make_shared<IntIterator>(0, 20, 1)));
         }
+        {  // test many sources of uneven length
+            std::shared_ptr<IWIterator> iterators[] = {
+                make_shared<IntIterator>(0, 100, 5)  // 0, 5, ... 95
+                ,
+                make_shared<IntIterator>(1, 20, 5)  // 1, 6, 11, 16
+                ,
+                make_shared<EmptyIterator>(),
+                make_shared<IntIterator>(2, 100, 5)  // 2, 7, ... 97
+                ,
+                make_shared<IntIterator>(3, 100, 5)  // 3, 8, ... 98
+                ,
+                make_shared<IntIterator>(4, 100, 5)  // 4, 9, ... 99
+                ,
+                make_shared<IntIterator>(21, 100, 5)  // 21, 26, ... 96
+            };
+
+            ASSERT_ITERATORS_EQUIVALENT(mergeIterators(iterators, ASC),
+                                        make_shared<IntIterator>(0, 100, 1));
+        }
+        {  // test that equal keys are returned in the order of their sources
+            std::vector<std::shared_ptr<IWIterator>> vec;
+            for (int source = 0; source < 5; source++) {
+                std::vector<IWPair> pairs;
+                for (int key = 0; key < 10; key++)
+                    pairs.push_back(IWPair(key, source));
+                vec.push_back(
+                    std::make_shared<sorter::InMemIterator<IntWrapper, IntWrapper>>(pairs));
+            }
+            std::shared_ptr<IWIterator> mergeIter(
+                IWIterator::merge(vec, SortOptions(), IWComparator()));
+
+            for (int key = 0; key < 10; key++) {
+                for (int source = 0; source < 5; source++) {
+                    ASSERT(mergeIter->more());
+                    IWPair pair = mergeIter->next();
+                    ASSERT_EQUALS(pair.first, key);
+                    ASSERT_EQUALS(pair.second, source);
+                }
+            }
+            ASSERT(!mergeIter->more());
+        }
+    }
+};
+
+class ParallelStableSortTests {
+public:
+    void run() {
+        PseudoRandom random(int64_t(time(0)));
+        const int numItems = 10 * kMinElementsPerSortThread + 123;
+
+        // Few distinct keys so stability is observable through the values.
+        std::deque<IWPair> input;
+        for (int i = 0; i < numItems; i++)
+            input.push_back(IWPair(random.nextInt32(100), i));
+
+        auto less = [](const IWPair& lhs, const IWPair& rhs) {
+            return IWComparator()(lhs, rhs) < 0;
+        };
+
+        std::deque<IWPair> expected(input);
+        std::stable_sort(expected.begin(), expected.end(), less);
+
+        for (size_t numThreads : {1, 2, 3, 4, 7}) {
+            std::deque<IWPair> data(input);
+            auto pool = makeThreadPool(numThreads);
+            parallelStableSort(data.begin(), data.end(), less, numThreads, pool.get());
+
+            ASSERT_EQUALS(data.size(), expected.size());
+            for (size_t i = 0; i < data.size(); i++) {
+                ASSERT_EQUALS(data[i].first, expected[i].first);
+                ASSERT_EQUALS(data[i].second, expected[i].second);
+            }
+        }
     }
 };
 
@@ -510,6 +643,58 @@ public:
     PseudoRandom _random;
 };
 
+template <bool Random = true>
+class ParallelLotsOfDataLittleMemory : public LotsOfDataLittleMemory<Random> {
+    SortOptions adjustSortOptions(SortOptions opts) {
+        // Spills happen in the background and spilled blocks are read ahead while merging.
+        return LotsOfDataLittleMemory<Random>::adjustSortOptions(opts).ParallelSortThreads(4);
+    }
+};
+
+/**
+ * Without external sorting, a parallel sort must still hold a full memory limit's worth of data,
+ * since only background spills need room for a second run.
+ */
+class ParallelInMemory : public Basic {
+    SortOptions adjustSortOptions(SortOptions opts) {
+        MONGO_STATIC_ASSERT(NUM_ITEMS * 2 * sizeof(IntWrapper) > MEM_LIMIT / 2);
+        MONGO_STATIC_ASSERT(NUM_ITEMS * 2 * sizeof(IntWrapper) < MEM_LIMIT);
+
+        return opts.MaxMemoryUsageBytes(MEM_LIMIT).ParallelSortThreads(4);
+    }
+    void addData(unowned_ptr<IWSorter> sorter) {
+        for (int i = NUM_ITEMS - 1; i >= 0; i--)
+            sorter->add(i, -i);
+
+        ASSERT_EQUALS(sorter->numFiles(), 0);
+    }
+    virtual std::shared_ptr<IWIterator> correct() {
+        return make_shared<IntIterator>(0, NUM_ITEMS);
+    }
+    virtual std::shared_ptr<IWIterator> correctReverse() {
+        return make_shared<IntIterator>(NUM_ITEMS - 1, -1, -1);
+    }
+    enum Constants {
+        NUM_ITEMS = 6 * 1000,
+        MEM_LIMIT = 64 * 1024,
+    };
+};
+
+
+template <SorterCompression Compression>
+class CompressedLotsOfDataLittleMemory : public LotsOfDataLittleMemory</*random=*/true> {
+    SortOptions adjustSortOptions(SortOptions opts) {
+        return LotsOfDataLittleMemory<true>::adjustSortOptions(opts).Compression(Compression);
+    }
+};
+
+template <bool Random = true>
+class PrefixCompressedLotsOfDataLittleMemory : public LotsOfDataLittleMemory<Random> {
+    SortOptions adjustSortOptions(SortOptions opts) {
+        return LotsOfDataLittleMemory<Random>::adjustSortOptions(opts).PrefixCompressKeys();
+    }
+};
+
 
 template <long long Limit, bool Random = true>
 class LotsOfDataWithLimit : public LotsOfDataLittleMemory<Random> {
@@ -543,12 +728,22 @@ public:
     void setupTests() {
         add<InMemIterTests>();
         add<SortedFileWriterAndFileIteratorTests>();
+        add<SortedFileWriterCompressionTests>();
         add<MergeIteratorTests>();
+        add<ParallelStableSortTests>();
         add<SorterTests::Basic>();
         add<SorterTests::Limit>();
         add<SorterTests::Dupes>();
         add<SorterTests::LotsOfDataLittleMemory</*random=*/false>>();
         add<SorterTests::LotsOfDataLittleMemory</*random=*/true>>();
+        add<SorterTests::ParallelLotsOfDataLittleMemory</*random=*/false>>();
+        add<SorterTests::ParallelLotsOfDataLittleMemory</*random=*/true>>();
+        add<SorterTests::ParallelInMemory>();
+        add<SorterTests::CompressedLotsOfDataLittleMemory<SorterCompression::kNone>>();
+        add<SorterTests::CompressedLotsOfDataLittleMemory<SorterCompression::kZlib>>();
+        add<SorterTests::CompressedLotsOfDataLittleMemory<SorterCompression::kAdaptive>>();
+        add<SorterTests::PrefixCompressedLotsOfDataLittleMemory</*random=*/false>>();
+        add<SorterTests::PrefixCompressedLotsOfDataLittleMemory</*random=*/true>>();
         add<SorterTests::LotsOfDataWithLimit<1, /*random=*/false>>();     // limit=1 is special case
         add<SorterTests::LotsOfDataWithLimit<1, /*random=*/true>>();      // limit=1 is special case
         add<SorterTests::LotsOfDataWithLimit<100, /*random=*/false>>();   // fits in mem
@@ -196,9 +196,9 @@ Status RecordStore::updateRecord(OperationContext* opCtx,
                                  UpdateNotifier* notifier) {
     StringStore* workingCopy = getRecoveryUnitBranch_forking(opCtx);
     std::string key = createKey(_ident, oldLocation.repr());
-    StringStore::iterator it = workingCopy->find(key);
+    StringStore::iterator it =
+        workingCopy->update(StringStore::value_type{key, std::string(data, len)});
     invariant(it != workingCopy->end());
-    it->second = std::string(data, len);
     return Status::OK();
 }
 
@@ -215,11 +215,15 @@ StatusWith<RecordData> RecordStore::updateWithDamages(OperationContext* opCtx,
     std::string key = createKey(_ident, loc.repr());
     StringStore::iterator doc = workingCopy->find(key);
     invariant(doc != workingCopy->end());  // Only update existing records.
+
+    // Values in the store may be shared with other snapshots, so apply the damages to a copy.
+    std::string updated = doc->second;
     for (const auto& d : damages) {
         const char* source = damageSource + d.sourceOffset;
-        char* target = (&doc->second[0]) + d.targetOffset;
+        char* target = (&updated[0]) + d.targetOffset;
         std::memcpy(target, source, d.size);
     }
+    doc = workingCopy->update(StringStore::value_type{key, std::move(updated)});
     RecordData updatedRecord(doc->second.c_str(), doc->second.length());
     return updatedRecord;  // Data is un-owned.
 }
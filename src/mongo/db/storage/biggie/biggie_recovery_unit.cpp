@@ -48,14 +48,18 @@ void RecoveryUnit::beginUnitOfWork(OperationContext* opCtx) {}
 void RecoveryUnit::commitUnitOfWork() {
     while (true) {
         std::shared_ptr<StringStore> master = _KVEngine->getMaster();
+        // Only the parts of the store that both this unit of work and the commits since
+        // _mergeBase changed are visited, so this is cheap when there were no concurrent commits.
+        std::unique_ptr<StringStore> merged;
         try {
-            _workingCopy->merge3(*_mergeBase, *master);
+            merged = std::make_unique<StringStore>(_workingCopy->merge3(*_mergeBase, *master));
         } catch (const merge_conflict_exception&) {
             throw WriteConflictException();
         }
         stdx::lock_guard<stdx::mutex> lkOnMaster(_KVEngine->getMasterLock());
         if (_KVEngine->getMaster_inlock() == master) {
-            _KVEngine->setMaster_inlock(std::move(_workingCopy));
+            _KVEngine->setMaster_inlock(std::move(merged));
+            _workingCopy.reset();
             _mergeBase.reset();
             break;
         }
@@ -110,9 +114,8 @@ bool RecoveryUnit::forkIfNeeded() {
     if (_mergeBase) {
         return false;
     }
-    // TODO : later on this needs to be changed to use their copy function.
     _mergeBase = _KVEngine->getMaster();
-    // TODO : later on this needs to be changed to use their copy function.
+    // Copying a StringStore shares its nodes, so this does not copy any data.
     _workingCopy = std::make_unique<StringStore>(*_mergeBase);
     return true;
 }
@@ -28,8 +28,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
 #include <exception>
-#include <map>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace mongo {
 namespace biggie {
@@ -40,260 +46,682 @@ class merge_conflict_exception : std::exception {
     }
 };
 
+/**
+ * An ordered map from string keys to values, stored as a persistent radix tree.
+ *
+ * Nodes are never modified once another Store or iterator can see them: a modification copies
+ * only the nodes on the path to the key it touches. Copying a Store is therefore O(1), and a
+ * copy shares every node that neither side has modified since. Iterators keep the version of
+ * the tree they were created from alive and do not observe later modifications to the Store.
+ *
+ * The tree is path compressed, and every node other than the root either holds a value or has
+ * at least two children. This makes the shape of the tree a function of the set of keys alone,
+ * which is what lets merge3() walk three versions side by side and skip every subtree that one
+ * side still shares with the merge base.
+ */
 template <class Key, class T>
 class Store {
-private:
-    std::map<Key, T> map;
-
 public:
     using mapped_type = T;
     using value_type = std::pair<const Key, mapped_type>;
-    using allocator_type = std::allocator<value_type>;
-    using pointer = typename std::allocator_traits<allocator_type>::pointer;
-    using const_pointer = typename std::allocator_traits<allocator_type>::const_pointer;
     using size_type = std::size_t;
 
-    template <class pointer_type, class reference_type, class iter_type>
-    class store_iterator {
-    private:
-        friend class Store;
-        iter_type iter;
-        store_iterator(iter_type iter) : iter(iter) {}
+private:
+    struct Node {
+        // Key bytes on the edge from the parent to this node. Empty only for the root.
+        std::string label;
+
+        // Set if a key ends at this node. Values are immutable and shared between versions.
+        std::shared_ptr<const value_type> data;
+
+        // Ordered by the first byte of their labels, which are distinct.
+        std::vector<std::shared_ptr<Node>> children;
+
+        // Number of values, and total size of the mapped data, in this subtree.
+        size_type numElements = 0;
+        size_type dataSize = 0;
+
+        /**
+         * Returns the index of the first child whose label starts with a byte not less than 'b'.
+         */
+        size_t lowerBoundChild(unsigned char b) const {
+            auto it = std::lower_bound(
+                children.begin(),
+                children.end(),
+                b,
+                [](const std::shared_ptr<Node>& child, unsigned char c) {
+                    return static_cast<unsigned char>(child->label[0]) < c;
+                });
+            return it - children.begin();
+        }
 
+        /**
+         * Returns the index of the child whose label starts with 'b', or children.size().
+         */
+        size_t findChild(unsigned char b) const {
+            size_t idx = lowerBoundChild(b);
+            if (idx != children.size() && static_cast<unsigned char>(children[idx]->label[0]) != b)
+                return children.size();
+            return idx;
+        }
+    };
+
+public:
+    class const_iterator {
     public:
         using iterator_category = std::bidirectional_iterator_tag;
         using value_type = typename Store::value_type;
         using difference_type = std::ptrdiff_t;
-        using pointer = pointer_type;
-        using reference = reference_type;
+        using pointer = const value_type*;
+        using reference = const value_type&;
 
-        store_iterator() = default;
+        const_iterator() = default;
 
-        store_iterator& operator++() {
-            ++this->iter;
+        const_iterator& operator++() {
+            if (_path.back().node->children.empty()) {
+                _nextSubtree();
+            } else {
+                _path.push_back({_path.back().node->children.front().get(), 0});
+                _descendFirst();
+            }
             return *this;
         }
 
-        store_iterator operator++(int) {
-            store_iterator old = *this;
-            ++this->iter;
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
             return old;
         }
 
-        store_iterator& operator--() {
-            --this->iter;
+        const_iterator& operator--() {
+            if (_path.empty()) {
+                _atRoot();
+                _descendLast();
+                return *this;
+            }
+
+            while (_path.size() > 1) {
+                Frame frame = _path.back();
+                _path.pop_back();
+                if (frame.index > 0) {
+                    _path.push_back({_path.back().node->children[frame.index - 1].get(),
+                                     frame.index - 1});
+                    _descendLast();
+                    return *this;
+                }
+                if (_path.back().node->data)
+                    return *this;
+            }
+            _path.clear();
             return *this;
         }
 
-        store_iterator operator--(int) {
-            store_iterator old = *this;
-            --this->iter;
+        const_iterator operator--(int) {
+            const_iterator old = *this;
+            --*this;
             return old;
         }
 
         // Non member equality
 
-        friend bool operator==(const store_iterator& lhs, const store_iterator& rhs) {
-            return lhs.iter == rhs.iter;
+        friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) {
+            if (lhs._path.empty() || rhs._path.empty())
+                return lhs._path.empty() && rhs._path.empty();
+            return lhs._path.back().node == rhs._path.back().node;
         }
 
-        friend bool operator!=(const store_iterator& lhs, const store_iterator& rhs) {
-            return !(lhs.iter == rhs.iter);
+        friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) {
+            return !(lhs == rhs);
         }
 
         reference operator*() const {
-            return *this->iter;
+            return *_path.back().node->data;
         }
 
         pointer operator->() const {
-            return &(*this->iter);
+            return _path.back().node->data.get();
+        }
+
+    private:
+        friend class Store;
+
+        struct Frame {
+            const Node* node;
+            // Position of 'node' among its parent's children.
+            size_t index;
+        };
+
+        explicit const_iterator(std::shared_ptr<Node> root) : _root(std::move(root)) {}
+
+        /**
+         * Positions the iterator at the root, from which the other helpers descend.
+         */
+        void _atRoot() {
+            _path.assign(1, Frame{_root.get(), 0});
+        }
+
+        /**
+         * Moves from the node on top of the path to the first value in its subtree.
+         */
+        void _descendFirst() {
+            while (!_path.back().node->data) {
+                if (_path.back().node->children.empty()) {
+                    // Only an empty root has neither a value nor children.
+                    _path.clear();
+                    return;
+                }
+                _path.push_back({_path.back().node->children.front().get(), 0});
+            }
         }
+
+        /**
+         * Moves from the node on top of the path to the last value in its subtree.
+         */
+        void _descendLast() {
+            while (!_path.back().node->children.empty()) {
+                size_t last = _path.back().node->children.size() - 1;
+                _path.push_back({_path.back().node->children[last].get(), last});
+            }
+            if (!_path.back().node->data)
+                _path.clear();
+        }
+
+        /**
+         * Moves to the first value after the subtree of the node on top of the path.
+         */
+        void _nextSubtree() {
+            while (_path.size() > 1) {
+                Frame frame = _path.back();
+                _path.pop_back();
+                const Node* parent = _path.back().node;
+                if (frame.index + 1 < parent->children.size()) {
+                    _path.push_back({parent->children[frame.index + 1].get(), frame.index + 1});
+                    _descendFirst();
+                    return;
+                }
+            }
+            _path.clear();
+        }
+
+        // Keeps the version of the tree this iterator walks alive.
+        std::shared_ptr<Node> _root;
+
+        // Nodes from the root down to the current value. Empty for end().
+        std::vector<Frame> _path;
     };
 
-    using iterator = store_iterator<pointer, value_type&, typename std::map<Key, T>::iterator>;
-    using const_iterator =
-        store_iterator<const_pointer, const value_type&, typename std::map<Key, T>::const_iterator>;
+    // Values are immutable, so all iterators are const; use update() to change a mapped value.
+    using iterator = const_iterator;
     using reverse_iterator = std::reverse_iterator<iterator>;
     using reverse_const_iterator = std::reverse_iterator<const_iterator>;
 
     // Constructors
 
+    Store() : _root(std::make_shared<Node>()) {}
     Store(const Store& other) = default;
-    Store() = default;
+    Store& operator=(const Store& other) = default;
 
     ~Store() = default;
 
     // Non member equality
 
     friend bool operator==(const Store& lhs, const Store& rhs) {
-        return lhs.map == rhs.map;
+        if (lhs._root == rhs._root)
+            return true;
+        if (lhs.size() != rhs.size())
+            return false;
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin());
     }
 
     // Capacity
 
     bool empty() const {
-        return map.empty();
+        return size() == 0;
     }
 
     // Number of nodes
     size_type size() const {
-        return map.size();
+        return _root->numElements;
     }
 
     // Size of mapped data in store
     size_type dataSize() const {
-        size_type s = size_type(0);
-        for (const value_type val : *this) {
-            s += val.second.size();
-        }
-
-        return s;
+        return _root->dataSize;
     }
 
     // Modifiers
 
-    void clear() noexcept {
-        map.clear();
+    void clear() {
+        _root = std::make_shared<Node>();
     }
 
     std::pair<iterator, bool> insert(value_type&& value) {
-        auto res = this->map.insert(value);
-        iterator iter = iterator(res.first);
-        return std::pair<iterator, bool>(iter, res.second);
+        {
+            const_iterator existing = find(value.first);
+            if (existing != end())
+                return std::pair<iterator, bool>(existing, false);
+        }
+
+        Key key = value.first;
+        _upsert(std::make_shared<const value_type>(std::move(value)), nullptr);
+        return std::pair<iterator, bool>(find(key), true);
+    }
+
+    /**
+     * Replaces the mapped value of an existing key. Returns an iterator to the new value, or
+     * end() if the key is not present.
+     */
+    iterator update(value_type&& value) {
+        Key key = value.first;
+        {
+            const_iterator existing = find(key);
+            if (existing == end())
+                return end();
+
+            std::shared_ptr<const value_type> old = _dataOf(existing);
+            existing = const_iterator();
+            _upsert(std::make_shared<const value_type>(std::move(value)), old.get());
+        }
+        return find(key);
     }
 
     size_type erase(const Key& key) {
-        return map.erase(key);
+        size_type size;
+        {
+            const_iterator existing = find(key);
+            if (existing == end())
+                return 0;
+            size = existing->second.size();
+        }
+        _erase(_root, key, 0, size, true);
+        return 1;
     }
 
     /**
      * Returns a Store that has all changes from both 'this' and 'other' compared to base.
      * Throws merge_conflict_exception if there are merge conflicts.
+     *
+     * Only the parts of the trees where both 'this' and 'other' differ from 'base' are visited;
+     * everything else is shared with the inputs.
      */
     Store merge3(const Store& base, const Store& other) const {
         Store store;
+        store._root = _merge(MergePosition{&_root, 0},
+                             MergePosition{&base._root, 0},
+                             MergePosition{&other._root, 0},
+                             std::string());
+        return store;
+    }
 
-        // Merges all differences between this and base, along with modifications from other.
-        for (const Store::value_type val : *this) {
-            Store::const_iterator baseIter = base.find(val.first);
-            Store::const_iterator otherIter = other.find(val.first);
+    // Iterators
 
-            if (baseIter != base.end() && otherIter != other.end()) {
-                if (val.second != baseIter->second && otherIter->second != baseIter->second) {
-                    // Throws exception if there are conflicting modifications.
-                    throw merge_conflict_exception();
-                }
+    const_iterator begin() const {
+        const_iterator it(_root);
+        it._atRoot();
+        it._descendFirst();
+        return it;
+    }
 
-                if (val.second != baseIter->second) {
-                    // Merges non-conflicting insertions from this.
-                    store.insert(Store::value_type(val));
-                } else {
-                    // Merges non-conflicting modifications from other or no modifications.
-                    store.insert(Store::value_type(*otherIter));
-                }
-            } else if (baseIter != base.end() && otherIter == other.end()) {
-                if (val.second != baseIter->second) {
-                    // Throws exception if modifications from this conflict with deletions from
-                    // other.
-                    throw merge_conflict_exception();
-                }
-            } else if (baseIter == base.end()) {
-                if (otherIter != other.end()) {
-                    // Throws exception if insertions from this conflict with insertions from other.
-                    throw merge_conflict_exception();
-                }
+    const_iterator end() const {
+        return const_iterator(_root);
+    }
 
-                // Merges insertions from this.
-                store.insert(Store::value_type(val));
-            }
-        }
+    reverse_const_iterator rbegin() const {
+        return reverse_const_iterator(end());
+    }
 
-        // Merges insertions and deletions from other.
-        for (const Store::value_type otherVal : other) {
-            Store::const_iterator baseIter = base.find(otherVal.first);
-            Store::const_iterator thisIter = this->find(otherVal.first);
-
-            if (baseIter == base.end()) {
-                // Merges insertions from other.
-                store.insert(Store::value_type(otherVal));
-            } else if (thisIter == this->end() && otherVal.second != baseIter->second) {
-                // Throws exception if modifications from this conflict with deletions from other.
-                throw merge_conflict_exception();
-            }
+    reverse_const_iterator rend() const {
+        return reverse_const_iterator(begin());
+    }
+
+    // Look up
+
+    const_iterator find(const Key& key) const {
+        const_iterator it(_root);
+        it._atRoot();
+        const Node* node = _root.get();
+        size_t pos = 0;
+        while (pos < key.size()) {
+            size_t idx = node->findChild(key[pos]);
+            if (idx == node->children.size())
+                return end();
+
+            const Node* child = node->children[idx].get();
+            if (key.compare(pos, child->label.size(), child->label) != 0)
+                return end();
+
+            pos += child->label.size();
+            node = child;
+            it._path.push_back({node, idx});
         }
 
-        return store;
+        if (!node->data)
+            return end();
+        return it;
     }
 
-    // Iterators
+    const_iterator lower_bound(const Key& key) const {
+        const_iterator it(_root);
+        it._atRoot();
+        const Node* node = _root.get();
+        size_t pos = 0;
+        while (pos < key.size()) {
+            unsigned char b = key[pos];
+            size_t idx = node->lowerBoundChild(b);
+            if (idx == node->children.size()) {
+                // Every key in this subtree is a prefix of 'key' or diverges below it.
+                it._nextSubtree();
+                return it;
+            }
 
-    iterator begin() noexcept {
-        return iterator(this->map.begin());
-    }
+            const Node* child = node->children[idx].get();
+            it._path.push_back({child, idx});
 
-    iterator end() noexcept {
-        return iterator(this->map.end());
-    }
+            const std::string& label = child->label;
+            size_t len = std::min(label.size(), key.size() - pos);
+            int cmp = std::memcmp(label.data(), key.data() + pos, len);
+            if (cmp == 0 && len == label.size()) {
+                pos += len;
+                node = child;
+                continue;
+            }
 
-    reverse_iterator rbegin() noexcept {
-        return reverse_iterator(end());
-    }
+            if (cmp < 0) {
+                it._nextSubtree();
+            } else {
+                // The label either sorts after 'key' or extends past its end.
+                it._descendFirst();
+            }
+            return it;
+        }
 
-    reverse_iterator rend() noexcept {
-        return reverse_iterator(begin());
+        // Every key in this subtree has 'key' as a prefix.
+        it._descendFirst();
+        return it;
     }
 
-    const_iterator begin() const noexcept {
-        return const_iterator(this->map.begin());
+    const_iterator upper_bound(const Key& key) const {
+        const_iterator it = lower_bound(key);
+        if (it != end() && it->first == key)
+            ++it;
+        return it;
     }
 
-    const_iterator end() const noexcept {
-        return const_iterator(this->map.end());
+    // std::distance
+
+    typename iterator::difference_type distance(const_iterator iter1, const_iterator iter2) const {
+        return std::distance(iter1, iter2);
+    };
+
+private:
+    /**
+     * A point in one version of the tree, used by merge3() to walk several versions a byte at a
+     * time. The position may fall in the middle of a node's label.
+     */
+    struct MergePosition {
+        // Null if this version has no keys below the position.
+        const std::shared_ptr<Node>* node = nullptr;
+
+        // Number of bytes of the node's label above the position.
+        size_t consumed = 0;
+
+        bool atNode() const {
+            return node && consumed == (*node)->label.size();
+        }
+
+        const std::shared_ptr<const value_type>* data() const {
+            return atNode() && (*node)->data ? &(*node)->data : nullptr;
+        }
+
+        void appendNextBytes(std::vector<unsigned char>* bytes) const {
+            if (!node)
+                return;
+            if (!atNode()) {
+                bytes->push_back((*node)->label[consumed]);
+                return;
+            }
+            for (const auto& child : (*node)->children)
+                bytes->push_back(child->label[0]);
+        }
+
+        MergePosition next(unsigned char b) const {
+            if (!node)
+                return {};
+            if (!atNode()) {
+                if (static_cast<unsigned char>((*node)->label[consumed]) != b)
+                    return {};
+                return {node, consumed + 1};
+            }
+            size_t idx = (*node)->findChild(b);
+            if (idx == (*node)->children.size())
+                return {};
+            return {&(*node)->children[idx], 1};
+        }
+
+        bool sameAs(const MergePosition& other) const {
+            if (!node || !other.node)
+                return !node && !other.node;
+            return node->get() == other.node->get() && consumed == other.consumed;
+        }
+    };
+
+    static std::shared_ptr<const value_type> _dataOf(const const_iterator& it) {
+        return it._path.back().node->data;
     }
 
-    reverse_const_iterator rbegin() const noexcept {
-        return reverse_const_iterator(end());
+    /**
+     * Returns 'node' if nothing but its parent in this Store refers to it, and otherwise replaces
+     * it with a copy that this Store can modify.
+     */
+    static Node* _makeUnique(std::shared_ptr<Node>& node) {
+        if (node.use_count() != 1)
+            node = std::make_shared<Node>(*node);
+        return node.get();
     }
 
-    reverse_const_iterator rend() const noexcept {
-        return reverse_const_iterator(begin());
+    static bool _sameValue(const std::shared_ptr<const value_type>* lhs,
+                           const std::shared_ptr<const value_type>* rhs) {
+        if (!lhs || !rhs)
+            return !lhs && !rhs;
+        return *lhs == *rhs || (*lhs)->second == (*rhs)->second;
     }
 
-    // Look up
+    /**
+     * Stores 'data' under its key, copying the nodes on the path that are shared. 'old' is the
+     * value being replaced, or null if the key is new.
+     */
+    void _upsert(std::shared_ptr<const value_type> data, const value_type* old) {
+        const Key& key = data->first;
+        size_type elementsAdded = old ? 0 : 1;
+        size_type newSize = data->second.size();
+        size_type oldSize = old ? old->second.size() : 0;
+
+        std::shared_ptr<Node>* slot = &_root;
+        size_t pos = 0;
+        while (true) {
+            Node* node = _makeUnique(*slot);
+            node->numElements += elementsAdded;
+            node->dataSize = node->dataSize - oldSize + newSize;
+
+            if (pos == key.size()) {
+                node->data = std::move(data);
+                return;
+            }
 
-    iterator find(const Key& key) {
-        return iterator(this->map.find(key));
-    }
+            size_t idx = node->lowerBoundChild(key[pos]);
+            if (idx == node->children.size() ||
+                node->children[idx]->label[0] != static_cast<char>(key[pos])) {
+                auto leaf = std::make_shared<Node>();
+                leaf->label = key.substr(pos);
+                leaf->data = std::move(data);
+                leaf->numElements = 1;
+                leaf->dataSize = newSize;
+                node->children.insert(node->children.begin() + idx, std::move(leaf));
+                return;
+            }
 
-    const_iterator find(const Key& key) const {
-        return const_iterator(this->map.find(key));
-    }
+            std::shared_ptr<Node>& childSlot = node->children[idx];
+            const std::string& label = childSlot->label;
+            size_t common = 1;
+            while (common < label.size() && pos + common < key.size() &&
+                   label[common] == key[pos + common])
+                ++common;
+
+            if (common == label.size()) {
+                pos += common;
+                slot = &childSlot;
+                continue;
+            }
 
-    iterator lower_bound(const Key& key) {
-        return iterator(this->map.lower_bound(key));
+            // The key diverges from the child's label, or ends, partway along it. Split the edge.
+            auto split = std::make_shared<Node>();
+            split->label = label.substr(0, common);
+            split->numElements = childSlot->numElements + 1;
+            split->dataSize = childSlot->dataSize + newSize;
+
+            std::shared_ptr<Node> rest = std::move(childSlot);
+            _makeUnique(rest)->label.erase(0, common);
+
+            if (pos + common == key.size()) {
+                split->data = std::move(data);
+                split->children.push_back(std::move(rest));
+            } else {
+                auto leaf = std::make_shared<Node>();
+                leaf->label = key.substr(pos + common);
+                leaf->data = std::move(data);
+                leaf->numElements = 1;
+                leaf->dataSize = newSize;
+                if (static_cast<unsigned char>(leaf->label[0]) <
+                    static_cast<unsigned char>(rest->label[0])) {
+                    split->children.push_back(std::move(leaf));
+                    split->children.push_back(std::move(rest));
+                } else {
+                    split->children.push_back(std::move(rest));
+                    split->children.push_back(std::move(leaf));
+                }
+            }
+            childSlot = std::move(split);
+            return;
+        }
     }
 
-    const_iterator lower_bound(const Key& key) const {
-        return const_iterator(this->map.lower_bound(key));
+    /**
+     * Removes 'key', which must be present, from the subtree in 'slot'. 'pos' is the number of
+     * key bytes above the node and 'size' the size of the value being removed.
+     */
+    static void _erase(
+        std::shared_ptr<Node>& slot, const Key& key, size_t pos, size_type size, bool isRoot) {
+        Node* node = _makeUnique(slot);
+        node->numElements -= 1;
+        node->dataSize -= size;
+
+        if (pos == key.size()) {
+            node->data.reset();
+        } else {
+            size_t idx = node->findChild(key[pos]);
+            std::shared_ptr<Node>& childSlot = node->children[idx];
+            _erase(childSlot, key, pos + childSlot->label.size(), size, false);
+            if (!childSlot)
+                node->children.erase(node->children.begin() + idx);
+        }
+
+        if (!isRoot)
+            slot = _compress(std::move(slot));
     }
 
-    iterator upper_bound(const Key& key) {
-        return iterator(this->map.upper_bound(key));
+    /**
+     * Restores the invariant that a node other than the root has a value or at least two
+     * children, by dropping an empty node or merging it with its only child.
+     */
+    static std::shared_ptr<Node> _compress(std::shared_ptr<Node> node) {
+        if (node->data || node->children.size() > 1)
+            return node;
+        if (node->children.empty())
+            return nullptr;
+
+        std::shared_ptr<Node> child = std::move(node->children.front());
+        std::string label = node->label + child->label;
+        node.reset();
+        _makeUnique(child)->label = std::move(label);
+        return child;
     }
 
-    const_iterator upper_bound(const Key& key) const {
-        return const_iterator(this->map.upper_bound(key));
+    /**
+     * Returns the subtree below 'pos' as a node with the given label, sharing it if possible.
+     */
+    static std::shared_ptr<Node> _subtreeAt(const MergePosition& pos, std::string label) {
+        if (!pos.node)
+            return nullptr;
+
+        const std::shared_ptr<Node>& node = *pos.node;
+        label.append(node->label, pos.consumed, std::string::npos);
+        if (label == node->label)
+            return node;
+
+        auto copy = std::make_shared<Node>(*node);
+        copy->label = std::move(label);
+        return copy;
     }
 
-    // std::distance
+    /**
+     * Merges the subtrees below the given positions, which all correspond to the same key
+     * prefix, into a node with the given label.
+     */
+    static std::shared_ptr<Node> _merge(const MergePosition& current,
+                                        const MergePosition& base,
+                                        const MergePosition& other,
+                                        std::string label) {
+        if (current.sameAs(base))
+            return _subtreeAt(other, std::move(label));
+        if (other.sameAs(base))
+            return _subtreeAt(current, std::move(label));
+
+        auto node = std::make_shared<Node>();
+        bool isRoot = label.empty();
+        node->label = std::move(label);
+
+        const auto* currentData = current.data();
+        const auto* baseData = base.data();
+        const auto* otherData = other.data();
+        bool currentChanged = !_sameValue(currentData, baseData);
+        bool otherChanged = !_sameValue(otherData, baseData);
+
+        // A key deleted on both sides is not a conflict. Any other pair of changes is, even if
+        // both sides made the same one.
+        if (currentChanged && otherChanged && (currentData || otherData))
+            throw merge_conflict_exception();
+
+        const auto* data = currentChanged ? currentData : otherData;
+        if (data) {
+            node->data = *data;
+            node->numElements = 1;
+            node->dataSize = (*data)->second.size();
+        }
 
-    typename iterator::difference_type distance(iterator iter1, iterator iter2) {
-        return typename iterator::difference_type(std::distance(iter1.iter, iter2.iter));
-    };
+        std::vector<unsigned char> bytes;
+        current.appendNextBytes(&bytes);
+        base.appendNextBytes(&bytes);
+        other.appendNextBytes(&bytes);
+        std::sort(bytes.begin(), bytes.end());
+        bytes.erase(std::unique(bytes.begin(), bytes.end()), bytes.end());
+
+        for (unsigned char b : bytes) {
+            auto child = _merge(
+                current.next(b), base.next(b), other.next(b), std::string(1, static_cast<char>(b)));
+            if (!child)
+                continue;
+            node->numElements += child->numElements;
+            node->dataSize += child->dataSize;
+            node->children.push_back(std::move(child));
+        }
 
-    typename iterator::difference_type distance(const_iterator iter1, const_iterator iter2) const {
-        return typename iterator::difference_type(std::distance(iter1.iter, iter2.iter));
-    };
+        if (isRoot)
+            return node;
+        return _compress(std::move(node));
+    }
+
+    // Never null. Shared with copies of this Store and with iterators.
+    std::shared_ptr<Node> _root;
 };
 
 using StringStore = Store<std::string, std::string>;
@@ -0,0 +1,154 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mongo/db/storage/biggie/store.h"
+
+namespace mongo {
+namespace biggie {
+namespace {
+
+using StdMap = std::map<std::string, std::string>;
+
+/**
+ * Returns 'count' distinct keys shaped like the ones the biggie record store uses: an ident
+ * prefix followed by a big-endian record id. The keys are shuffled.
+ */
+std::vector<std::string> makeKeys(int64_t count) {
+    std::vector<std::string> keys;
+    for (int64_t i = 0; i < count; i++) {
+        std::string key = "collection-7-1234567890123456789";
+        for (int shift = 56; shift >= 0; shift -= 8)
+            key.push_back(static_cast<char>((i >> shift) & 0xff));
+        keys.push_back(std::move(key));
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+    return keys;
+}
+
+template <typename Map>
+Map makeMap(const std::vector<std::string>& keys) {
+    Map map;
+    for (const auto& key : keys)
+        map.insert(typename Map::value_type(key, std::string(100, 'x')));
+    return map;
+}
+
+template <typename Map>
+void BM_Insert(benchmark::State& state) {
+    auto keys = makeKeys(state.range(0));
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(makeMap<Map>(keys));
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template <typename Map>
+void BM_Find(benchmark::State& state) {
+    auto keys = makeKeys(state.range(0));
+    Map map = makeMap<Map>(keys);
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(map.find(keys[i++ % keys.size()]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Map>
+void BM_Iterate(benchmark::State& state) {
+    Map map = makeMap<Map>(makeKeys(state.range(0)));
+    while (state.KeepRunning()) {
+        size_t bytes = 0;
+        for (const auto& entry : map)
+            bytes += entry.second.size();
+        benchmark::DoNotOptimize(bytes);
+    }
+    state.SetItemsProcessed(state.iterations() * map.size());
+}
+
+/**
+ * A write in a new unit of work: take a private copy of the committed data and modify it.
+ */
+template <typename Map>
+void BM_CopyAndInsert(benchmark::State& state) {
+    auto keys = makeKeys(state.range(0) + 1);
+    std::string newKey = keys.back();
+    keys.pop_back();
+    const Map master = makeMap<Map>(keys);
+    while (state.KeepRunning()) {
+        Map workingCopy(master);
+        workingCopy.insert(typename Map::value_type(newKey, std::string(100, 'y')));
+        benchmark::DoNotOptimize(workingCopy);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * Committing a unit of work that inserted one key while another unit of work, committed first,
+ * inserted a different one.
+ */
+void BM_Merge3(benchmark::State& state) {
+    auto keys = makeKeys(state.range(0) + 2);
+    std::string thisKey = keys.back();
+    keys.pop_back();
+    std::string otherKey = keys.back();
+    keys.pop_back();
+
+    StringStore base = makeMap<StringStore>(keys);
+    StringStore current = base;
+    current.insert(StringStore::value_type(thisKey, std::string(100, 'y')));
+    StringStore other = base;
+    other.insert(StringStore::value_type(otherKey, std::string(100, 'z')));
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(current.merge3(base, other));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_Insert, StdMap)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_Insert, StringStore)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_Find, StdMap)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_Find, StringStore)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_Iterate, StdMap)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_Iterate, StringStore)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_CopyAndInsert, StdMap)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_CopyAndInsert, StringStore)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_Merge3)->Arg(1000)->Arg(100000);
+
+}  // namespace
+}  // namespace biggie
+}  // namespace mongo
@@ -28,6 +28,9 @@
 
 #include "mongo/platform/basic.h"
 
+#include <map>
+#include <random>
+
 #include "mongo/db/storage/biggie/store.h"
 
 #include "mongo/unittest/unittest.h"
@@ -215,6 +218,28 @@ TEST_F(StoreTest, MergeDeletions) {
     ASSERT_TRUE(merged == expected);
 }
 
+TEST_F(StoreTest, MergeDeletionDeletion) {
+    value_type value1 = std::make_pair("1", "foo");
+    value_type value2 = std::make_pair("2", "moo");
+    value_type value3 = std::make_pair("3", "bar");
+
+    thisStore.insert(value_type(value1));
+    thisStore.insert(value_type(value3));
+
+    otherStore.insert(value_type(value1));
+
+    baseStore.insert(value_type(value1));
+    baseStore.insert(value_type(value2));
+    baseStore.insert(value_type(value3));
+
+    expected.insert(value_type(value1));
+
+    // "2" is deleted on both sides, which is not a conflict.
+    StringStore merged = thisStore.merge3(baseStore, otherStore);
+
+    ASSERT_TRUE(merged == expected);
+}
+
 TEST_F(StoreTest, MergeInsertions) {
     value_type value1 = std::make_pair("1", "foo");
     value_type value2 = std::make_pair("2", "foo");
@@ -397,6 +422,167 @@ TEST_F(StoreTest, ReverseIteratorTest) {
     }
     ASSERT_EQ(cur, 0);
 }
+
+TEST_F(StoreTest, UpdateTest) {
+    value_type value1 = std::make_pair("1", "foo");
+    value_type value2 = std::make_pair("1", "barbaz");
+
+    ASSERT_TRUE(thisStore.update(value_type(value1)) == thisStore.end());
+    ASSERT_TRUE(thisStore.empty());
+
+    thisStore.insert(value_type(value1));
+    StringStore::iterator iter = thisStore.update(value_type(value2));
+    ASSERT_TRUE(*iter == value2);
+    ASSERT_TRUE(*thisStore.find("1") == value2);
+    ASSERT_EQ(thisStore.size(), StringStore::size_type(1));
+    ASSERT_EQ(thisStore.dataSize(), StringStore::size_type(6));
+}
+
+TEST_F(StoreTest, CopyIsSnapshotTest) {
+    value_type value1 = std::make_pair("1", "foo");
+    value_type value2 = std::make_pair("2", "bar");
+    value_type value3 = std::make_pair("3", "baz");
+
+    thisStore.insert(value_type(value1));
+    thisStore.insert(value_type(value2));
+
+    StringStore snapshot(thisStore);
+    StringStore::iterator iter = thisStore.begin();
+
+    thisStore.insert(value_type(value3));
+    thisStore.erase(value1.first);
+    thisStore.update(std::make_pair("2", "qux"));
+
+    expected.insert(value_type(value1));
+    expected.insert(value_type(value2));
+    ASSERT_TRUE(snapshot == expected);
+
+    // Iterators keep walking the version they were created from.
+    ASSERT_TRUE(*iter == value1);
+    ASSERT_TRUE(*++iter == value2);
+    ASSERT_TRUE(++iter == snapshot.end());
+
+    ASSERT_EQ(thisStore.size(), StringStore::size_type(2));
+    ASSERT_EQ(thisStore.find("2")->second, "qux");
+    ASSERT_TRUE(thisStore.find("1") == thisStore.end());
+}
+
+TEST_F(StoreTest, PrefixKeysTest) {
+    std::vector<std::string> keys = {"", "a", "ab", "abc", "abd", "b", "ba", "bab"};
+    for (auto it = keys.rbegin(); it != keys.rend(); ++it) {
+        thisStore.insert(std::make_pair(*it, *it));
+    }
+
+    ASSERT_EQ(thisStore.size(), keys.size());
+    auto iter = thisStore.begin();
+    for (const auto& key : keys) {
+        ASSERT_EQ(iter->first, key);
+        ++iter;
+    }
+    ASSERT_TRUE(iter == thisStore.end());
+
+    ASSERT_EQ(thisStore.lower_bound("aa")->first, "ab");
+    ASSERT_EQ(thisStore.lower_bound("abb")->first, "abc");
+    ASSERT_EQ(thisStore.upper_bound("abd")->first, "b");
+    ASSERT_EQ(thisStore.upper_bound("")->first, "a");
+    ASSERT_TRUE(thisStore.lower_bound("bb") == thisStore.end());
+    ASSERT_TRUE(thisStore.find("ac") == thisStore.end());
+    ASSERT_TRUE(thisStore.find("aba") == thisStore.end());
+
+    // Removing the keys that split edges has to leave the remaining keys reachable.
+    ASSERT_EQ(thisStore.erase("ab"), StringStore::size_type(1));
+    ASSERT_EQ(thisStore.erase("abc"), StringStore::size_type(1));
+    ASSERT_EQ(thisStore.erase("b"), StringStore::size_type(1));
+    ASSERT_EQ(thisStore.erase("b"), StringStore::size_type(0));
+
+    std::vector<std::string> remaining = {"", "a", "abd", "ba", "bab"};
+    iter = thisStore.begin();
+    for (const auto& key : remaining) {
+        ASSERT_EQ(iter->first, key);
+        ASSERT_TRUE(thisStore.find(key) == iter);
+        ++iter;
+    }
+    ASSERT_TRUE(iter == thisStore.end());
+}
+
+TEST_F(StoreTest, MergeAfterRestructuringTest) {
+    // Both sides change the shape of the tree around "ab", in different subtrees.
+    baseStore.insert(std::make_pair("abc", "1"));
+    baseStore.insert(std::make_pair("abd", "2"));
+    baseStore.insert(std::make_pair("x", "3"));
+
+    thisStore = baseStore;
+    thisStore.insert(std::make_pair("ab", "4"));
+    thisStore.erase("abd");
+
+    otherStore = baseStore;
+    otherStore.insert(std::make_pair("abcd", "5"));
+    otherStore.erase("x");
+
+    expected.insert(std::make_pair("ab", "4"));
+    expected.insert(std::make_pair("abc", "1"));
+    expected.insert(std::make_pair("abcd", "5"));
+
+    StringStore merged = thisStore.merge3(baseStore, otherStore);
+    ASSERT_TRUE(merged == expected);
+    ASSERT_EQ(merged.size(), expected.size());
+    ASSERT_EQ(merged.dataSize(), expected.dataSize());
+}
+
+TEST_F(StoreTest, RandomOperationsMatchStdMapTest) {
+    std::mt19937 rng(12345);
+    auto randomKey = [&rng] {
+        const char alphabet[] = {'\x00', '\x01', 'a', 'b', '\xff'};
+        std::string key;
+        for (size_t len = rng() % 6; len > 0; --len)
+            key.push_back(alphabet[rng() % sizeof(alphabet)]);
+        return key;
+    };
+
+    std::map<std::string, std::string> reference;
+    for (int i = 0; i < 5000; ++i) {
+        std::string key = randomKey();
+        std::string value = std::to_string(rng() % 1000);
+        switch (rng() % 3) {
+            case 0:
+                ASSERT_EQ(thisStore.insert(std::make_pair(key, value)).second,
+                          reference.insert(std::make_pair(key, value)).second);
+                break;
+            case 1:
+                ASSERT_EQ(thisStore.erase(key), reference.erase(key));
+                break;
+            case 2: {
+                auto lower = thisStore.lower_bound(key);
+                auto refLower = reference.lower_bound(key);
+                ASSERT_EQ(lower == thisStore.end(), refLower == reference.end());
+                if (refLower != reference.end())
+                    ASSERT_EQ(lower->first, refLower->first);
+
+                auto upper = thisStore.upper_bound(key);
+                auto refUpper = reference.upper_bound(key);
+                ASSERT_EQ(upper == thisStore.end(), refUpper == reference.end());
+                if (refUpper != reference.end())
+                    ASSERT_EQ(upper->first, refUpper->first);
+                break;
+            }
+        }
+    }
+
+    ASSERT_EQ(thisStore.size(), reference.size());
+    auto iter = thisStore.begin();
+    for (const auto& entry : reference) {
+        ASSERT_TRUE(*iter == entry);
+        ++iter;
+    }
+    ASSERT_TRUE(iter == thisStore.end());
+
+    auto reverseIter = thisStore.rbegin();
+    for (auto refIter = reference.rbegin(); refIter != reference.rend(); ++refIter) {
+        ASSERT_TRUE(*reverseIter == *refIter);
+        ++reverseIter;
+    }
+    ASSERT_TRUE(reverseIter == thisStore.rend());
+}
 }  // namespace
 }  // namespace biggie
 }  // namespace mongo
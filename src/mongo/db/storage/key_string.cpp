@@ -2105,25 +2105,46 @@ std::string KeyString::toString() const {
 }
 
 int KeyString::compare(const KeyString& other) const {
-    int a = getSize();
-    int b = other.getSize();
-
-    int min = std::min(a, b);
+    return compare(getBuffer(), getSize(), other.getBuffer(), other.getSize());
+}
 
-    int cmp = memcmp(getBuffer(), other.getBuffer(), min);
+namespace {
+uint64_t loadBigEndian64(const char* ptr) {
+    return endian::bigToNative(ConstDataView(ptr).read<uint64_t>());
+}
+}  // namespace
 
-    if (cmp) {
-        if (cmp < 0)
-            return -1;
-        return 1;
+int KeyString::compare(const char* lhs, size_t lhsSize, const char* rhs, size_t rhsSize) {
+    const size_t min = std::min(lhsSize, rhsSize);
+
+    // Most keys are short or differ early, where a call to memcmp costs more than the comparison
+    // itself. Compare up to the first 16 bytes as big-endian words inline, which orders them the
+    // same way memcmp would, and leave anything longer to memcmp, which is vectorized.
+    if (min >= 8) {
+        uint64_t a = loadBigEndian64(lhs);
+        uint64_t b = loadBigEndian64(rhs);
+        if (a != b)
+            return a < b ? -1 : 1;
+
+        if (min <= 16) {
+            // Compare the last 8 bytes of the common prefix, which may overlap the first 8.
+            a = loadBigEndian64(lhs + min - 8);
+            b = loadBigEndian64(rhs + min - 8);
+            if (a != b)
+                return a < b ? -1 : 1;
+        } else if (int cmp = memcmp(lhs + 8, rhs + 8, min - 8)) {
+            return cmp < 0 ? -1 : 1;
+        }
+    } else if (int cmp = memcmp(lhs, rhs, min)) {
+        return cmp < 0 ? -1 : 1;
     }
 
     // keys match
 
-    if (a == b)
+    if (lhsSize == rhsSize)
         return 0;
 
-    return a < b ? -1 : 1;
+    return lhsSize < rhsSize ? -1 : 1;
 }
 
 void KeyString::TypeBits::resetFromBuffer(BufReader* reader) {
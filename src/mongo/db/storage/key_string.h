@@ -363,6 +363,12 @@ public:
 
     int compare(const KeyString& other) const;
 
+    /**
+     * Compares two KeyString buffers byte-wise, with a shorter buffer ordering before any longer
+     * buffer it is a prefix of. Returns -1, 0 or 1.
+     */
+    static int compare(const char* lhs, size_t lhsSize, const char* rhs, size_t rhsSize);
+
     /**
      * @return a hex encoding of this key
      */
@@ -0,0 +1,129 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/storage/key_string.h"
+#include "mongo/stdx/memory.h"
+
+namespace mongo {
+namespace {
+
+const KeyString::Version kVersion = KeyString::Version::V1;
+const Ordering kOrdering = Ordering::make(BSON("tenant" << 1 << "ts" << -1 << "seq" << 1));
+const int kNumKeys = 1000;
+
+/**
+ * Returns index keys shaped like {tenant: <string>, ts: <date>, seq: <int>}, in index order. The
+ * argument is the length of the tenant string, which every 100 consecutive keys share.
+ */
+std::vector<BSONObj> makeKeys(int tenantLength) {
+    std::vector<BSONObj> keys;
+    for (int i = 0; i < kNumKeys; i++) {
+        std::string tenant(tenantLength, 't');
+        tenant.back() = 'a' + (i / 100);
+        keys.push_back(BSON("" << tenant << "" << Date_t::fromMillisSinceEpoch(1000000 - i) << ""
+                               << i % 7));
+    }
+    return keys;
+}
+
+using KeyStrings = std::vector<std::unique_ptr<KeyString>>;
+
+KeyStrings makeKeyStrings(int tenantLength) {
+    KeyStrings keyStrings;
+    for (auto&& key : makeKeys(tenantLength)) {
+        keyStrings.push_back(stdx::make_unique<KeyString>(
+            kVersion, key, kOrdering, RecordId(keyStrings.size() + 1)));
+    }
+    std::sort(keyStrings.begin(), keyStrings.end(), [](const auto& lhs, const auto& rhs) {
+        return *lhs < *rhs;
+    });
+    return keyStrings;
+}
+
+size_t totalSize(const KeyStrings& keyStrings) {
+    size_t bytes = 0;
+    for (auto&& ks : keyStrings) {
+        bytes += ks->getSize();
+    }
+    return bytes;
+}
+
+void BM_KeyStringEncode(benchmark::State& state) {
+    const auto keys = makeKeys(state.range(0));
+    KeyString ks(kVersion);
+    size_t bytes = 0;
+    for (auto keepRunning : state) {
+        for (auto&& key : keys) {
+            ks.resetToKey(key, kOrdering, RecordId(1));
+            bytes += ks.getSize();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+    state.SetBytesProcessed(bytes);
+}
+
+void BM_KeyStringDecode(benchmark::State& state) {
+    const auto keyStrings = makeKeyStrings(state.range(0));
+    for (auto keepRunning : state) {
+        for (auto&& ks : keyStrings) {
+            benchmark::DoNotOptimize(
+                KeyString::toBson(ks->getBuffer(), ks->getSize(), kOrdering, ks->getTypeBits()));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * keyStrings.size());
+    state.SetBytesProcessed(state.iterations() * totalSize(keyStrings));
+}
+
+/**
+ * Compares each key with the next in index order, which is the comparison a B-tree or merge does
+ * most often: the keys share a long prefix and differ near the end.
+ */
+void BM_KeyStringCompare(benchmark::State& state) {
+    const auto keyStrings = makeKeyStrings(state.range(0));
+    for (auto keepRunning : state) {
+        for (size_t i = 1; i < keyStrings.size(); i++) {
+            benchmark::DoNotOptimize(keyStrings[i - 1]->compare(*keyStrings[i]));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * (keyStrings.size() - 1));
+}
+
+BENCHMARK(BM_KeyStringEncode)->Arg(8)->Arg(64);
+BENCHMARK(BM_KeyStringDecode)->Arg(8)->Arg(64);
+BENCHMARK(BM_KeyStringCompare)->Arg(8)->Arg(64)->Arg(256);
+
+}  // namespace
+}  // namespace mongo
@@ -1465,3 +1465,33 @@ DEATH_TEST(KeyStringTest, ToBsonPromotesAssertionsToTerminate, "terminate() call
     KeyString::TypeBits typeBits(KeyString::Version::V1);
     KeyString::toBson(invalidString, sizeof(invalidString), ALL_ASCENDING, typeBits);
 }
+
+TEST(KeyStringCompare, MatchesMemcmpOrderForAllLengths) {
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    for (size_t len = 0; len <= 40; len++) {
+        for (size_t diffAt = 0; diffAt <= len; diffAt++) {
+            std::string lhs(len, '\0');
+            for (auto& c : lhs) {
+                c = static_cast<char>(byte(gen));
+            }
+            std::string rhs = lhs;
+            if (diffAt < len) {
+                rhs[diffAt] = static_cast<char>(byte(gen));
+            }
+
+            // Compare against every prefix of rhs as well, to cover keys of different lengths.
+            for (size_t rhsLen = 0; rhsLen <= len; rhsLen++) {
+                int expected = memcmp(lhs.data(), rhs.data(), rhsLen);
+                if (expected == 0) {
+                    expected = len == rhsLen ? 0 : 1;
+                }
+                expected = expected < 0 ? -1 : (expected > 0 ? 1 : 0);
+
+                ASSERT_EQ(expected, KeyString::compare(lhs.data(), len, rhs.data(), rhsLen));
+                ASSERT_EQ(-expected, KeyString::compare(rhs.data(), rhsLen, lhs.data(), len));
+            }
+        }
+    }
+}
@@ -30,6 +30,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <boost/optional.hpp>
 
 #include "mongo/base/owned_pointer_vector.h"
@@ -244,6 +245,18 @@ public:
      */
     virtual boost::optional<Record> seekExact(const RecordId& id) = 0;
 
+    /**
+     * Positions a forward cursor so that the next call to next() returns the first Record whose
+     * id is greater than or equal to 'start', which need not exist. The position survives
+     * save() and restore() like one reached with next().
+     *
+     * Returns false, leaving the cursor where it was, if the cursor cannot seek this way. Callers
+     * must then read from the beginning and skip the records before 'start'.
+     */
+    virtual bool seekAtOrAfter(const RecordId& start) {
+        return false;
+    }
+
     /**
      * Prepares for state changes in underlying data without necessarily saving the current
      * state.
@@ -487,6 +500,43 @@ public:
         return {};
     }
 
+    /**
+     * Returns increasing RecordIds that split this record store into at most 'numRanges' ranges
+     * holding roughly equal numbers of records, so that the ranges can be scanned independently,
+     * for example by CollectionScans with 'minRecord' and 'maxRecord' set. The ids need not exist.
+     * Returns an empty vector if the record store is empty or cannot be split.
+     *
+     * The default implementation samples the record store with getRandomCursor(). WiredTiger's
+     * random cursor descends the B-tree, so this costs a few page reads per sample.
+     */
+    virtual std::vector<RecordId> getRangeSplitPoints(OperationContext* opCtx,
+                                                      size_t numRanges) const {
+        // Enough samples per range that the quantiles are usually within a few percent.
+        const size_t kSamplesPerRange = 32;
+
+        auto cursor = numRanges > 1 ? getRandomCursor(opCtx) : nullptr;
+        if (!cursor)
+            return {};
+
+        std::vector<RecordId> sample;
+        while (sample.size() < numRanges * kSamplesPerRange) {
+            auto record = cursor->next();
+            if (!record)
+                break;
+            sample.push_back(record->id);
+        }
+        std::sort(sample.begin(), sample.end());
+        sample.erase(std::unique(sample.begin(), sample.end()), sample.end());
+
+        std::vector<RecordId> splitPoints;
+        for (size_t i = 1; i < numRanges && !sample.empty(); ++i) {
+            const RecordId& id = sample[i * sample.size() / numRanges];
+            if (splitPoints.empty() || splitPoints.back() < id)
+                splitPoints.push_back(id);
+        }
+        return splitPoints;
+    }
+
     // higher level
 
 
@@ -1975,6 +1975,44 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::seekExact(const RecordI
     return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
 }
 
+bool WiredTigerRecordStoreCursorBase::seekAtOrAfter(const RecordId& start) {
+    if (!_forward)
+        return false;
+
+    _skipNextAdvance = false;
+    _eof = false;
+    // Act as if the record just before 'start' was returned, so that next() and restore() carry
+    // on from 'start'. A null id would mean an unpositioned cursor, which already starts there.
+    _lastReturnedId = RecordId(std::max(start.repr() - 1, RecordId().repr()));
+    WT_CURSOR* c = _cursor->get();
+    if (_lastReturnedId.isNull()) {
+        invariantWTOK(c->reset(c));
+        return true;
+    }
+
+    setKey(c, start);
+    int cmp;
+    int ret = wiredTigerPrepareConflictRetry(_opCtx, [&] { return c->search_near(c, &cmp); });
+    if (ret == 0 && cmp < 0) {
+        // Landed on the record before 'start'.
+        ret = wiredTigerPrepareConflictRetry(_opCtx, [&] { return c->next(c); });
+    }
+    if (ret == WT_NOTFOUND) {
+        _eof = true;
+        return true;
+    }
+    invariantWTOK(ret);
+
+    RecordId id;
+    if (hasWrongPrefix(c, &id)) {
+        _eof = true;
+        return true;
+    }
+
+    // Return the record we landed on from the next call to next().
+    _skipNextAdvance = true;
+    return true;
+}
 
 void WiredTigerRecordStoreCursorBase::save() {
     try {
@@ -34,6 +34,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 #include <wiredtiger.h>
 
 #include "mongo/db/catalog/collection_options.h"
@@ -433,6 +434,8 @@ public:
 
     boost::optional<Record> seekExact(const RecordId& id);
 
+    bool seekAtOrAfter(const RecordId& start) override;
+
     void save();
 
     void saveUnpositioned();
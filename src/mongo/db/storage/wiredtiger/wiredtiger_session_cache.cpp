@@ -45,6 +45,7 @@
 #include "mongo/stdx/memory.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/scopeguard.h"
 
 namespace mongo {
@@ -192,11 +193,34 @@ uint64_t WiredTigerSession::genTableId() {
 
 // -----------------------
 
+namespace {
+
+// Upper bound on the number of session cache partitions, whatever the number of cores.
+const size_t kMaxPartitions = 64;
+
+// Number of partitions, starting with the thread's own, that getSession() looks in for a cached
+// session before opening a new one.
+const size_t kMaxPartitionsProbed = 4;
+
+size_t numPartitions() {
+    return std::max<size_t>(1,
+                            std::min<size_t>(kMaxPartitions, ProcessInfo::getNumAvailableCores()));
+}
+
+}  // namespace
+
 WiredTigerSessionCache::WiredTigerSessionCache(WiredTigerKVEngine* engine)
-    : _engine(engine), _conn(engine->getConnection()), _shuttingDown(0) {}
+    : WiredTigerSessionCache(engine->getConnection()) {
+    _engine = engine;
+}
 
 WiredTigerSessionCache::WiredTigerSessionCache(WT_CONNECTION* conn)
-    : _engine(NULL), _conn(conn), _shuttingDown(0) {}
+    : _engine(NULL), _conn(conn), _shuttingDown(0) {
+    const size_t partitions = numPartitions();
+    for (size_t i = 0; i < partitions; i++) {
+        _partitions.push_back(stdx::make_unique<Partition>());
+    }
+}
 
 WiredTigerSessionCache::~WiredTigerSessionCache() {
     shuttingDown();
@@ -316,9 +340,13 @@ void WiredTigerSessionCache::notifyPreparedUnitOfWorkHasCommittedOrAborted() {
 
 
 void WiredTigerSessionCache::closeAllCursors(const std::string& uri) {
-    stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-    for (SessionCache::iterator i = _sessions.begin(); i != _sessions.end(); i++) {
-        (*i)->closeAllCursors(uri);
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> lock(partition->lock);
+        for (SessionCache::iterator i = partition->sessions.begin();
+             i != partition->sessions.end();
+             i++) {
+            (*i)->closeAllCursors(uri);
+        }
     }
 }
 
@@ -326,24 +354,32 @@ void WiredTigerSessionCache::closeCursorsForQueuedDrops() {
     // Increment the cursor epoch so that all cursors from this epoch are closed.
     _cursorEpoch.fetchAndAdd(1);
 
-    stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-    for (SessionCache::iterator i = _sessions.begin(); i != _sessions.end(); i++) {
-        (*i)->closeCursorsForQueuedDrops(_engine);
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<stdx::mutex> lock(partition->lock);
+        for (SessionCache::iterator i = partition->sessions.begin();
+             i != partition->sessions.end();
+             i++) {
+            (*i)->closeCursorsForQueuedDrops(_engine);
+        }
     }
 }
 
 void WiredTigerSessionCache::closeAll() {
-    // Increment the epoch as we are now closing all sessions with this epoch.
-    SessionCache swap;
+    // Increment the epoch as we are now closing all sessions with this epoch. Once it has moved
+    // on, releaseSession() no longer caches sessions from the old epoch and getSession() no
+    // longer hands them out, so emptying the partitions one at a time afterwards is enough.
+    _epoch.fetchAndAdd(1);
 
-    {
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-        _epoch.fetchAndAdd(1);
-        _sessions.swap(swap);
-    }
+    for (auto&& partition : _partitions) {
+        SessionCache swap;
+        {
+            stdx::lock_guard<stdx::mutex> lock(partition->lock);
+            partition->sessions.swap(swap);
+        }
 
-    for (SessionCache::iterator i = swap.begin(); i != swap.end(); i++) {
-        delete (*i);
+        for (SessionCache::iterator i = swap.begin(); i != swap.end(); i++) {
+            delete (*i);
+        }
     }
 }
 
@@ -356,15 +392,31 @@ UniqueWiredTigerSession WiredTigerSessionCache::getSession() {
     // operations should be allowed to start.
     invariant(!(_shuttingDown.loadRelaxed() & kShuttingDownMask));
 
-    {
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
-        if (!_sessions.empty()) {
+    // Start with this thread's own partition, and take from a few neighbouring ones before opening
+    // a new session. Looking in every partition would make each miss lock all of them.
+    const size_t home = _homePartition();
+    const size_t probed = std::min(kMaxPartitionsProbed, _partitions.size());
+    for (size_t n = 0; n < probed; n++) {
+        Partition& partition = *_partitions[(home + n) % _partitions.size()];
+        WiredTigerSession* cachedSession = nullptr;
+        {
+            stdx::lock_guard<stdx::mutex> lock(partition.lock);
+            if (partition.sessions.empty()) {
+                continue;
+            }
+
             // Get the most recently used session so that if we discard sessions, we're
             // discarding older ones
-            WiredTigerSession* cachedSession = _sessions.back();
-            _sessions.pop_back();
-            return UniqueWiredTigerSession(cachedSession);
+            cachedSession = partition.sessions.back();
+            partition.sessions.pop_back();
+        }
+
+        if (cachedSession->_getEpoch() != _epoch.load()) {
+            // closeAll() is emptying the partitions, and has not reached this one yet.
+            delete cachedSession;
+            continue;
         }
+        return UniqueWiredTigerSession(cachedSession);
     }
 
     // Outside of the cache partition lock, but on release will be put back on the cache
@@ -421,10 +473,11 @@ void WiredTigerSessionCache::releaseSession(WiredTigerSession* session) {
     session->dropQueuedIdentsAtSessionEndAllowed(true);
 
     if (session->_getEpoch() == currentEpoch) {  // check outside of lock to reduce contention
-        stdx::lock_guard<stdx::mutex> lock(_cacheLock);
+        Partition& partition = *_partitions[_homePartition()];
+        stdx::lock_guard<stdx::mutex> lock(partition.lock);
         if (session->_getEpoch() == _epoch.load()) {  // recheck inside the lock for correctness
             returnedToCache = true;
-            _sessions.push_back(session);
+            partition.sessions.push_back(session);
         }
     } else
         invariant(session->_getEpoch() < currentEpoch);
@@ -437,6 +490,13 @@ void WiredTigerSessionCache::releaseSession(WiredTigerSession* session) {
 }
 
 
+size_t WiredTigerSessionCache::_homePartition() const {
+    // Threads are assigned partitions round-robin the first time they use a session cache.
+    static AtomicUInt32 nextThreadPartition;
+    thread_local const uint32_t threadPartition = nextThreadPartition.fetchAndAdd(1);
+    return threadPartition % _partitions.size();
+}
+
 void WiredTigerSessionCache::setJournalListener(JournalListener* jl) {
     stdx::unique_lock<stdx::mutex> lk(_journalListenerMutex);
     _journalListener = jl;
@@ -32,7 +32,9 @@
 #pragma once
 
 #include <list>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <wiredtiger.h>
 
@@ -263,9 +265,21 @@ private:
     AtomicUInt32 _shuttingDown;
     static const uint32_t kShuttingDownMask = 1 << 31;
 
-    stdx::mutex _cacheLock;
+    // Idle sessions are spread across partitions, each with its own lock, so that threads getting
+    // and releasing sessions concurrently rarely contend. A thread releases sessions to its home
+    // partition and gets them from there first, falling back to the other partitions before
+    // opening a new session.
     typedef std::vector<WiredTigerSession*> SessionCache;
-    SessionCache _sessions;
+    struct Partition {
+        stdx::mutex lock;
+        SessionCache sessions;
+    };
+    std::vector<std::unique_ptr<Partition>> _partitions;
+
+    /**
+     * Returns the partition the calling thread should use first.
+     */
+    size_t _homePartition() const;
 
     // Bumped when all open sessions need to be closed
     AtomicUInt64 _epoch;  // atomic so we can check it outside of the lock
@@ -0,0 +1,113 @@
+/**
+ * Copyright (C) 2018 MongoDB, Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <wiredtiger.h>
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/unittest/temp_dir.h"
+
+namespace mongo {
+namespace {
+
+const int kMaxPerfThreads = 16;
+
+/**
+ * Owns a WiredTiger connection on a temporary directory and a session cache on top of it, shared
+ * by every thread of a benchmark run.
+ */
+class SessionCacheHarness {
+public:
+    SessionCacheHarness() : _dbpath("wt_session_cache_bm") {
+        invariantWTOK(
+            wiredtiger_open(_dbpath.path().c_str(), NULL, "create,cache_size=100M", &_conn));
+        _sessionCache = stdx::make_unique<WiredTigerSessionCache>(_conn);
+    }
+
+    ~SessionCacheHarness() {
+        _sessionCache.reset();
+        _conn->close(_conn, NULL);
+    }
+
+    WiredTigerSessionCache* getSessionCache() const {
+        return _sessionCache.get();
+    }
+
+private:
+    unittest::TempDir _dbpath;
+    WT_CONNECTION* _conn = nullptr;
+    std::unique_ptr<WiredTigerSessionCache> _sessionCache;
+};
+
+std::unique_ptr<SessionCacheHarness> harness;
+
+void BM_GetReleaseSession(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        harness = stdx::make_unique<SessionCacheHarness>();
+    }
+
+    for (auto keepRunning : state) {
+        auto session = harness->getSessionCache()->getSession();
+        benchmark::DoNotOptimize(session.get());
+    }
+
+    if (state.thread_index == 0) {
+        harness.reset();
+    }
+}
+
+void BM_GetReleaseSessionWithCloseAll(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        harness = stdx::make_unique<SessionCacheHarness>();
+    }
+
+    uint64_t iterations = 0;
+    for (auto keepRunning : state) {
+        // Periodically invalidate every cached session, as happens when the storage engine
+        // discards its sessions, so that the cost of repopulating the cache is included.
+        if (state.thread_index == 0 && ++iterations % 1000 == 0) {
+            harness->getSessionCache()->closeAll();
+        }
+        auto session = harness->getSessionCache()->getSession();
+        benchmark::DoNotOptimize(session.get());
+    }
+
+    if (state.thread_index == 0) {
+        harness.reset();
+    }
+}
+
+BENCHMARK(BM_GetReleaseSession)->ThreadRange(1, kMaxPerfThreads);
+BENCHMARK(BM_GetReleaseSessionWithCloseAll)->ThreadRange(1, kMaxPerfThreads);
+
+}  // namespace
+}  // namespace mongo
@@ -43,9 +43,11 @@
 #include "mongo/db/pipeline/document_value_test_util.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/pipeline/pipeline.h"
+#include "mongo/db/query/column_cache.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/mock_yield_policies.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/stage_builder.h"
 #include "mongo/dbtests/dbtests.h"
@@ -518,5 +520,213 @@ TEST_F(DocumentSourceCursorTest, NormalCursorShouldErrorAfterBeingKilled) {
     ASSERT_THROWS_CODE(cursor->getNext().isEOF(), AssertionException, ErrorCodes::QueryPlanKilled);
 }
 
+/**
+ * Runs 'pipeline' against the test collection and returns its results, which must fit in the
+ * first batch.
+ */
+BSONObj runAggregate(DBDirectClient* client, const BSONArray& pipeline) {
+    BSONObj result;
+    ASSERT_TRUE(client->runCommand(nss.db().toString(),
+                                   BSON("aggregate" << nss.coll() << "pipeline" << pipeline
+                                                    << "cursor"
+                                                    << BSONObj()),
+                                   result))
+        << result;
+    ASSERT_EQUALS(result["cursor"]["id"].numberLong(), 0);
+    return result["cursor"]["firstBatch"].Obj().getOwned();
+}
+
+TEST_F(DocumentSourceCursorTest, GroupFromCachedColumnsMatchesCollectionScan) {
+    client.insert(nss.ns(), BSON("_id" << 0 << "a" << BSON_ARRAY(1 << 2) << "b" << 5));
+    client.insert(nss.ns(), BSON("_id" << 1 << "b" << 7));
+    for (int i = 2; i < 100; i++) {
+        client.insert(nss.ns(),
+                      BSON("_id" << i << "a" << i % 3 << "b" << i << "c"
+                                 << "unused"));
+    }
+
+    const std::vector<BSONArray> pipelines{
+        BSON_ARRAY(BSON("$group" << BSON("_id"
+                                         << "$a"
+                                         << "total"
+                                         << BSON("$sum"
+                                                 << "$b")))
+                   << BSON("$sort" << BSON("_id" << 1))),
+        BSON_ARRAY(BSON("$match" << BSON("a" << 1 << "b" << BSON("$lt" << 50)))
+                   << BSON("$group" << BSON("_id" << BSONNULL << "n" << BSON("$sum" << 1)))),
+        BSON_ARRAY(BSON("$match" << BSON("$or" << BSON_ARRAY(BSON("a" << BSONNULL)
+                                                             << BSON("b" << BSON("$gt" << 95)))))
+                   << BSON("$group" << BSON("_id"
+                                            << "$a"
+                                            << "ids"
+                                            << BSON("$push"
+                                                    << "$_id")))
+                   << BSON("$sort" << BSON("_id" << 1)))};
+
+    std::vector<BSONObj> expected;
+    for (auto&& pipeline : pipelines) {
+        expected.push_back(runAggregate(&client, pipeline));
+    }
+
+    internalQueryColumnCacheMaxSizeMB.store(16);
+    ON_BLOCK_EXIT([] { internalQueryColumnCacheMaxSizeMB.store(0); });
+
+    // Run every pipeline twice, so that both building the columns and reading cached ones is
+    // covered.
+    for (int run = 0; run < 2; run++) {
+        for (size_t i = 0; i < pipelines.size(); i++) {
+            ASSERT_BSONOBJ_EQ(runAggregate(&client, pipelines[i]), expected[i]);
+        }
+    }
+}
+
+TEST_F(DocumentSourceCursorTest, GroupFromChangedColumnsMatchesCollectionScan) {
+    for (int i = 0; i < 100; i++) {
+        client.insert(nss.ns(), BSON("_id" << i << "a" << i % 3 << "b" << i));
+    }
+
+    const auto pipeline = BSON_ARRAY(BSON("$match" << BSON("b" << BSON("$gte" << 10)))
+                                     << BSON("$group" << BSON("_id"
+                                                              << "$a"
+                                                              << "ids"
+                                                              << BSON("$push"
+                                                                      << "$_id")))
+                                     << BSON("$sort" << BSON("_id" << 1)));
+
+    internalQueryColumnCacheMaxSizeMB.store(16);
+    ON_BLOCK_EXIT([] { internalQueryColumnCacheMaxSizeMB.store(0); });
+    runAggregate(&client, pipeline);
+
+    // Change some documents after the columns are cached, and check that the column scan returns
+    // their new values in the order a collection scan would.
+    client.update(nss.ns(),
+                  BSON("_id" << BSON("$lt" << 20)),
+                  BSON("$inc" << BSON("a" << 1)),
+                  false,
+                  true);
+    client.remove(nss.ns(), BSON("_id" << BSON("$gte" << 90)));
+    client.insert(nss.ns(), BSON("_id" << 100 << "a" << 5 << "b" << 100));
+    const BSONObj withColumns = runAggregate(&client, pipeline);
+
+    internalQueryColumnCacheMaxSizeMB.store(0);
+    ASSERT_BSONOBJ_EQ(withColumns, runAggregate(&client, pipeline));
+}
+
+TEST_F(DocumentSourceCursorTest, WritesMarkCachedRowsAsChanged) {
+    internalQueryColumnCacheMaxSizeMB.store(16);
+    ON_BLOCK_EXIT([] { internalQueryColumnCacheMaxSizeMB.store(0); });
+
+    client.insert(nss.ns(), BSON("_id" << 0 << "a" << 1));
+    client.insert(nss.ns(), BSON("_id" << 1 << "b" << 2));
+
+    const std::set<std::string> fields{"a"};
+    std::shared_ptr<const ColumnCache::ColumnSet> columns;
+    {
+        AutoGetCollectionForRead readLock(opCtx(), nss);
+        auto cache = readLock.getCollection()->infoCache()->getColumnCache();
+        auto view = cache->getColumns(opCtx(), readLock.getCollection(), fields);
+        ASSERT(view);
+        columns = view->columns;
+        ASSERT_EQUALS(columns->numRows, 2U);
+        ASSERT_BSONELT_EQ(columns->getColumn("a")->at(0), BSON("a" << 1).firstElement());
+        ASSERT(columns->getColumn("a")->at(1).eoo());
+        ASSERT(view->changedIds.empty());
+        ASSERT_EQUALS(view->changedRows->numRows, 0U);
+    }
+
+    client.update(nss.ns(), BSON("_id" << 0), BSON("$set" << BSON("a" << 5)));
+    client.remove(nss.ns(), BSON("_id" << 1));
+    client.insert(nss.ns(), BSON("_id" << 2 << "a" << 3));
+
+    // The cached columns are kept, and the changed documents are read again.
+    AutoGetCollectionForRead readLock(opCtx(), nss);
+    auto cache = readLock.getCollection()->infoCache()->getColumnCache();
+    auto view = cache->getColumns(opCtx(), readLock.getCollection(), fields);
+    ASSERT(view);
+    ASSERT(view->columns == columns);
+    ASSERT_EQUALS(view->changedIds.size(), 3U);
+    ASSERT_EQUALS(view->changedRows->numRows, 2U);
+    ASSERT_BSONELT_EQ(view->changedRows->getColumn("a")->at(0), BSON("a" << 5).firstElement());
+    ASSERT_BSONELT_EQ(view->changedRows->getColumn("a")->at(1), BSON("a" << 3).firstElement());
+}
+
+TEST_F(DocumentSourceCursorTest, ColumnsBuiltAfterAnOlderSnapshotIncludeLaterWrites) {
+    internalQueryColumnCacheMaxSizeMB.store(16);
+    ON_BLOCK_EXIT([] { internalQueryColumnCacheMaxSizeMB.store(0); });
+
+    client.insert(nss.ns(), BSON("_id" << 0 << "a" << 1));
+
+    AutoGetCollectionForRead readLock(opCtx(), nss);
+    // Open a snapshot before the write, as an outer cursor of the same operation would.
+    opCtx()->recoveryUnit()->preallocateSnapshot();
+    {
+        auto otherClient = getGlobalServiceContext()->makeClient("otherClient");
+        AlternativeClientRegion acr(otherClient);
+        auto otherOpCtx = cc().makeOperationContext();
+        DBDirectClient otherDirectClient(otherOpCtx.get());
+        otherDirectClient.update(nss.ns(), BSON("_id" << 0), BSON("$set" << BSON("a" << 2)));
+    }
+
+    auto cache = readLock.getCollection()->infoCache()->getColumnCache();
+    auto view = cache->getColumns(opCtx(), readLock.getCollection(), {"a"});
+    ASSERT(view);
+    ASSERT_EQUALS(view->columns->numRows, 1U);
+    ASSERT_BSONELT_EQ(view->columns->getColumn("a")->at(0), BSON("a" << 2).firstElement());
+    ASSERT(view->changedIds.empty());
+}
+
+TEST_F(DocumentSourceCursorTest, RoundRobinExchangeConsumersScanTheirOwnRanges) {
+    for (int i = 0; i < 1000; i++) {
+        client.insert(nss.ns(), BSON("_id" << i << "a" << i % 10));
+    }
+    {
+        // Storage engines without a random cursor cannot split the collection.
+        AutoGetCollectionForRead readLock(opCtx(), nss);
+        if (readLock.getCollection()->getRecordStore()->getRangeSplitPoints(opCtx(), 4).empty()) {
+            return;
+        }
+    }
+
+    BSONObj result;
+    ASSERT_TRUE(client.runCommand(
+        nss.db().toString(),
+        BSON("aggregate" << nss.coll() << "pipeline"
+                         << BSON_ARRAY(BSON("$match" << BSON("a" << BSON("$lt" << 5)))
+                                       << BSON("$exchange" << BSON("policy"
+                                                                   << "roundrobin"
+                                                                   << "consumers"
+                                                                   << 4
+                                                                   << "bufferSize"
+                                                                   << 1024)))
+                         << "cursor"
+                         << BSON("batchSize" << 0)),
+        result))
+        << result;
+    const auto cursors = result["cursors"].Array();
+    ASSERT_EQUALS(cursors.size(), 4U);
+
+    // Read each consumer to the end before starting on the next. Consumers sharing one producer
+    // could not be read this way: the producer stops as soon as another consumer's small buffer
+    // is full.
+    std::set<int> ids;
+    for (auto&& cursor : cursors) {
+        CursorId cursorId = cursor["cursor"]["id"].numberLong();
+        while (cursorId != 0) {
+            BSONObj batch;
+            ASSERT_TRUE(client.runCommand(nss.db().toString(),
+                                          BSON("getMore" << cursorId << "collection"
+                                                         << nss.coll()),
+                                          batch))
+                << batch;
+            for (auto&& doc : batch["cursor"]["nextBatch"].Array()) {
+                ASSERT_LESS_THAN(doc["a"].numberInt(), 5);
+                ASSERT_TRUE(ids.insert(doc["_id"].numberInt()).second);
+            }
+            cursorId = batch["cursor"]["id"].numberLong();
+        }
+    }
+    ASSERT_EQUALS(ids.size(), 500U);
+}
+
 }  // namespace
 }  // namespace mongo
@@ -36,12 +36,16 @@
 #include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/catalog/index_create.h"
 #include "mongo/db/client.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
+#include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/storage_engine_init.h"
 #include "mongo/dbtests/dbtests.h"
+#include "mongo/util/scopeguard.h"
 
 namespace IndexUpdateTests {
 
@@ -270,6 +274,102 @@ public:
     }
 };
 
+/**
+ * A foreground build of several indexes at once generates and sorts keys on multiple threads when
+ * maxIndexBuildThreads allows it, and ends up with the same indexes.
+ */
+class InsertBuildMultipleIndexesInParallel : public IndexBuildBase {
+public:
+    void run() {
+        auto param = ServerParameterSet::getGlobal()->getMap().find("maxIndexBuildThreads");
+        ASSERT(param != ServerParameterSet::getGlobal()->getMap().end());
+        ASSERT_OK(param->second->setFromString("4"));
+        ON_BLOCK_EXIT([&] { param->second->setFromString("1").transitional_ignore(); });
+
+        // Create a new collection. Enough documents are inserted to fill several key generation
+        // batches.
+        const int numDocs = 3000;
+        Database* db = _ctx.db();
+        Collection* coll;
+        {
+            WriteUnitOfWork wunit(&_opCtx);
+            db->dropCollection(&_opCtx, _ns).transitional_ignore();
+            coll = db->createCollection(&_opCtx, _ns);
+
+            OpDebug* const nullOpDebug = nullptr;
+            for (int i = 0; i < numDocs; i++) {
+                BSONObjBuilder doc;
+                doc.append("_id", i);
+                doc.append("a", numDocs - i);
+                doc.append("b", BSON_ARRAY(i << i + 1));
+                if (i % 2 == 0)
+                    doc.append("c", i);
+                ASSERT_OK(
+                    coll->insertDocument(&_opCtx, InsertStatement(doc.obj()), nullOpDebug, true));
+            }
+            wunit.commit();
+        }
+
+        MultiIndexBlock indexer(&_opCtx, coll);
+        std::vector<BSONObj> specs;
+        for (auto&& name : {"a", "b", "c"}) {
+            BSONObjBuilder spec;
+            spec.append("name", name);
+            spec.append("ns", coll->ns().ns());
+            spec.append("key", BSON(name << 1));
+            spec.append("v", static_cast<int>(kIndexVersion));
+            if (name == std::string("c"))
+                spec.append("partialFilterExpression", BSON("c" << BSON("$exists" << true)));
+            specs.push_back(spec.obj());
+        }
+
+        ASSERT_OK(indexer.init(specs).getStatus());
+        ASSERT_OK(indexer.insertAllDocumentsInCollection());
+        {
+            WriteUnitOfWork wunit(&_opCtx);
+            indexer.commit();
+            wunit.commit();
+        }
+
+        // Every phase of the build is reported with the operation.
+        const BSONObj phases = CurOp::get(_opCtx)->debug().indexBuildPhases;
+        for (auto&& phase : {"scanMillis",
+                             "keyGenerationMillis",
+                             "sorterInsertMillis",
+                             "sortMillis",
+                             "bulkLoadMillis"}) {
+            ASSERT_TRUE(phases.hasField(phase)) << phases;
+        }
+
+        ASSERT_EQUALS(countIndexKeys(coll, "a"), static_cast<size_t>(numDocs));
+        ASSERT_EQUALS(countIndexKeys(coll, "b"), static_cast<size_t>(2 * numDocs));
+        ASSERT_EQUALS(countIndexKeys(coll, "c"), static_cast<size_t>(numDocs / 2));
+
+        IndexCatalog* catalog = coll->getIndexCatalog();
+        ASSERT_FALSE(catalog->findIndexByName(&_opCtx, "a")->isMultikey(&_opCtx));
+        ASSERT_TRUE(catalog->findIndexByName(&_opCtx, "b")->isMultikey(&_opCtx));
+    }
+
+private:
+    // Counts the entries in an index, checking that they come back in key order.
+    size_t countIndexKeys(Collection* coll, const std::string& indexName) {
+        IndexCatalog* catalog = coll->getIndexCatalog();
+        IndexDescriptor* desc = catalog->findIndexByName(&_opCtx, indexName);
+        ASSERT(desc);
+
+        size_t numKeys = 0;
+        BSONObj lastKey;
+        auto cursor = catalog->getIndex(desc)->newCursor(&_opCtx);
+        for (auto kv = cursor->seek(kMinBSONKey, true); kv; kv = cursor->next()) {
+            if (numKeys > 0)
+                ASSERT_LTE(SimpleBSONObjComparator::kInstance.compare(lastKey, kv->key), 0);
+            lastKey = kv->key.getOwned();
+            numKeys++;
+        }
+        return numKeys;
+    }
+};
+
 /** Index creation is killed if mayInterrupt is true. */
 class InsertBuildIndexInterrupt : public IndexBuildBase {
 public:
@@ -830,6 +930,7 @@ public:
         add<InsertBuildEnforceUnique<false>>();
         add<InsertBuildFillDups<true>>();
         add<InsertBuildFillDups<false>>();
+        add<InsertBuildMultipleIndexesInParallel>();
         add<InsertBuildIndexInterrupt>();
         add<InsertBuildIndexInterruptDisallowed>();
         add<InsertBuildIdIndexInterrupt>();
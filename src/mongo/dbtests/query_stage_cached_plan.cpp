@@ -258,6 +258,79 @@ TEST_F(QueryStageCachedPlan, QueryStageCachedPlanHitMaxWorks) {
     ASSERT_EQ(cache->get(*cq).state, PlanCache::CacheEntryState::kPresentInactive);
 }
 
+/**
+ * Test that a short trial period ends once the cached plan produces its first result, but that the
+ * query is still replanned if the plan needs too many works to get there.
+ */
+TEST_F(QueryStageCachedPlan, ShortTrialEndsAfterFirstResultButStillReplans) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    Collection* collection = ctx.getCollection();
+    ASSERT(collection);
+
+    // Query can be answered by either index on "a" or index on "b".
+    auto qr = stdx::make_unique<QueryRequest>(nss);
+    qr->setFilter(fromjson("{a: {$gte: 8}, b: 1}"));
+    auto statusWithCQ = CanonicalQuery::canonicalize(opCtx(), std::move(qr));
+    ASSERT_OK(statusWithCQ.getStatus());
+    const std::unique_ptr<CanonicalQuery> cq = std::move(statusWithCQ.getValue());
+
+    QueryPlannerParams plannerParams;
+    fillOutPlannerParams(&_opCtx, collection, cq.get(), &plannerParams);
+    plannerParams.options |= QueryPlannerParams::SHORT_CACHED_PLAN_TRIAL;
+
+    const size_t decisionWorks = 10;
+    const size_t mockWorks =
+        1U + static_cast<size_t>(internalQueryCacheEvictionRatio * decisionWorks);
+    PlanYieldPolicy yieldPolicy(PlanExecutor::NO_YIELD,
+                                _opCtx.getServiceContext()->getFastClockSource());
+
+    // The first result arrives at once, so the trial ends even though producing the rest of the
+    // results would take more works than a full trial allows.
+    {
+        auto mockChild = stdx::make_unique<QueuedDataStage>(&_opCtx, &_ws);
+        WorkingSetID id = _ws.allocate();
+        WorkingSetMember* member = _ws.get(id);
+        member->obj = Snapshotted<BSONObj>(SnapshotId(), BSON("_id" << 8 << "a" << 8 << "b" << 1));
+        _ws.transitionToOwnedObj(id);
+        mockChild->pushBack(id);
+        for (size_t i = 0; i < mockWorks; i++) {
+            mockChild->pushBack(PlanStage::NEED_TIME);
+        }
+
+        CachedPlanStage cachedPlanStage(&_opCtx,
+                                        collection,
+                                        &_ws,
+                                        cq.get(),
+                                        plannerParams,
+                                        decisionWorks,
+                                        mockChild.release());
+        ASSERT_OK(cachedPlanStage.pickBestPlan(&yieldPolicy));
+        auto stats = static_cast<const CachedPlanStats*>(cachedPlanStage.getSpecificStats());
+        ASSERT_FALSE(stats->replanned);
+        ASSERT_EQ(getNumResultsForStage(_ws, &cachedPlanStage, cq.get()), 1U);
+    }
+
+    // Taking too many works before the first result still causes the query to be replanned.
+    {
+        auto mockChild = stdx::make_unique<QueuedDataStage>(&_opCtx, &_ws);
+        for (size_t i = 0; i < mockWorks; i++) {
+            mockChild->pushBack(PlanStage::NEED_TIME);
+        }
+
+        CachedPlanStage cachedPlanStage(&_opCtx,
+                                        collection,
+                                        &_ws,
+                                        cq.get(),
+                                        plannerParams,
+                                        decisionWorks,
+                                        mockChild.release());
+        ASSERT_OK(cachedPlanStage.pickBestPlan(&yieldPolicy));
+        auto stats = static_cast<const CachedPlanStats*>(cachedPlanStage.getSpecificStats());
+        ASSERT_TRUE(stats->replanned);
+        ASSERT_EQ(getNumResultsForStage(_ws, &cachedPlanStage, cq.get()), 2U);
+    }
+}
+
 /**
  * Test the way cache entries are added (either "active" or "inactive") to the plan cache.
  */
@@ -400,6 +400,67 @@ public:
     }
 };
 
+//
+// Split the scan into RecordId ranges, including ranges bounded by ids that no longer exist. The
+// ranges together should return every record exactly once, in order.
+//
+
+class QueryStageCollscanRangePartitions : public QueryStageCollectionScanBase {
+public:
+    void run() {
+        dbtests::WriteContextForTests ctx(&_opCtx, nss.ns());
+        Collection* coll = ctx.getCollection();
+
+        vector<RecordId> recordIds;
+        getRecordIds(coll, CollectionScanParams::FORWARD, &recordIds);
+
+        vector<RecordId> boundaries = {recordIds[10], recordIds[20], recordIds[35]};
+        for (int i : {10, 20, 30}) {
+            remove(coll->docFor(&_opCtx, recordIds[i]).value());
+        }
+
+        vector<RecordId> expected;
+        getRecordIds(coll, CollectionScanParams::FORWARD, &expected);
+        ASSERT_EQUALS(static_cast<size_t>(numObj() - 3), expected.size());
+        ASSERT(expected == scanRanges(coll, boundaries));
+
+        // Sampled split points may not split the collection at all, depending on the storage
+        // engine, but must always produce valid ranges.
+        vector<RecordId> splitPoints = coll->getRecordStore()->getRangeSplitPoints(&_opCtx, 4);
+        ASSERT_LESS_THAN_OR_EQUALS(splitPoints.size(), 3U);
+        for (size_t i = 1; i < splitPoints.size(); ++i) {
+            ASSERT_LESS_THAN(splitPoints[i - 1], splitPoints[i]);
+        }
+        ASSERT(expected == scanRanges(coll, splitPoints));
+    }
+
+private:
+    /**
+     * Scans the ranges that 'boundaries' split the collection into one after the other, and
+     * returns the concatenated results.
+     */
+    vector<RecordId> scanRanges(Collection* coll, const vector<RecordId>& boundaries) {
+        vector<RecordId> out;
+        for (size_t i = 0; i <= boundaries.size(); ++i) {
+            CollectionScanParams params;
+            params.collection = coll;
+            params.direction = CollectionScanParams::FORWARD;
+            params.minRecord = i > 0 ? boundaries[i - 1] : RecordId();
+            params.maxRecord = i < boundaries.size() ? boundaries[i] : RecordId();
+
+            WorkingSet ws;
+            CollectionScan scan(&_opCtx, params, &ws, nullptr);
+            while (!scan.isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                if (PlanStage::ADVANCED == scan.work(&id)) {
+                    out.push_back(ws.get(id)->recordId);
+                }
+            }
+        }
+        return out;
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("QueryStageCollectionScan") {}
@@ -414,6 +475,7 @@ public:
         add<QueryStageCollscanObjectsInOrderBackward>();
         add<QueryStageCollscanInvalidateUpcomingObject>();
         add<QueryStageCollscanInvalidateUpcomingObjectBackward>();
+        add<QueryStageCollscanRangePartitions>();
     }
 };
 
@@ -563,6 +563,47 @@ TEST_F(QueryStageMultiPlanTest, MPSSummaryStats) {
     ASSERT_LTE(stats.totalKeysExamined, static_cast<size_t>(N));
 }
 
+// Test that a candidate plan which is clearly less productive than another is no longer worked once
+// pruning is enabled, and that the trial period's cost is reported either way.
+TEST_F(QueryStageMultiPlanTest, MPSPrunesDominatedPlans) {
+    const int N = 5000;
+    for (int i = 0; i < N; ++i) {
+        insert(BSON("foo" << (i % 10)));
+    }
+
+    addIndex(BSON("foo" << 1));
+
+    AutoGetCollectionForReadCommand ctx(_opCtx.get(), nss);
+    const Collection* coll = ctx.getCollection();
+
+    // Without pruning, the collection scan is worked for as long as the index scan.
+    {
+        auto mps = runMultiPlanner(_opCtx.get(), nss, coll, 7);
+        auto stats = static_cast<const MultiPlanStats*>(mps->getSpecificStats());
+        ASSERT_EQ(stats->candidatesPruned, 0U);
+        ASSERT_EQ(mps->getChildren()[1]->getStats()->common.works, getBestPlanWorks(mps.get()));
+        ASSERT_EQ(stats->trialWorks, 2 * getBestPlanWorks(mps.get()));
+    }
+
+    // The collection scan only returns one in ten documents, whereas the index scan returns a
+    // document for every work, so the collection scan is pruned as soon as it is eligible.
+    const int minWorks = 10;
+    internalQueryPlanEvaluationPruneRatio.store(0.5);
+    internalQueryPlanEvaluationPruneMinWorks.store(minWorks);
+    ON_BLOCK_EXIT([] {
+        internalQueryPlanEvaluationPruneRatio.store(0.0);
+        internalQueryPlanEvaluationPruneMinWorks.store(100);
+    });
+
+    auto mps = runMultiPlanner(_opCtx.get(), nss, coll, 7);
+    auto stats = static_cast<const MultiPlanStats*>(mps->getSpecificStats());
+    ASSERT_EQ(stats->candidatesPruned, 1U);
+    const size_t collScanWorks = mps->getChildren()[1]->getStats()->common.works;
+    ASSERT_EQ(collScanWorks, static_cast<size_t>(minWorks));
+    ASSERT_GT(getBestPlanWorks(mps.get()), collScanWorks);
+    ASSERT_EQ(stats->trialWorks, getBestPlanWorks(mps.get()) + collScanWorks);
+}
+
 TEST_F(QueryStageMultiPlanTest, ShouldReportErrorIfExceedsTimeLimitDuringPlanning) {
     const int N = 5000;
     for (int i = 0; i < N; ++i) {
@@ -100,10 +100,28 @@ public:
             MONGO_UNREACHABLE;
         }
 
+        boost::optional<long long> getCollectionDataSize(OperationContext* opCtx,
+                                                         const NamespaceString& nss) const final {
+            return boost::none;
+        }
+
+        bool hasIndexForEqualityMatch(OperationContext* opCtx,
+                                      const NamespaceString& nss,
+                                      const FieldPath& field,
+                                      const CollatorInterface* collator) const final {
+            return false;
+        }
+
         BSONObj getCollectionOptions(const NamespaceString& nss) final {
             MONGO_UNREACHABLE;
         }
 
+        void createIndexes(OperationContext* opCtx,
+                           const NamespaceString& nss,
+                           const std::vector<BSONObj>& indexSpecs) final {
+            MONGO_UNREACHABLE;
+        }
+
         void renameIfOptionsAndIndexesHaveNotChanged(
             OperationContext* opCtx,
             const BSONObj& renameCommandObj,